@@ -114,6 +114,7 @@ int hashTable::remove(const char *id)
 void hashTable::clear(void)
 {
    delete[] table;
+   table = NULL;
    freepos = -1;
    size = 0;
 }
@@ -0,0 +1,357 @@
+/*************************************************************************
+  FILE:  order.cxx
+  DESCR: Static variable orders computed from the circuit structure
+*************************************************************************/
+#include <algorithm>
+#include "order.h"
+
+using namespace std;
+
+   /* Max. number of FORCE iterations */
+#define FORCE_MAXITE 100
+
+
+/*************************************************************************
+  Building the netlist
+*************************************************************************/
+
+int netlist::addInput(void)
+{
+   int n = input.size();
+
+   left.push_back(-1);
+   right.push_back(-1);
+   input.push_back(inputs.size());
+   inputs.push_back(n);
+   return n;
+}
+
+
+int netlist::addGate(int l, int r)
+{
+   int n = input.size();
+
+   left.push_back(l);
+   right.push_back(r);
+   input.push_back(-1);
+   return n;
+}
+
+
+/* Find the longest path from an input to each node. Fan-ins always
+   come before the gate, so one pass is enough.
+*/
+void netlist::findDepth(void)
+{
+   depth.assign(input.size(), 0);
+
+   for (unsigned int n=0 ; n<input.size() ; n++)
+   {
+      if (left[n] >= 0)
+	 depth[n] = max(depth[n], depth[left[n]]+1);
+      if (right[n] >= 0)
+	 depth[n] = max(depth[n], depth[right[n]]+1);
+   }
+}
+
+
+struct deeperCmp
+{
+   deeperCmp(const vector<int> &d) : depth(d) {}
+   bool operator()(int a, int b) const
+   {
+      if (depth[a] != depth[b])
+	 return depth[a] > depth[b];
+      return a < b;
+   }
+   const vector<int> &depth;
+};
+
+
+/* Find the gates without fan-out, deepest first
+ */
+void netlist::findOutputs(vector<int> &out)
+{
+   vector<char> used(input.size(), 0);
+
+   for (unsigned int n=0 ; n<input.size() ; n++)
+   {
+      if (left[n] >= 0)
+	 used[left[n]] = 1;
+      if (right[n] >= 0)
+	 used[right[n]] = 1;
+   }
+
+   for (unsigned int n=0 ; n<input.size() ; n++)
+      if (!used[n]  &&  input[n] < 0)
+	 out.push_back(n);
+
+   stable_sort(out.begin(), out.end(), deeperCmp(depth));
+}
+
+
+/*************************************************************************
+  Depth first ordering
+*************************************************************************/
+
+/* Visit the fan-in cone of 'n', the deepest fan-in first, and add the
+   nodes to 'seq' in the order they are first reached
+*/
+void netlist::dfsVisit(int n, vector<char> &visited, vector<int> &seq)
+{
+   if (n < 0  ||  visited[n])
+      return;
+
+   visited[n] = 1;
+   seq.push_back(n);
+
+   int a = left[n], b = right[n];
+   if (b >= 0  &&  (a < 0  ||  depth[b] > depth[a]))
+      swap(a,b);
+
+   dfsVisit(a, visited, seq);
+   dfsVisit(b, visited, seq);
+}
+
+
+/* Depth first traversal from the outputs in the style of Malik et al.
+   Inputs are placed in the order they are reached.
+*/
+void netlist::dfsOrder(vector<int> &seq)
+{
+   vector<char> visited(input.size(), 0);
+   vector<int> out;
+
+   findOutputs(out);
+   for (unsigned int n=0 ; n<out.size() ; n++)
+      dfsVisit(out[n], visited, seq);
+}
+
+
+/*************************************************************************
+  FORCE placement
+*************************************************************************/
+
+struct posCmp
+{
+   posCmp(const vector<double> &p, const vector<int> &o) : pos(p), old(o) {}
+   bool operator()(int a, int b) const
+   {
+      if (pos[a] != pos[b])
+	 return pos[a] < pos[b];
+      return old[a] < old[b];
+   }
+   const vector<double> &pos;
+   const vector<int> &old;
+};
+
+
+/* FORCE by Aloul et al. Each signal forms a hyperedge with the gates it
+   feeds. The nodes are placed on a line, moved to the average center of
+   gravity of their hyperedges and spread out again by sorting. This is
+   repeated as long as the total span of the hyperedges decreases. The
+   placement starts with the inputs in interleaved order and each gate
+   just after its last fan-in.
+*/
+void netlist::forceOrder(vector<int> &seq)
+{
+   int num = input.size();
+   vector<int> pos(num), node, best, first(num+1, 0), fanout;
+   vector<double> sum(num), cnt(num), newpos(num);
+   long bestspan = -1;
+
+      /* Fan-out lists, indexed by 'first' */
+   for (int g=0 ; g<num ; g++)
+   {
+      if (left[g] >= 0)
+	 first[left[g]+1]++;
+      if (right[g] >= 0)
+	 first[right[g]+1]++;
+   }
+   for (int n=0 ; n<num ; n++)
+      first[n+1] += first[n];
+   
+   fanout.resize(first[num]);
+   vector<int> fill(first.begin(), first.end()-1);
+   for (int g=0 ; g<num ; g++)
+   {
+      if (left[g] >= 0)
+	 fanout[fill[left[g]]++] = g;
+      if (right[g] >= 0)
+	 fanout[fill[right[g]]++] = g;
+   }
+
+      /* Initial placement */
+   interleaveOrder(node);
+   for (int n=0 ; n<num ; n++)
+      newpos[n] = 0.0;
+   for (unsigned int n=0 ; n<node.size() ; n++)
+      newpos[node[n]] = n;
+   for (int g=0 ; g<num ; g++)
+      if (input[g] < 0)
+      {
+	 if (left[g] >= 0)
+	    newpos[g] = max(newpos[g], newpos[left[g]]+0.5);
+	 if (right[g] >= 0)
+	    newpos[g] = max(newpos[g], newpos[right[g]]+0.5);
+      }
+   
+   node.resize(num);
+   for (int n=0 ; n<num ; n++)
+      node[n] = pos[n] = n;
+   stable_sort(node.begin(), node.end(), posCmp(newpos, pos));
+   for (int n=0 ; n<num ; n++)
+      pos[node[n]] = n;
+
+   for (int ite=0 ; ite<FORCE_MAXITE ; ite++)
+   {
+      long span = 0;
+
+      for (int n=0 ; n<num ; n++)
+	 sum[n] = cnt[n] = 0.0;
+
+      for (int d=0 ; d<num ; d++)
+      {
+	 if (first[d] == first[d+1])
+	    continue;
+
+	 int lo = pos[d], hi = pos[d];
+	 double cog = pos[d];
+
+	 for (int f=first[d] ; f<first[d+1] ; f++)
+	 {
+	    cog += pos[fanout[f]];
+	    lo = min(lo, pos[fanout[f]]);
+	    hi = max(hi, pos[fanout[f]]);
+	 }
+	 cog /= first[d+1] - first[d] + 1;
+	 span += hi - lo;
+
+	 sum[d] += cog;
+	 cnt[d] += 1.0;
+	 for (int f=first[d] ; f<first[d+1] ; f++)
+	 {
+	    sum[fanout[f]] += cog;
+	    cnt[fanout[f]] += 1.0;
+	 }
+      }
+
+      if (bestspan >= 0  &&  span >= bestspan)
+	 break;
+      bestspan = span;
+      best = node;
+
+      for (int n=0 ; n<num ; n++)
+	 newpos[n] = (cnt[n] > 0.0 ? sum[n]/cnt[n] : pos[n]);
+
+      stable_sort(node.begin(), node.end(), posCmp(newpos, pos));
+      for (int n=0 ; n<num ; n++)
+	 pos[node[n]] = n;
+   }
+
+   seq = best;
+}
+
+
+/*************************************************************************
+  Interleaving
+*************************************************************************/
+
+/* Interleaving by Fujii et al. The outputs are traversed depth first one
+   at a time. An input that is not placed yet is put just after the last
+   input seen in the current traversal, so inputs used together by the
+   outputs end up next to each other.
+*/
+void netlist::interleaveOrder(vector<int> &seq)
+{
+   int num = input.size();
+   vector<int> next(num+1, -1);  /* Linked list with 'num' as the head */
+   vector<int> stamp(num, -1);
+   vector<int> out, stack;
+   vector<char> placed(num, 0);
+
+   findOutputs(out);
+
+   for (unsigned int o=0 ; o<out.size() ; o++)
+   {
+      int last = num;
+
+      stack.push_back(out[o]);
+      while (!stack.empty())
+      {
+	 int n = stack.back();
+	 stack.pop_back();
+
+	 if (n < 0  ||  stamp[n] == (int)o)
+	    continue;
+	 stamp[n] = o;
+
+	 if (input[n] >= 0)
+	 {
+	    if (!placed[n])
+	    {
+	       next[n] = next[last];
+	       next[last] = n;
+	       placed[n] = 1;
+	    }
+	    last = n;
+	    continue;
+	 }
+
+	 int a = left[n], b = right[n];
+	 if (b >= 0  &&  (a < 0  ||  depth[b] > depth[a]))
+	    swap(a,b);
+	 stack.push_back(b);
+	 stack.push_back(a);
+      }
+   }
+
+   for (int n=next[num] ; n>=0 ; n=next[n])
+      seq.push_back(n);
+}
+
+
+/*************************************************************************
+  Interface
+*************************************************************************/
+
+/* Calculate a variable order for the inputs with the heuristic 'method'.
+   The result is stored in 'order' as the input number for each level,
+   ready for bdd_setvarorder(). Inputs that are not used by any gate are
+   placed last in declared order.
+*/
+void netlist::makeOrder(int method, int *order)
+{
+   vector<int> seq;
+   vector<char> placed(input.size(), 0);
+   int level = 0;
+
+   findDepth();
+
+   switch (method)
+   {
+   case ORDER_DFS:
+      dfsOrder(seq);
+      break;
+   case ORDER_FORCE:
+      forceOrder(seq);
+      break;
+   case ORDER_INTERLEAVE:
+      interleaveOrder(seq);
+      break;
+   }
+
+   for (unsigned int n=0 ; n<seq.size() ; n++)
+      if (input[seq[n]] >= 0  &&  !placed[seq[n]])
+      {
+	 placed[seq[n]] = 1;
+	 order[level++] = input[seq[n]];
+      }
+
+   for (unsigned int n=0 ; n<inputs.size() ; n++)
+      if (!placed[inputs[n]])
+	 order[level++] = n;
+}
+
+
+/* EOF */
@@ -0,0 +1,49 @@
+/*************************************************************************
+  FILE:  order.h
+  DESCR: Static variable orders computed from the circuit structure
+*************************************************************************/
+
+#ifndef _ORDER_H
+#define _ORDER_H
+
+#include <vector>
+
+   /* Static ordering heuristics */
+#define ORDER_FILE       0  /* Inputs in the order they are declared */
+#define ORDER_DFS        1  /* Depth first from the outputs, deepest fan-in first */
+#define ORDER_FORCE      2  /* FORCE placement of the gate hypergraph */
+#define ORDER_INTERLEAVE 3  /* Depth first per output, interleaved */
+
+
+/* Gate DAG of a circuit. Each node is either a primary input or a gate
+   with one or two fan-ins. Node numbers are handed out in the order the
+   nodes are added, so fan-ins always have lower numbers than the gate.
+*/
+class netlist
+{
+public:
+   int addInput(void);
+   int addGate(int left, int right);
+   int inputNum(void) const { return inputs.size(); }
+   void makeOrder(int method, int *order);
+
+private:
+   void findDepth(void);
+   void findOutputs(std::vector<int> &);
+   void dfsVisit(int, std::vector<char> &, std::vector<int> &);
+   void dfsOrder(std::vector<int> &);
+   void forceOrder(std::vector<int> &);
+   void interleaveOrder(std::vector<int> &);
+
+   std::vector<int> left;    /* Fan-ins, -1 for none */
+   std::vector<int> right;
+   std::vector<int> input;   /* Input number or -1 for gates */
+   std::vector<int> depth;   /* Longest path from an input */
+   std::vector<int> inputs;  /* Nodes of the inputs in declared order */
+};
+
+
+#endif /* _ORDER_H */
+
+
+/* EOF */
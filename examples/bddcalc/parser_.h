@@ -19,6 +19,7 @@ struct token         /* BISON token data */
    char *str;
    int ival;
    bdd *bval;
+   int nval;         /* Netlist node when scanning for a static order */
 };
 
 #define YYSTYPE token
@@ -31,6 +32,7 @@ extern void yyerror(char *,...);  /* Declare for flex and bison */
 extern FILE *yyin;
 extern int yylex(void);           /* Declare for bison */
 extern int yyparse(void);         /* Declare for bison user */
+extern void yyrestart(FILE *);    /* Declare for bison user */
 extern int linenum;               /* Declare for error handler */
 
    /* Use this instead of strdup() to avoid malloc() */
@@ -0,0 +1,103 @@
+/*************************************************************************
+  FILE:  circuit.cxx
+  DESCR: Builds the BDDs of AIGER and BLIF circuits and compares the
+         input order of the file with the static order.
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bdd.h"
+
+using namespace std;
+
+static int showtime = 0;
+
+
+/*************************************************************************
+  Building
+*************************************************************************/
+
+static int build(char *fname, int flags, const char *name)
+{
+   bddCircuit *c;
+   bddCircuitStat stat;
+   bdd *out;
+   clock_t t0;
+   int n, taut = 0;
+
+   bdd_init(100000, 10000);
+   bdd_setmaxincrease(1000000);
+   bdd_gbc_hook(NULL);
+
+   if ((c=bdd_circuit_fnload(fname)) == NULL)
+   {
+      cout << fname << ": cannot read the circuit\n";
+      bdd_done();
+      return 1;
+   }
+
+   out = new bdd[bdd_circuit_outputnum(c)];
+   t0 = clock();
+   if (bdd_circuit_build(c, 0, flags, out, &stat) < 0)
+   {
+      cout << fname << ": cannot build the circuit\n";
+      delete[] out;
+      bdd_circuit_free(c);
+      bdd_done();
+      return 1;
+   }
+
+   for (n=0 ; n<bdd_circuit_outputnum(c) ; n++)
+      if (out[n] == bddtrue)
+	 taut++;
+
+   cout << "  " << name << ": gates " << stat.gates
+	<< ", max live gates " << stat.maxlive
+	<< ", peak table nodes " << stat.peaknodes;
+   if (flags & BDD_CIRCUIT_PEAK)
+      cout << ", peak live nodes " << stat.peaklive;
+   cout << ", tautologies " << taut << "/" << bdd_circuit_outputnum(c);
+   if (showtime)
+      cout << ", time " << (float)(clock()-t0)/CLOCKS_PER_SEC << "s";
+   cout << endl;
+   
+   delete[] out;
+   bdd_circuit_free(c);
+   bdd_done();
+   return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+   int n, err = 0, flags = 0, fileorder = 0;
+
+   if (argc < 2)
+   {
+      cout << "usage: circuit [-file] [-peak] [-time] file ...\n";
+      cout << "       Builds the outputs of the AIGER or BLIF files with the\n";
+      cout << "       static order, and also with the input order of the\n";
+      cout << "       file if -file is given. -peak counts the nodes of the\n";
+      cout << "       live gates after each gate.\n";
+      exit(1);
+   }
+
+   for (n=1 ; n<argc ; n++)
+   {
+      if (strcmp(argv[n], "-time") == 0)
+	 showtime = 1;
+      else if (strcmp(argv[n], "-peak") == 0)
+	 flags |= BDD_CIRCUIT_PEAK;
+      else if (strcmp(argv[n], "-file") == 0)
+	 fileorder = 1;
+      else
+      {
+	 cout << argv[n] << "\n";
+	 if (fileorder)
+	    err |= build(argv[n], flags, "file order");
+	 err |= build(argv[n], flags | BDD_CIRCUIT_ORDER, "static order");
+      }
+   }
+
+   return err;
+}
@@ -0,0 +1,22 @@
+AC_DEFUN([buddy_THREADS],
+[AC_ARG_ENABLE([threads], 
+  [AC_HELP_STRING([--disable-threads], 
+     [Do not use POSIX threads for parallel reordering])])
+case $enable_threads in
+  no)
+    ;;
+  *)
+    AC_CACHE_CHECK([for thread local storage and atomics], [buddy_cv_tls],
+      [AC_LINK_IFELSE([AC_LANG_PROGRAM([[static __thread unsigned int x;]],
+                         [[return __atomic_fetch_add(&x, 1, __ATOMIC_RELAXED);]])],
+                         [buddy_cv_tls=yes], [buddy_cv_tls=no])])
+    if test "$buddy_cv_tls" = yes; then
+      AC_CHECK_HEADERS([pthread.h],
+        [AC_SEARCH_LIBS([pthread_create], [pthread],
+          [AC_DEFINE([HAVE_PTHREAD], 1, 
+                     [Define to 1 to reorder independent blocks in parallel
+		      using POSIX threads.])])])
+    fi
+    ;;
+esac
+])
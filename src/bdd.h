@@ -46,6 +46,7 @@
 #endif
 
 #include <stdio.h>
+#include <stdint.h>
 
 /*=== Defined operators for apply calls ================================*/
 
@@ -149,6 +150,42 @@ typedef struct s_bddCacheStat
    long unsigned int swapCount;		/**< Number of variable swaps in reordering. */
 } bddCacheStat;
 
+
+/**
+ * \ingroup reorder
+ * 
+ * Statistics for one block moved by sifting.
+ *
+ * \see bdd_sift_hook
+ */
+typedef struct s_bddSiftStat
+{
+   int id;		/**< Id of the block as given to ::bdd_addvarblock. */
+   int before;		/**< Number of nodes before the block was moved. */
+   int after;		/**< Number of nodes with the block at its best position. */
+   int swaps;		/**< Number of variable swaps done for this block. */
+   int pruned;		/**< Number of directions cut short by the lower bound. */
+   int grown;		/**< Number of directions stopped by the growth limit. */
+   int limited;		/**< Non-zero if the swap or time budget ran out. */
+   long time;		/**< Wall time used for this block in milliseconds. */
+} bddSiftStat;
+
+
+/**
+ * \ingroup fileio
+ * 
+ * Statistics for the construction of the bdds of a circuit.
+ *
+ * \see bdd_circuit_build
+ */
+typedef struct s_bddCircuitStat
+{
+   int gates;		/**< Number of gates made. */
+   int maxlive;		/**< Largest number of gate bdds alive at the same time. */
+   int peaknodes;	/**< Largest number of nodes in use in the node table after a gate. */
+   int peaklive;	/**< Largest number of nodes in the live gate bdds, only counted with \c BDD_CIRCUIT_PEAK. */
+} bddCircuitStat;
+
 /*=== BDD interface prototypes =========================================*/
 
 /**
@@ -194,6 +231,30 @@ typedef void (*bddfilehandler)(FILE *, int);
  * Data type for satisfying assignment handlers for use with ::bdd_allsat.
  */
 typedef void (*bddallsathandler)(char*, int);
+/**
+ * Opaque data type for pull based cube iterators, see ::bdd_cube_iter_new.
+ */
+typedef struct s_bddCubeIter bddCubeIter;
+/**
+ * Opaque data type for compiled read-only bdds, see ::bdd_compile.
+ */
+typedef struct s_bddProgram bddProgram;
+/**
+ * Opaque data type for incremental bdd streams, see ::bdd_stream_open.
+ */
+typedef struct s_bddStream bddStream;
+/**
+ * Opaque data type for circuits read from AIGER or BLIF files, see ::bdd_circuit_load.
+ */
+typedef struct s_bddCircuit bddCircuit;
+/**
+ * Opaque data type for CNF formulas read from DIMACS files, see ::bdd_cnf_load.
+ */
+typedef struct s_bddCnf bddCnf;
+/**
+ * Data type for sifting statistics handlers for use with ::bdd_sift_hook.
+ */
+typedef void (*bddsifthandler)(bddSiftStat*);
    
 
 /**
@@ -1306,6 +1367,52 @@ extern BDD      bdd_fullsatone(BDD r);
 extern void     bdd_allsat(BDD r, bddallsathandler handler);
 
 
+/**
+ * \ingroup operator
+ * \brief Creates an iterator over all satisfying variable assignments.
+ *
+ * Creates an iterator that enumerates the same cubes as ::bdd_allsat, in the same order, but
+ * lets the caller pull them out in batches of at most \a batch cubes using
+ * ::bdd_cube_iter_next. The iterator keeps its own reference to \a r and keeps all its state
+ * in the iterator object, so several iterators may be active at the same time and an
+ * enumeration can be stopped and resumed at will. The iterator must be released with
+ * ::bdd_cube_iter_free. Reordering the variables or changing the number of variables
+ * invalidates the iterator.
+ *
+ * \return A new iterator or \c NULL if an error occured.
+ * \see bdd_cube_iter_next, bdd_cube_iter_free, bdd_allsat
+ */
+extern bddCubeIter* bdd_cube_iter_new(BDD r, int batch);
+
+
+/**
+ * \ingroup operator
+ * \brief Fetches the next batch of satisfying variable assignments.
+ *
+ * Fills the internal buffer of the iterator \a it with the next cubes and stores a pointer to
+ * it in \a cubes. Cube number \c i is found at offset \c i*bdd_varnum() in the buffer and has
+ * one entry for each variable, coded as for ::bdd_allsat: 0 for false, 1 for true and -1 for
+ * don't care. The buffer is reused by the next call, so the cubes must be consumed or copied
+ * before that.
+ *
+ * \return The number of cubes stored in the buffer, zero when all cubes have been returned or
+ * a negative error code if the iterator has been invalidated.
+ * \see bdd_cube_iter_new, bdd_cube_iter_free
+ */
+extern int      bdd_cube_iter_next(bddCubeIter *it, char **cubes);
+
+
+/**
+ * \ingroup operator
+ * \brief Releases a cube iterator.
+ *
+ * Frees all memory used by \a it and releases its reference to the root BDD.
+ *
+ * \see bdd_cube_iter_new
+ */
+extern void     bdd_cube_iter_free(bddCubeIter *it);
+
+
 /**
  * \ingroup info
  * \brief Calculates the number of satisfying variable assignments.
@@ -1364,6 +1471,101 @@ extern double   bdd_satcountln(BDD r);
 extern double   bdd_satcountlnset(BDD r, BDD varset);
 
 
+/**
+ * \ingroup operator
+ * \brief Evaluates bdds on many variable assignments at once.
+ *
+ * Evaluates each of the \a num bdds in \a r on \a words*64 variable assignments. The
+ * assignments are given bit sliced: bit \c j of word \a in[v*words+w] is the value of variable
+ * \c v in assignment number \c w*64+j, so \a in must hold \a words entries for each defined
+ * variable. The results are packed in the same way with bit \c j of \a out[i*words+w] being the
+ * value of \a r[i] in assignment \c w*64+j. The shared nodes of all the bdds are visited once,
+ * children before parents, for each block of several words, so the work is done on 64 or more
+ * assignments at a time without touching the node table after the initial setup.
+ *
+ * \see bdd_restrict
+ * \return Zero on success, otherwise a negative error code.
+ */
+extern int      bdd_eval_batch(BDD *r, int num, const uint64_t *in, int words,
+			       uint64_t *out);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the exact number of satisfying variable assignments.
+ *
+ * Calculates the same number as ::bdd_satcount but with arbitrary precision, so the result
+ * neither overflows nor loses precision no matter how many variables are defined. The count is
+ * returned as a decimal string that it is the users responsibility to free again using a call
+ * to \c free.
+ * 
+ * \see bdd_satcount, bdd_satcountln
+ * \return The number of possible assignments as a string or \c NULL if an error occured.
+ */
+extern char*    bdd_satcount_exact(BDD r);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the exact number of satisfying variable assignments for a given set of variables.
+ *
+ * Does the same as ::bdd_satcount_exact but only the variables in the variable set \a varset
+ * are considered, as for ::bdd_satcountset. The count is only exact if \a r does not depend
+ * on variables outside \a varset.
+ * 
+ * \see bdd_satcount_exact, bdd_satcountset
+ * \return The number of possible assignments as a string or \c NULL if an error occured.
+ */
+extern char*    bdd_satcountset_exact(BDD r, BDD varset);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the weighted model count of a bdd.
+ *
+ * Calculates the sum over all variable assignments that satisfy \a r of the product of the
+ * weights of the literals in the assignment. The weight of variable \c v is \a pos[v] when it
+ * is true and \a neg[v] when it is false, and both arrays must have an entry for every defined
+ * variable. All weights must be non negative. With \a pos[v]+neg[v]==1 for all variables this
+ * is the probability of \a r. The count is found in one linear pass over the nodes of \a r.
+ *
+ * \see bdd_wmcln, bdd_wmcmarginals, bdd_satcount
+ * \return The weighted model count.
+ */
+extern double   bdd_wmc(BDD r, double *pos, double *neg);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the logarithm of the weighted model count of a bdd.
+ *
+ * Does the same as ::bdd_wmc but returns the logarithm (base 2) of the result. The calculation
+ * is done in the logarithmic domain, so it does neither overflow nor underflow for large
+ * numbers of variables. A weighted model count of zero gives \c -HUGE_VAL.
+ *
+ * \see bdd_wmc, bdd_wmcmarginals, bdd_satcountln
+ * \return The logarithm of the weighted model count.
+ */
+extern double   bdd_wmcln(BDD r, double *pos, double *neg);
+
+
+/**
+ * \ingroup info
+ * \brief Calculates the marginal probability of all variables.
+ *
+ * For each variable \c v this calculates \a marg[v] = wmc(r & v) / wmc(r) where wmc is the
+ * weighted model count found with ::bdd_wmc using the weights \a pos and \a neg. This is also
+ * the derivative of the weighted model count with respect to \a pos[v], scaled by
+ * pos[v]/wmc(r). All marginals are found with one bottom up and one top down pass over the
+ * nodes of \a r instead of one count for each variable. If the weighted model count of \a r is
+ * zero then all marginals are zero.
+ *
+ * \see bdd_wmc, bdd_wmcln
+ * \return Zero on success, otherwise a negative error code.
+ */
+extern int      bdd_wmcmarginals(BDD r, double *pos, double *neg, double *marg);
+
+
 /**
  * \ingroup info
  * \brief Counts the number of nodes used for a bdd.
@@ -1616,189 +1818,995 @@ extern int      bdd_fnload(char *fname, BDD *r);
  * or a 0 as the next integer. In any other case the next \f$N\f$ sets of 4 integers will describe
  * the nodes used by the BDD. Each set consists of first the node number, then the variable
  * number and then the low and high nodes. The nodes \a must be saved in a order such that any
- * low or high node must be defined before it is mentioned.
+ * low or high node must be defined before it is mentioned. Files in the binary format
+ * written by ::bdd_binsave are also accepted. If the variables have the same relative order
+ * as when the file was saved then the nodes are made directly, otherwise they are rebuilt
+ * under the current order.
  * 
- * \see bdd_fnload, bdd_save
+ * \see bdd_fnload, bdd_save, bdd_binload
  * \return Zero on success, otherwise an error code from ::bdd.h.
  */
 extern int      bdd_load(FILE *ifile, BDD *r);
 
-/* In file reorder.c */
+/* In file binio.c */
 
 /**
- * \ingroup reorder
- * \brief Swap two bdd variables.
+ * \ingroup fileio
+ * \brief Saves a bdd in the binary format to a file specified by filename.
  *
- * Use ::bdd_swapvar to swap the position (in the current variable order) of the two BDD
- * variables \a v1 and \a v2. There are no constraints on the position of the two variables
- * before the call. This function may \em not be used together with user defined variable
- * blocks. The swap is done by a series of adjacent variable swaps and requires the whole node
- * table to be rehashed twice for each call to ::bdd_swapvar. It should therefore not be used
- * were efficiency is a major concern.
- * 
- * \return Zero on success and a negative error code otherwise.
- * \see bdd_reorder, bdd_addvarblock
+ * Saves the nodes used by \a r in the binary format to the file named \a fname, which will
+ * be truncated and opened for writing.
+ *
+ * \see bdd_binsave, bdd_fnbinload
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern int      bdd_swapvar(int v1, int v2);
+extern int      bdd_fnbinsave(char *fname, BDD r);
 
 
 /**
- * \ingroup reorder
- * \brief Default reorder handler.
- * 
- * The default reorder handler prints information about the 
- * reorder process to \c stdout if \c bdd_reorder_verbose(1) has been
- * called previously.
- * 
- * The information printed includes a message before the reorder runs and 
- * a message after it has run, indicating how many nodes were in use before and after
- * the reorder as well as how long (in seconds) it took to run the reorder.
- * 
- * \see bdd_reorder_hook
+ * \ingroup fileio
+ * \brief Saves a bdd in the binary format to a file.
+ *
+ * Saves the nodes used by \a r to the file \a ofile which must be opened for writing. The
+ * binary format is much smaller and faster to read and write than the one used by
+ * ::bdd_save. It starts with the four characters \c BDDB and a version number, followed by
+ * the number of variables and the variable order. Then come the nodes, each child given
+ * as the distance back to a node written earlier, a table of the roots with optional names
+ * and a checksum. All numbers are stored as variable length integers, so most nodes take
+ * only a few bytes.
+ *
+ * \see bdd_fnbinsave, bdd_binload, bdd_save
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern void     bdd_default_reohandler(int prestate);
+extern int      bdd_binsave(FILE *ofile, BDD r);
 
 
 /**
- * \ingroup reorder
- * \brief Start dynamic reordering.
+ * \ingroup fileio
+ * \brief Loads a bdd in the binary format from a file specified by filename.
  *
- * This function initiates dynamic reordering using the heuristic defined by \a method,
- * which may be one of the following:
- * - \a BDD_REORDER_WIN2 \n
- *   Reordering using a sliding window of size 2. This algorithm swaps two adjacent variable
- *   blocks and if this results in more nodes then the two blocks are swapped back again.
- *   Otherwise the result is kept in the variable order. This is then repeated for all variable
- *   blocks. 
- * - \a BDD_REORDER_WIN2ITE \n
- *   The same as above but the process is repeated until
- *   no further progress is done. Usually a fast and efficient method. 
- * - \a BDD_REORDER_WIN3 \n
- *   The same as above but with a window size of 3. 
- * - \a BDD_REORDER_WIN2ITE \n
- *   The same as above but with a window size of 3. 
- * - \a BDD_REORDER_SIFT \n 
- *   Reordering where each block is moved through all possible positions.
- *   The best of these is then used as the new position. Potentially a very slow but good method.
- * - \a BDD_REORDER_SIFTITE \n
- *   The same as above but the process is repeated until no
- *   further progress is done. Can be extremely slow.
- * - \a BDD_REORDER_RANDOM \n
- *   Mostly used for debugging purpose, but may be usefull for others. Selects a random position for
- *   each variable.
- * 
- * \see bdd_autoreorder, bdd_reorder_verbose, bdd_addvarblock, bdd_clrvarblocks
+ * Loads a bdd saved by ::bdd_binsave from the file named \a fname into the bdd pointed to
+ * by \a r.
+ *
+ * \see bdd_binload, bdd_fnbinsave
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern void     bdd_reorder(int method);
+extern int      bdd_fnbinload(char *fname, BDD *r);
 
 
 /**
- * \ingroup reorder
- * \brief Calculate the gain in size after a reordering.
+ * \ingroup fileio
+ * \brief Loads a bdd in the binary format from a file.
  *
- * Returns the gain in percent of the previous number of used nodes. The value returned is 
- * \f[ (100 * (A - B)) / A \f] 
- * Where \f$A\f$ is previous number of used nodes and \f$B\f$ is current number of used
- * nodes.
- * 
+ * Loads a bdd saved by ::bdd_binsave from the file \a ifile into the bdd pointed to by
+ * \a r. The file is read in large blocks and the checksum is verified before the bdd is
+ * returned. As for ::bdd_load the nodes are made directly when the variable order allows it.
+ * ::bdd_load also recognizes the binary format and calls this function.
+ *
+ * \see bdd_fnbinload, bdd_binsave, bdd_load
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern int      bdd_reorder_gain(void);
+extern int      bdd_binload(FILE *ifile, BDD *r);
 
 
 /**
- * \ingroup reorder
- * \brief Define a handler for minimization of bdds.
+ * \ingroup fileio
+ * \brief Saves several bdds with shared nodes to a file.
  *
- * Reordering is typically done to minimize the global number of BDD nodes in use, but it may in
- * some cases be usefull to minimize with respect to a specific BDD. With ::bdd_reorder_probe
- * it is possible to define a callback function that calculates the size of a specific BDD (or
- * anything else in fact). This handler will then be called by the reordering functions to get
- * the current size information. A typical handle could look like this: 
- * \code 
- * int * sizehandler(void) 
- * { 
- *   extern BDD mybdd; 
- *   return bdd_nodecount(mybdd); 
- * } 
- * \endcode 
- * No default handler is supplied. The argument \a handler may be \c NULL if no handler is needed.
- * 
- * \return The old handler.
- * \see bdd_reorder
+ * Saves the \a num bdds in \a r to the file \a ofile in the binary format described under
+ * ::bdd_binsave. Nodes shared by the bdds are only written once, and the file ends with a
+ * table of the roots. Use ::bdd_load_many to read them back.
+ *
+ * \see bdd_save_named, bdd_load_many
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern bddsizehandler bdd_reorder_probe(bddsizehandler handler);
+extern int      bdd_save_many(FILE *ofile, BDD *r, int num);
 
 
 /**
- * \ingroup reorder
- * \brief Clears all variable blocks.
+ * \ingroup fileio
+ * \brief Saves several named bdds with shared nodes to a file.
  *
- * Clears all the variable blocks that has been defined by calls to ::bdd_addvarblock.
- * 
- * \see bdd_addvarblock
+ * Does the same as ::bdd_save_many but also stores the name \a names[i] with the root
+ * \a r[i]. Either \a names or any of the names may be \c NULL for unnamed roots.
+ *
+ * \see bdd_fnsave_named, bdd_load_named
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern void     bdd_clrvarblocks(void);
+extern int      bdd_save_named(FILE *ofile, BDD *r, char **names, int num);
 
 
 /**
- * \ingroup reorder
- * \brief Adds a new variable block for reordering.
+ * \ingroup fileio
+ * \brief Saves several named bdds to a file specified by filename.
  *
- * Creates a new variable block with the variables in the variable set \a b. The variables in
- * \a b must be contiguous. This order does
- * not depend on current variable order. The variable blocks are ordered as a tree, with the
- * largest ranges at top and the smallest at the bottom. 
- * 
- * Example: Assume the block 0-9 is added
- * as the first block and then the block 0-6. This yields the 0-9 block at the top, with the 0-6
- * block as a child. If now the block 2-4 was added, it would become a child of the 0-6 block. A
- * block of 0-8 would be a child of the 0-9 block and have the 0-6 block as a child. 
- * 
- * Partially
- * overlapping blocks are not allowed. The \a fixed parameter sets the block to be fixed (no
- * reordering of its child blocks is allowed) or free, using the constants 
- * \c BDD_REORDER_FIXED and \c BDD_REORDER_FREE. Reordering is always done on the top most
- * blocks first and then recursively downwards. The return value is an integer that can be used
- * to identify the block later on - with for example ::bdd_blockfile_hook. The values
- * returned will be in the sequence \f$0,1,2,3,\ldots\f$.
- * 
- * \return A non-negative identifier on success, otherwise a negative error code.
- * \see bdd_varblockall, fdd_intaddvarblock, bdd_clrvarblocks
+ * Does the same as ::bdd_save_named, but the file named \a fname is truncated and opened
+ * for writing.
+ *
+ * \see bdd_save_named, bdd_fnload_named
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern int      bdd_addvarblock(BDD b, int fixed);
+extern int      bdd_fnsave_named(char *fname, BDD *r, char **names, int num);
 
 
 /**
- * \ingroup reorder
- * \brief Adds a new variable block for reordering.
+ * \ingroup fileio
+ * \brief Loads several bdds with shared nodes from a file.
  *
- * Creates a new variable block, where the argument \a first is the first variable
- * included in the block and \a last is the last variable included in the block. This order does
- * not depend on current variable order. The variable blocks are ordered as a tree, with the
- * largest ranges at top and the smallest at the bottom. 
- * 
- * Example: Assume the block 0-9 is added
- * as the first block and then the block 0-6. This yields the 0-9 block at the top, with the 0-6
- * block as a child. If now the block 2-4 was added, it would become a child of the 0-6 block. A
- * block of 0-8 would be a child of the 0-9 block and have the 0-6 block as a child. 
- * 
- * Partially
- * overlapping blocks are not allowed. The \a fixed parameter sets the block to be fixed (no
- * reordering of its child blocks is allowed) or free, using the constants \a
- * BDD_REORDER_FIXED and \a BDD_REORDER_FREE. Reordering is always done on the top most
- * blocks first and then recursively downwards. The return value is an integer that can be used
- * to identify the block later on - with for example ::bdd_blockfile_hook. The values
- * returned will be in the sequence \f$0,1,2,3,\ldots\f$.
- * 
- * \return A non-negative identifier on success, otherwise a negative error code.
- * \see bdd_varblockall, fdd_intaddvarblock, bdd_clrvarblocks
+ * Loads the bdds saved by ::bdd_save_many, ::bdd_save_named or ::bdd_binsave from the file
+ * \a ifile. The number of bdds is stored in \a num and a new array with the roots in the
+ * order they were saved is stored in \a r. Nodes that were shared in the file are shared
+ * again. As for ::bdd_load the roots have no references added. The array must be freed
+ * with \c free.
+ *
+ * \see bdd_load_named, bdd_save_many
+ * \return Zero on success, otherwise an error code from ::bdd.h.
  */
-extern int      bdd_intaddvarblock(int first, int last, int fixed);
+extern int      bdd_load_many(FILE *ifile, BDD **r, int *num);
 
 
 /**
- * \ingroup reorder
- * \brief Add a variable block for all variables.
+ * \ingroup fileio
+ * \brief Loads several named bdds from a file.
+ *
+ * Does the same as ::bdd_load_many but also stores a new array of the root names in
+ * \a names. Roots saved without a name get a \c NULL name. The names and the array must be
+ * freed with \c free.
+ *
+ * \see bdd_fnload_named, bdd_save_named
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_load_named(FILE *ifile, BDD **r, char ***names, int *num);
+
+
+/**
+ * \ingroup fileio
+ * \brief Loads several named bdds from a file specified by filename.
+ *
+ * Does the same as ::bdd_load_named but opens the file named \a fname for reading.
+ *
+ * \see bdd_load_named, bdd_fnsave_named
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_fnload_named(char *fname, BDD **r, char ***names, int *num);
+
+
+/**
+ * \ingroup fileio
+ * \brief Saves the whole state of the package to a file.
+ *
+ * Writes a checkpoint of the package to the file named \a fname, from which
+ * ::bdd_restore can later continue in a new process. The checkpoint holds all nodes reachable
+ * from referenced nodes together with their numbers and reference counts, the variable order,
+ * the variable blocks, the finite domains and all pairs. The file is written under a temporary
+ * name and then renamed, so an existing checkpoint is only replaced by a complete one.
+ *
+ * \see bdd_restore
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_checkpoint(char *fname);
+
+
+/**
+ * \ingroup fileio
+ * \brief Restores the state of the package from a checkpoint.
+ *
+ * Replaces the state of a package, that has just been started with ::bdd_init, with the
+ * checkpoint saved by ::bdd_checkpoint in the file named \a fname. The node table is rebuilt in
+ * one pass without any bdd operations. All nodes get the numbers and reference counts they had
+ * when saved, so BDD numbers the application kept with the checkpoint can be used directly and
+ * their references must be released as usual. The finite domains and variable blocks are
+ * restored with their old numbers. If \a pairs is not \c NULL it is set to a new array with
+ * the restored pairs, oldest first, and \a pairnum to their number. The array must be released
+ * with \c free. The whole file is checked before anything is changed.
+ *
+ * \see bdd_checkpoint
+ * \return Zero on success, ::BDD_RUNNING if the package is not running or already has
+ *         variables, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_restore(char *fname, bddPair ***pairs, int *pairnum);
+
+
+/* In file compile.c */
+
+/**
+ * \ingroup fileio
+ * \brief Compiles a bdd into a flat read-only program.
+ *
+ * Copies the nodes of \a r into a compact and self contained array representation that does
+ * not depend on the node table, so it stays valid after garbage collections, reordering and
+ * even ::bdd_done. The nodes are renumbered in depth first (\a order is \c BDD_COMPILE_DFS) or
+ * breadth first by level (\a order is \c BDD_COMPILE_BFS) order, such that all children come
+ * after their parents. The children are stored as 16 bit offsets whenever possible and the
+ * levels are mapped to variable numbers. The program is never changed after it has been made
+ * so it can be evaluated with ::bdd_program_eval from any number of threads without locking.
+ *
+ * \see bdd_acompile, bdd_program_eval, bdd_program_save, bdd_program_free
+ * \return The compiled program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_compile(BDD r, int order);
+
+
+/**
+ * \ingroup fileio
+ * \brief Compiles an array of bdds into one flat read-only program.
+ *
+ * Does the same as ::bdd_compile but for all the \a num bdds in \a r. Shared nodes are only
+ * stored once and root number \c i of the program is \a r[i].
+ *
+ * \see bdd_compile
+ * \return The compiled program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_acompile(BDD *r, int num, int order);
+
+
+/**
+ * \ingroup fileio
+ * \brief Releases a compiled program.
+ *
+ * Also releases the bdds imported from it as ::bdd_program_forget does.
+ *
+ * \see bdd_compile
+ */
+extern void     bdd_program_free(bddProgram *p);
+
+
+/**
+ * \ingroup operator
+ * \brief Evaluates a compiled program.
+ *
+ * Evaluates root number \a root of the compiled program \a p on the variable assignment
+ * \a assign, which must have a zero or non-zero entry for each variable used by the program.
+ * The evaluation only reads the program and \a assign, so it is safe to call from several
+ * threads at the same time.
+ *
+ * \see bdd_compile, bdd_program_varnum
+ * \return The value (0 or 1) of the root, or a negative error code for illegal roots. The
+ *         error handler is not called.
+ */
+extern int      bdd_program_eval(const bddProgram *p, int root, const char *assign);
+
+
+/**
+ * \ingroup operator
+ * \brief Counts the satisfying assignments of a compiled program.
+ *
+ * Does the same as ::bdd_satcount for root number \a root of \a p, counting over all the
+ * variables known when the program was compiled. Only the program is read, so this also works
+ * on programs opened with ::bdd_program_map without building any bdds.
+ *
+ * \see bdd_satcount, bdd_program_satone
+ * \return The number of satisfying assignments, or zero for illegal roots and when out of
+ *         memory. The error handler is not called.
+ */
+extern double   bdd_program_satcount(const bddProgram *p, int root);
+
+
+/**
+ * \ingroup operator
+ * \brief Finds one satisfying assignment of a compiled program.
+ *
+ * Writes an assignment to \a assign, which must have room for ::bdd_program_varnum entries,
+ * under which root number \a root of \a p is true. Variables that do not matter are set to
+ * zero. Like ::bdd_satone the low branch is preferred.
+ *
+ * \see bdd_satone, bdd_program_eval
+ * \return One if an assignment was found, zero if the root is false, or a negative error code
+ *         for illegal roots. The error handler is not called.
+ */
+extern int      bdd_program_satone(const bddProgram *p, int root, char *assign);
+
+
+/**
+ * \ingroup operator
+ * \brief Restricts a compiled program to a partial assignment.
+ *
+ * Finds the value of root number \a root of \a p when only some variables are known. An
+ * entry in \a assign is zero or one for a known variable and negative, usually -1, for a
+ * free one. The entries are signed chars since a plain char may be unsigned.
+ *
+ * \see bdd_restrict, bdd_program_eval
+ * \return Zero or one if the restricted function is that constant, two if it still depends
+ *         on the free variables, or a negative error code for illegal roots or lack of
+ *         memory. The error handler is not called.
+ */
+extern int      bdd_program_restrict(const bddProgram *p, int root,
+				     const signed char *assign);
+
+
+/**
+ * \ingroup info
+ * \brief Returns the number of nodes in a compiled program.
+ *
+ * The constant nodes are not included.
+ *
+ * \see bdd_compile
+ */
+extern int      bdd_program_nodenum(const bddProgram *p);
+
+
+/**
+ * \ingroup info
+ * \brief Returns the number of roots in a compiled program.
+ *
+ * \see bdd_compile, bdd_acompile
+ */
+extern int      bdd_program_rootnum(const bddProgram *p);
+
+
+/**
+ * \ingroup info
+ * \brief Returns the number of variables known when a program was compiled.
+ *
+ * This is the size of the assignment needed by ::bdd_program_eval.
+ *
+ * \see bdd_compile
+ */
+extern int      bdd_program_varnum(const bddProgram *p);
+
+
+/**
+ * \ingroup fileio
+ * \brief Saves a compiled program to a file.
+ *
+ * Does the same as ::bdd_program_save, but opens the file \a fname for writing first.
+ *
+ * \see bdd_program_save, bdd_program_fnload
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_program_fnsave(char *fname, const bddProgram *p);
+
+
+/**
+ * \ingroup fileio
+ * \brief Saves a compiled program to a file.
+ *
+ * Writes the compiled program \a p to the file \a ofile, which must be opened for binary
+ * writing. The file holds an exact copy of the in-memory image, in the byte order of the
+ * machine that wrote it.
+ *
+ * \see bdd_program_fnsave, bdd_program_load
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_program_save(FILE *ofile, const bddProgram *p);
+
+
+/**
+ * \ingroup fileio
+ * \brief Loads a compiled program from a file.
+ *
+ * Does the same as ::bdd_program_load, but opens the file \a fname for reading first.
+ *
+ * \see bdd_program_load, bdd_program_fnsave
+ * \return The loaded program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_program_fnload(char *fname);
+
+
+/**
+ * \ingroup fileio
+ * \brief Loads a compiled program from a file.
+ *
+ * Reads a compiled program saved with ::bdd_program_save from \a ifile. The program is checked
+ * such that evaluating it can never read outside the program.
+ *
+ * \see bdd_program_fnload, bdd_program_save
+ * \return The loaded program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_program_load(FILE *ifile);
+
+
+/**
+ * \ingroup fileio
+ * \brief Maps a compiled program file into memory.
+ *
+ * Opens a file written by ::bdd_program_save without reading it. The file is mapped read-only
+ * and shared, so all processes on a host that map the same file use one copy of it in the page
+ * cache. Only the header and the file size are checked, which takes constant time, unless
+ * \a check is non-zero in which case the whole program is checked as in ::bdd_program_load.
+ * Unchecked files must come from a trusted writer. The program is released with
+ * ::bdd_program_free and the file must not be changed while it is mapped. On systems without
+ * \c mmap the file is loaded with ::bdd_program_fnload instead.
+ *
+ * \see bdd_program_fnload, bdd_program_eval, bdd_program_satcount
+ * \return The mapped program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_program_map(char *fname, int check);
+
+
+/**
+ * \ingroup fileio
+ * \brief Places a compiled program in shared memory.
+ *
+ * Copies \a p into a new POSIX shared memory object called \a name, which must start with a
+ * slash as for \c shm_open. This freezes the bdds of the program so that other processes,
+ * typically workers forked from the one calling this, can use them with
+ * ::bdd_program_attach without building them again. An existing object is never replaced. It
+ * stays until ::bdd_program_unshare is called, even after all processes have detached. Fails
+ * with \c BDD_FILE on systems without \c shm_open.
+ *
+ * \see bdd_acompile, bdd_program_attach, bdd_program_unshare
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_program_share(const bddProgram *p, char *name);
+
+
+/**
+ * \ingroup fileio
+ * \brief Attaches a program in shared memory.
+ *
+ * Maps the shared memory object \a name made by ::bdd_program_share read-only, exactly as
+ * ::bdd_program_map does for a file, and with the same meaning of \a check. All processes
+ * attaching the object use the same pages. The program can be queried in place with
+ * ::bdd_program_eval and the other program queries, and bdds can be taken into the private
+ * node table with ::bdd_program_import. It is released with ::bdd_program_free.
+ *
+ * \see bdd_program_share, bdd_program_import
+ * \return The attached program or \c NULL if an error occured.
+ */
+extern bddProgram* bdd_program_attach(char *name, int check);
+
+
+/**
+ * \ingroup fileio
+ * \brief Removes a program from shared memory.
+ *
+ * Removes the name \a name of a shared memory object made by ::bdd_program_share. Processes
+ * that already have it attached can go on using it until they free it.
+ *
+ * \see bdd_program_share
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_program_unshare(char *name);
+
+
+/**
+ * \ingroup fileio
+ * \brief Makes a bdd of a compiled program in the node table.
+ *
+ * Makes the bdd of root number \a root of \a p in the node table of the calling process and
+ * stores it in \a res. Only the nodes below the root are made, directly if the variable order
+ * is still the one the program was compiled with and with ::bdd_ite otherwise, and new
+ * variables are made as needed. The handle remembers the bdd of each node it has made and
+ * keeps a reference to it, so importing several roots that share nodes makes each node only
+ * once. The references are released by ::bdd_program_forget or ::bdd_program_free, and the
+ * root has no further reference added.
+ *
+ * \see bdd_program_attach, bdd_program_forget
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_program_import(bddProgram *p, int root, BDD *res);
+
+
+/**
+ * \ingroup fileio
+ * \brief Releases the bdds imported from a compiled program.
+ *
+ * Removes the references held by \a p on the bdds made by ::bdd_program_import, so they can be
+ * garbage collected unless referenced elsewhere. Later imports make the nodes again.
+ *
+ * \see bdd_program_import
+ */
+extern void     bdd_program_forget(bddProgram *p);
+
+/* In file stream.c */
+
+/**
+ * \ingroup fileio
+ * \brief Starts a stream of bdds in a file.
+ *
+ * Writes the start of a stream to \a ofile, which must be opened for binary writing. Bdds are
+ * then added with ::bdd_stream_add, which only writes the nodes that the stream does not
+ * already hold, so a sequence of similar bdds such as the frontiers of a fixed point iteration
+ * takes little more room than the last one. The data is written in blocks that are compressed
+ * with a built-in LZ coder if \a flags contains \c BDD_STREAM_LZ. Any bdd in the stream can be
+ * read back with ::bdd_stream_load.
+ *
+ * \see bdd_stream_fnopen, bdd_stream_add, bdd_stream_close
+ * \return The new stream or \c NULL if an error occured.
+ */
+extern bddStream* bdd_stream_open(FILE *ofile, int flags);
+
+
+/**
+ * \ingroup fileio
+ * \brief Starts a stream of bdds in a file specified by filename.
+ *
+ * Does the same as ::bdd_stream_open but opens the file named \a fname for writing. The file is
+ * closed by ::bdd_stream_close.
+ *
+ * \see bdd_stream_open
+ * \return The new stream or \c NULL if an error occured.
+ */
+extern bddStream* bdd_stream_fnopen(char *fname, int flags);
+
+
+/**
+ * \ingroup fileio
+ * \brief Adds a bdd to a stream.
+ *
+ * Appends \a r to the stream \a s, writing only the nodes of \a r that have not been written
+ * for an earlier bdd. The stream remembers the nodes it has written without keeping them
+ * referenced, and checks each of them again when it is met, so garbage collections and
+ * reordering between the calls are allowed. The data is buffered until a block is full, the
+ * stream is flushed with ::bdd_stream_flush or it is closed.
+ *
+ * \see bdd_stream_open, bdd_stream_load
+ * \return The number of the bdd in the stream, counting from zero, or a negative error code.
+ */
+extern int      bdd_stream_add(bddStream *s, BDD r);
+
+
+/**
+ * \ingroup fileio
+ * \brief Writes all buffered data of a stream.
+ *
+ * Writes the bdds added to \a s so far to its file. A stream that is cut off after a flush can
+ * still be read up to that point.
+ *
+ * \see bdd_stream_add
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_stream_flush(bddStream *s);
+
+
+/**
+ * \ingroup fileio
+ * \brief Ends a stream of bdds.
+ *
+ * Writes the remaining data and the end of the stream \a s and releases it. The file is only
+ * closed if the stream was started with ::bdd_stream_fnopen.
+ *
+ * \see bdd_stream_open
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_stream_close(bddStream *s);
+
+
+/**
+ * \ingroup fileio
+ * \brief Loads one bdd from a stream.
+ *
+ * Reads the stream in \a ifile up to bdd number \a root and stores it in \a r, making only
+ * the nodes that bdd needs. A negative \a root gives the last bdd in the stream. Streams that
+ * were never closed are read up to the last complete bdd. The variables are numbered as when
+ * written, and new variables are made as needed.
+ *
+ * \see bdd_stream_fnload, bdd_stream_add
+ * \return Zero on success, ::BDD_RANGE if the stream has no such bdd, otherwise an error code
+ *         from ::bdd.h.
+ */
+extern int      bdd_stream_load(FILE *ifile, int root, BDD *r);
+
+
+/**
+ * \ingroup fileio
+ * \brief Loads one bdd from a stream in a file specified by filename.
+ *
+ * Does the same as ::bdd_stream_load but opens the file named \a fname for reading.
+ *
+ * \see bdd_stream_load
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_stream_fnload(char *fname, int root, BDD *r);
+
+/* In file circuit.c */
+
+/**
+ * \ingroup fileio
+ * \brief Reads a circuit in the AIGER or BLIF format.
+ *
+ * Reads a combinational or sequential circuit from \a ifile. Files that start with an
+ * \c aag or \c aig header are read as ASCII or binary AIGER and all other files as BLIF
+ * with \c .names covers. Latches are cut: the current state of a latch becomes an input
+ * after the primary inputs and its next state an output after the primary outputs, named
+ * as the latch followed by a quote. The gates that the outputs depend on are sorted
+ * topologically, so cycles and undefined signals are found here. The bdds are made with
+ * ::bdd_circuit_build.
+ *
+ * \see bdd_circuit_fnload, bdd_circuit_build, bdd_circuit_free
+ * \return The new circuit or \c NULL if an error occured. A damaged or unsupported file
+ *         gives ::BDD_FORMAT.
+ */
+extern bddCircuit* bdd_circuit_load(FILE *ifile);
+
+
+/**
+ * \ingroup fileio
+ * \brief Reads a circuit from a file specified by filename.
+ *
+ * Does the same as ::bdd_circuit_load but opens the file named \a fname for reading.
+ *
+ * \see bdd_circuit_load
+ * \return The new circuit or \c NULL if an error occured.
+ */
+extern bddCircuit* bdd_circuit_fnload(char *fname);
+
+
+/**
+ * \ingroup fileio
+ * \brief Frees a circuit.
+ *
+ * Frees all memory used by the circuit \a c. The bdds made from it are not affected.
+ *
+ * \see bdd_circuit_load
+ */
+extern void     bdd_circuit_free(bddCircuit *c);
+
+
+/**
+ * \ingroup fileio
+ * \brief Number of inputs of a circuit.
+ *
+ * \see bdd_circuit_inputname, bdd_circuit_outputnum
+ * \return The number of inputs of \a c, including the cut latches.
+ */
+extern int      bdd_circuit_inputnum(const bddCircuit *c);
+
+
+/**
+ * \ingroup fileio
+ * \brief Number of outputs of a circuit.
+ *
+ * \see bdd_circuit_outputname, bdd_circuit_inputnum
+ * \return The number of outputs of \a c, including the cut latches.
+ */
+extern int      bdd_circuit_outputnum(const bddCircuit *c);
+
+
+/**
+ * \ingroup fileio
+ * \brief Number of gates of a circuit.
+ *
+ * \see bdd_circuit_build
+ * \return The number of gates that the outputs of \a c depend on.
+ */
+extern int      bdd_circuit_gatenum(const bddCircuit *c);
+
+
+/**
+ * \ingroup fileio
+ * \brief Name of an input of a circuit.
+ *
+ * \see bdd_circuit_inputnum
+ * \return The name of input number \a n of \a c, or \c NULL and ::BDD_RANGE if there is no
+ *         such input. The name belongs to the circuit.
+ */
+extern const char* bdd_circuit_inputname(const bddCircuit *c, int n);
+
+
+/**
+ * \ingroup fileio
+ * \brief Name of an output of a circuit.
+ *
+ * \see bdd_circuit_outputnum
+ * \return The name of output number \a n of \a c, or \c NULL and ::BDD_RANGE if there is no
+ *         such output. The name belongs to the circuit.
+ */
+extern const char* bdd_circuit_outputname(const bddCircuit *c, int n);
+
+
+/**
+ * \ingroup fileio
+ * \brief Makes the bdds of the outputs of a circuit.
+ *
+ * Makes a bdd for each output of the circuit \a c and stores them in \a out, which must have
+ * room for ::bdd_circuit_outputnum roots. Input number \a n becomes variable
+ * \a firstvar+n and new variables are made as needed. The gates are made in topological
+ * order and the bdd of a gate is released as soon as the last gate that uses it has been
+ * made, so only the frontier of the circuit is kept alive.
+ *
+ * If \a flags contains \c BDD_CIRCUIT_ORDER the circuit variables are first given a static
+ * order found by a depth first search from the outputs that visits the deepest fanin first.
+ * The variables keep the levels they use between them, so other variables are not moved.
+ * This cannot be used together with variable blocks. With \c BDD_CIRCUIT_PEAK the nodes of
+ * all live gate bdds are counted after each gate, which is exact but slow. If \a stat is
+ * not \c NULL it receives the statistics of the construction. As for ::bdd_load the roots
+ * have no references added.
+ *
+ * \see bdd_circuit_load, bdd_setvarorder
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_circuit_build(bddCircuit *c, int firstvar, int flags, BDD *out,
+				  bddCircuitStat *stat);
+
+/* In file cnf.c */
+
+/**
+ * \ingroup fileio
+ * \brief Reads a CNF formula in the DIMACS format.
+ *
+ * Reads the clauses of a CNF formula from \a ifile. Comment lines of the form
+ * <tt>c ind v1 v2 ... 0</tt> or <tt>c p show v1 v2 ... 0</tt> after the \c p line give the
+ * projected variables for ::bdd_cnf_count. The bdd is made with ::bdd_cnf_build.
+ *
+ * \see bdd_cnf_fnload, bdd_cnf_build, bdd_cnf_count, bdd_cnf_free
+ * \return The new formula or \c NULL if an error occured. A damaged file gives ::BDD_FORMAT.
+ */
+extern bddCnf*  bdd_cnf_load(FILE *ifile);
+
+
+/**
+ * \ingroup fileio
+ * \brief Reads a CNF formula from a file specified by filename.
+ *
+ * Does the same as ::bdd_cnf_load but opens the file named \a fname for reading.
+ *
+ * \see bdd_cnf_load
+ * \return The new formula or \c NULL if an error occured.
+ */
+extern bddCnf*  bdd_cnf_fnload(char *fname);
+
+
+/**
+ * \ingroup fileio
+ * \brief Frees a CNF formula.
+ *
+ * Frees all memory used by the formula \a cnf.
+ *
+ * \see bdd_cnf_load
+ */
+extern void     bdd_cnf_free(bddCnf *cnf);
+
+
+/**
+ * \ingroup fileio
+ * \brief Number of variables of a CNF formula.
+ *
+ * \see bdd_cnf_clausenum
+ * \return The number of variables given in the header of \a cnf.
+ */
+extern int      bdd_cnf_varnum(const bddCnf *cnf);
+
+
+/**
+ * \ingroup fileio
+ * \brief Number of clauses of a CNF formula.
+ *
+ * \see bdd_cnf_varnum
+ * \return The number of clauses read for \a cnf.
+ */
+extern int      bdd_cnf_clausenum(const bddCnf *cnf);
+
+
+/**
+ * \ingroup fileio
+ * \brief Makes the bdd of a CNF formula.
+ *
+ * Makes the conjunction of the clauses of \a cnf and stores it in \a res. Variable \a v of
+ * the file becomes variable \a firstvar+v-1 and new variables are made as needed. The clauses
+ * are made directly from nodes and conjoined by bucket elimination: each clause goes to the
+ * bucket of its first variable in an elimination order, and the conjunction of a bucket goes
+ * on to the bucket of its next variable. This keeps the conjunctions local instead of growing
+ * one large bdd clause by clause.
+ *
+ * The elimination order is the variable order from the deepest level up. If \a flags contains
+ * \c BDD_CNF_MINWIDTH it is instead a greedy arrangement that keeps few clauses open at a
+ * time, and the variables of the formula are reordered within the levels they use so the
+ * first eliminated variable is deepest. This reordering may \em not be used together with
+ * user defined variable blocks. With
+ * \c BDD_CNF_PROJECT and a formula with projected variables, the other variables are
+ * quantified away with ::bdd_appex in the last conjunction of their bucket, so the result is
+ * the projection of the formula. As for ::bdd_load the root has no reference added.
+ *
+ * \see bdd_cnf_count, bdd_cnf_load
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ */
+extern int      bdd_cnf_build(bddCnf *cnf, int firstvar, int flags, BDD *res);
+
+
+/**
+ * \ingroup fileio
+ * \brief Counts the models of a CNF formula exactly.
+ *
+ * Makes the bdd of \a cnf as ::bdd_cnf_build and counts its satisfying assignments over the
+ * variables of the formula, or over the projected variables if \a flags contains
+ * \c BDD_CNF_PROJECT. The count is returned as a decimal string as for
+ * ::bdd_satcount_exact, and must be freed with \c free.
+ *
+ * \see bdd_cnf_build, bdd_satcountset_exact
+ * \return The number of models or \c NULL if an error occured.
+ */
+extern char*    bdd_cnf_count(bddCnf *cnf, int firstvar, int flags);
+
+/* In file reorder.c */
+
+/**
+ * \ingroup reorder
+ * \brief Swap two bdd variables.
+ *
+ * Use ::bdd_swapvar to swap the position (in the current variable order) of the two BDD
+ * variables \a v1 and \a v2. There are no constraints on the position of the two variables
+ * before the call. This function may \em not be used together with user defined variable
+ * blocks. The swap is done by a series of adjacent variable swaps and requires the whole node
+ * table to be rehashed twice for each call to ::bdd_swapvar. It should therefore not be used
+ * were efficiency is a major concern.
+ * 
+ * \return Zero on success and a negative error code otherwise.
+ * \see bdd_reorder, bdd_addvarblock
+ */
+extern int      bdd_swapvar(int v1, int v2);
+
+
+/**
+ * \ingroup reorder
+ * \brief Default reorder handler.
+ * 
+ * The default reorder handler prints information about the 
+ * reorder process to \c stdout if \c bdd_reorder_verbose(1) has been
+ * called previously.
+ * 
+ * The information printed includes a message before the reorder runs and 
+ * a message after it has run, indicating how many nodes were in use before and after
+ * the reorder as well as how long (in seconds) it took to run the reorder.
+ * 
+ * \see bdd_reorder_hook
+ */
+extern void     bdd_default_reohandler(int prestate);
+
+
+/**
+ * \ingroup reorder
+ * \brief Start dynamic reordering.
+ *
+ * This function initiates dynamic reordering using the heuristic defined by \a method,
+ * which may be one of the following:
+ * - \a BDD_REORDER_WIN2 \n
+ *   Reordering using a sliding window of size 2. This algorithm swaps two adjacent variable
+ *   blocks and if this results in more nodes then the two blocks are swapped back again.
+ *   Otherwise the result is kept in the variable order. This is then repeated for all variable
+ *   blocks. 
+ * - \a BDD_REORDER_WIN2ITE \n
+ *   The same as above but the process is repeated until
+ *   no further progress is done. Usually a fast and efficient method. 
+ * - \a BDD_REORDER_WIN3 \n
+ *   The same as above but with a window size of 3. 
+ * - \a BDD_REORDER_WIN2ITE \n
+ *   The same as above but with a window size of 3. 
+ * - \a BDD_REORDER_SIFT \n 
+ *   Reordering where each block is moved through all possible positions.
+ *   The best of these is then used as the new position. Potentially a very slow but good method.
+ * - \a BDD_REORDER_SIFTITE \n
+ *   The same as above but the process is repeated until no
+ *   further progress is done. Can be extremely slow.
+ * - \a BDD_REORDER_RANDOM \n
+ *   Mostly used for debugging purpose, but may be usefull for others. Selects a random position for
+ *   each variable.
+ * - \a BDD_REORDER_SIFT_SYM \n
+ *   Sifting where adjacent single variable blocks that are found to be symmetric are joined
+ *   into groups and moved as one unit. Symmetries are detected both before and during sifting.
+ * - \a BDD_REORDER_SIFT_SYMITE \n
+ *   The same as above but the process is repeated until no further progress is done.
+ * - \a BDD_REORDER_WIN4 \n
+ *   Reordering using a sliding window of size 4. All permutations of the blocks in the
+ *   window are tried by swapping adjacent blocks and the best of them is kept.
+ * - \a BDD_REORDER_WINK \n
+ *   The same as above but with the window size set by ::bdd_reorder_window.
+ * - \a BDD_REORDER_EXACT \n
+ *   Finds an order of the blocks with the fewest nodes by dynamic programming over sets of
+ *   blocks, skipping sets that cannot improve the current order. The result is only kept
+ *   if the reordering probe agrees. Very slow for more than a few blocks, so lists with
+ *   more blocks than the limit set by ::bdd_reorder_exactlimit are sifted instead.
+ * - \a BDD_REORDER_ANNEAL \n
+ *   Simulated annealing where random swaps of adjacent blocks are kept if they help, and
+ *   with a probability that falls with the temperature if they don't. The schedule is set
+ *   by ::bdd_reorder_anneal and the best order seen is used. Meant for long batch runs.
+ * - \a BDD_REORDER_GENETIC \n
+ *   A genetic search over block orders with the population set by ::bdd_reorder_genetic.
+ *   The best order found is used. Meant for long batch runs.
+ * 
+ * \see bdd_autoreorder, bdd_reorder_verbose, bdd_addvarblock, bdd_clrvarblocks
+ */
+extern void     bdd_reorder(int method);
+
+
+/**
+ * \ingroup reorder
+ * \brief Calculate the gain in size after a reordering.
+ *
+ * Returns the gain in percent of the previous number of used nodes. The value returned is 
+ * \f[ (100 * (A - B)) / A \f] 
+ * Where \f$A\f$ is previous number of used nodes and \f$B\f$ is current number of used
+ * nodes.
+ * 
+ */
+extern int      bdd_reorder_gain(void);
+
+
+/**
+ * \ingroup reorder
+ * \brief Define a handler for minimization of bdds.
+ *
+ * Reordering is typically done to minimize the global number of BDD nodes in use, but it may in
+ * some cases be usefull to minimize with respect to a specific BDD. With ::bdd_reorder_probe
+ * it is possible to define a callback function that calculates the size of a specific BDD (or
+ * anything else in fact). This handler will then be called by the reordering functions to get
+ * the current size information. A typical handle could look like this: 
+ * \code 
+ * int * sizehandler(void) 
+ * { 
+ *   extern BDD mybdd; 
+ *   return bdd_nodecount(mybdd); 
+ * } 
+ * \endcode 
+ * No default handler is supplied. The argument \a handler may be \c NULL if no handler is needed.
+ * 
+ * \return The old handler.
+ * \see bdd_reorder
+ */
+extern bddsizehandler bdd_reorder_probe(bddsizehandler handler);
+
+
+/**
+ * \ingroup reorder
+ * \brief Clears all variable blocks.
+ *
+ * Clears all the variable blocks that has been defined by calls to ::bdd_addvarblock.
+ * 
+ * \see bdd_addvarblock
+ */
+extern void     bdd_clrvarblocks(void);
+
+
+/**
+ * \ingroup reorder
+ * \brief Adds a new variable block for reordering.
+ *
+ * Creates a new variable block with the variables in the variable set \a b. The variables in
+ * \a b must be contiguous. This order does
+ * not depend on current variable order. The variable blocks are ordered as a tree, with the
+ * largest ranges at top and the smallest at the bottom. 
+ * 
+ * Example: Assume the block 0-9 is added
+ * as the first block and then the block 0-6. This yields the 0-9 block at the top, with the 0-6
+ * block as a child. If now the block 2-4 was added, it would become a child of the 0-6 block. A
+ * block of 0-8 would be a child of the 0-9 block and have the 0-6 block as a child. 
+ * 
+ * Partially
+ * overlapping blocks are not allowed. The \a fixed parameter sets the block to be fixed (no
+ * reordering of its child blocks is allowed) or free, using the constants 
+ * \c BDD_REORDER_FIXED and \c BDD_REORDER_FREE. Reordering is always done on the top most
+ * blocks first and then recursively downwards. The return value is an integer that can be used
+ * to identify the block later on - with for example ::bdd_blockfile_hook. The values
+ * returned will be in the sequence \f$0,1,2,3,\ldots\f$.
+ * 
+ * \return A non-negative identifier on success, otherwise a negative error code.
+ * \see bdd_varblockall, fdd_intaddvarblock, bdd_clrvarblocks
+ */
+extern int      bdd_addvarblock(BDD b, int fixed);
+
+
+/**
+ * \ingroup reorder
+ * \brief Adds a new variable block for reordering.
+ *
+ * Creates a new variable block, where the argument \a first is the first variable
+ * included in the block and \a last is the last variable included in the block. This order does
+ * not depend on current variable order. The variable blocks are ordered as a tree, with the
+ * largest ranges at top and the smallest at the bottom. 
+ * 
+ * Example: Assume the block 0-9 is added
+ * as the first block and then the block 0-6. This yields the 0-9 block at the top, with the 0-6
+ * block as a child. If now the block 2-4 was added, it would become a child of the 0-6 block. A
+ * block of 0-8 would be a child of the 0-9 block and have the 0-6 block as a child. 
+ * 
+ * Partially
+ * overlapping blocks are not allowed. The \a fixed parameter sets the block to be fixed (no
+ * reordering of its child blocks is allowed) or free, using the constants \a
+ * BDD_REORDER_FIXED and \a BDD_REORDER_FREE. Reordering is always done on the top most
+ * blocks first and then recursively downwards. The return value is an integer that can be used
+ * to identify the block later on - with for example ::bdd_blockfile_hook. The values
+ * returned will be in the sequence \f$0,1,2,3,\ldots\f$.
+ * 
+ * \return A non-negative identifier on success, otherwise a negative error code.
+ * \see bdd_varblockall, fdd_intaddvarblock, bdd_clrvarblocks
+ */
+extern int      bdd_intaddvarblock(int first, int last, int fixed);
+
+
+/**
+ * \ingroup reorder
+ * \brief Add a variable block for all variables.
  *
  * Adds a variable block for all BDD variables declared so far. Each block contains one
  * variable only. More variable blocks can be added later with the use of ::bdd_addvarblock --
@@ -1841,9 +2849,11 @@ extern bddfilehandler bdd_blockfile_hook(bddfilehandler handler);
  *
  * Enables automatic reordering using \a method as the reordering method. If \a method is 
  * \c BDD_REORDER_NONE then automatic reordering is disabled. Automatic reordering is done
- * every time the number of active nodes in the node table has been doubled and works by
+ * when the policy set by ::bdd_reorder_trigger says so, by default every time the number of
+ * active nodes in the node table has been doubled, and works by
  * interrupting the current BDD operation, doing the reordering and the retrying the
- * operation. Values for \a method can be found under ::bdd_reorder.
+ * operation. Some operations can instead continue under the new order, see
+ * ::bdd_reorder_resume. Values for \a method can be found under ::bdd_reorder.
  * 
  * \return Returns the old value of \a method.
  * \see bdd_reorder
@@ -1857,18 +2867,91 @@ extern int      bdd_autoreorder(int method);
  *
  * Enables automatic reordering using \a method as the reordering method. If \a method is 
  * \c BDD_REORDER_NONE then automatic reordering is disabled. Automatic reordering is done
- * every time the number of active nodes in the node table has been doubled and works by
+ * when the policy set by ::bdd_reorder_trigger says so, by default every time the number of
+ * active nodes in the node table has been doubled, and works by
  * interrupting the current BDD operation, doing the reordering and the retrying the
- * operation. In this form the argument \a num specifies the allowed number of
- * reorderings. So if for example a "one shot" reordering is needed, then the \a num argument
+ * operation, or continuing it as described under ::bdd_reorder_resume. In this form the
+ * argument \a num specifies the allowed number of reorderings. So if for example a "one shot" reordering is needed, then the \a num argument
  * would be set to one. Values for \a method can be found under ::bdd_reorder.
  * 
  * \return Returns the old value of \a method.
- * \see bdd_reorder
+ * \see bdd_reorder, bdd_reorder_trigger
  */
 extern int      bdd_autoreorder_times(int method, int num);
 
 
+/**
+ * \ingroup reorder
+ * \brief Select when automatic reordering is done.
+ *
+ * Sets the policy used to decide when automatic reordering is done. The number of live
+ * nodes is checked each time a garbage collection is forced by a full node table.
+ * Values for \a policy are:
+ * - \a BDD_TRIGGER_DOUBLE \n
+ *   Reorder when twice as many nodes are live as after the last reordering. If the last
+ *   reordering gained less than 20% then wait for up to twice as many again. This is the
+ *   default.
+ * - \a BDD_TRIGGER_GROWTH \n
+ *   Reorder when the live nodes have grown by the percentage set with
+ *   ::bdd_reorder_triggergrowth since the last reordering.
+ * - \a BDD_TRIGGER_COST \n
+ *   As \c BDD_TRIGGER_GROWTH, but also wait until the time since the last reordering pays
+ *   for it. A reordering that took \e T milliseconds and removed \e G percent of the nodes
+ *   is not repeated before 100\e T/\e G milliseconds have passed, unless the live nodes
+ *   have grown four times the percentage.
+ * - \a BDD_TRIGGER_BACKOFF \n
+ *   As \c BDD_TRIGGER_GROWTH, but the growth needed is doubled after each reordering that
+ *   gained less than 20%, up to 256 times, and set back after one that gained more.
+ *
+ * \return The old policy or a negative error code.
+ * \see bdd_autoreorder, bdd_reorder_triggergrowth, bdd_reorder_gain
+ */
+extern int      bdd_reorder_trigger(int policy);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the growth needed for automatic reordering.
+ *
+ * Sets the growth in live nodes, in percent of the nodes left by the last reordering,
+ * needed before \c BDD_TRIGGER_GROWTH, \c BDD_TRIGGER_COST and \c BDD_TRIGGER_BACKOFF
+ * reorder again. The default is 100.
+ *
+ * \return The old growth or a negative error code.
+ * \see bdd_reorder_trigger
+ */
+extern int      bdd_reorder_triggergrowth(int percent);
+
+
+/**
+ * \ingroup reorder
+ * \brief Continue operations after automatic reordering.
+ *
+ * If \a on is nonzero then ::bdd_not, ::bdd_apply, ::bdd_ite, ::bdd_exist, ::bdd_forall,
+ * ::bdd_unique, ::bdd_appex, ::bdd_appall and ::bdd_appuni are not retried after an
+ * automatic reordering. The reordering is instead done at the next recursive call, with the
+ * results found so far kept, and the operation continues under the new order. It is still
+ * retried once if no node was free when the reordering was asked for. This keeps the
+ * partial results at the cost of slightly slower operations, and is off by default.
+ *
+ * \return The old setting.
+ * \see bdd_autoreorder, bdd_reorder_resumed
+ */
+extern int      bdd_reorder_resume(int on);
+
+
+/**
+ * \ingroup reorder
+ * \brief Number of operations continued after reordering.
+ *
+ * Returns the number of operations that continued after an automatic reordering was done
+ * inside them, as enabled by ::bdd_reorder_resume.
+ *
+ * \see bdd_reorder_resume
+ */
+extern int      bdd_reorder_resumed(void);
+
+
 /**
  * \ingroup reorder
  * \brief Fetch the level of a specific bdd variable.
@@ -1952,6 +3035,158 @@ extern void     bdd_disable_reorder(void);
 extern int      bdd_reorder_verbose(int value);
 
 
+/**
+ * \ingroup reorder
+ * \brief Reorder independent variable blocks in parallel.
+ *
+ * The subtrees of the variable block tree are reordered as independent tasks after the
+ * blocks above them have been placed. Sibling blocks cover disjoint levels, so up to \a num
+ * threads can work on them at the same time. Each task judges its moves by the nodes on its
+ * own levels and draws random numbers from its own state. For the random, annealing and
+ * genetic methods that state is seeded from the one set by ::bdd_reorder_seed, so the tasks
+ * never draw from the application's \c lrand48 stream. The result is therefore the same for
+ * any \a num of two or more, also when the library is built without thread support. With
+ * the default of zero, or with one, the blocks are reordered one after the other as without
+ * this function. Tasks are only used with the default reordering probe.
+ *
+ * \return The old number of threads or a negative error code.
+ * \see bdd_reorder, bdd_addvarblock, bdd_reorder_probe, bdd_reorder_seed
+ */
+extern int      bdd_reorder_threads(int num);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the window size for window reordering.
+ *
+ * Sets the number of blocks \a size that are permuted together by
+ * \c BDD_REORDER_WINK. A window of size \a size tries \a size! orders at each
+ * position. The default is 4.
+ *
+ * \return The old window size or a negative error code.
+ * \see bdd_reorder
+ */
+extern int      bdd_reorder_window(int size);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the max. number of blocks for exact reordering.
+ *
+ * \c BDD_REORDER_EXACT is only used on block lists with at most \a num blocks, and
+ * longer lists are sifted instead. Time and memory grow with 2^\a num, so at most 20
+ * blocks are allowed. The default is 12.
+ *
+ * \return The old limit or a negative error code.
+ * \see bdd_reorder
+ */
+extern int      bdd_reorder_exactlimit(int num);
+
+
+/**
+ * \ingroup reorder
+ * \brief Limit the number of swaps in a reordering.
+ *
+ * Sifting stops when \a num adjacent variable swaps have been done in one call to
+ * ::bdd_reorder. The block being moved is still put back at the best position found, and
+ * the remaining blocks are left where they are. Zero means no limit, which is the
+ * default. With parallel reordering the limit is shared by all threads, so the result
+ * may then depend on the scheduling.
+ *
+ * \return The old limit or a negative error code.
+ * \see bdd_reorder_maxtime, bdd_reorder_maxgrowth, bdd_sift_hook
+ */
+extern int      bdd_reorder_maxswaps(int num);
+
+
+/**
+ * \ingroup reorder
+ * \brief Limit the time used for a reordering.
+ *
+ * Sifting stops when \a msec milliseconds of wall time have passed in one call to
+ * ::bdd_reorder, in the same way as for ::bdd_reorder_maxswaps. Zero means no limit,
+ * which is the default.
+ *
+ * \return The old limit or a negative error code.
+ * \see bdd_reorder_maxswaps, bdd_reorder_maxgrowth
+ */
+extern int      bdd_reorder_maxtime(int msec);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the max. growth allowed while sifting.
+ *
+ * A block is moved no further in one direction once the number of nodes is more than
+ * \a percent percent above the smallest size seen for that block. Moving also stops when
+ * a lower bound on the size shows that the rest of that direction can't improve on the
+ * best size. The default is 20.
+ *
+ * \return The old growth limit or a negative error code.
+ * \see bdd_reorder_maxswaps, bdd_reorder_maxtime
+ */
+extern int      bdd_reorder_maxgrowth(int percent);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set a handler for sifting statistics.
+ *
+ * After each block has been sifted the handler \a handler is called with the statistics
+ * for that block. This makes it possible to log how much each block costs and to tune
+ * the budgets set by ::bdd_reorder_maxswaps, ::bdd_reorder_maxtime and
+ * ::bdd_reorder_maxgrowth. The handler is called during reordering and must not use
+ * any bdd operations. With parallel reordering the calls come from several threads,
+ * one at a time. The default is no handler.
+ *
+ * \return The previous handler.
+ * \see bdd_reorder, bdd_reorder_verbose
+ */
+extern bddsifthandler bdd_sift_hook(bddsifthandler handler);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the schedule for annealing.
+ *
+ * \c BDD_REORDER_ANNEAL runs \a rounds rounds of \a steps random swaps of adjacent blocks,
+ * or four swaps per block if \a steps is zero. A swap that adds \e d nodes is kept with
+ * probability exp(-\e d/\e T). The temperature \e T starts at \a start times the number of
+ * nodes and is multiplied by \a cooling after each round. The defaults are 0.05, 0.9, 50
+ * and 0. The budgets set by ::bdd_reorder_maxswaps and ::bdd_reorder_maxtime also apply.
+ *
+ * \return Zero on success or a negative error code.
+ * \see bdd_reorder, bdd_reorder_seed
+ */
+extern int      bdd_reorder_anneal(double start, double cooling, int rounds, int steps);
+
+
+/**
+ * \ingroup reorder
+ * \brief Set the population for genetic reordering.
+ *
+ * \c BDD_REORDER_GENETIC keeps \a population block orders, starting with the current one,
+ * and runs for \a generations generations. Each generation adds as many children made by
+ * crossover and mutation and keeps the best half. The defaults are 20 and 30.
+ *
+ * \return Zero on success or a negative error code.
+ * \see bdd_reorder, bdd_reorder_seed
+ */
+extern int      bdd_reorder_genetic(int population, int generations);
+
+
+/**
+ * \ingroup reorder
+ * \brief Seed the random numbers for annealing and genetic reordering.
+ *
+ * The stochastic reordering methods use their own random numbers, so the same seed and
+ * the same bdds give the same order. The default seed is zero.
+ *
+ * \see bdd_reorder_anneal, bdd_reorder_genetic
+ */
+extern void     bdd_reorder_seed(long seed);
+
+
 /**
  * \ingroup reorder
  * \brief Set a specific variable order.
@@ -2004,6 +3239,85 @@ extern void     bdd_printorder(void);
  */
 extern void     bdd_fprintorder(FILE *ofile);
 
+
+/**
+ * \ingroup reorder
+ * \brief Saves the variable order to a file specified by filename.
+ *
+ * Saves the current variable order and variable blocks to the file named \a fname, which
+ * will be truncated and opened for writing. The file can be read again by
+ * ::bdd_fnloadorder.
+ *
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ * \see bdd_saveorder, bdd_fnloadorder, bdd_reorder_bestfile
+ */
+extern int      bdd_fnsaveorder(char *fname);
+
+
+/**
+ * \ingroup reorder
+ * \brief Saves the variable order to a file.
+ *
+ * Saves the current variable order and variable blocks to the file \a ofile which must be
+ * opened for writing. The format consists of integers. First the number of variables \f$V\f$
+ * and the number of blocks \f$B\f$, then the \f$V\f$ variables in the order from the top
+ * level and down. Then follows the number of blocks on the top most level and the \f$B\f$
+ * blocks as sets of 5 integers: the first and last variable, the fixed flag, the block id and
+ * the number of blocks on the next level inside this block. These inner blocks follow
+ * immediately after the block itself.
+ *
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ * \see bdd_fnsaveorder, bdd_loadorder
+ */
+extern int      bdd_saveorder(FILE *ofile);
+
+
+/**
+ * \ingroup reorder
+ * \brief Loads a variable order from a file specified by filename.
+ *
+ * Loads a variable order and variable blocks saved by ::bdd_fnsaveorder from the file named
+ * \a fname. See ::bdd_loadorder for how it is applied.
+ *
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ * \see bdd_loadorder, bdd_fnsaveorder
+ */
+extern int      bdd_fnloadorder(char *fname);
+
+
+/**
+ * \ingroup reorder
+ * \brief Loads a variable order from a file.
+ *
+ * Loads a variable order and variable blocks saved by ::bdd_saveorder from the file \a ifile
+ * which must be opened for reading. If all the variables in the file have been defined then
+ * the order is applied at once, otherwise it is applied by the call to ::bdd_setvarnum or
+ * ::bdd_extvarnum that defines the last of them. Applying the order replaces all variable
+ * blocks with those from the file. Variables that are not in the file are placed below the
+ * others in their current order. Loading a new order replaces one that is waiting to be
+ * applied.
+ *
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ * \see bdd_fnloadorder, bdd_saveorder, bdd_setvarorder
+ */
+extern int      bdd_loadorder(FILE *ifile);
+
+
+/**
+ * \ingroup reorder
+ * \brief Keep the best order found in a file.
+ *
+ * After each reordering that reduces the number of nodes, the new order is saved to the file
+ * named \a fname with ::bdd_fnsaveorder. The file is written under a temporary name and then
+ * renamed, so it always holds a complete order, and errors while writing it are ignored. A
+ * later run can start from this order with ::bdd_fnloadorder and save most of the cost of
+ * reordering. A \c NULL name stops the saving, which is the default.
+ *
+ * \return Zero on success, otherwise an error code from ::bdd.h.
+ * \see bdd_fnsaveorder, bdd_fnloadorder, bdd_autoreorder
+ */
+extern int      bdd_reorder_bestfile(char *fname);
+
 #ifdef CPLUSPLUS
 }
 #endif
@@ -2048,11 +3362,49 @@ extern const BDD bddtrue;
 #define BDD_REORDER_WIN3     5
 #define BDD_REORDER_WIN3ITE  6
 #define BDD_REORDER_RANDOM   7
+#define BDD_REORDER_SIFT_SYM    8
+#define BDD_REORDER_SIFT_SYMITE 9
+#define BDD_REORDER_EXACT    10
+#define BDD_REORDER_WIN4     11
+#define BDD_REORDER_WINK     12
+#define BDD_REORDER_ANNEAL   13
+#define BDD_REORDER_GENETIC  14
 
 #define BDD_REORDER_FREE     0
 #define BDD_REORDER_FIXED    1
 
 
+/*=== Automatic reorder triggers =======================================*/
+
+#define BDD_TRIGGER_DOUBLE   0
+#define BDD_TRIGGER_GROWTH   1
+#define BDD_TRIGGER_COST     2
+#define BDD_TRIGGER_BACKOFF  3
+
+
+/*=== Compilation orders ===============================================*/
+
+#define BDD_COMPILE_DFS      0
+#define BDD_COMPILE_BFS      1
+
+
+/*=== Stream flags =====================================================*/
+
+#define BDD_STREAM_LZ        1
+
+
+/*=== Circuit flags ====================================================*/
+
+#define BDD_CIRCUIT_ORDER    1
+#define BDD_CIRCUIT_PEAK     2
+
+
+/*=== CNF flags ========================================================*/
+
+#define BDD_CNF_MINWIDTH     1
+#define BDD_CNF_PROJECT      2
+
+
 /*=== Error codes ======================================================*/
 
 #define BDD_MEMORY (-1)   /**< Out of memory */
@@ -2173,6 +3525,17 @@ private:
    friend double   bdd_satcountset(const bdd &, const bdd &);
    friend double   bdd_satcountln(const bdd &);
    friend double   bdd_satcountlnset(const bdd &, const bdd &);
+   friend int      bdd_eval_batch(const bdd &, const uint64_t *, int,
+				  uint64_t *);
+   friend int      bdd_eval_batch(const bdd *, int, const uint64_t *, int,
+				  uint64_t *);
+   friend char*    bdd_satcount_exact(const bdd &);
+   friend char*    bdd_satcountset_exact(const bdd &, const bdd &);
+   friend bddProgram* bdd_compile(const bdd &, int);
+   friend bddProgram* bdd_acompile(const bdd *, int, int);
+   friend double   bdd_wmc(const bdd &, double *, double *);
+   friend double   bdd_wmcln(const bdd &, double *, double *);
+   friend int      bdd_wmcmarginals(const bdd &, double *, double *, double *);
    friend int      bdd_nodecount(const bdd &);
    friend int      bdd_anodecountpp(const bdd *, int);
    friend int*     bdd_varprofile(const bdd &);
@@ -2190,6 +3553,19 @@ private:
    friend int    bdd_save(FILE*, const bdd &);
    friend int    bdd_fnload(char*, bdd &);
    friend int    bdd_load(FILE*, bdd &);
+   friend int    bdd_fnbinsave(char*, const bdd &);
+   friend int    bdd_binsave(FILE*, const bdd &);
+   friend int    bdd_fnbinload(char*, bdd &);
+   friend int    bdd_binload(FILE*, bdd &);
+   friend int    bdd_save_named(FILE*, const bdd *, char **, int);
+   friend int    bdd_load_named(FILE*, bdd **, char ***, int *);
+   friend int    bdd_stream_add(bddStream*, const bdd &);
+   friend int    bdd_stream_load(FILE*, int, bdd &);
+   friend int    bdd_stream_fnload(char*, int, bdd &);
+   friend int    bdd_circuit_build(bddCircuit*, int, int, bdd *,
+				   bddCircuitStat*);
+   friend int    bdd_cnf_build(bddCnf*, int, int, bdd &);
+   friend int    bdd_program_import(bddProgram*, int, bdd &);
    
    friend bdd    fdd_ithvarpp(int, int);
    friend bdd    fdd_ithsetpp(int);
@@ -2205,6 +3581,7 @@ private:
    friend int    bdd_addvarblock(const bdd &, int);
 
    friend class bvec;
+   friend class bdd_cubes;
    friend bvec bvec_ite(const bdd& a, const bvec& b, const bvec& c);
    friend bvec bvec_shlfixed(const bvec &e, int pos, const bdd &c);
    friend bvec bvec_shl(const bvec &left, const bvec &right, const bdd &c);
@@ -2350,6 +3727,32 @@ inline double bdd_satcountln(const bdd &r)
 inline double bdd_satcountlnset(const bdd &r, const bdd &varset)
 { return bdd_satcountlnset(r.root, varset.root); }
 
+inline int bdd_eval_batch(const bdd &r, const uint64_t *in, int words,
+			  uint64_t *out)
+{ return bdd_eval_batch((BDD*)&r.root, 1, in, words, out); }
+
+extern int bdd_eval_batch(const bdd *, int, const uint64_t *, int, uint64_t *);
+
+inline char* bdd_satcount_exact(const bdd &r)
+{ return bdd_satcount_exact(r.root); }
+
+inline char* bdd_satcountset_exact(const bdd &r, const bdd &varset)
+{ return bdd_satcountset_exact(r.root, varset.root); }
+
+inline bddProgram* bdd_compile(const bdd &r, int order)
+{ return bdd_compile(r.root, order); }
+
+extern bddProgram* bdd_acompile(const bdd *, int, int);
+
+inline double bdd_wmc(const bdd &r, double *pos, double *neg)
+{ return bdd_wmc(r.root, pos, neg); }
+
+inline double bdd_wmcln(const bdd &r, double *pos, double *neg)
+{ return bdd_wmcln(r.root, pos, neg); }
+
+inline int bdd_wmcmarginals(const bdd &r, double *pos, double *neg, double *m)
+{ return bdd_wmcmarginals(r.root, pos, neg, m); }
+
 inline int bdd_nodecount(const bdd &r)
 { return bdd_nodecount(r.root); }
 
@@ -2395,6 +3798,41 @@ inline int bdd_fnload(char *fname, bdd &r)
 inline int bdd_load(FILE *ifile, bdd &r)
 { int lr,e; e=bdd_load(ifile, &lr); r=bdd(lr); return e; }
 
+inline int bdd_fnbinsave(char *fname, const bdd &r)
+{ return bdd_fnbinsave(fname, r.root); }
+
+inline int bdd_binsave(FILE *ofile, const bdd &r)
+{ return bdd_binsave(ofile, r.root); }
+
+inline int bdd_fnbinload(char *fname, bdd &r)
+{ int lr,e; e=bdd_fnbinload(fname, &lr); r=bdd(lr); return e; }
+
+inline int bdd_binload(FILE *ifile, bdd &r)
+{ int lr,e; e=bdd_binload(ifile, &lr); r=bdd(lr); return e; }
+
+inline int bdd_stream_add(bddStream *s, const bdd &r)
+{ return bdd_stream_add(s, r.root); }
+
+inline int bdd_stream_load(FILE *ifile, int root, bdd &r)
+{ int lr,e; e=bdd_stream_load(ifile, root, &lr); r=bdd(lr); return e; }
+
+inline int bdd_stream_fnload(char *fname, int root, bdd &r)
+{ int lr,e; e=bdd_stream_fnload(fname, root, &lr); r=bdd(lr); return e; }
+
+inline int bdd_cnf_build(bddCnf *cnf, int firstvar, int flags, bdd &r)
+{ int lr,e; e=bdd_cnf_build(cnf, firstvar, flags, &lr); r=bdd(lr); return e; }
+
+inline int bdd_program_import(bddProgram *p, int root, bdd &r)
+{ int lr,e; e=bdd_program_import(p, root, &lr); r=bdd(lr); return e; }
+
+extern int bdd_save_many(FILE *, const bdd *, int);
+extern int bdd_save_named(FILE *, const bdd *, char **, int);
+extern int bdd_fnsave_named(char *, const bdd *, char **, int);
+extern int bdd_load_many(FILE *, bdd **, int *);
+extern int bdd_load_named(FILE *, bdd **, char ***, int *);
+extern int bdd_fnload_named(char *, bdd **, char ***, int *);
+extern int bdd_circuit_build(bddCircuit *, int, int, bdd *, bddCircuitStat *);
+
 inline int bdd_addvarblock(const bdd &v, int f)
 { return bdd_addvarblock(v.root, f); }
 
@@ -2469,6 +3907,52 @@ inline bdd bdd_false(void)
 { return 0; }
 
 
+/*=== Cube iteration ===================================================*/
+
+/**
+ * Range of all satisfying variable assignments of a bdd, for use with
+ * range based for loops. Each element is a cube of ::bdd_varnum entries
+ * coded as for ::bdd_allsat. The cubes are fetched in batches through
+ * ::bdd_cube_iter_next and only remain valid until the iterator is advanced.
+ */
+class bdd_cubes
+{
+ public:
+   class iterator
+   {
+    public:
+      const char *operator*(void) const { return cube; }
+      iterator &operator++(void) { cube=owner->fetch(); return *this; }
+      int operator==(const iterator &i) const { return cube==i.cube; }
+      int operator!=(const iterator &i) const { return cube!=i.cube; }
+    private:
+      iterator(bdd_cubes *o, const char *c) { owner=o; cube=c; }
+      bdd_cubes *owner;
+      const char *cube;
+
+      friend class bdd_cubes;
+   };
+
+   bdd_cubes(const bdd &r, int batch=64);
+   ~bdd_cubes(void);
+
+   iterator begin(void);
+   iterator end(void) { return iterator(this,NULL); }
+
+private:
+   bdd_cubes(const bdd_cubes &);
+   bdd_cubes &operator=(const bdd_cubes &);
+   const char *fetch(void);
+
+   bdd root;
+   int batchsize;
+   bddCubeIter *iter;
+   char *cubes;
+   int cubenum;
+   int pos;
+};
+
+
 /*=== Iostream printing ================================================*/
 
 class bdd_ioformat
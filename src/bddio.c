@@ -42,25 +42,25 @@
 #include <assert.h>
 #include <sys/stat.h>
 #include "kernel.h"
+#include "printer.h"
 
-static void bdd_printset_rec(FILE *, int, int *);
-static void bdd_fprintdot_rec(FILE*, BDD);
+static void printer_fileinit(BddPrinter *, FILE *);
 static int  bdd_save_rec(FILE*, int);
-static int  bdd_loaddata(FILE *);
-static int  loadhash_get(int);
-static void loadhash_add(int, int);
+static int  bdd_loaddata(FILE *, int);
+static int  loadmap_add(int, int);
+static int  loadmap_get(int);
 
 static bddfilehandler filehandler;
 
-typedef struct s_LoadHash
+typedef struct s_LoadMap
 {
    int key;
    int data;
-   int first;
    int next;
-} LoadHash;
+} LoadMap;
 
-static LoadHash *lh_table;
+static LoadMap  *lh_table;
+static int      *lh_first;
 static int       lh_freepos;
 static int       lh_nodenum;
 static int      *loadvar2level;
@@ -76,6 +76,22 @@ bddfilehandler bdd_file_hook(bddfilehandler handler)
 }
 
 
+static void printer_filename(BddPrinter *p, int var)
+{
+   filehandler((FILE*)p->data, var);
+}
+
+
+   /* Sets up a printer for 'ofile' that names variables with the file
+    * handler */
+static void printer_fileinit(BddPrinter *p, FILE *ofile)
+{
+   BddPrinter_init(p, BddPrinter_filesink, ofile);
+   if (filehandler)
+      p->varname = printer_filename;
+}
+
+
 void bdd_printall(void)
 {
    bdd_fprintall(stdout);
@@ -84,23 +100,10 @@ void bdd_printall(void)
 
 void bdd_fprintall(FILE *ofile)
 {
-   int n;
-   
-   for (n=0 ; n<bddnodesize ; n++)
-   {
-      if (LOW(n) != -1)
-      {
-	 fprintf(ofile, "[%5d - %2d] ", n, bddnodes[n].refcou);
-	 if (filehandler)
-	    filehandler(ofile, bddlevel2var[LEVEL(n)]);
-	 else
-	    fprintf(ofile, "%3d", bddlevel2var[LEVEL(n)]);
-
-	 fprintf(ofile, ": %3d", LOW(n));
-	 fprintf(ofile, " %3d", HIGH(n));
-	 fprintf(ofile, "\n");
-      }
-   }
+   BddPrinter p;
+
+   printer_fileinit(&p, ofile);
+   BddPrinter_all(&p);
 }
 
 
@@ -112,34 +115,10 @@ void bdd_printtable(BDD r)
 
 void bdd_fprinttable(FILE *ofile, BDD r)
 {
-   BddNode *node;
-   int n;
-   
-   fprintf(ofile, "ROOT: %d\n", r);
-   if (r < 2)
-      return;
+   BddPrinter p;
 
-   bdd_mark(r);
-   
-   for (n=0 ; n<bddnodesize ; n++)
-   {
-      if (LEVEL(n) & MARKON)
-      {
-	 node = &bddnodes[n];
-	 
-	 LEVELp(node) &= MARKOFF;
-
-	 fprintf(ofile, "[%5d] ", n);
-	 if (filehandler)
-	    filehandler(ofile, bddlevel2var[LEVELp(node)]);
-	 else
-	    fprintf(ofile, "%3d", bddlevel2var[LEVELp(node)]);
-
-	 fprintf(ofile, ": %3d", LOWp(node));
-	 fprintf(ofile, " %3d", HIGHp(node));
-	 fprintf(ofile, "\n");
-      }
-   }
+   printer_fileinit(&p, ofile);
+   BddPrinter_table(&p, r);
 }
 
 
@@ -151,66 +130,10 @@ void bdd_printset(BDD r)
 
 void bdd_fprintset(FILE *ofile, BDD r)
 {
-   int *set;
-   
-   if (r < 2)
-   {
-      fprintf(ofile, "%s", r == 0 ? "F" : "T");
-      return;
-   }
-
-   if ((set=(int *)malloc(sizeof(int)*bddvarnum)) == NULL)
-   {
-      bdd_error(BDD_MEMORY);
-      return;
-   }
-   
-   memset(set, 0, sizeof(int) * bddvarnum);
-   bdd_printset_rec(ofile, r, set);
-   free(set);
-}
-
-
-static void bdd_printset_rec(FILE *ofile, int r, int *set)
-{
-   int n;
-   int first;
-   
-   if (r == 0)
-      return;
-   else
-   if (r == 1)
-   {
-      fprintf(ofile, "<");
-      first = 1;
-      
-      for (n=0 ; n<bddvarnum ; n++)
-      {
-	 if (set[n] > 0)
-	 {
-	    if (!first)
-	       fprintf(ofile, ", ");
-	    first = 0;
-	    if (filehandler)
-	       filehandler(ofile, bddlevel2var[n]);
-	    else
-	       fprintf(ofile, "%d", bddlevel2var[n]);
-	    fprintf(ofile, ":%d", (set[n]==2 ? 1 : 0));
-	 }
-      }
+   BddPrinter p;
 
-      fprintf(ofile, ">");
-   }
-   else
-   {
-      set[LEVEL(r)] = 1;
-      bdd_printset_rec(ofile, LOW(r), set);
-      
-      set[LEVEL(r)] = 2;
-      bdd_printset_rec(ofile, HIGH(r), set);
-      
-      set[LEVEL(r)] = 0;
-   }
+   printer_fileinit(&p, ofile);
+   BddPrinter_set(&p, r);
 }
 
 
@@ -233,37 +156,10 @@ int bdd_fnprintdot(char *fname, BDD r)
 
 void bdd_fprintdot(FILE* ofile, BDD r)
 {
-   fprintf(ofile, "digraph G {\n");
-   fprintf(ofile, "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n");
-   fprintf(ofile, "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n");
-
-   bdd_fprintdot_rec(ofile, r);
-
-   fprintf(ofile, "}\n");
-
-   bdd_unmark(r);
-}
-
-
-static void bdd_fprintdot_rec(FILE* ofile, BDD r)
-{
-   if (ISCONST(r) || MARKED(r))
-      return;
-
-   fprintf(ofile, "%d [label=\"", r);
-   if (filehandler)
-      filehandler(ofile, bddlevel2var[LEVEL(r)]);
-   else
-      fprintf(ofile, "%d", bddlevel2var[LEVEL(r)]);
-   fprintf(ofile, "\"];\n");
+   BddPrinter p;
 
-   fprintf(ofile, "%d -> %d [style=dotted];\n", r, LOW(r));
-   fprintf(ofile, "%d -> %d [style=filled];\n", r, HIGH(r));
-
-   SETMARK(r);
-   
-   bdd_fprintdot_rec(ofile, LOW(r));
-   bdd_fprintdot_rec(ofile, HIGH(r));
+   printer_fileinit(&p, ofile);
+   BddPrinter_dot(&p, r);
 }
 
 
@@ -352,6 +248,14 @@ int bdd_fnload(char *fname, BDD *root)
 int bdd_load(FILE *ifile, BDD *root)
 {
    int n, vnum, tmproot;
+   int c;
+
+      /* Files in the binary format start with "BDDB" and are passed on
+	 to bdd_binload() */
+   if ((c=getc(ifile)) != EOF)
+      ungetc(c, ifile);
+   if (c == 'B')
+      return bdd_binload(ifile, root);
 
    if (fscanf(ifile, "%d %d", &lh_nodenum, &vnum) != 2)
       return bdd_error(BDD_FORMAT);
@@ -363,6 +267,10 @@ int bdd_load(FILE *ifile, BDD *root)
       return 0;
    }
 
+   if (lh_nodenum < 0  ||  lh_nodenum == INT_MAX  ||
+       vnum < 1  ||  vnum > MAXVAR)
+      return bdd_error(BDD_FORMAT);
+   
    if ((loadvar2level=(int*)malloc(sizeof(int)*vnum)) == NULL)
       return bdd_error(BDD_MEMORY);
    for (n=0 ; n<vnum ; n++)
@@ -371,23 +279,26 @@ int bdd_load(FILE *ifile, BDD *root)
    if (vnum > bddvarnum)
       bdd_setvarnum(vnum);
 
-   if ((lh_table=(LoadHash*)malloc(lh_nodenum*sizeof(LoadHash))) == NULL)
-      return bdd_error(BDD_MEMORY);
-   
-   for (n=0 ; n<lh_nodenum ; n++)
+   lh_table = NEW(LoadMap,lh_nodenum+1);
+   lh_first = NEW(int,lh_nodenum+1);
+   if (lh_table == NULL  ||  lh_first == NULL)
    {
-      lh_table[n].first = -1;
-      lh_table[n].next = n+1;
+      free(lh_table);
+      free(lh_first);
+      free(loadvar2level);
+      return bdd_error(BDD_MEMORY);
    }
-   lh_table[lh_nodenum-1].next = -1;
+   for (n=0 ; n<=lh_nodenum ; n++)
+      lh_first[n] = -1;
    lh_freepos = 0;
+   
+   tmproot = bdd_loaddata(ifile, vnum);
 
-   tmproot = bdd_loaddata(ifile);
-
-   for (n=0 ; n<lh_nodenum ; n++)
+   for (n=0 ; n<lh_freepos ; n++)
       bdd_delref(lh_table[n].data);
    
    free(lh_table);
+   free(lh_first);
    free(loadvar2level);
    
    *root = 0;
@@ -400,56 +311,132 @@ int bdd_load(FILE *ifile, BDD *root)
 }
 
 
-static int bdd_loaddata(FILE *ifile)
+/* The nodes are made directly with bdd_makenode() when the variables
+   have the same relative order as when they were saved. Otherwise they
+   are rebuilt with bdd_ite() under the current order.
+*/
+static int bdd_loaddata(FILE *ifile, int vnum)
 {
    int key,var,low,high,root=0,n;
+   int direct = bdd_sameorder(loadvar2level, vnum);
+
+   if (direct)
+      bdd_disable_reorder();
    
    for (n=0 ; n<lh_nodenum ; n++)
    {
       if (fscanf(ifile,"%d %d %d %d", &key, &var, &low, &high) != 4)
-	 return bdd_error(BDD_FORMAT);
-
-      if (low >= 2)
-	 low = loadhash_get(low);
-      if (high >= 2)
-	 high = loadhash_get(high);
+      {
+	 root = bdd_error(BDD_FORMAT);
+	 break;
+      }
 
-      if (low<0 || high<0 || var<0)
-	 return bdd_error(BDD_FORMAT);
+      low = loadmap_get(low);
+      high = loadmap_get(high);
 
-      root = bdd_addref( bdd_ite(bdd_ithvar(var), high, low) );
+      if (low<0 || high<0 || var<0 || var>=vnum || key<2 ||
+	  (direct  &&  (LEVEL(low) <= bddvar2level[var]  ||
+			LEVEL(high) <= bddvar2level[var])))
+      {
+	 root = bdd_error(BDD_FORMAT);
+	 break;
+      }
 
-      loadhash_add(key, root);
+      if (direct)
+	 root = bdd_addref( bdd_makenode(bddvar2level[var], low, high) );
+      else
+	 root = bdd_addref( bdd_ite(bdd_ithvar(var), high, low) );
+      
+      if (bdderrorcond)
+      {
+	 root = -bdderrorcond;
+	 break;
+      }
+      if ((root=loadmap_add(key, root)) < 0)
+	 break;
    }
 
+   if (direct)
+      bdd_enable_reorder();
+   
    return root;
 }
 
 
-static void loadhash_add(int key, int data)
+/* Check whether the variables saved with 'var2level' still have the same
+   relative order. All the 'num' variables must be defined.
+*/
+int bdd_sameorder(int *var2level, int num)
 {
-   int hash = key % lh_nodenum;
-   int pos = lh_freepos;
+   int *level2var;
+   int n, last = -1, res = 1;
 
-   lh_freepos = lh_table[pos].next;
-   lh_table[pos].next = lh_table[hash].first;
-   lh_table[hash].first = pos;
+   if ((level2var=NEW(int,num)) == NULL)
+      return 0;
+   for (n=0 ; n<num ; n++)
+      level2var[n] = -1;
+   
+   for (n=0 ; n<num ; n++)
+   {
+      if (var2level[n] < 0  ||  var2level[n] >= num  ||
+	  level2var[var2level[n]] >= 0)
+      {
+	 free(level2var);
+	 return 0;
+      }
+      level2var[var2level[n]] = n;
+   }
 
-   lh_table[pos].key = key;
-   lh_table[pos].data = data;
+   for (n=0 ; n<num  &&  res ; n++)
+   {
+      if (bddvar2level[level2var[n]] <= last)
+	 res = 0;
+      last = bddvar2level[level2var[n]];
+   }
+
+   free(level2var);
+   return res;
 }
 
 
-static int loadhash_get(int key)
+/* Node numbers from the file are mapped to the new nodes through a hash
+   table with one entry per node in the file. The numbers are indices in
+   the node table they were saved from, so they may be large and sparse.
+*/
+static int loadmap_add(int key, int data)
 {
-   int hash = lh_table[key % lh_nodenum].first;
+   int hash = key % (lh_nodenum+1);
+   int pos;
+
+   for (pos=lh_first[hash] ; pos != -1 ; pos=lh_table[pos].next)
+      if (lh_table[pos].key == key)
+      {
+	 bdd_delref(lh_table[pos].data);
+	 lh_table[pos].data = data;
+	 return data;
+      }
+   
+   pos = lh_freepos++;
+   lh_table[pos].key = key;
+   lh_table[pos].data = data;
+   lh_table[pos].next = lh_first[hash];
+   lh_first[hash] = pos;
+   return data;
+}
 
-   while (hash != -1  &&  lh_table[hash].key != key)
-      hash = lh_table[hash].next;
 
-   if (hash == -1)
-      return -1;
-   return lh_table[hash].data;
+static int loadmap_get(int key)
+{
+   int pos;
+   
+   if (key < 2)
+      return key;
+   
+   for (pos=lh_first[key % (lh_nodenum+1)] ; pos != -1 ;
+	pos=lh_table[pos].next)
+      if (lh_table[pos].key == key)
+	 return lh_table[pos].data;
+   return -1;
 }
 
 
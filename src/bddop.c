@@ -43,6 +43,7 @@
 #include "config.h"
 #include "kernel.h"
 #include "cache.h"
+#include "bignum.h"
 
    /* Hash value modifiers to distinguish between entries in misccache */
 #define CACHEID_CONSTRAIN   0x0
@@ -92,6 +93,10 @@ static int quantid;                 /* Current cache id for quantifications */
 static int *quantvarset;            /* Current variable set for quant. */
 static int quantvarsetID;           /* Current id used in quantvarset */
 static int quantlast;               /* Current last variable to be quant. */
+static int quantvarroot;            /* Variable set of the current quant. */
+static int resumeon;                /* Resume operations after reordering */
+static int resumereordered;         /* Reordered at a safe point */
+static int resumecount;             /* Number of operations resumed */
 static int replaceid;               /* Current cache id for replace */
 static int *replacepair;            /* Current replace pair */
 static int replacelast;             /* Current last var. level to replace */
@@ -114,6 +119,11 @@ static int firstReorder;            /* Used instead of local variable in order
 				       to avoid compiler warning about 'first'
 				       being clobbered by setjmp */
 
+static double* wmcpos;              /* log2 positive weights by level */
+static double* wmcneg;              /* log2 negative weights by level */
+static double* wmcsum;              /* Summed log2 weights of levels above */
+static int*    wmczero;             /* Number of zero weight levels above */
+
 static char*            allsatProfile; /* Variable profile for bdd_allsat() */
 static bddallsathandler allsatHandler; /* Callback handler for bdd_allsat() */
 
@@ -126,6 +136,11 @@ static BDD    ite_rec(BDD, BDD, BDD);
 static int    simplify_rec(BDD, BDD);
 static int    quant_rec(int);
 static int    appquant_rec(int, int);
+static BDD    not_resume(BDD);
+static BDD    apply_resume(BDD, BDD);
+static BDD    ite_resume(BDD, BDD, BDD);
+static int    quant_resume(int);
+static int    appquant_resume(int, int);
 static int    restrict_rec(int);
 static BDD    constrain_rec(BDD, BDD);
 static BDD    replace_rec(BDD);
@@ -139,10 +154,16 @@ static int    fullsatone_rec(int);
 static void   allsat_rec(BDD r);
 static double satcount_rec(int);
 static double satcountln_rec(int);
+static double log2add(double, double);
+static int    wmc_init(double*, double*);
+static void   wmc_done(void);
 static void   varprofile_rec(int);
 static double bdd_pathcount_rec(BDD);
 static int    varset2vartable(BDD);
 static int    varset2svartable(BDD);
+static void   safereorder(void);
+static void   resumerestart(void);
+static BDD    resumedone(BDD);
 
 
    /* Hashvalues */
@@ -159,12 +180,33 @@ static int    varset2svartable(BDD);
 #define PATHCOUHASH(r)       (r)
 #define APPEXHASH(l,r,op)    (PAIR(l,r))
 
+   /* Safe points for reordering inside an operation, see safereorder() */
+#define SAFEPOINT1(a) \
+   if (bddreorderpending) \
+   { PUSHREF(a); safereorder(); POPREF(1); }
+#define SAFEPOINT2(a,b) \
+   if (bddreorderpending) \
+   { PUSHREF(a); PUSHREF(b); safereorder(); POPREF(2); }
+#define SAFEPOINT3(a,b,c) \
+   if (bddreorderpending) \
+   { PUSHREF(a); PUSHREF(b); PUSHREF(c); safereorder(); POPREF(3); }
+
+   /* Start the current call over if the variables were reordered since
+      'reordered' was read, dropping the 'n' references it has pushed */
+#define CHECKRESUME(n) \
+   if (reordered != bddreordered) \
+   { POPREF(n); goto resume; }
+
 #ifndef M_LN2
 #define M_LN2 0.69314718055994530942
 #endif
 
 #define log1p(a) (log(1.0+a))
 
+   /* log2 weight of a terminal and of a node already seen in wmc_up() */
+#define WMCTERM(r) ((r) ? 0.0 : -HUGE_VAL)
+#define WMCVAL(r) ((r) < 2 ? WMCTERM(r) : val[index[r]])
+
 #define INVARSET(a) (quantvarset[a] == quantvarsetID) /* unsigned check */
 #define INSVARSET(a) (abs(quantvarset[a]) == quantvarsetID) /* signed check */
 
@@ -194,6 +236,11 @@ int bdd_operator_init(int cachesize)
 
    quantvarsetID = 0;
    quantvarset = NULL;
+   quantvarroot = 0;
+   resumeon = 0;
+   resumereordered = 0;
+   resumecount = 0;
+   appexid = -1;
    cacheratio = 0;
    supportSet = NULL;
    
@@ -231,6 +278,113 @@ void bdd_operator_reset(void)
 }
 
 
+/* Tells whether a node from a cache entry is still the same node. It
+   must not have been freed and, when 'kept' is given, it must have kept
+   its function while reordering.
+*/
+static int cache_keepnode(int n, char *kept, int keptnum)
+{
+   if (n < 2)
+      return 1;
+   if (n >= bddnodesize  ||  LOW(n) == -1)
+      return 0;
+   return kept == NULL  ||  (n < keptnum  &&  kept[n]);
+}
+
+
+static void cache_keep(char *kept, int keptnum)
+{
+   int n;
+
+   for (n=0 ; n<applycache.tablesize ; n++)
+   {
+      BddCacheData *entry = &applycache.table[n];
+
+      if (entry->a == -1)
+	 continue;
+
+	 /* Simplify depends on the variable order */
+      if ((kept != NULL  &&  entry->c == bddop_simplify)  ||
+	  !cache_keepnode(entry->a, kept, keptnum)  ||
+	  (entry->c != bddop_not  &&
+	   !cache_keepnode(entry->b, kept, keptnum))  ||
+	  !cache_keepnode(entry->r.res, kept, keptnum))
+	 entry->a = -1;
+   }
+
+   for (n=0 ; n<itecache.tablesize ; n++)
+   {
+      BddCacheData *entry = &itecache.table[n];
+
+      if (entry->a == -1)
+	 continue;
+
+      if (!cache_keepnode(entry->a, kept, keptnum)  ||
+	  !cache_keepnode(entry->b, kept, keptnum)  ||
+	  !cache_keepnode(entry->c, kept, keptnum)  ||
+	  !cache_keepnode(entry->r.res, kept, keptnum))
+	 entry->a = -1;
+   }
+
+      /* Quantification results are keyed by the node of the variable set.
+	 Only the ones for the quantification in progress are kept, since
+	 its variable set is on the reference stack. */
+   for (n=0 ; n<quantcache.tablesize ; n++)
+   {
+      BddCacheData *entry = &quantcache.table[n];
+
+      if (entry->a == -1)
+	 continue;
+
+      if (quantvarroot < 2  ||  entry->c != quantid  ||
+	  !cache_keepnode(entry->a, kept, keptnum)  ||
+	  !cache_keepnode(entry->r.res, kept, keptnum))
+	 entry->a = -1;
+   }
+
+   for (n=0 ; n<appexcache.tablesize ; n++)
+   {
+      BddCacheData *entry = &appexcache.table[n];
+
+      if (entry->a == -1)
+	 continue;
+
+      if (quantvarroot < 2  ||  entry->c != appexid  ||
+	  !cache_keepnode(entry->a, kept, keptnum)  ||
+	  !cache_keepnode(entry->b, kept, keptnum)  ||
+	  !cache_keepnode(entry->r.res, kept, keptnum))
+	 entry->a = -1;
+   }
+   
+   BddCache_reset(&replacecache);
+   BddCache_reset(&misccache);
+}
+
+
+/* Called after a garbage collection. Apply and ITE results only refer
+   to nodes, so they are kept as long as none of the nodes were freed.
+   The same goes for the current quantification.
+*/
+void bdd_operator_clean(void)
+{
+   cache_keep(NULL, 0);
+}
+
+
+/* Called after a reordering, before the garbage collection. The nodes
+   in 'kept' have the same function as before, so apply, ITE and current
+   quantification results made only from these are still valid.
+   Everything else is reset.
+*/
+void bdd_operator_reorder(char *kept, int keptnum)
+{
+   if (kept == NULL)
+      bdd_operator_reset();
+   else
+      cache_keep(kept, keptnum);
+}
+
+
 void bdd_operator_varresize(void)
 {
    if (quantvarset != NULL)
@@ -283,6 +437,20 @@ int bdd_setcacheratio(int r)
 }
 
 
+int bdd_reorder_resume(int on)
+{
+   int old = resumeon;
+   resumeon = (on != 0);
+   return old;
+}
+
+
+int bdd_reorder_resumed(void)
+{
+   return resumecount;
+}
+
+
 /*************************************************************************
   Operators
 *************************************************************************/
@@ -295,6 +463,87 @@ static void checkresize(void)
 }
 
 
+/* With bdd_reorder_resume(1), not, apply, ite, quantification and appex
+   use the *_resume() variants of their recursion and do not start over
+   when bdd_makenode() wants to reorder. It sets 'bddreorderpending'
+   instead and the next recursive call does the reordering with its
+   operands and all partial results on the reference stack. These are
+   made roots while the variables are moved, so they keep their function.
+   The calls that were in progress see 'bddreordered' change and start
+   over under the new order, finding most of the work in the caches.
+*/
+static void safereorder(void)
+{
+   int reordered = bddreordered;
+   int *r;
+
+   bddreorderpending = 0;
+   
+   for (r=bddrefstack ; r<bddrefstacktop ; r++)
+      bdd_addref(*r);
+   bdd_checkreorder();
+   for (r=bddrefstack ; r<bddrefstacktop ; r++)
+      bdd_delref(*r);
+
+   if (reordered != bddreordered)
+      resumereordered = 1;
+
+      /* The variable table is indexed by level. It keeps its id so the
+	 cache entries of the quantification still match */
+   if (quantvarroot > 1)
+   {
+      BDD n;
+      
+      memset(quantvarset, 0, sizeof(int)*bddvarnum);
+      for (n=quantvarroot ; n > 1 ; n=HIGH(n))
+      {
+	 quantvarset[LEVEL(n)] = quantvarsetID;
+	 quantlast = LEVEL(n);
+      }
+   }
+}
+
+
+/* Start an operation that can be resumed over, as the other operations
+   do. bdd_makenode() does this instead of waiting for a safe point when
+   no node is left, since the table would otherwise have to grow only to
+   hold partial results that the reordering then has to keep.
+*/
+static void resumerestart(void)
+{
+   bddresumable = 0;
+   bddreorderpending = 0;
+   resumereordered = 0;
+   quantvarroot = 0;
+   appexid = -1;
+   
+   bdd_checkreorder();
+}
+
+
+/* End an operation that can be resumed. A reordering asked for after the
+   last safe point is done now. The operation is counted as resumed if it
+   went on after a reordering at a safe point.
+*/
+static BDD resumedone(BDD res)
+{
+   if (resumereordered)
+      resumecount++;
+   resumereordered = 0;
+   
+   PUSHREF(res);
+   if (bddreorderpending)
+      safereorder();
+   INITREF;
+
+   bddresumable = 0;
+   quantvarroot = 0;
+   appexid = -1;
+   
+   return res;
+}
+
+
 /*=== BUILD A CUBE =====================================================*/
 
 BDD bdd_buildcube(int value, int width, BDD *variables)
@@ -356,22 +605,39 @@ BDD bdd_not(BDD r)
 {
    BDD res;
    firstReorder = 1;
+   
    CHECKa(r, bddfalse);
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = not_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 bddresumable = 1;
+	 res = resumedone(not_resume(r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = not_rec(r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
+
       if (firstReorder-- == 1)
 	 goto again;
       res = BDDZERO;  /* avoid warning about res being uninitialized */
@@ -418,6 +684,51 @@ static BDD not_rec(BDD r)
 }
 
 
+static BDD not_resume(BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+   int reordered;
+
+ resume:
+   SAFEPOINT1(r);
+   
+   if (ISZERO(r))
+      return BDDONE;
+   if (ISONE(r))
+      return BDDZERO;
+   
+   entry = BddCache_lookup(&applycache, NOTHASH(r));
+      
+   if (entry->a == r  &&  entry->c == bddop_not)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->r.res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   PUSHREF(r);
+   reordered = bddreordered;
+   
+   PUSHREF( not_resume(LOW(r)) );
+   CHECKRESUME(2);
+   PUSHREF( not_resume(HIGH(r)) );
+   CHECKRESUME(3);
+   res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+   POPREF(3);
+   
+   entry->a = r;
+   entry->c = bddop_not;
+   entry->r.res = res;
+
+   return res;
+}
+
+
 /*=== APPLY ============================================================*/
 
 BDD bdd_apply(BDD l, BDD r, int op)
@@ -434,20 +745,35 @@ BDD bdd_apply(BDD l, BDD r, int op)
       return bddfalse;
    }
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
       applyop = op;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = apply_rec(l, r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 bddresumable = 1;
+	 res = resumedone(apply_resume(l, r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = apply_rec(l, r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -562,6 +888,122 @@ static BDD apply_rec(BDD l, BDD r)
 }
 
 
+static BDD apply_resume(BDD l, BDD r)
+{
+   BddCacheData *entry;
+   BDD res;
+   int reordered;
+
+ resume:
+   SAFEPOINT2(l, r);
+   
+   switch (applyop)
+   {
+    case bddop_and:
+       if (l == r)
+	  return l;
+       if (ISZERO(l)  ||  ISZERO(r))
+	  return 0;
+       if (ISONE(l))
+	  return r;
+       if (ISONE(r))
+	  return l;
+       break;
+    case bddop_or:
+       if (l == r)
+	  return l;
+       if (ISONE(l)  ||  ISONE(r))
+	  return 1;
+       if (ISZERO(l))
+	  return r;
+       if (ISZERO(r))
+	  return l;
+       break;
+    case bddop_xor:
+       if (l == r)
+	  return 0;
+       if (ISZERO(l))
+	  return r;
+       if (ISZERO(r))
+	  return l;
+       break;
+    case bddop_nand:
+       if (ISZERO(l) || ISZERO(r))
+	  return 1;
+       break;
+    case bddop_nor:
+       if (ISONE(l)  ||  ISONE(r))
+	  return 0;
+       break;
+   case bddop_imp:
+      if (ISZERO(l))
+	 return 1;
+      if (ISONE(l))
+	 return r;
+      if (ISONE(r))
+	 return 1;
+      break;
+   }
+
+   if (ISCONST(l)  &&  ISCONST(r))
+      res = oprres[applyop][l<<1 | r];
+   else
+   {
+      entry = BddCache_lookup(&applycache, APPLYHASH(l,r,applyop));
+      
+      if (entry->a == l  &&  entry->b == r  &&  entry->c == applyop)
+      {
+#ifdef CACHESTATS
+	 bddcachestats.opHit++;
+#endif
+	 return entry->r.res;
+      }
+#ifdef CACHESTATS
+      bddcachestats.opMiss++;
+#endif
+
+      PUSHREF(l);
+      PUSHREF(r);
+      reordered = bddreordered;
+      
+      if (LEVEL(l) == LEVEL(r))
+      {
+	 PUSHREF( apply_resume(LOW(l), LOW(r)) );
+	 CHECKRESUME(3);
+	 PUSHREF( apply_resume(HIGH(l), HIGH(r)) );
+	 CHECKRESUME(4);
+	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(l) < LEVEL(r))
+      {
+	 PUSHREF( apply_resume(LOW(l), r) );
+	 CHECKRESUME(3);
+	 PUSHREF( apply_resume(HIGH(l), r) );
+	 CHECKRESUME(4);
+	 res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      }
+      else
+      {
+	 PUSHREF( apply_resume(l, LOW(r)) );
+	 CHECKRESUME(3);
+	 PUSHREF( apply_resume(l, HIGH(r)) );
+	 CHECKRESUME(4);
+	 res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      }
+
+      POPREF(4);
+
+      entry->a = l;
+      entry->b = r;
+      entry->c = applyop;
+      entry->r.res = res;
+   }
+
+   return res;
+}
+
+
 BDD bdd_and(BDD l, BDD r)
 {
    return bdd_apply(l,r,bddop_and);
@@ -603,19 +1045,34 @@ BDD bdd_ite(BDD f, BDD g, BDD h)
    CHECKa(g, bddfalse);
    CHECKa(h, bddfalse);
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
       INITREF;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = ite_rec(f,g,h);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 bddresumable = 1;
+	 res = resumedone(ite_resume(f,g,h));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = ite_rec(f,g,h);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -724,7 +1181,68 @@ static BDD ite_rec(BDD f, BDD g, BDD h)
       }
    }
 
-   POPREF(2);
+   POPREF(2);
+
+   entry->a = f;
+   entry->b = g;
+   entry->c = h;
+   entry->r.res = res;
+
+   return res;
+}
+
+
+static BDD ite_resume(BDD f, BDD g, BDD h)
+{
+   BddCacheData *entry;
+   BDD res;
+   int level, reordered;
+
+ resume:
+   SAFEPOINT3(f, g, h);
+   
+   if (ISONE(f))
+      return g;
+   if (ISZERO(f))
+      return h;
+   if (g == h)
+      return g;
+   if (ISONE(g) && ISZERO(h))
+      return f;
+   if (ISZERO(g) && ISONE(h))
+      return not_resume(f);
+
+   entry = BddCache_lookup(&itecache, ITEHASH(f,g,h));
+   if (entry->a == f  &&  entry->b == g  &&  entry->c == h)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->r.res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   PUSHREF(f);
+   PUSHREF(g);
+   PUSHREF(h);
+   reordered = bddreordered;
+
+      /* Split on the topmost variable of the three */
+   level = MIN(LEVEL(f), MIN(LEVEL(g), LEVEL(h)));
+   
+   PUSHREF( ite_resume(LEVEL(f) == level ? LOW(f) : f,
+		    LEVEL(g) == level ? LOW(g) : g,
+		    LEVEL(h) == level ? LOW(h) : h) );
+   CHECKRESUME(4);
+   PUSHREF( ite_resume(LEVEL(f) == level ? HIGH(f) : f,
+		    LEVEL(g) == level ? HIGH(g) : g,
+		    LEVEL(h) == level ? HIGH(h) : h) );
+   CHECKRESUME(5);
+   res = bdd_makenode(level, READREF(2), READREF(1));
+
+   POPREF(5);
 
    entry->a = f;
    entry->b = g;
@@ -1318,6 +1836,7 @@ BDD bdd_exist(BDD r, BDD var)
    if (var < 2)  /* Empty set */
       return r;
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -1328,14 +1847,30 @@ BDD bdd_exist(BDD r, BDD var)
       quantid = (var << 3) | CACHEID_EXIST; /* FIXME: range */
       applyop = bddop_or;
 
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(quant_resume(r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = quant_rec(r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1359,6 +1894,7 @@ BDD bdd_forall(BDD r, BDD var)
    if (var < 2)  /* Empty set */
       return r;
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -1368,15 +1904,31 @@ BDD bdd_forall(BDD r, BDD var)
       INITREF;
       quantid = (var << 3) | CACHEID_FORALL;
       applyop = bddop_and;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(quant_resume(r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = quant_rec(r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1400,6 +1952,7 @@ BDD bdd_unique(BDD r, BDD var)
    if (var < 2)  /* Empty set */
       return r;
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -1409,15 +1962,31 @@ BDD bdd_unique(BDD r, BDD var)
       INITREF;
       quantid = (var << 3) | CACHEID_UNIQUE;
       applyop = bddop_xor;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = quant_rec(r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(quant_resume(r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = quant_rec(r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1468,6 +2037,52 @@ static int quant_rec(int r)
 }
 
 
+static int quant_resume(int r)
+{
+   BddCacheData *entry;
+   int res, reordered;
+
+ resume:
+   SAFEPOINT1(r);
+   
+   if (r < 2  ||  LEVEL(r) > quantlast)
+      return r;
+
+   entry = BddCache_lookup(&quantcache, QUANTHASH(r));
+   if (entry->a == r  &&  entry->c == quantid)
+   {
+#ifdef CACHESTATS
+      bddcachestats.opHit++;
+#endif
+      return entry->r.res;
+   }
+#ifdef CACHESTATS
+   bddcachestats.opMiss++;
+#endif
+
+   PUSHREF(r);
+   reordered = bddreordered;
+   
+   PUSHREF( quant_resume(LOW(r)) );
+   CHECKRESUME(2);
+   PUSHREF( quant_resume(HIGH(r)) );
+   CHECKRESUME(3);
+   
+   if (INVARSET(LEVEL(r)))
+      res = apply_resume(READREF(2), READREF(1));
+   else
+      res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+
+   POPREF(3);
+   
+   entry->a = r;
+   entry->c = quantid;
+   entry->r.res = res;
+
+   return res;
+}
+
+
 /*=== APPLY & QUANTIFY =================================================*/
 
 BDD bdd_appex(BDD l, BDD r, int opr, BDD var)
@@ -1488,26 +2103,43 @@ BDD bdd_appex(BDD l, BDD r, int opr, BDD var)
    if (var < 2)  /* Empty set */
       return bdd_apply(l,r,opr);
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
       if (varset2vartable(var) < 0)
 	 return bddfalse;
-   
+
       INITREF;
       applyop = bddop_or;
       appexop = opr;
       appexid = (var << 5) | (appexop << 1); /* FIXME: range! */
       quantid = (appexid << 3) | CACHEID_APPEX;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(appquant_resume(l, r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = appquant_rec(l, r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1538,6 +2170,7 @@ BDD bdd_appall(BDD l, BDD r, int opr, BDD var)
    if (var < 2)  /* Empty set */
       return bdd_apply(l,r,opr);
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -1549,15 +2182,31 @@ BDD bdd_appall(BDD l, BDD r, int opr, BDD var)
       appexop = opr;
       appexid = (var << 5) | (appexop << 1) | 1; /* FIXME: range! */
       quantid = (appexid << 3) | CACHEID_APPAL;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(appquant_resume(l, r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = appquant_rec(l, r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1588,6 +2237,7 @@ BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
    if (var < 2)  /* Empty set */
       return bdd_apply(l,r,opr);
 
+   bddrestartable = 1;
  again:
    if (setjmp(bddexception) == 0)
    {
@@ -1599,15 +2249,31 @@ BDD bdd_appuni(BDD l, BDD r, int opr, BDD var)
       appexop = opr;
       appexid = (var << 5) | (appexop << 1) | 1; /* FIXME: range! */
       quantid = (appexid << 3) | CACHEID_APPUN;
-      
-      if (!firstReorder)
-	 bdd_disable_reorder();
-      res = appquant_rec(l, r);
-      if (!firstReorder)
-	 bdd_enable_reorder();
+
+      if (resumeon)
+      {
+	 PUSHREF(var);
+	 quantvarroot = var;
+	 bddresumable = 1;
+	 res = resumedone(appquant_resume(l, r));
+      }
+      else
+      {
+	 if (!firstReorder)
+	    bdd_disable_reorder();
+	 res = appquant_rec(l, r);
+	 if (!firstReorder)
+	    bdd_enable_reorder();
+      }
    }
    else
    {
+      if (bddresumable)
+      {
+	 resumerestart();
+	 goto again;
+      }
+
       bdd_checkreorder();
 
       if (firstReorder-- == 1)
@@ -1651,9 +2317,122 @@ static int appquant_rec(int l, int r)
        if (l == r)
 	  return 0;
        if (l == 0)
-	  return quant_rec(r);
+	  return quant_rec(r);
+       if (r == 0)
+	  return quant_rec(l);
+       break;
+    case bddop_nand:
+       if (l == 0  ||  r == 0)
+	  return 1;
+       break;
+    case bddop_nor:
+       if (l == 1  ||  r == 1)
+	  return 0;
+       break;
+   }
+   
+   if (ISCONST(l)  &&  ISCONST(r))
+      res = oprres[appexop][(l<<1) | r];
+   else
+   if (LEVEL(l) > quantlast  &&  LEVEL(r) > quantlast)
+   {
+      int oldop = applyop;
+      applyop = appexop;
+      res = apply_rec(l,r);
+      applyop = oldop;
+   }
+   else
+   {
+      entry = BddCache_lookup(&appexcache, APPEXHASH(l,r,appexop));
+      if (entry->a == l  &&  entry->b == r  &&  entry->c == appexid)
+      {
+#ifdef CACHESTATS
+	 bddcachestats.opHit++;
+#endif
+	 return entry->r.res;
+      }
+#ifdef CACHESTATS
+      bddcachestats.opMiss++;
+#endif
+
+      if (LEVEL(l) == LEVEL(r))
+      {
+	 PUSHREF( appquant_rec(LOW(l), LOW(r)) );
+	 PUSHREF( appquant_rec(HIGH(l), HIGH(r)) );
+	 if (INVARSET(LEVEL(l)))
+	    res = apply_rec(READREF(2), READREF(1));
+	 else
+	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      }
+      else
+      if (LEVEL(l) < LEVEL(r))
+      {
+	 PUSHREF( appquant_rec(LOW(l), r) );
+	 PUSHREF( appquant_rec(HIGH(l), r) );
+	 if (INVARSET(LEVEL(l)))
+	    res = apply_rec(READREF(2), READREF(1));
+	 else
+	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
+      }
+      else
+      {
+	 PUSHREF( appquant_rec(l, LOW(r)) );
+	 PUSHREF( appquant_rec(l, HIGH(r)) );
+	 if (INVARSET(LEVEL(r)))
+	    res = apply_rec(READREF(2), READREF(1));
+	 else
+	    res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
+      }
+
+      POPREF(2);
+      
+      entry->a = l;
+      entry->b = r;
+      entry->c = appexid;
+      entry->r.res = res;
+   }
+
+   return res;
+}
+
+
+static int appquant_resume(int l, int r)
+{
+   BddCacheData *entry;
+   int res, reordered;
+
+ resume:
+   SAFEPOINT2(l, r);
+   
+   switch (appexop)
+   {
+    case bddop_and:
+       if (l == 0  ||  r == 0)
+	  return 0;
+       if (l == r)
+	  return quant_resume(l);
+       if (l == 1)
+	  return quant_resume(r);
+       if (r == 1)
+	  return quant_resume(l);
+       break;
+    case bddop_or:
+       if (l == 1  ||  r == 1)
+	  return 1;
+       if (l == r)
+	  return quant_resume(l);
+       if (l == 0)
+	  return quant_resume(r);
+       if (r == 0)
+	  return quant_resume(l);
+       break;
+    case bddop_xor:
+       if (l == r)
+	  return 0;
+       if (l == 0)
+	  return quant_resume(r);
        if (r == 0)
-	  return quant_rec(l);
+	  return quant_resume(l);
        break;
     case bddop_nand:
        if (l == 0  ||  r == 0)
@@ -1672,7 +2451,7 @@ static int appquant_rec(int l, int r)
    {
       int oldop = applyop;
       applyop = appexop;
-      res = apply_rec(l,r);
+      res = apply_resume(l,r);
       applyop = oldop;
    }
    else
@@ -1689,36 +2468,46 @@ static int appquant_rec(int l, int r)
       bddcachestats.opMiss++;
 #endif
 
+      PUSHREF(l);
+      PUSHREF(r);
+      reordered = bddreordered;
+      
       if (LEVEL(l) == LEVEL(r))
       {
-	 PUSHREF( appquant_rec(LOW(l), LOW(r)) );
-	 PUSHREF( appquant_rec(HIGH(l), HIGH(r)) );
+	 PUSHREF( appquant_resume(LOW(l), LOW(r)) );
+	 CHECKRESUME(3);
+	 PUSHREF( appquant_resume(HIGH(l), HIGH(r)) );
+	 CHECKRESUME(4);
 	 if (INVARSET(LEVEL(l)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_resume(READREF(2), READREF(1));
 	 else
 	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
       }
       else
       if (LEVEL(l) < LEVEL(r))
       {
-	 PUSHREF( appquant_rec(LOW(l), r) );
-	 PUSHREF( appquant_rec(HIGH(l), r) );
+	 PUSHREF( appquant_resume(LOW(l), r) );
+	 CHECKRESUME(3);
+	 PUSHREF( appquant_resume(HIGH(l), r) );
+	 CHECKRESUME(4);
 	 if (INVARSET(LEVEL(l)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_resume(READREF(2), READREF(1));
 	 else
 	    res = bdd_makenode(LEVEL(l), READREF(2), READREF(1));
       }
       else
       {
-	 PUSHREF( appquant_rec(l, LOW(r)) );
-	 PUSHREF( appquant_rec(l, HIGH(r)) );
+	 PUSHREF( appquant_resume(l, LOW(r)) );
+	 CHECKRESUME(3);
+	 PUSHREF( appquant_resume(l, HIGH(r)) );
+	 CHECKRESUME(4);
 	 if (INVARSET(LEVEL(r)))
-	    res = apply_rec(READREF(2), READREF(1));
+	    res = apply_resume(READREF(2), READREF(1));
 	 else
 	    res = bdd_makenode(LEVEL(r), READREF(2), READREF(1));
       }
 
-      POPREF(2);
+      POPREF(4);
       
       entry->a = l;
       entry->b = r;
@@ -2059,6 +2848,142 @@ static void allsat_rec(BDD r)
 }
 
 
+/*=== PULL BASED CUBE ITERATOR =========================================*/
+
+typedef struct s_bddCubeFrame
+{
+   int node;      /* Node visited at this depth */
+   int branch;    /* Next branch to try: 0 = low, 1 = high, 2 = done */
+} bddCubeFrame;
+
+struct s_bddCubeIter
+{
+   BDD root;            /* Referenced root of the enumeration */
+   int varnum;          /* Number of variables when the iterator was made */
+   int reordered;       /* Value of bddreordered when the iterator was made */
+   int batch;           /* Max. number of cubes returned per call */
+   char *profile;       /* The cube currently being built */
+   char *cubes;         /* Output buffer of batch*varnum entries */
+   bddCubeFrame *stack; /* Explicit DFS stack */
+   int sp;              /* Stack pointer */
+};
+
+
+bddCubeIter *bdd_cube_iter_new(BDD r, int batch)
+{
+   bddCubeIter *it;
+   int v;
+
+   CHECKa(r, NULL);
+   if (batch < 1)
+   {
+      bdd_error(BDD_SIZE);
+      return NULL;
+   }
+
+   if ((it=NEW(bddCubeIter,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   it->profile = (char*)malloc(bddvarnum+1);
+   it->cubes = (char*)malloc(batch*(bddvarnum+1));
+   it->stack = NEW(bddCubeFrame,bddvarnum+1);
+
+   if (it->profile == NULL  ||  it->cubes == NULL  ||  it->stack == NULL)
+   {
+      free(it->profile);
+      free(it->cubes);
+      free(it->stack);
+      free(it);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   it->root = bdd_addref(r);
+   it->varnum = bddvarnum;
+   it->reordered = bddreordered;
+   it->batch = batch;
+
+   for (v=LEVEL(r)-1 ; v>=0 ; --v)
+     it->profile[bddlevel2var[v]] = -1;
+
+   it->stack[0].node = r;
+   it->stack[0].branch = 0;
+   it->sp = 1;
+
+   return it;
+}
+
+
+int bdd_cube_iter_next(bddCubeIter *it, char **cubes)
+{
+   int num = 0;
+
+   if (it == NULL)
+      return 0;
+
+      /* Node numbers and levels on the stack are useless after a reorder */
+   if (it->reordered != bddreordered  ||  it->varnum != bddvarnum)
+      return bdd_error(BDD_ILLBDD);
+
+   if (cubes != NULL)
+      *cubes = it->cubes;
+
+   while (it->sp > 0  &&  num < it->batch)
+   {
+      bddCubeFrame *f = &it->stack[it->sp-1];
+      int r = f->node;
+      int next, v;
+
+      if (ISONE(r))
+      {
+	 memcpy(it->cubes + num*it->varnum, it->profile, it->varnum);
+	 num++;
+	 it->sp--;
+	 continue;
+      }
+
+      if (ISZERO(r)  ||  f->branch > 1)
+      {
+	 it->sp--;
+	 continue;
+      }
+
+      next = (f->branch == 0 ? LOW(r) : HIGH(r));
+      it->profile[bddlevel2var[LEVEL(r)]] = f->branch;
+      f->branch++;
+
+      if (ISZERO(next))
+	 continue;
+
+      for (v=LEVEL(next)-1 ; v>LEVEL(r) ; --v)
+	 it->profile[bddlevel2var[v]] = -1;
+
+      it->stack[it->sp].node = next;
+      it->stack[it->sp].branch = 0;
+      it->sp++;
+   }
+
+   return num;
+}
+
+
+void bdd_cube_iter_free(bddCubeIter *it)
+{
+   if (it == NULL)
+      return;
+
+   if (bddrunning)
+      bdd_delref(it->root);
+   free(it->profile);
+   free(it->cubes);
+   free(it->stack);
+   free(it);
+}
+
+
 /*=== COUNT NUMBER OF SATISFYING ASSIGNMENT ============================*/
 
 double bdd_satcount(BDD r)
@@ -2185,10 +3110,8 @@ static double satcountln_rec(int root)
       size = s2;
    else if (s2 < 0.0)
       size = s1;
-   else if (s1 < s2)
-      size = s2 + log1p(pow(2.0,s1-s2)) / M_LN2;
    else
-      size = s1 + log1p(pow(2.0,s2-s1)) / M_LN2;
+      size = log2add(s1, s2);
    
    entry->a = root;
    entry->c = miscid;
@@ -2198,6 +3121,482 @@ static double satcountln_rec(int root)
 }
 
 
+/*=== BIT PARALLEL BATCH EVALUATION ===================================*/
+
+   /* Number of 64 bit words evaluated per node visit. The inner loop has a
+    * fixed trip count so that the compiler can map it to vector registers */
+#define EVALLANES 8
+
+int bdd_eval_batch(BDD *r, int num, const uint64_t *in, int words,
+		   uint64_t *out)
+{
+   int *cone, *index, *var, *low, *high;
+   uint64_t *val;
+   int n, i, w, size;
+
+   if (r == NULL  ||  in == NULL  ||  out == NULL  ||  num < 0  ||  words < 0)
+      return bdd_error(BDD_ILLBDD);
+   for (n=0 ; n<num ; n++)
+      CHECK(r[n]);
+
+   if ((cone=bdd_postorder(r, num, &size)) == NULL)
+      return BDD_MEMORY;
+
+      /* Flatten the cone so the evaluation does not touch the node table.
+       * Row 0 and 1 of the scratch area hold the constants and node i of
+       * the cone is in row i+2 */
+   index = NEW(int,bddnodesize);
+   var = NEW(int,size+1);
+   low = NEW(int,size+1);
+   high = NEW(int,size+1);
+   val = NEW(uint64_t,(size+2)*EVALLANES);
+
+   if (index == NULL  ||  var == NULL  ||  low == NULL  ||  high == NULL  ||
+       val == NULL)
+   {
+      free(cone);
+      free(index);
+      free(var);
+      free(low);
+      free(high);
+      free(val);
+      return bdd_error(BDD_MEMORY);
+   }
+
+   for (i=0 ; i<size ; i++)
+   {
+      int node = cone[i];
+      
+      index[node] = i+2;
+      var[i] = bddlevel2var[LEVEL(node)];
+      low[i] = (LOW(node) < 2 ? LOW(node) : index[LOW(node)]);
+      high[i] = (HIGH(node) < 2 ? HIGH(node) : index[HIGH(node)]);
+   }
+   
+   for (i=0 ; i<EVALLANES ; i++)
+   {
+      val[i] = 0;
+      val[EVALLANES+i] = ~(uint64_t)0;
+   }
+
+   for (w=0 ; w<words ; w+=EVALLANES)
+   {
+      int lanes = MIN(EVALLANES, words-w);
+      
+      for (i=0 ; i<size ; i++)
+      {
+	 const uint64_t *x = in + (long)var[i]*words + w;
+	 const uint64_t *l = val + low[i]*EVALLANES;
+	 const uint64_t *h = val + high[i]*EVALLANES;
+	 uint64_t *d = val + (i+2)*EVALLANES;
+	 int k;
+
+	 if (lanes == EVALLANES)
+	 {
+	    for (k=0 ; k<EVALLANES ; k++)
+	       d[k] = (x[k] & h[k]) | (~x[k] & l[k]);
+	 }
+	 else
+	 {
+	    for (k=0 ; k<lanes ; k++)
+	       d[k] = (x[k] & h[k]) | (~x[k] & l[k]);
+	 }
+      }
+
+      for (n=0 ; n<num ; n++)
+      {
+	 const uint64_t *s = val + (r[n] < 2 ? r[n] : index[r[n]])*EVALLANES;
+	 for (i=0 ; i<lanes ; i++)
+	    out[(long)n*words + w + i] = s[i];
+      }
+   }
+
+   free(cone);
+   free(index);
+   free(var);
+   free(low);
+   free(high);
+   free(val);
+   
+   return 0;
+}
+
+
+/*=== EXACT SATCOUNT ===================================================*/
+
+   /* Counts over all variables and divides by 2^unused */
+static char *satcount_exact(BDD r, int unused)
+{
+   bddlimb *pool, *res;
+   int *cone, *index;
+   long *offset;
+   long poolsize = 0;
+   char *str;
+   int num, size, n;
+
+   CHECKa(r, NULL);
+
+   if ((cone=bdd_postorder(&r, 1, &num)) == NULL)
+      return NULL;
+
+   index = NEW(int,bddnodesize);
+   offset = NEW(long,num+1);
+   res = NEW(bddlimb,BIGNUM_SIZE(bddvarnum));
+
+      /* Each node gets just enough limbs for the levels below it */
+   if (offset != NULL)
+   {
+      for (n=0 ; n<num ; n++)
+      {
+	 offset[n] = poolsize;
+	 poolsize += BIGNUM_SIZE(bddvarnum - LEVEL(cone[n]));
+      }
+      offset[num] = poolsize;
+   }
+   pool = NEW(bddlimb,poolsize+1);
+
+   if (index == NULL  ||  offset == NULL  ||  res == NULL  ||  pool == NULL)
+   {
+      free(cone);
+      free(index);
+      free(offset);
+      free(res);
+      free(pool);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   bignum_clear(pool, poolsize);
+   size = BIGNUM_SIZE(bddvarnum);
+   bignum_clear(res, size);
+   
+   for (n=0 ; n<num ; n++)
+   {
+      int node = cone[n];
+      int level = LEVEL(node);
+      bddlimb *dst = pool + offset[n];
+      int dsize = (int)(offset[n+1] - offset[n]);
+      int b;
+
+      index[node] = n;
+      
+      for (b=0 ; b<2 ; b++)
+      {
+	 int c = (b ? HIGH(node) : LOW(node));
+	 int shift = LEVEL(c) - level - 1;
+
+	 if (c == 1)
+	 {
+	    bddlimb one = 1;
+	    bignum_addshift(dst, dsize, &one, 1, shift);
+	 }
+	 else if (c >= 2)
+	 {
+	    int i = index[c];
+	    bignum_addshift(dst, dsize, pool + offset[i],
+			    (int)(offset[i+1] - offset[i]), shift);
+	 }
+      }
+   }
+
+   if (r == 1)
+   {
+      bddlimb one = 1;
+      bignum_addshift(res, size, &one, 1, bddvarnum);
+   }
+   else if (r >= 2)
+      bignum_addshift(res, size, pool + offset[num-1],
+		      (int)(offset[num] - offset[num-1]), LEVEL(r));
+   bignum_shiftright(res, size, unused);
+
+   if ((str=bignum_tostring(res, size)) == NULL)
+      bdd_error(BDD_MEMORY);
+   
+   free(cone);
+   free(index);
+   free(offset);
+   free(res);
+   free(pool);
+   
+   return str;
+}
+
+
+char *bdd_satcount_exact(BDD r)
+{
+   return satcount_exact(r, 0);
+}
+
+
+char *bdd_satcountset_exact(BDD r, BDD varset)
+{
+   int unused = bddvarnum;
+   BDD n;
+
+   CHECKa(r, NULL);
+   CHECKa(varset, NULL);
+   
+   for (n=varset ; !ISCONST(n) ; n=HIGH(n))
+      unused--;
+
+   return satcount_exact(r, unused);
+}
+
+
+/* Returns log2(2^a + 2^b) without leaving the log domain. Either argument
+   may be -HUGE_VAL which represents zero. */
+static double log2add(double a, double b)
+{
+   if (a < b)
+      return b + log1p(pow(2.0,a-b)) / M_LN2;
+   if (b == -HUGE_VAL)
+      return a;
+   return a + log1p(pow(2.0,b-a)) / M_LN2;
+}
+
+
+/*=== WEIGHTED MODEL COUNTING ==========================================*/
+
+static int wmc_init(double *pos, double *neg)
+{
+   int l;
+
+   if (pos == NULL  ||  neg == NULL)
+      return bdd_error(BDD_ILLBDD);
+
+   wmcpos = NEW(double,bddvarnum);
+   wmcneg = NEW(double,bddvarnum);
+   wmcsum = NEW(double,bddvarnum+1);
+   wmczero = NEW(int,bddvarnum+1);
+
+   if (wmcpos == NULL  ||  wmcneg == NULL  ||  wmcsum == NULL  ||
+       wmczero == NULL)
+   {
+      wmc_done();
+      return bdd_error(BDD_MEMORY);
+   }
+
+   wmcsum[0] = 0.0;
+   wmczero[0] = 0;
+
+   for (l=0 ; l<bddvarnum ; l++)
+   {
+      int v = bddlevel2var[l];
+      double s = pos[v] + neg[v];
+
+      if (!(pos[v] >= 0.0  &&  neg[v] >= 0.0))
+      {
+	 wmc_done();
+	 return bdd_error(BDD_RANGE);
+      }
+      
+      wmcpos[l] = (pos[v] > 0.0 ? log(pos[v]) / M_LN2 : -HUGE_VAL);
+      wmcneg[l] = (neg[v] > 0.0 ? log(neg[v]) / M_LN2 : -HUGE_VAL);
+      wmcsum[l+1] = wmcsum[l] + (s > 0.0 ? log(s) / M_LN2 : 0.0);
+      wmczero[l+1] = wmczero[l] + (s > 0.0 ? 0 : 1);
+   }
+
+   return 0;
+}
+
+
+static void wmc_done(void)
+{
+   free(wmcpos);
+   free(wmcneg);
+   free(wmcsum);
+   free(wmczero);
+   wmcpos = wmcneg = wmcsum = NULL;
+   wmczero = NULL;
+}
+
+
+/* log2 of the weight of all the levels strictly between 'a' and 'b' */
+static double wmc_skip(int a, int b)
+{
+   if (wmczero[b] - wmczero[a+1] > 0)
+      return -HUGE_VAL;
+   return wmcsum[b] - wmcsum[a+1];
+}
+
+
+/* Bottom up pass over the nodes in 'cone' (post order). The log2 weight
+   of node cone[i] is stored in val[i] and index[] maps nodes to positions
+   in the cone. */
+static void wmc_up(int *cone, int num, int *index, double *val)
+{
+   int i;
+
+   for (i=0 ; i<num ; i++)
+   {
+      int n = cone[i];
+      int l = LEVEL(n);
+      double lo, hi;
+
+      index[n] = i;
+      lo = wmcneg[l] + wmc_skip(l, LEVEL(LOW(n))) + WMCVAL(LOW(n));
+      hi = wmcpos[l] + wmc_skip(l, LEVEL(HIGH(n))) + WMCVAL(HIGH(n));
+      val[i] = log2add(lo, hi);
+   }
+}
+
+
+static double wmc_cone(BDD r, int **cone, int *num, int **index,
+		       double **val)
+{
+   if ((*cone=bdd_postorder(&r, 1, num)) == NULL)
+      return 0.0;
+   
+   *index = NEW(int,bddnodesize);
+   *val = NEW(double,*num+1);
+   if (*index == NULL  ||  *val == NULL)
+   {
+      free(*cone);
+      free(*index);
+      free(*val);
+      *cone = NULL;
+      bdd_error(BDD_MEMORY);
+      return 0.0;
+   }
+
+   wmc_up(*cone, *num, *index, *val);
+
+   return wmc_skip(-1, LEVEL(r)) + (r < 2 ? WMCTERM(r) : (*val)[*num-1]);
+}
+
+
+double bdd_wmc(BDD r, double *pos, double *neg)
+{
+   double res = bdd_wmcln(r, pos, neg);
+   return res == -HUGE_VAL ? 0.0 : pow(2.0, res);
+}
+
+
+double bdd_wmcln(BDD r, double *pos, double *neg)
+{
+   int *cone, *index;
+   double *val;
+   double res;
+   int num;
+   
+   CHECKa(r, 0.0);
+
+   if (wmc_init(pos, neg) < 0)
+      return 0.0;
+
+   res = wmc_cone(r, &cone, &num, &index, &val);
+   if (cone != NULL)
+   {
+      free(cone);
+      free(index);
+      free(val);
+   }
+   
+   wmc_done();
+   return res;
+}
+
+
+int bdd_wmcmarginals(BDD r, double *pos, double *neg, double *marg)
+{
+   int *cone, *index;
+   double *val, *reach, *diff, *high;
+   double total, acc;
+   int num, i, l;
+
+   CHECK(r);
+   if (marg == NULL)
+      return bdd_error(BDD_ILLBDD);
+   
+   if ((i=wmc_init(pos, neg)) < 0)
+      return i;
+
+   total = wmc_cone(r, &cone, &num, &index, &val);
+   if (cone == NULL)
+   {
+      wmc_done();
+      return BDD_MEMORY;
+   }
+
+   reach = NEW(double,num+1);
+   diff = NEW(double,bddvarnum+1);
+   high = NEW(double,bddvarnum);
+   if (reach == NULL  ||  diff == NULL  ||  high == NULL)
+   {
+      free(reach);
+      free(diff);
+      free(high);
+      free(cone);
+      free(index);
+      free(val);
+      wmc_done();
+      return bdd_error(BDD_MEMORY);
+   }
+
+   for (i=0 ; i<num ; i++)
+      reach[i] = -HUGE_VAL;
+   for (l=0 ; l<bddvarnum ; l++)
+      diff[l] = high[l] = 0.0;
+   diff[bddvarnum] = 0.0;
+
+   if (total != -HUGE_VAL)
+   {
+	 /* All paths pass through the levels above the root */
+      diff[0] += 1.0;
+      diff[LEVEL(r)] -= 1.0;
+      if (r >= 2)
+	 reach[num-1] = wmc_skip(-1, LEVEL(r));
+
+	 /* Top down pass. Reverse post order visits parents before children.
+	  * The mass of each edge is normalized with the total weight so the
+	  * difference array over skipped levels can be kept in linear space */
+      for (i=num-1 ; i>=0 ; i--)
+      {
+	 int n = cone[i];
+	 int lvl = LEVEL(n);
+	 int b;
+
+	 for (b=0 ; b<2 ; b++)
+	 {
+	    int c = (b ? HIGH(n) : LOW(n));
+	    double e = reach[i] + (b ? wmcpos[lvl] : wmcneg[lvl]) +
+	       wmc_skip(lvl, LEVEL(c));
+	    double p = pow(2.0, e + WMCVAL(c) - total);
+
+	    if (b)
+	       high[lvl] += p;
+	    if (c >= 2)
+	       reach[index[c]] = log2add(reach[index[c]], e);
+
+	    diff[lvl+1] += p;
+	    diff[LEVEL(c)] -= p;
+	 }
+      }
+   }
+
+   for (l=0, acc=0.0 ; l<bddvarnum ; l++)
+   {
+      int v = bddlevel2var[l];
+      double s = pos[v] + neg[v];
+      double m;
+      
+      acc += diff[l];
+      m = high[l] + (s > 0.0 ? acc * pos[v] / s : 0.0);
+      marg[v] = (m < 0.0 ? 0.0 : (m > 1.0 ? 1.0 : m));
+   }
+
+   free(reach);
+   free(diff);
+   free(high);
+   free(cone);
+   free(index);
+   free(val);
+   wmc_done();
+   
+   return 0;
+}
+
+
 /*=== COUNT NUMBER OF ALLOCATED NODES ==================================*/
 
 int bdd_nodecount(BDD r)
@@ -28,7 +28,11 @@
 ========================================================================*/
 
 #include <string>
+#include <sstream>
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 #include "bdd.h"
 #include "bvec.h"
 
@@ -97,14 +101,1873 @@ void testBvecIte()
 }
 
 
+static bdd cubeToBdd(const char *cube)
+{
+  bdd x = bddtrue;
+  for (int v=0 ; v<bdd_varnum() ; ++v)
+    if (cube[v] == 0)
+      x &= bdd_nithvar(v);
+    else if (cube[v] == 1)
+      x &= bdd_ithvar(v);
+  return x;
+}
+
+
+static bdd allsatCubes;
+static int allsatNum;
+
+static void allsatCollect(char *cube, int size)
+{
+  allsatCubes |= cubeToBdd(cube);
+  allsatNum++;
+}
+
+
+static void testCubeIter(void)
+{
+  cout << "Testing cube iterator\n";
+
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(9);
+  bdd tests[] = { bddtrue, bddfalse, a, !a, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c) };
+
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+  {
+    bdd r = tests[t];
+
+    allsatCubes = bddfalse;
+    allsatNum = 0;
+    bdd_allsat(r, allsatCollect);
+
+    for (int batch=1 ; batch<=7 ; batch+=3)
+    {
+      bddCubeIter *it = bdd_cube_iter_new(r.id(), batch);
+      bdd sum = bddfalse;
+      char *cubes;
+      int n, num = 0;
+
+      while ((n=bdd_cube_iter_next(it, &cubes)) > 0)
+      {
+	if (n > batch)
+	  ERROR("Too many cubes in one batch");
+	for (int i=0 ; i<n ; ++i)
+	{
+	  bdd x = cubeToBdd(cubes + i*bdd_varnum());
+	  if ((sum & x) != bddfalse)
+	    ERROR("Overlapping cubes");
+	  sum |= x;
+	}
+	num += n;
+      }
+
+      if (n < 0)
+	ERROR("Iterator failed");
+      if (bdd_cube_iter_next(it, &cubes) != 0)
+	ERROR("Iterator did not stay exhausted");
+      bdd_cube_iter_free(it);
+
+      if (sum != r  ||  num != allsatNum)
+	ERROR("Iterator does not match bdd_allsat");
+    }
+
+    bdd sum = bddfalse;
+    int num = 0;
+    bdd_cubes range(r, 2);
+    for (const char *cube : range)
+    {
+      sum |= cubeToBdd(cube);
+      num++;
+    }
+    if (sum != r  ||  num != allsatNum)
+      ERROR("Range iteration does not match bdd_allsat");
+  }
+
+  /* Two interleaved iterators must not disturb each other */
+  bdd r = a & !b | c & d;
+  bddCubeIter *i1 = bdd_cube_iter_new(r.id(), 1);
+  bddCubeIter *i2 = bdd_cube_iter_new(r.id(), 1);
+  char *c1, *c2;
+  int n1, n2;
+  do
+  {
+    n1 = bdd_cube_iter_next(i1, &c1);
+    n2 = bdd_cube_iter_next(i2, &c2);
+    if (n1 != n2  ||  (n1 > 0 && memcmp(c1,c2,bdd_varnum()) != 0))
+      ERROR("Interleaved iterators differ");
+  }
+  while (n1 > 0);
+  bdd_cube_iter_free(i1);
+  bdd_cube_iter_free(i2);
+}
+
+
+static int evalBdd(bdd r, int *assign)
+{
+  while (r != bddtrue  &&  r != bddfalse)
+    r = (assign[bdd_var(r)] ? bdd_high(r) : bdd_low(r));
+  return r == bddtrue;
+}
+
+
+static int nearlyEqual(double a, double b)
+{
+  return fabs(a-b) <= 1e-9 * (fabs(a) + fabs(b)) + 1e-12;
+}
+
+
+static void testWmc(void)
+{
+  cout << "Testing weighted model counting\n";
+
+  const int varnum = bdd_varnum();
+  double *pos = new double[varnum];
+  double *neg = new double[varnum];
+  double *marg = new double[varnum];
+  double *bmarg = new double[varnum];
+  int *assign = new int[varnum];
+
+  bdd a = bdd_ithvar(1);
+  bdd b = bdd_ithvar(4);
+  bdd c = bdd_ithvar(6);
+  bdd d = bdd_ithvar(8);
+  bdd tests[] = { bddtrue, bddfalse, a, !c, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c) };
+
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+  {
+    bdd r = tests[t];
+
+    for (int v=0 ; v<varnum ; ++v)
+    {
+      pos[v] = 1.0;
+      neg[v] = 1.0;
+    }
+    if (!nearlyEqual(bdd_wmc(r, pos, neg), bdd_satcount(r)))
+      ERROR("Unit weights differ from satcount");
+
+    for (int v=0 ; v<varnum ; ++v)
+    {
+      pos[v] = drand48();
+      neg[v] = (v == 2 ? 0.0 : drand48());
+      bmarg[v] = 0.0;
+    }
+
+    double total = 0.0;
+    for (int n=0 ; n<(1<<varnum) ; ++n)
+    {
+      double w = 1.0;
+      for (int v=0 ; v<varnum ; ++v)
+      {
+	assign[v] = (n >> v) & 1;
+	w *= (assign[v] ? pos[v] : neg[v]);
+      }
+      if (evalBdd(r, assign))
+      {
+	total += w;
+	for (int v=0 ; v<varnum ; ++v)
+	  if (assign[v])
+	    bmarg[v] += w;
+      }
+    }
+
+    if (!nearlyEqual(bdd_wmc(r, pos, neg), total))
+      ERROR("Weighted model count failed");
+    if (total > 0.0  &&  !nearlyEqual(bdd_wmcln(r, pos, neg), log2(total)))
+      ERROR("Logarithmic weighted model count failed");
+
+    if (bdd_wmcmarginals(r, pos, neg, marg) != 0)
+      ERROR("Marginals failed");
+    for (int v=0 ; v<varnum ; ++v)
+      if (!nearlyEqual(marg[v], total > 0.0 ? bmarg[v]/total : 0.0))
+	ERROR("Wrong marginal");
+  }
+
+  delete[] pos;
+  delete[] neg;
+  delete[] marg;
+  delete[] bmarg;
+  delete[] assign;
+}
+
+
+static void testEvalBatch(void)
+{
+  cout << "Testing batch evaluation\n";
+
+  const int varnum = bdd_varnum();
+  const int words = 11;
+  uint64_t *in = new uint64_t[varnum*words];
+  int *assign = new int[varnum];
+
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(9);
+  bdd tests[] = { bddtrue, bddfalse, a, !a, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c) };
+  const int num = sizeof(tests)/sizeof(bdd);
+  uint64_t *out = new uint64_t[num*words];
+
+  for (int n=0 ; n<varnum*words ; ++n)
+    in[n] = ((uint64_t)lrand48() << 33) ^ ((uint64_t)lrand48() << 11) ^
+      (uint64_t)lrand48();
+
+  if (bdd_eval_batch(tests, num, in, words, out) != 0)
+    ERROR("Batch evaluation failed");
+
+  for (int w=0 ; w<words ; ++w)
+    for (int j=0 ; j<64 ; ++j)
+    {
+      for (int v=0 ; v<varnum ; ++v)
+	assign[v] = (in[v*words+w] >> j) & 1;
+      for (int t=0 ; t<num ; ++t)
+	if ((int)((out[t*words+w] >> j) & 1) != evalBdd(tests[t], assign))
+	  ERROR("Wrong result from batch evaluation");
+    }
+
+  bvec x = bvec_var(3, 0, 3);
+  bvec y = bvec_var(3, 1, 3);
+  bvec z = x + y;
+  uint64_t sum[3];
+
+    /* One word per variable this time */
+  if (bdd_eval_batch(z, in, 1, sum) != 0)
+    ERROR("Vector batch evaluation failed");
+  for (int j=0 ; j<64 ; ++j)
+  {
+    int xv = 0, yv = 0, zv = 0;
+    for (int i=0 ; i<3 ; ++i)
+    {
+      xv |= ((in[3*i] >> j) & 1) << i;
+      yv |= ((in[3*i+1] >> j) & 1) << i;
+      zv |= ((sum[i] >> j) & 1) << i;
+    }
+    if (zv != ((xv + yv) & 7))
+      ERROR("Wrong vector sum from batch evaluation");
+  }
+
+  delete[] in;
+  delete[] out;
+  delete[] assign;
+}
+
+
+static int errorCount;
+
+static void countErrors(int)
+{
+  ++errorCount;
+}
+
+
+static void testCompile(void)
+{
+  cout << "Testing compiled programs\n";
+
+  const int varnum = bdd_varnum();
+  char *assign = new char[varnum];
+  int *iassign = new int[varnum];
+
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(9);
+  bdd tests[] = { bddtrue, bddfalse, a, !a, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c) };
+  const int num = sizeof(tests)/sizeof(bdd);
+
+  for (int order=BDD_COMPILE_DFS ; order<=BDD_COMPILE_BFS ; ++order)
+  {
+    bddProgram *p = bdd_acompile(tests, num, order);
+    if (p == NULL  ||  bdd_program_rootnum(p) != num)
+      ERROR("Compilation failed");
+    if (bdd_program_nodenum(p) != bdd_anodecount(tests, num))
+      ERROR("Wrong number of compiled nodes");
+
+    FILE *f = tmpfile();
+    if (bdd_program_save(f, p) != 0)
+      ERROR("Saving compiled program failed");
+    rewind(f);
+    bddProgram *q = bdd_program_load(f);
+    fclose(f);
+    if (q == NULL)
+      ERROR("Loading compiled program failed");
+
+    for (int n=0 ; n<(1<<varnum) ; ++n)
+    {
+      for (int v=0 ; v<varnum ; ++v)
+	iassign[v] = assign[v] = (n >> v) & 1;
+      for (int t=0 ; t<num ; ++t)
+      {
+	int res = evalBdd(tests[t], iassign);
+	if (bdd_program_eval(p, t, assign) != res)
+	  ERROR("Wrong result from compiled program");
+	if (bdd_program_eval(q, t, assign) != res)
+	  ERROR("Wrong result from loaded program");
+      }
+    }
+
+      /* Illegal roots are returned without calling the error handler */
+    bddinthandler old = bdd_error_hook(countErrors);
+    errorCount = 0;
+    if (bdd_program_eval(p, num, assign) != BDD_SIZE  ||
+	bdd_program_satone(p, -1, assign) != BDD_SIZE  ||
+	bdd_program_satcount(p, num) != 0.0)
+      ERROR("Illegal program root accepted");
+    if (errorCount != 0)
+      ERROR("Error handler called from program query");
+    bdd_error_hook(old);
+
+    bdd_program_free(p);
+    bdd_program_free(q);
+  }
+
+  delete[] assign;
+  delete[] iassign;
+}
+
+
+static void testSiftSym(void)
+{
+  cout << "Testing symmetric sifting\n";
+
+  const int varnum = bdd_varnum();
+  int *assign = new int[varnum];
+  int *order = new int[varnum];
+
+  for (int method=BDD_REORDER_SIFT_SYM ; method<=BDD_REORDER_SIFT_SYMITE ;
+       ++method)
+  {
+    /* At least two of the even variables and the odd ones pairwise equal */
+    bdd even = bddfalse;
+    for (int v=0 ; v<varnum ; v+=2)
+      for (int w=v+2 ; w<varnum ; w+=2)
+	even |= bdd_ithvar(v) & bdd_ithvar(w);
+    bdd odd = bddtrue;
+    for (int v=1 ; v+2<varnum ; v+=4)
+      odd &= bdd_biimp(bdd_ithvar(v), bdd_ithvar(v+2));
+    bdd f = even & odd;
+
+    double count = bdd_satcount(f);
+    int before = bdd_getnodenum();
+
+    bdd_varblockall();
+    bdd_reorder(method);
+    bdd_clrvarblocks();
+
+    if (bdd_getnodenum() > before)
+      ERROR("Symmetric sifting increased the number of nodes");
+    if (bdd_satcount(f) != count)
+      ERROR("Symmetric sifting changed the function");
+    
+    for (int n=0 ; n<(1<<varnum) ; ++n)
+    {
+      int e = 0, o = 1;
+      for (int v=0 ; v<varnum ; ++v)
+	assign[v] = (n >> v) & 1;
+      for (int v=0 ; v<varnum ; v+=2)
+	e += assign[v];
+      for (int v=1 ; v+2<varnum ; v+=4)
+	o &= assign[v] == assign[v+2];
+      if (evalBdd(f, assign) != (e >= 2  &&  o))
+	ERROR("Wrong result after symmetric sifting");
+    }
+
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+  }
+
+  delete[] assign;
+  delete[] order;
+}
+
+
+static void testReorderThreads(void)
+{
+  cout << "Testing parallel reordering\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+  int *result = new int[varnum];
+  int *assign = new int[varnum];
+
+  /* Each half is best with its variables interleaved */
+  bdd f = bddtrue;
+  for (int b=0 ; b<varnum ; b+=half)
+  {
+    bdd g = bddfalse;
+    for (int v=0 ; v<half/2 ; ++v)
+      g |= bdd_ithvar(b+v) & bdd_ithvar(b+v+half/2);
+    f &= g;
+  }
+  double count = bdd_satcount(f);
+
+  const int methods[] = { BDD_REORDER_SIFT, BDD_REORDER_WIN2ITE,
+			  BDD_REORDER_RANDOM };
+  for (unsigned int m=0 ; m<sizeof(methods)/sizeof(int) ; ++m)
+  {
+    int nodes = 0;
+
+      /* Two or more threads give the same result, whatever state the
+	 application's lrand48 is in. Zero threads is the plain serial
+	 reordering. The halves sit in one fixed block, so with threads
+	 all the blocks are reordered by the tasks */
+    for (int run=0 ; run<6 ; ++run)
+    {
+      int threads = (run/2)*2;
+
+      bdd_clrvarblocks();
+      for (int v=0 ; v<varnum ; ++v)
+	order[v] = v;
+      bdd_setvarorder(order);
+      bdd_intaddvarblock(0, half-1, BDD_REORDER_FREE);
+      bdd_intaddvarblock(half, varnum-1, BDD_REORDER_FREE);
+      bdd_intaddvarblock(0, varnum-1, BDD_REORDER_FIXED);
+      bdd_varblockall();
+      
+      srand48(42 + run%2);
+      bdd_reorder_seed(42);
+      bdd_reorder_threads(threads);
+      bdd_reorder(methods[m]);
+      bdd_reorder_threads(0);
+
+      if (run == 2)
+      {
+	nodes = bdd_getnodenum();
+	for (int l=0 ; l<varnum ; ++l)
+	  result[l] = bdd_level2var(l);
+      }
+      else if (threads > 2)
+      {
+	if (bdd_getnodenum() != nodes)
+	  ERROR("Parallel reordering gave another size");
+	for (int l=0 ; l<varnum ; ++l)
+	  if (bdd_level2var(l) != result[l])
+	    ERROR("Parallel reordering gave another order");
+      }
+      
+      if (bdd_satcount(f) != count)
+	ERROR("Parallel reordering changed the function");
+      for (int n=0 ; n<(1<<varnum) ; ++n)
+      {
+	for (int v=0 ; v<varnum ; ++v)
+	  assign[v] = (n >> v) & 1;
+	int e = 1;
+	for (int b=0 ; b<varnum ; b+=half)
+	{
+	  int g = 0;
+	  for (int v=0 ; v<half/2 ; ++v)
+	    g |= assign[b+v] & assign[b+v+half/2];
+	  e &= g;
+	}
+	if (evalBdd(f, assign) != e)
+	  ERROR("Wrong result after parallel reordering");
+      }
+    }
+  }
+
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  
+  delete[] order;
+  delete[] result;
+  delete[] assign;
+}
+
+
+static void testReorderExact(void)
+{
+  cout << "Testing exact and window reordering\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+  int *assign = new int[varnum];
+
+  const int methods[] = { BDD_REORDER_EXACT, BDD_REORDER_WIN4,
+			  BDD_REORDER_WINK };
+  for (unsigned int m=0 ; m<sizeof(methods)/sizeof(int) ; ++m)
+  {
+    /* Best with the pairs next to each other */
+    bdd f = bddfalse;
+    for (int v=0 ; v<half ; ++v)
+      f |= bdd_ithvar(v) & bdd_ithvar(v+half);
+    int before = bdd_nodecount(f);
+    
+    bdd_varblockall();
+    bdd_reorder_window(5);
+    bdd_reorder(methods[m]);
+    bdd_clrvarblocks();
+
+    if (methods[m] == BDD_REORDER_EXACT  &&  bdd_nodecount(f) != varnum)
+      ERROR("Exact reordering did not find the optimal order");
+    if (bdd_nodecount(f) > before)
+      ERROR("Window reordering increased the number of nodes");
+    
+    for (int n=0 ; n<(1<<varnum) ; ++n)
+    {
+      int e = 0;
+      for (int v=0 ; v<varnum ; ++v)
+	assign[v] = (n >> v) & 1;
+      for (int v=0 ; v<half ; ++v)
+	e |= assign[v] & assign[v+half];
+      if (evalBdd(f, assign) != e)
+	ERROR("Wrong result after exact or window reordering");
+    }
+    
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+  }
+
+  bdd_reorder_window(4);
+  delete[] order;
+  delete[] assign;
+}
+
+
+static int siftBlocks, siftLimited, siftSwaps;
+
+static void siftStat(bddSiftStat *stat)
+{
+  siftBlocks++;
+  siftSwaps += stat->swaps;
+  if (stat->limited)
+    siftLimited++;
+  if (stat->after > stat->before)
+    ERROR("Sifting increased the number of nodes for a block");
+}
+
+
+static void testSiftBudget(void)
+{
+  cout << "Testing budgeted sifting\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+  
+  bdd f = bddfalse;
+  for (int v=0 ; v<half ; ++v)
+    f |= bdd_ithvar(v) & bdd_ithvar(v+half);
+  bdd g = f;
+  int before = bdd_nodecount(f);
+
+  bdd_sift_hook(siftStat);
+  
+  for (int n=0 ; n<2 ; ++n)
+  {
+    siftBlocks = siftLimited = siftSwaps = 0;
+    bdd_reorder_maxswaps(n == 0 ? 0 : 5);
+    
+    bdd_varblockall();
+    bdd_reorder(BDD_REORDER_SIFT);
+    bdd_clrvarblocks();
+
+    if (f != g)
+      ERROR("Budgeted sifting changed the function");
+    if (bdd_nodecount(f) > before)
+      ERROR("Budgeted sifting increased the number of nodes");
+    if (n == 0  &&  (siftBlocks != varnum  ||  siftLimited != 0))
+      ERROR("Unlimited sifting did not sift all blocks");
+    if (n == 1  &&  (siftLimited == 0  ||  siftBlocks == varnum))
+      ERROR("Sifting did not stop at the swap budget");
+    
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+  }
+
+  bdd_reorder_maxswaps(0);
+  bdd_sift_hook(NULL);
+  delete[] order;
+}
+
+
+static void testReorderStochastic(void)
+{
+  cout << "Testing annealing and genetic reordering\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+  int *result = new int[varnum];
+
+  bdd f = bddfalse;
+  for (int v=0 ; v<half ; ++v)
+    f |= bdd_ithvar(v) & bdd_ithvar(v+half);
+  bdd g = f;
+  int before = bdd_nodecount(f);
+
+  const int methods[] = { BDD_REORDER_ANNEAL, BDD_REORDER_GENETIC };
+  for (unsigned int m=0 ; m<sizeof(methods)/sizeof(int) ; ++m)
+  {
+    /* The same seed must give the same order */
+    for (int n=0 ; n<2 ; ++n)
+    {
+      bdd_reorder_seed(42);
+      
+      bdd_varblockall();
+      bdd_reorder(methods[m]);
+      bdd_clrvarblocks();
+
+      if (f != g)
+	ERROR("Stochastic reordering changed the function");
+      if (bdd_nodecount(f) > before)
+	ERROR("Stochastic reordering increased the number of nodes");
+
+      for (int v=0 ; v<varnum ; ++v)
+      {
+	if (n == 0)
+	  result[v] = bdd_level2var(v);
+	else if (result[v] != bdd_level2var(v))
+	  ERROR("Stochastic reordering is not repeatable");
+      }
+      
+      for (int v=0 ; v<varnum ; ++v)
+	order[v] = v;
+      bdd_setvarorder(order);
+    }
+  }
+
+  delete[] order;
+  delete[] result;
+}
+
+
+static void testReorderCache(void)
+{
+  cout << "Testing operator caches across reordering\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+
+  bdd f = bddfalse, g = bddtrue, h = bddfalse;
+  for (int v=0 ; v<half ; ++v)
+  {
+    f |= bdd_ithvar(v) & bdd_ithvar(v+half);
+    g &= bdd_ithvar(v) | bdd_nithvar(varnum-1-v);
+    h ^= bdd_ithvar(2*v);
+  }
+
+  const int methods[] = { BDD_REORDER_SIFT, BDD_REORDER_WIN2ITE,
+			  BDD_REORDER_RANDOM };
+  for (unsigned int m=0 ; m<sizeof(methods)/sizeof(int) ; ++m)
+  {
+      /* Fill the caches, some entries with nodes that die */
+    bdd a = f & g;
+    bdd i = bdd_ite(f, g, h);
+    bdd_ite(g, h, f);
+    (f | h) & !g;
+    
+    bdd_varblockall();
+    bdd_reorder(methods[m]);
+    bdd_clrvarblocks();
+
+    if ((f & g) != a  ||  bdd_ite(f, g, h) != i)
+      ERROR("Wrong cached result after reordering");
+    if ((f & g) != !(!f | !g))
+      ERROR("Wrong apply result after reordering");
+    if (bdd_ite(g, h, f) != ((g & h) | (!g & f)))
+      ERROR("Wrong ITE result after reordering");
+    if (((f | h) & !g) != !(!(f | h) | g))
+      ERROR("Wrong result for dead nodes after reordering");
+    
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+  }
+
+  delete[] order;
+}
+
+
+static int resumeReorders;
+
+static void resumeHook(int prestate)
+{
+  if (prestate)
+    resumeReorders++;
+}
+
+
+static void testReorderResume(void)
+{
+  cout << "Testing operations resumed after reordering\n";
+
+  const int varnum = bdd_varnum();
+  const int half = varnum/2;
+  int *order = new int[varnum];
+  bdd *f = new bdd[200];
+  bdd var = bddtrue;
+
+  for (int v=half ; v<varnum ; ++v)
+    var &= bdd_ithvar(v);
+  
+  bddinthandler oldHook = bdd_reorder_hook(resumeHook);
+  bdd_autoreorder(BDD_REORDER_SIFT);
+
+    /* Keep enough functions alive to make the kernel reorder while the
+       operations are running. First the operations are retried as by
+       default, then they are resumed */
+  for (int resume=0 ; resume<2 ; ++resume)
+  {
+    bdd_clrvarblocks();
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+    bdd_varblockall();
+    for (int n=0 ; n<200 ; ++n)
+      f[n] = bddfalse;
+    bdd_gbc();
+    bdd_reorder_trigger(BDD_TRIGGER_DOUBLE);
+    
+    resumeReorders = 0;
+    int resumed = bdd_reorder_resumed();
+    bdd_reorder_resume(resume);
+    
+    srand48(17);
+    for (int n=0 ; n<200 ; ++n)
+    {
+      f[n] = bddfalse;
+      for (int m=0 ; m<8 ; ++m)
+      {
+	bdd t = bddtrue;
+	for (int v=0 ; v<varnum ; ++v)
+	  t &= (lrand48() & 1 ? bdd_ithvar(v) : bdd_nithvar(v));
+	f[n] |= t;
+      }
+      
+      if (n == 0)
+	continue;
+      
+      bdd a = f[n] & f[n-1];
+      if (a != !(!f[n] | !f[n-1]))
+	ERROR("Wrong apply result with reordering");
+      if (bdd_ite(f[n], f[n-1], a) != (f[n] & f[n-1]))
+	ERROR("Wrong ITE result with reordering");
+      if (bdd_appex(f[n], f[n-1], bddop_and, var) != bdd_exist(a, var))
+	ERROR("Wrong appex result with reordering");
+    }
+
+    if (resumeReorders == 0)
+      ERROR("No reordering was done while running the operations");
+    if (!resume  &&  bdd_reorder_resumed() != resumed)
+      ERROR("Operation resumed without bdd_reorder_resume");
+    if (resume  &&  bdd_reorder_resumed() == resumed)
+      ERROR("No operation was resumed after reordering");
+  }
+
+    /* Fill the node table with live nodes so that the next operation
+       finds no free node when the kernel wants to reorder. It is then
+       started over instead of resumed */
+  int *vars = new int[varnum];
+  bdd *pad = new bdd[bdd_getallocnum()];
+  int padnum = 0;
+  
+  for (int v=0 ; v<varnum ; ++v)
+    vars[v] = v;
+  bdd_reorder_trigger(BDD_TRIGGER_GROWTH);
+  int oldGrowth = bdd_reorder_triggergrowth(1);
+  bdd_disable_reorder();
+  bdd g = bddfalse, h = bddfalse;
+  for (int n=0 ; n<64 ; ++n)
+  {
+    g |= bdd_ibuildcube(lrand48(), varnum, vars);
+    h |= bdd_ibuildcube(lrand48(), varnum, vars);
+  }
+  bdd_gbc();
+  while (bdd_getallocnum() - bdd_getnodenum() > varnum*2)
+  {
+    pad[padnum++] = bdd_ibuildcube(lrand48(), varnum, vars);
+    if (bdd_getallocnum() - bdd_getnodenum() <= varnum*2)
+      bdd_gbc();
+  }
+  bdd_enable_reorder();
+
+  resumeReorders = 0;
+  bdd a = g ^ h;
+  if (resumeReorders == 0)
+    ERROR("No reordering was done with a full node table");
+  if (a != (!g ^ !h))
+    ERROR("Wrong apply result after starting over");
+
+  bdd_reorder_trigger(BDD_TRIGGER_DOUBLE);
+  bdd_reorder_triggergrowth(oldGrowth);
+  bdd_reorder_resume(0);
+  delete[] pad;
+  delete[] vars;
+  
+  bdd_autoreorder(BDD_REORDER_NONE);
+  bdd_reorder_hook(oldHook);
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  
+  delete[] f;
+  delete[] order;
+}
+
+
+/* Build and drop functions with automatic reordering under 'policy',
+   returning the number of reorderings done */
+static int triggerRun(int policy, int growth)
+{
+  const int varnum = bdd_varnum();
+  int *order = new int[varnum];
+  bdd *f = new bdd[400];
+
+  resumeReorders = 0;
+  bddinthandler oldHook = bdd_reorder_hook(resumeHook);
+  bdd_varblockall();
+  bdd_gbc();
+  bdd_reorder_trigger(policy);
+  bdd_reorder_triggergrowth(growth);
+  bdd_autoreorder(BDD_REORDER_SIFT);
+
+  srand48(23);
+  for (int n=0 ; n<400 ; ++n)
+  {
+    f[n] = bddfalse;
+    for (int m=0 ; m<24 ; ++m)
+    {
+      bdd t = bddtrue;
+      for (int v=0 ; v<varnum ; ++v)
+	t &= (lrand48() & 1 ? bdd_ithvar(v) : bdd_nithvar(v));
+      f[n] |= t;
+    }
+    if (n > 0  &&  (f[n] & f[n-1]) != !(!f[n] | !f[n-1]))
+      ERROR("Wrong apply result with reorder trigger");
+  }
+
+  int res = resumeReorders;
+  
+  bdd_autoreorder(BDD_REORDER_NONE);
+  bdd_reorder_trigger(BDD_TRIGGER_DOUBLE);
+  bdd_reorder_triggergrowth(100);
+  bdd_reorder_hook(oldHook);
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+
+  delete[] f;
+  delete[] order;
+  return res;
+}
+
+
+static void testReorderTrigger(void)
+{
+  cout << "Testing automatic reorder triggers\n";
+
+  if (bdd_reorder_trigger(BDD_TRIGGER_GROWTH) != BDD_TRIGGER_DOUBLE)
+    ERROR("Wrong default reorder trigger");
+  if (bdd_reorder_triggergrowth(50) != 100)
+    ERROR("Wrong default trigger growth");
+  bdd_reorder_trigger(BDD_TRIGGER_DOUBLE);
+  bdd_reorder_triggergrowth(100);
+  
+  int twice = triggerRun(BDD_TRIGGER_DOUBLE, 100);
+  int often = triggerRun(BDD_TRIGGER_GROWTH, 10);
+  int backoff = triggerRun(BDD_TRIGGER_BACKOFF, 10);
+  int cost = triggerRun(BDD_TRIGGER_COST, 10);
+
+  if (often == 0  ||  often < twice)
+    ERROR("Too few reorderings with a small growth trigger");
+  if (backoff > often)
+    ERROR("Too many reorderings with backoff");
+  if (cost > often)
+    ERROR("Too many reorderings with the cost trigger");
+}
+
+
+/* Read all of 'f' from the start into a string */
+static string fileText(FILE *f)
+{
+  string res;
+  int c;
+  
+  rewind(f);
+  while ((c=fgetc(f)) != EOF)
+    res += (char)c;
+  return res;
+}
+
+
+static void testOrderProfile(void)
+{
+  cout << "Testing saved variable orders\n";
+
+  int varnum = bdd_varnum();
+  int *order = new int[varnum+2];
+
+    /* Order and nested blocks survive a save and load */
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = varnum-1-v;
+  bdd_clrvarblocks();
+  bdd_setvarorder(order);
+  bdd_intaddvarblock(0,1,1);
+  bdd_intaddvarblock(2,3,0);
+  bdd_intaddvarblock(0,3,0);
+  
+  FILE *saved = tmpfile(), *printed = tmpfile(), *again = tmpfile();
+  if (bdd_saveorder(saved) != 0)
+    ERROR("Could not save order");
+  bdd_fprintorder(printed);
+  
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  
+  rewind(saved);
+  if (bdd_loadorder(saved) != 0)
+    ERROR("Could not load order");
+  for (int v=0 ; v<varnum ; ++v)
+    if (bdd_var2level(v) != varnum-1-v)
+      ERROR("Wrong order after load");
+  bdd_saveorder(again);
+  if (fileText(saved) != fileText(again))
+    ERROR("Saved order differs after load");
+  fclose(again);
+  again = tmpfile();
+  bdd_fprintorder(again);
+  if (fileText(printed) != fileText(again))
+    ERROR("Blocks differ after load");
+
+    /* Overlapping siblings and children outside their parent are
+       rejected, and the blocks are left as they were */
+  const char *badBlocks[] = { "2\n0 2 0 0 0\n1 3 0 1 0\n",
+			      "1\n0 1 0 0 1\n1 2 0 1 0\n" };
+  bddinthandler oldHook = bdd_error_hook(NULL);
+  for (int n=0 ; n<2 ; ++n)
+  {
+    FILE *bad = tmpfile();
+    fprintf(bad, "%d 2\n", varnum);
+    for (int v=0 ; v<varnum ; ++v)
+      fprintf(bad, "%d ", v);
+    fprintf(bad, "\n%s", badBlocks[n]);
+    rewind(bad);
+    if (bdd_loadorder(bad) != BDD_FORMAT)
+      ERROR("Malformed blocks loaded");
+    fclose(bad);
+  }
+  bdd_error_hook(oldHook);
+  for (int v=0 ; v<varnum ; ++v)
+    if (bdd_var2level(v) != varnum-1-v)
+      ERROR("Order changed by malformed blocks");
+  fclose(again);
+  again = tmpfile();
+  bdd_fprintorder(again);
+  if (fileText(printed) != fileText(again))
+    ERROR("Blocks changed by malformed blocks");
+  
+    /* An order for more variables waits for them to be made */
+  rewind(again);
+  fprintf(again, "%d 1\n%d %d ", varnum+2, varnum+1, varnum);
+  for (int v=0 ; v<varnum ; ++v)
+    fprintf(again, "%d ", v);
+  fprintf(again, "\n1\n%d %d 1 0 0\n", varnum, varnum+1);
+  fflush(again);
+  rewind(again);
+  if (bdd_loadorder(again) != 0)
+    ERROR("Could not load order for new variables");
+  if (bdd_var2level(varnum-1) != 0)
+    ERROR("Order for new variables applied too early");
+  bdd_setvarnum(varnum+2);
+  if (bdd_level2var(0) != varnum+1  ||  bdd_level2var(2) != 0  ||
+      bdd_var2level(varnum-1) != varnum+1)
+    ERROR("Order for new variables not applied");
+  varnum += 2;
+
+    /* The best order is kept after reordering */
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  bdd f = bddfalse;
+  for (int v=0 ; v<varnum/2 ; ++v)
+    f |= bdd_ithvar(v) & bdd_ithvar(v+varnum/2);
+  
+  const char *best = "bddtest.order";
+  remove(best);
+  bdd_reorder_bestfile((char*)best);
+  bdd_varblockall();
+  bdd_reorder(BDD_REORDER_SIFT);
+  bdd_reorder_bestfile(NULL);
+  if (bdd_reorder_gain() <= 0)
+    ERROR("No gain from sifting");
+  
+  int *found = new int[varnum];
+  for (int l=0 ; l<varnum ; ++l)
+    found[l] = bdd_level2var(l);
+  bdd_clrvarblocks();
+  bdd_setvarorder(order);
+  if (bdd_fnloadorder((char*)best) != 0)
+    ERROR("Could not load best order");
+  for (int l=0 ; l<varnum ; ++l)
+    if (bdd_level2var(l) != found[l])
+      ERROR("Wrong best order");
+  delete[] found;
+  remove(best);
+  
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+
+  fclose(saved);
+  fclose(printed);
+  fclose(again);
+  delete[] order;
+}
+
+
+static void testBinaryFile(void)
+{
+  cout << "Testing binary bdd files\n";
+
+  bdd a = bdd_ithvar(0), b = bdd_ithvar(3), c = bdd_ithvar(5);
+  bdd x = bddfalse;
+  for (int v=0 ; v<bdd_varnum() ; ++v)
+    x ^= bdd_ithvar(v) & bdd_ithvar((v+3) % bdd_varnum());
+  bdd tests[] = { bddtrue, bddfalse, a, !c, a & !b | c, x };
+  
+  FILE *f = tmpfile();
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+    if (bdd_binsave(f, tests[t]) != 0)
+      ERROR("Could not save binary bdd");
+  if (bdd_save(f, x) != 0)
+    ERROR("Could not save text bdd");
+
+    /* Load both formats through bdd_load */
+  rewind(f);
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+  {
+    bdd r;
+    if (bdd_load(f, r) != 0  ||  r != tests[t])
+      ERROR("Wrong bdd loaded from binary file");
+  }
+  bdd r;
+  if (bdd_load(f, r) != 0  ||  r != x)
+    ERROR("Wrong bdd loaded from text file after binary");
+
+    /* Load under a different order */
+  int varnum = bdd_varnum();
+  int *order = new int[varnum];
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = varnum-1-v;
+  bdd_clrvarblocks();
+  bdd_setvarorder(order);
+  fseek(f, 0, SEEK_SET);
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+    if (bdd_binload(f, r) != 0  ||  r != tests[t])
+      ERROR("Wrong bdd loaded under another order");
+  if (bdd_load(f, r) != 0  ||  r != x)
+    ERROR("Wrong text bdd loaded under another order");
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  delete[] order;
+  
+    /* A changed byte is found by the checksum */
+  fclose(f);
+  f = tmpfile();
+  bdd_binsave(f, x);
+  long size = ftell(f);
+  fseek(f, size/2, SEEK_SET);
+  int byte = fgetc(f);
+  fseek(f, size/2, SEEK_SET);
+  fputc(byte ^ 0x10, f);
+  rewind(f);
+  
+  bddinthandler old = bdd_error_hook(NULL);
+  if (bdd_binload(f, r) != BDD_FORMAT)
+    ERROR("Damaged binary file not detected");
+  fclose(f);
+
+    /* A huge node count in a short file is found without allocating
+       room for all the nodes */
+  const unsigned char huge[] = { 'B','D','D','B', 2, 1, 0,
+				 0xFD, 0xFF, 0xFF, 0xFF, 0x07, 0, 1, 2 };
+  f = tmpfile();
+  fwrite(huge, 1, sizeof(huge), f);
+  rewind(f);
+  if (bdd_binload(f, r) != BDD_FORMAT)
+    ERROR("Short binary file with a huge node count not detected");
+  bdd_error_hook(old);
+  fclose(f);
+
+    /* Node numbers in a text file may be large */
+  f = tmpfile();
+  fprintf(f, "1 1\n0\n2147483647 0 0 1\n");
+  rewind(f);
+  if (bdd_load(f, r) != 0  ||  r != bdd_ithvar(0))
+    ERROR("Wrong bdd loaded with a large node number");
+  fclose(f);
+}
+
+
+static void testSaveMany(void)
+{
+  cout << "Testing saving several bdds\n";
+
+  bdd shared = bddfalse;
+  for (int v=0 ; v<bdd_varnum()-1 ; ++v)
+    shared ^= bdd_ithvar(v) & bdd_ithvar(v+1);
+  bdd r[] = { shared & bdd_ithvar(0), bddtrue, shared | bdd_ithvar(1), shared };
+  char *names[] = { (char*)"first", NULL, (char*)"third", (char*)"" };
+  const int num = sizeof(r)/sizeof(bdd);
+
+    /* The shared nodes are written once */
+  FILE *f = tmpfile();
+  for (int n=0 ; n<num ; ++n)
+    bdd_binsave(f, r[n]);
+  long single = ftell(f);
+  fclose(f);
+  
+  f = tmpfile();
+  if (bdd_save_named(f, r, names, num) != 0)
+    ERROR("Could not save named bdds");
+  if (ftell(f) >= single)
+    ERROR("Shared nodes saved more than once");
+  if (bdd_save_many(f, r, num) != 0)
+    ERROR("Could not save bdds");
+  
+  rewind(f);
+  bdd *loaded;
+  char **loadnames;
+  int loadnum;
+  if (bdd_load_named(f, &loaded, &loadnames, &loadnum) != 0)
+    ERROR("Could not load named bdds");
+  if (loadnum != num)
+    ERROR("Wrong number of bdds loaded");
+  for (int n=0 ; n<loadnum ; ++n)
+  {
+    if (loaded[n] != r[n])
+      ERROR("Wrong named bdd loaded");
+    if ((names[n] == NULL  ||  names[n][0] == 0) ?
+	loadnames[n] != NULL : strcmp(names[n], loadnames[n]) != 0)
+      ERROR("Wrong name loaded");
+    free(loadnames[n]);
+  }
+  free(loadnames);
+  delete[] loaded;
+
+  if (bdd_load_many(f, &loaded, &loadnum) != 0  ||  loadnum != num)
+    ERROR("Could not load bdds");
+  for (int n=0 ; n<loadnum ; ++n)
+    if (loaded[n] != r[n])
+      ERROR("Wrong bdd loaded");
+  delete[] loaded;
+
+    /* The C interface gives the same nodes */
+  rewind(f);
+  BDD *roots;
+  if (bdd_load_many(f, &roots, &loadnum) != 0  ||  loadnum != num)
+    ERROR("Could not load bdds through C");
+  for (int n=0 ; n<loadnum ; ++n)
+    if (roots[n] != r[n].id())
+      ERROR("Wrong bdd loaded through C");
+  free(roots);
+  fclose(f);
+}
+
+
+static void testProgramMap(void)
+{
+  cout << "Testing mapped programs\n";
+
+  const int varnum = bdd_varnum();
+  const char *fname = "bddtest.prog";
+  char *assign = new char[varnum];
+  signed char *partial = new signed char[varnum];
+  int *order = new int[varnum];
+
+    /* Compile under a reversed order so the levels differ from the
+       variable numbers */
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = varnum-1-v;
+  bdd_setvarorder(order);
+
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(varnum-1);
+  bdd tests[] = { bddtrue, bddfalse, a, !b, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c), (a | d) & (b | c) };
+  const int num = sizeof(tests)/sizeof(bdd);
+
+  bddProgram *p = bdd_acompile(tests, num, BDD_COMPILE_BFS);
+  if (p == NULL  ||  bdd_program_fnsave((char*)fname, p) != 0)
+    ERROR("Could not save compiled program");
+  bdd_program_free(p);
+
+  for (int check=0 ; check<2 ; ++check)
+  {
+    bddProgram *q = bdd_program_map((char*)fname, check);
+    if (q == NULL  ||  bdd_program_rootnum(q) != num)
+      ERROR("Could not map compiled program");
+
+    for (int t=0 ; t<num ; ++t)
+    {
+      if (!nearlyEqual(bdd_program_satcount(q, t), bdd_satcount(tests[t])))
+	ERROR("Wrong satcount from mapped program");
+
+      int sat = bdd_program_satone(q, t, assign);
+      if (sat != (tests[t] != bddfalse))
+	ERROR("Wrong result from satone on mapped program");
+      if (sat  &&  bdd_program_eval(q, t, assign) != 1)
+	ERROR("Wrong assignment from satone on mapped program");
+
+      for (int n=0 ; n<4 ; ++n)
+      {
+	for (int v=0 ; v<varnum ; ++v)
+	  partial[v] = -1;
+	partial[0] = n & 1;
+	partial[3] = (n >> 1) & 1;
+	
+	bdd r = bdd_restrict(tests[t], (n & 1 ? a : !a) & (n & 2 ? b : !b));
+	int res = (r == bddfalse ? 0 : r == bddtrue ? 1 : 2);
+	if (bdd_program_restrict(q, t, partial) != res)
+	  ERROR("Wrong result from restrict on mapped program");
+      }
+    }
+    
+    bdd_program_free(q);
+  }
+  remove(fname);
+
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+
+  delete[] assign;
+  delete[] partial;
+  delete[] order;
+}
+
+
+  /* Writes 'size' bytes of a checkpoint followed by their checksum */
+static void writeCheckpoint(const char *fname, const unsigned char *data,
+			    int size)
+{
+  FILE *f = fopen(fname, "wb");
+  unsigned int sum = 2166136261U;
+  
+  fwrite(data, 1, size, f);
+  for (int n=0 ; n<size ; ++n)
+    sum = (sum ^ data[n]) * 16777619U;
+  for (int n=0 ; n<4 ; ++n)
+    fputc((sum >> (8*n)) & 0xFF, f);
+  fclose(f);
+}
+
+
+static void testCheckpoint(void)
+{
+  cout << "Testing checkpoints\n";
+
+  const char *fname = "bddtest.chk";
+  const int varnum = bdd_varnum();
+  int *order = new int[varnum];
+  int dom[] = { 4, 8 };
+  BDD roots[3], replaced;
+  double count[3];
+  FILE *blocks = tmpfile(), *again = tmpfile();
+
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = varnum-1-v;
+  bdd_clrvarblocks();
+  bdd_setvarorder(order);
+  bdd_intaddvarblock(0,1,1);
+  bdd_intaddvarblock(4,7,0);
+  bdd_saveorder(blocks);
+
+  int d = fdd_extdomain(dom, 2);
+  bddPair *pair = bdd_newpair();
+  int nodes;
+  {
+    bdd a = bdd_ithvar(0);
+    bdd b = bdd_ithvar(3);
+    bdd c = bdd_ithvar(5);
+    bdd_setpair(pair, 0, 7);
+    bdd_setbddpair(pair, 3, bdd_ithvar(1) & c);
+
+    roots[0] = bdd_addref((a & !b | c).id());
+    roots[1] = bdd_addref((a ^ b ^ c ^ bdd_ithvar(varnum-1)).id());
+    roots[2] = bdd_addref((fdd_ithvar(d,3) & fdd_ithvar(d+1,5)).id());
+    replaced = bdd_addref(bdd_veccompose(roots[0], pair));
+    for (int n=0 ; n<3 ; ++n)
+      count[n] = bdd_satcount(roots[n]);
+
+      /* Unreferenced nodes are not saved */
+    bdd garbage = bddtrue;
+    for (int v=0 ; v<varnum ; ++v)
+      garbage &= bdd_ithvar(v) | bdd_ithvar((v+5) % varnum);
+    nodes = bdd_getnodenum();
+  }
+
+  if (bdd_checkpoint((char*)fname) != 0)
+    ERROR("Could not save checkpoint");
+
+  bdd_done();
+  bdd_init(1000,1000);
+  bdd_gbc_hook(NULL);
+
+    /* Nodes over the constants and equal nodes are rejected. Both files
+       have one variable and two nodes with the variable set after them */
+  const unsigned char overTrue[] = { 'B','D','D','C', 1, 10, 1, 0, 2,
+				     1, 0, 0, 1, 1,  1, 0, 1, 0, 1,
+				     1, 2,  0, 0, 0, 0 };
+  const unsigned char equal[] = { 'B','D','D','C', 1, 10, 1, 0, 2,
+				  2, 0, 0, 1, 1,  1, 0, 0, 1, 1,
+				  2, 3,  0, 0, 0, 0 };
+  const char *badname = "bddtest.bad";
+  bddinthandler oldHook = bdd_error_hook(NULL);
+  writeCheckpoint(badname, overTrue, sizeof(overTrue));
+  if (bdd_restore((char*)badname, NULL, NULL) != BDD_FORMAT)
+    ERROR("Checkpoint node over the constant true restored");
+  writeCheckpoint(badname, equal, sizeof(equal));
+  if (bdd_restore((char*)badname, NULL, NULL) != BDD_FORMAT)
+    ERROR("Checkpoint with equal nodes restored");
+  bdd_error_hook(oldHook);
+  remove(badname);
+
+  bddPair **pairs;
+  int pairnum;
+  if (bdd_restore((char*)fname, &pairs, &pairnum) != 0)
+    ERROR("Could not restore checkpoint");
+  remove(fname);
+  
+  if (bdd_varnum() != varnum  ||  bdd_var2level(0) != varnum-1)
+    ERROR("Wrong order after restore");
+  if (bdd_getnodenum() >= nodes)
+    ERROR("Unreferenced nodes restored");
+  bdd_saveorder(again);
+  if (fileText(blocks) != fileText(again))
+    ERROR("Wrong blocks after restore");
+
+  {
+    bdd a = bdd_ithvar(0);
+    bdd b = bdd_ithvar(3);
+    bdd c = bdd_ithvar(5);
+
+      /* The unique table finds the restored nodes */
+    for (int n=0 ; n<3 ; ++n)
+      if (bdd_satcount(roots[n]) != count[n])
+	ERROR("Wrong bdd after restore");
+    if ((a & !b | c).id() != roots[0])
+      ERROR("Restored node not found");
+    if ((a ^ b ^ c ^ bdd_ithvar(varnum-1)).id() != roots[1])
+      ERROR("Restored node not found");
+    
+    if (fdd_domainnum() != d+2  ||  fdd_domainsize(d+1) != 8  ||
+	(fdd_ithvar(d,3) & fdd_ithvar(d+1,5)).id() != roots[2])
+      ERROR("Wrong domains after restore");
+
+    if (pairnum < 1  ||
+	bdd_veccompose(roots[0], pairs[pairnum-1]) != replaced)
+      ERROR("Wrong pair after restore");
+  }
+
+  bddinthandler old = bdd_error_hook(NULL);
+  if (bdd_restore((char*)fname, NULL, NULL) != BDD_RUNNING)
+    ERROR("Restored into a running package");
+  bdd_error_hook(old);
+
+  for (int n=0 ; n<3 ; ++n)
+    bdd_delref(roots[n]);
+  bdd_delref(replaced);
+  free(pairs);
+  
+  bdd_clrvarblocks();
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+
+  fclose(blocks);
+  fclose(again);
+  delete[] order;
+}
+
+
+static void testStream(void)
+{
+  cout << "Testing bdd streams\n";
+
+  const int varnum = bdd_varnum();
+  const int num = 8;
+  int *order = new int[varnum];
+  bdd frontier[num];
+  long size[2];
+
+  for (int flags=0 ; flags<=BDD_STREAM_LZ ; ++flags)
+  {
+    FILE *f = tmpfile();
+    bddStream *s = bdd_stream_open(f, flags);
+    if (s == NULL)
+      ERROR("Could not open stream");
+
+    bdd reached = bddfalse;
+    for (int n=0 ; n<num ; ++n)
+    {
+      reached |= bdd_ithvar(n) & bdd_nithvar((n+3) % varnum) &
+	bdd_ithvar((n+5) % varnum);
+      frontier[n] = reached;
+      
+	/* The nodes written before are checked again after reordering */
+      if (n == num/2)
+      {
+	for (int v=0 ; v<varnum ; ++v)
+	  order[v] = varnum-1-v;
+	bdd_setvarorder(order);
+	bdd_gbc();
+      }
+      if (bdd_stream_add(s, reached) != n)
+	ERROR("Could not add to stream");
+    }
+
+    bdd_stream_flush(s);
+    long before = ftell(f);
+    bdd_stream_add(s, frontier[num-1]);
+    bdd_stream_add(s, frontier[1]);
+    bdd_stream_flush(s);
+    if (ftell(f) - before > 20)
+      ERROR("Known nodes written again to stream");
+    if (bdd_stream_close(s) != 0)
+      ERROR("Could not close stream");
+    size[flags] = ftell(f);
+
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+    
+    for (int n=0 ; n<num ; ++n)
+    {
+      bdd r;
+      rewind(f);
+      if (bdd_stream_load(f, n, r) != 0  ||  r != frontier[n])
+	ERROR("Wrong bdd loaded from stream");
+    }
+    
+    bdd r;
+    rewind(f);
+    if (bdd_stream_load(f, -1, r) != 0  ||  r != frontier[1])
+      ERROR("Wrong last bdd loaded from stream");
+    
+    bddinthandler old = bdd_error_hook(NULL);
+    rewind(f);
+    if (bdd_stream_load(f, num+2, r) != BDD_RANGE)
+      ERROR("Missing bdd loaded from stream");
+    bdd_error_hook(old);
+    fclose(f);
+  }
+  if (size[1] >= size[0])
+    ERROR("Compressed stream not smaller");
+
+    /* A stream is readable up to the last flush before it is closed */
+  const char *fname = "bddtest.stream";
+  bddStream *s = bdd_stream_fnopen((char*)fname, BDD_STREAM_LZ);
+  bdd_stream_add(s, frontier[2]);
+  bdd_stream_add(s, frontier[5]);
+  bdd_stream_flush(s);
+  bdd r;
+  if (bdd_stream_fnload((char*)fname, -1, r) != 0  ||  r != frontier[5])
+    ERROR("Could not load from unfinished stream");
+  bdd_stream_close(s);
+  remove(fname);
+  
+  delete[] order;
+}
+
+
+static void checkExact(bdd r, const char *expected)
+{
+  char *res = bdd_satcount_exact(r);
+  if (res == NULL  ||  strcmp(res, expected) != 0)
+    ERROR("Exact satcount failed");
+  free(res);
+}
+
+
+static bddCircuit *loadCircuit(const char *text, int size)
+{
+  FILE *f = tmpfile();
+  fwrite(text, 1, size, f);
+  rewind(f);
+  bddCircuit *c = bdd_circuit_load(f);
+  fclose(f);
+  return c;
+}
+
+
+static void testCircuit(void)
+{
+  cout << "Testing circuit import\n";
+
+  bdd x = bdd_ithvar(0), y = bdd_ithvar(1), s = bdd_ithvar(2);
+  bdd out[4];
+
+    /* A half adder with a latch as ASCII and binary AIGER */
+  const char aag[] =
+    "aag 7 2 1 2 4\n2\n4\n6 8\n12\n15\n"
+    "8 2 4\n10 3 5\n12 9 11\n14 12 6\n"
+    "i0 x\no1 carry\nc\ncomment\n";
+  const char aig[] =
+    "aig 7 2 1 2 4\n8\n12\n15\n"
+    "\x04\x02\x05\x02\x01\x02\x02\x06";
+
+  for (int binary=0 ; binary<2 ; ++binary)
+  {
+    bddCircuit *c = binary ? loadCircuit(aig, sizeof(aig)-1)
+                           : loadCircuit(aag, sizeof(aag)-1);
+    bddCircuitStat stat;
+
+    if (c == NULL)
+      ERROR("Could not load AIGER circuit");
+    if (bdd_circuit_inputnum(c) != 3  ||  bdd_circuit_outputnum(c) != 3  ||
+	bdd_circuit_gatenum(c) != 4)
+      ERROR("Wrong size of AIGER circuit");
+    if (strcmp(bdd_circuit_outputname(c,2), "l0'") != 0  ||
+	strcmp(bdd_circuit_inputname(c,1), "i1") != 0  ||
+	(!binary  &&  (strcmp(bdd_circuit_inputname(c,0), "x") != 0  ||
+		       strcmp(bdd_circuit_outputname(c,1), "carry") != 0)))
+      ERROR("Wrong names in AIGER circuit");
+    
+    if (bdd_circuit_build(c, 0, BDD_CIRCUIT_PEAK, out, &stat) != 0)
+      ERROR("Could not build AIGER circuit");
+    if (out[0] != (x ^ y)  ||  out[1] != !((x ^ y) & s)  ||  out[2] != (x & y))
+      ERROR("Wrong outputs of AIGER circuit");
+    if (stat.gates != 4  ||  stat.maxlive != 3  ||  stat.peaklive <= 0)
+      ERROR("Wrong statistics for AIGER circuit");
+    bdd_circuit_free(c);
+  }
+
+    /* Covers defined out of order, an offset cover and a latch */
+  const char blif[] =
+    "# test\n.model t\n.inputs a b \\\n c\n.outputs f g\n"
+    ".names n1 c f\n1- 1\n-1 1\n"
+    ".names a b n1\n11 1\n"
+    ".names a c g\n00 0\n"
+    ".latch f q 0\n.end\n";
+  bddCircuit *c = loadCircuit(blif, sizeof(blif)-1);
+
+  if (c == NULL)
+    ERROR("Could not load BLIF circuit");
+  if (bdd_circuit_inputnum(c) != 4  ||  bdd_circuit_outputnum(c) != 3  ||
+      strcmp(bdd_circuit_inputname(c,3), "q") != 0  ||
+      strcmp(bdd_circuit_outputname(c,2), "q'") != 0)
+    ERROR("Wrong signals in BLIF circuit");
+
+  for (int flags=0 ; flags<=BDD_CIRCUIT_ORDER ; flags+=BDD_CIRCUIT_ORDER)
+  {
+    bdd a = bdd_ithvar(3), b = bdd_ithvar(4), cc = bdd_ithvar(5);
+    
+    if (bdd_circuit_build(c, 3, flags, out, NULL) != 0)
+      ERROR("Could not build BLIF circuit");
+    if (out[0] != ((a & b) | cc)  ||  out[1] != (a | cc)  ||  out[2] != out[0])
+      ERROR("Wrong outputs of BLIF circuit");
+    if (flags  &&  bdd_var2level(0) != 0)
+      ERROR("Static order moved other variables");
+    
+    int *order = new int[bdd_varnum()];
+    for (int v=0 ; v<bdd_varnum() ; ++v)
+      order[v] = v;
+    bdd_setvarorder(order);
+    delete[] order;
+  }
+  bdd_circuit_free(c);
+
+    /* Cycles are found when loading */
+  const char cycle[] =
+    ".inputs a\n.outputs x\n.names a y x\n11 1\n.names x y\n1 1\n.end\n";
+  bddinthandler old = bdd_error_hook(NULL);
+  if (loadCircuit(cycle, sizeof(cycle)-1) != NULL)
+    ERROR("Cyclic circuit loaded");
+  bdd_error_hook(old);
+}
+
+
+static void checkCnfCount(bddCnf *cnf, int flags, const bdd &r,
+			  const bdd &varset)
+{
+  char buf[64];
+  char *count = bdd_cnf_count(cnf, 0, flags);
+  
+  sprintf(buf, "%.0f", bdd_satcountset(r, varset));
+  if (count == NULL  ||  strcmp(count, buf) != 0)
+    ERROR("Wrong count for CNF formula");
+  free(count);
+}
+
+
+static void testCnf(void)
+{
+  cout << "Testing CNF formulas\n";
+
+    /* The third clause spans two lines and the last is a tautology */
+  const char text[] =
+    "c small example\nc ind 1 2 0\np cnf 5 4\n"
+    "1 -2 0\n2 3 -4 0\n-1 4\n0\n3 -3 5 0\n";
+  FILE *f = tmpfile();
+  fputs(text, f);
+  rewind(f);
+  bddCnf *cnf = bdd_cnf_load(f);
+  fclose(f);
+
+  if (cnf == NULL)
+    ERROR("Could not load CNF formula");
+  if (bdd_cnf_varnum(cnf) != 5  ||  bdd_cnf_clausenum(cnf) != 4)
+    ERROR("Wrong size of CNF formula");
+
+  bdd x1 = bdd_ithvar(0), x2 = bdd_ithvar(1), x3 = bdd_ithvar(2);
+  bdd x4 = bdd_ithvar(3), x5 = bdd_ithvar(4);
+  bdd naive = (x1 | bdd_nithvar(1)) & (x2 | x3 | bdd_nithvar(3)) &
+    (bdd_nithvar(0) | x4);
+  bdd all = x1 & x2 & x3 & x4 & x5;
+  bdd shown = x1 & x2;
+  bdd projected = bdd_exist(naive, x3 & x4 & x5);
+  
+  for (int flags=0 ; flags<=BDD_CNF_MINWIDTH ; ++flags)
+  {
+    bdd r;
+    
+    if (bdd_cnf_build(cnf, 0, flags, r) != 0  ||  r != naive)
+      ERROR("Wrong bdd for CNF formula");
+    if (bdd_cnf_build(cnf, 0, flags | BDD_CNF_PROJECT, r) != 0  ||
+	r != projected)
+      ERROR("Wrong projected bdd for CNF formula");
+    
+    checkCnfCount(cnf, flags, naive, all);
+    checkCnfCount(cnf, flags | BDD_CNF_PROJECT, projected, shown);
+  }
+  bdd_cnf_free(cnf);
+
+    /* Unsatisfiable, and beyond the precision of a double */
+  const char *unsat = "p cnf 2 3\n1 2 0\n-1 0\n-2 0\n";
+  const char *free100 = "p cnf 100 1\n1 -1 0\n";
+  const char *expect[] = { "0", "1267650600228229401496703205376" };
+  const char *tests[] = { unsat, free100 };
+
+  for (int t=0 ; t<2 ; ++t)
+  {
+    f = tmpfile();
+    fputs(tests[t], f);
+    rewind(f);
+    cnf = bdd_cnf_load(f);
+    fclose(f);
+    
+    char *count = (cnf == NULL ? NULL : bdd_cnf_count(cnf, 0, 0));
+    if (count == NULL  ||  strcmp(count, expect[t]) != 0)
+      ERROR("Wrong count for special CNF formula");
+    free(count);
+    bdd_cnf_free(cnf);
+  }
+}
+
+
+static void printName(ostream &o, int var)
+{
+  o << "x" << var;
+}
+
+
+static void testPrint(void)
+{
+  cout << "Testing buffered printing\n";
+
+  if (bdd_varnum() < 12)
+    bdd_setvarnum(12);
+  
+    /* One cube for each of the 2^11 paths, many times the buffer size */
+  bdd x = bddfalse;
+  for (int v=0 ; v<12 ; ++v)
+    x ^= bdd_ithvar(v);
+  
+  ostringstream out;
+  out << bddset << x;
+  string s = out.str();
+  
+  int cubes = 0;
+  for (unsigned int n=0 ; n<s.size() ; ++n)
+    if (s[n] == '<')
+      cubes++;
+  if (cubes != 2048  ||  s.size() < 3*8192  ||  s[s.size()-1] != '>')
+    ERROR("Wrong set output of large bdd");
+
+  FILE *f = tmpfile();
+  bdd_fprintset(f, x.id());
+  long len = ftell(f);
+  rewind(f);
+  string c(len, ' ');
+  if (len != (long)s.size()  ||  fread(&c[0], 1, len, f) != (size_t)len  ||
+      c != s)
+    ERROR("C and C++ set output differ");
+  fclose(f);
+
+    /* The handler writes to the stream between buffered text */
+  bdd_strm_hook(printName);
+  ostringstream named;
+  named << bddset << (bdd_ithvar(3) & bdd_nithvar(5)) << " ";
+  named << bdddot << bdd_ithvar(3) << bddset;
+  bdd_strm_hook(NULL);
+  
+  string cube = (bdd_var2level(3) < bdd_var2level(5) ?
+		 "<x3:1, x5:0>" : "<x5:0, x3:1>");
+  if (named.str().compare(0, cube.size()+1, cube + " ") != 0  ||
+      named.str().find("[label=\"x3\"];\n") == string::npos)
+    ERROR("Wrong output with print handler");
+}
+
+
+static void testProgramShare(void)
+{
+  cout << "Testing shared programs\n";
+
+  const int varnum = bdd_varnum();
+  const char *name = "/bddtest.share";
+  int *order = new int[varnum];
+  
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(varnum-1);
+  bdd tests[] = { bddtrue, a & !b | c & d, (a ^ b ^ c ^ d),
+		  (a ^ b ^ c ^ d) & c, bddfalse };
+  const int num = sizeof(tests)/sizeof(bdd);
+
+  bddProgram *p = bdd_acompile(tests, num, BDD_COMPILE_DFS);
+  if (p == NULL)
+    ERROR("Could not compile program for sharing");
+
+    /* Shared memory may not be available, which is not an error here.
+       A stale object from an earlier run is removed first. */
+  bddinthandler old = bdd_error_hook(NULL);
+  bdd_program_unshare((char*)name);
+  int err = bdd_program_share(p, (char*)name);
+  bdd_error_hook(old);
+  bdd_program_free(p);
+  if (err != 0)
+  {
+    delete[] order;
+    return;
+  }
+
+  bddProgram *q = bdd_program_attach((char*)name, 1);
+  if (q == NULL  ||  bdd_program_rootnum(q) != num)
+    ERROR("Could not attach shared program");
+  if (bdd_program_unshare((char*)name) != 0)
+    ERROR("Could not remove shared program");
+
+    /* Import with the same order, then again after the order changed */
+  for (int pass=0 ; pass<2 ; ++pass)
+  {
+    for (int t=0 ; t<num ; ++t)
+    {
+      bdd r, again;
+      if (bdd_program_import(q, t, r) != 0  ||  r != tests[t])
+	ERROR("Wrong bdd imported from shared program");
+      if (bdd_program_import(q, t, again) != 0  ||  again != r)
+	ERROR("Wrong second import from shared program");
+    }
+
+    bdd_program_forget(q);
+    for (int v=0 ; v<varnum ; ++v)
+      order[v] = varnum-1-v;
+    bdd_setvarorder(order);
+  }
+
+  bdd_program_free(q);
+  
+  for (int v=0 ; v<varnum ; ++v)
+    order[v] = v;
+  bdd_setvarorder(order);
+  delete[] order;
+}
+
+
+static void testSatcountExact(void)
+{
+  cout << "Testing exact satcount\n";
+
+  bdd a = bdd_ithvar(0);
+  bdd b = bdd_ithvar(3);
+  bdd c = bdd_ithvar(5);
+  bdd d = bdd_ithvar(9);
+  bdd tests[] = { bddtrue, bddfalse, a, !c, a & !b | c & d,
+		  (a ^ b ^ c ^ d), a >> (b | !c) };
+  
+  for (unsigned int t=0 ; t<sizeof(tests)/sizeof(bdd) ; ++t)
+  {
+    char buf[64];
+    sprintf(buf, "%.0f", bdd_satcount(tests[t]));
+    checkExact(tests[t], buf);
+  }
+
+  /* Beyond the precision of a double */
+  bdd_setvarnum(100);
+  checkExact(bddtrue, "1267650600228229401496703205376");
+  checkExact(bdd_ithvar(50), "633825300114114700748351602688");
+
+  bdd x = bddfalse;
+  for (int v=0 ; v<100 ; ++v)
+    x ^= bdd_ithvar(v);
+  checkExact(x, "633825300114114700748351602688");
+  checkExact(x & bdd_ithvar(99) & bdd_nithvar(98),
+	     "158456325028528675187087900672");
+
+  /* Beyond the range of a double */
+  bdd_setvarnum(1100);
+  char *res = bdd_satcount_exact(bddtrue);
+  if (strlen(res) != 332  ||  strcmp(res+312, "48948790552744165376") != 0)
+    ERROR("Exact satcount of 2^1100 failed");
+  free(res);
+}
+
+
 int main(int ac, char** av)
 {
   bdd_init(1000,1000);
+  bdd_gbc_hook(NULL);
 
   bdd_setvarnum(10);
 
   testSupport();
   testBvecIte();
+  testCubeIter();
+  testWmc();
+  testEvalBatch();
+  testCompile();
+  testSiftSym();
+  testReorderThreads();
+  testReorderExact();
+  testSiftBudget();
+  testReorderStochastic();
+  testReorderCache();
+  testReorderResume();
+  testReorderTrigger();
+  testOrderProfile();
+  testBinaryFile();
+  testSaveMany();
+  testProgramMap();
+  testCheckpoint();
+  testStream();
+  testCircuit();
+  testCnf();
+  testPrint();
+  testProgramShare();
+  testSatcountExact();
 
   bdd_done();
   return 0;
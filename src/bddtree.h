@@ -45,6 +45,8 @@ typedef struct s_BddTree
    int *seq;         /* Sequence of first...last in the current order */
    char fixed;       /* Are the sub-blocks fixed or may they be reordered */
    int id;           /* A sequential id number given by addblock */
+   int symsize;      /* Size of symmetry group (only valid at the head) */
+   struct s_BddTree *symhead; /* First block of symmetry group */
    struct s_BddTree *next, *prev;
    struct s_BddTree *nextlevel;
 } BddTree;
@@ -52,6 +54,7 @@ typedef struct s_BddTree
 BddTree *bddtree_new(int);
 void     bddtree_del(BddTree *);
 BddTree *bddtree_addrange(BddTree *, int, int, int, int);
+BddTree *bddtree_newrange(int, int, int, int);
 void     bddtree_print(FILE *, BddTree *, int);
 
 #endif /* _TREE_H */
@@ -0,0 +1,155 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  bignum.c
+  DESCR: Fixed size unsigned big integers for exact counting
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "bignum.h"
+
+/* The numbers are arrays of 32 bit limbs with the least significant limb
+   first. The size of a number is fixed by the caller, who is also
+   responsible for making it large enough to hold the results. */
+
+/*************************************************************************
+*************************************************************************/
+
+void bignum_clear(bddlimb *a, int size)
+{
+   memset(a, 0, sizeof(bddlimb)*size);
+}
+
+
+/* Calculates dst += src << shift. Limbs of the shifted source beyond the
+   size of the destination must be zero. */
+void bignum_addshift(bddlimb *dst, int dsize, const bddlimb *src, int ssize,
+		     int shift)
+{
+   int ls = shift / BIGNUM_BITS;
+   int bs = shift % BIGNUM_BITS;
+   uint64_t carry = 0;
+   int n;
+
+   for (n=0 ; n<ssize  &&  n+ls<dsize ; n++)
+   {
+      uint64_t v = (uint64_t)src[n] << bs;
+      uint64_t t = (uint64_t)dst[n+ls] + (v & 0xFFFFFFFF) + carry;
+      
+      dst[n+ls] = (bddlimb)t;
+      carry = (t >> BIGNUM_BITS) + (v >> BIGNUM_BITS);
+   }
+
+   for (n+=ls ; carry  &&  n<dsize ; n++)
+   {
+      uint64_t t = (uint64_t)dst[n] + carry;
+      dst[n] = (bddlimb)t;
+      carry = t >> BIGNUM_BITS;
+   }
+}
+
+
+/* Calculates a >>= shift */
+void bignum_shiftright(bddlimb *a, int size, int shift)
+{
+   int ls = shift / BIGNUM_BITS;
+   int bs = shift % BIGNUM_BITS;
+   int n;
+
+   for (n=0 ; n<size ; n++)
+   {
+      uint64_t v = (n+ls < size ? a[n+ls] : 0);
+      
+      if (n+ls+1 < size)
+	 v |= (uint64_t)a[n+ls+1] << BIGNUM_BITS;
+      a[n] = (bddlimb)(v >> bs);
+   }
+}
+
+
+/* Converts 'a' to a malloc'ed decimal string */
+char *bignum_tostring(const bddlimb *a, int size)
+{
+   bddlimb *tmp;
+   uint32_t *chunk;
+   char *res, *p;
+   int top = size, num = 0, n;
+
+   tmp = (bddlimb*)malloc(sizeof(bddlimb)*size);
+      /* Each chunk of 9 digits holds at least 29 bits */
+   chunk = (uint32_t*)malloc(sizeof(uint32_t)*(size*BIGNUM_BITS/29+1));
+   res = (char*)malloc(9*(size*BIGNUM_BITS/29+1)+1);
+
+   if (tmp == NULL  ||  chunk == NULL  ||  res == NULL)
+   {
+      free(tmp);
+      free(chunk);
+      free(res);
+      return NULL;
+   }
+
+   memcpy(tmp, a, sizeof(bddlimb)*size);
+   while (top > 0  &&  tmp[top-1] == 0)
+      top--;
+
+      /* Repeated division by 10^9 */
+   while (top > 0)
+   {
+      uint64_t rem = 0;
+      
+      for (n=top-1 ; n>=0 ; n--)
+      {
+	 uint64_t cur = (rem << BIGNUM_BITS) | tmp[n];
+	 tmp[n] = (bddlimb)(cur / 1000000000);
+	 rem = cur % 1000000000;
+      }
+      
+      chunk[num++] = (uint32_t)rem;
+      while (top > 0  &&  tmp[top-1] == 0)
+	 top--;
+   }
+
+   if (num == 0)
+      strcpy(res, "0");
+   else
+   {
+      p = res + sprintf(res, "%u", (unsigned int)chunk[num-1]);
+      for (n=num-2 ; n>=0 ; n--)
+	 p += sprintf(p, "%09u", (unsigned int)chunk[n]);
+   }
+
+   free(tmp);
+   free(chunk);
+   return res;
+}
+
+
+/* EOF */
@@ -0,0 +1,56 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  bignum.h
+  DESCR: Fixed size unsigned big integers for exact counting
+*************************************************************************/
+
+#ifndef _BIGNUM_H
+#define _BIGNUM_H
+
+#include <stdint.h>
+
+typedef uint32_t bddlimb;
+
+#define BIGNUM_BITS 32
+
+   /* Number of limbs needed to hold any value up to and including 2^bits */
+#define BIGNUM_SIZE(bits) ((bits)/BIGNUM_BITS+1)
+
+extern void  bignum_clear(bddlimb*, int);
+extern void  bignum_addshift(bddlimb*, int, const bddlimb*, int, int);
+extern void  bignum_shiftright(bddlimb*, int, int);
+extern char* bignum_tostring(const bddlimb*, int);
+
+
+#endif /* _BIGNUM_H */
+
+
+/* EOF */
@@ -0,0 +1,1164 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  binio.c
+  DESCR: Binary file format for BDDs and checkpoints
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "kernel.h"
+#include "fdd.h"
+
+/* The binary format is a byte stream where all numbers are unsigned
+   varints, seven bits per byte with the low bits first and the high bit
+   set on all but the last byte:
+
+     magic     "BDDB"
+     version
+     varnum    var2level[0] ... var2level[varnum-1]
+     nodenum   nodenum * (var, index-low, index-high)
+     rootnum   rootnum * (root, namelen, name[namelen])
+     checksum  4 bytes, FNV-1a of everything before it, low byte first
+
+   The constants are numbered 0 and 1 and the nodes 2..nodenum+1 in
+   postorder, so the children always come first and are written as the
+   distance back from the node. This keeps most of them to one byte.
+   Nodes shared by several roots are written once. A root without a name
+   has 'namelen' zero. Version 1 files have no names in the root table.
+*/
+
+#define BIN_MAGIC    "BDDB"
+#define BIN_VERSION  2
+#define BIN_BUFSIZE  65536
+#define BIN_MINNODES 1024
+
+#define FNV_OFFSET   2166136261U
+#define FNV_PRIME    16777619U
+
+typedef struct s_BinFile
+{
+   FILE *file;
+   unsigned char *buf;
+   int pos;          /* Next byte in 'buf' */
+   int size;         /* Bytes read into 'buf' */
+   unsigned int sum; /* Checksum of the bytes written or read */
+   int err;          /* Set by any failure, errors are checked at the end */
+} BinFile;
+
+
+/*=== Buffered byte stream =============================================*/
+
+static int bin_open(BinFile *bf, FILE *file)
+{
+   bf->file = file;
+   bf->pos = bf->size = 0;
+   bf->sum = FNV_OFFSET;
+   bf->err = 0;
+   if ((bf->buf=(unsigned char*)malloc(BIN_BUFSIZE)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   return 0;
+}
+
+
+static void bin_flush(BinFile *bf)
+{
+   if (bf->pos > 0  &&
+       fwrite(bf->buf, 1, bf->pos, bf->file) != (size_t)bf->pos)
+      bf->err = 1;
+   bf->pos = 0;
+}
+
+
+static void bin_putbyte(BinFile *bf, unsigned int c)
+{
+   if (bf->pos == BIN_BUFSIZE)
+      bin_flush(bf);
+   bf->buf[bf->pos++] = c;
+   bf->sum = (bf->sum ^ (c & 0xFF)) * FNV_PRIME;
+}
+
+
+static void bin_putnum(BinFile *bf, unsigned int n)
+{
+   while (n >= 0x80)
+   {
+      bin_putbyte(bf, (n & 0x7F) | 0x80);
+      n >>= 7;
+   }
+   bin_putbyte(bf, n);
+}
+
+
+static int bin_getbyte(BinFile *bf)
+{
+   int c;
+   
+   if (bf->pos == bf->size)
+   {
+      bf->size = fread(bf->buf, 1, BIN_BUFSIZE, bf->file);
+      bf->pos = 0;
+      if (bf->size == 0)
+      {
+	 bf->err = 1;
+	 return 0;
+      }
+   }
+
+   c = bf->buf[bf->pos++];
+   bf->sum = (bf->sum ^ c) * FNV_PRIME;
+   return c;
+}
+
+
+static unsigned int bin_getnum(BinFile *bf)
+{
+   unsigned int n = 0;
+   int shift, c;
+
+   for (shift=0 ; shift<35 ; shift+=7)
+   {
+      c = bin_getbyte(bf);
+      n |= (unsigned int)(c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+	 return n;
+   }
+
+   bf->err = 1;
+   return 0;
+}
+
+
+   /* Writes the checksum of everything written so far */
+static void bin_putsum(BinFile *bf)
+{
+   unsigned int sum = bf->sum;
+   int n;
+   
+   for (n=0 ; n<4 ; n++)
+      bin_putbyte(bf, (sum >> (8*n)) & 0xFF);
+}
+
+
+   /* Reads the checksum and flags an error if it does not match */
+static void bin_checksum(BinFile *bf)
+{
+   unsigned int sum = bf->sum;
+   int n;
+   
+   for (n=0 ; n<4 ; n++)
+      if ((unsigned int)bin_getbyte(bf) != ((sum >> (8*n)) & 0xFF))
+	 bf->err = 1;
+}
+
+
+/*=== SAVE =============================================================*/
+
+static int bin_save(FILE *ofile, BDD *r, char **names, int num)
+{
+   BinFile bf;
+   int *cone, *index;
+   int n, nodenum, err;
+
+   for (n=0 ; n<num ; n++)
+      CHECK(r[n]);
+   
+   if ((err=bin_open(&bf, ofile)) < 0)
+      return err;
+   if ((cone=bdd_postorder(r, num, &nodenum)) == NULL)
+   {
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+
+      /* The nodes are numbered through 'index', which is only valid for
+	 the nodes in 'cone' */
+   if ((index=NEW(int,bddnodesize)) == NULL)
+   {
+      free(cone);
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+   index[0] = 0;
+   index[1] = 1;
+
+   for (n=0 ; n<4 ; n++)
+      bin_putbyte(&bf, BIN_MAGIC[n]);
+   bin_putnum(&bf, BIN_VERSION);
+   
+   bin_putnum(&bf, bddvarnum);
+   for (n=0 ; n<bddvarnum ; n++)
+      bin_putnum(&bf, bddvar2level[n]);
+
+   bin_putnum(&bf, nodenum);
+   for (n=0 ; n<nodenum ; n++)
+   {
+      int node = cone[n];
+      
+      index[node] = n+2;
+      bin_putnum(&bf, bddlevel2var[LEVEL(node)]);
+      bin_putnum(&bf, n+2 - index[LOW(node)]);
+      bin_putnum(&bf, n+2 - index[HIGH(node)]);
+   }
+
+   bin_putnum(&bf, num);
+   for (n=0 ; n<num ; n++)
+   {
+      char *name = (names != NULL  &&  names[n] != NULL ? names[n] : "");
+      int len = strlen(name), i;
+      
+      bin_putnum(&bf, index[r[n]]);
+      bin_putnum(&bf, len);
+      for (i=0 ; i<len ; i++)
+	 bin_putbyte(&bf, (unsigned char)name[i]);
+   }
+
+   bin_putsum(&bf);
+   bin_flush(&bf);
+
+   free(index);
+   free(cone);
+   free(bf.buf);
+   
+   if (bf.err  ||  ferror(ofile))
+      return bdd_error(BDD_FILE);
+   return 0;
+}
+
+
+int bdd_fnbinsave(char *fname, BDD r)
+{
+   return bdd_fnsave_named(fname, &r, NULL, 1);
+}
+
+
+int bdd_binsave(FILE *ofile, BDD r)
+{
+   return bin_save(ofile, &r, NULL, 1);
+}
+
+
+int bdd_save_many(FILE *ofile, BDD *r, int num)
+{
+   return bdd_save_named(ofile, r, NULL, num);
+}
+
+
+int bdd_save_named(FILE *ofile, BDD *r, char **names, int num)
+{
+   if (num < 0  ||  (num > 0  &&  r == NULL))
+      return bdd_error(BDD_RANGE);
+   return bin_save(ofile, r, names, num);
+}
+
+
+int bdd_fnsave_named(char *fname, BDD *r, char **names, int num)
+{
+   FILE *ofile;
+   int ok;
+
+   if ((ofile=fopen(fname,"wb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_save_named(ofile, r, names, num);
+   if (fclose(ofile) != 0  &&  ok == 0)
+      return bdd_error(BDD_FILE);
+   return ok;
+}
+
+
+/*=== LOAD =============================================================*/
+
+static void bin_freenames(char **names, int num)
+{
+   int n;
+
+   if (names == NULL)
+      return;
+   for (n=0 ; n<num ; n++)
+      free(names[n]);
+   free(names);
+}
+
+
+/* Read the root table into 'roots' and 'names', where the roots are node
+   numbers from the file. Unnamed roots get a NULL name.
+*/
+static int bin_loadroots(BinFile *bf, int version, unsigned int nodenum,
+			 int **roots, char ***names, int *num)
+{
+   unsigned int rootnum, n, len, i;
+
+   rootnum = bin_getnum(bf);
+   if (bf->err  ||  rootnum > (unsigned int)INT_MAX)
+      return bdd_error(BDD_FORMAT);
+   
+   *names = NULL;
+   if ((*roots=NEW(int,rootnum+1)) == NULL  ||
+       (*names=NEW(char*,rootnum+1)) == NULL)
+   {
+      free(*roots);
+      *roots = NULL;
+      return bdd_error(BDD_MEMORY);
+   }
+   for (n=0 ; n<rootnum ; n++)
+      (*names)[n] = NULL;
+   *num = rootnum;
+
+   for (n=0 ; n<rootnum  &&  !bf->err ; n++)
+   {
+      (*roots)[n] = bin_getnum(bf);
+      if ((unsigned int)(*roots)[n] >= nodenum+2)
+	 bf->err = 1;
+      
+      len = (version > 1 ? bin_getnum(bf) : 0);
+      if (len == 0  ||  bf->err)
+	 continue;
+      if (len > (unsigned int)INT_MAX-1  ||
+	  ((*names)[n]=NEW(char,len+1)) == NULL)
+      {
+	 bf->err = 1;
+	 break;
+      }
+      for (i=0 ; i<len ; i++)
+	 (*names)[n][i] = bin_getbyte(bf);
+      (*names)[n][len] = 0;
+   }
+
+   if (bf->err)
+   {
+      free(*roots);
+      bin_freenames(*names, rootnum);
+      *roots = NULL;
+      *names = NULL;
+      *num = 0;
+      return bdd_error(BDD_FORMAT);
+   }
+   return 0;
+}
+
+
+/* Read the nodes and the root table once the header has been read. Each
+   node is made directly if 'direct' is set and otherwise built with
+   bdd_ite(). The nodes are kept referenced in 'node' until the roots
+   have been found.
+*/
+static int bin_loadnodes(BinFile *bf, int version, int varnum, int direct,
+			 BDD **roots, char ***names, int *num)
+{
+   unsigned int nodenum, nodesize, n;
+   int *node, *index = NULL;
+   int loaded = 0, res = 0;
+
+   nodenum = bin_getnum(bf);
+   if (bf->err  ||  nodenum > (unsigned int)INT_MAX-2)
+      return bdd_error(BDD_FORMAT);
+
+      /* The node count is not trusted for the allocation, so the array
+       * grows with the nodes actually read */
+   nodesize = (nodenum+2 < BIN_MINNODES ? nodenum+2 : BIN_MINNODES);
+   if ((node=NEW(int,nodesize)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   node[0] = 0;
+   node[1] = 1;
+
+   if (direct)
+      bdd_disable_reorder();
+   
+   for (n=0 ; n<nodenum ; n++)
+   {
+      unsigned int var = bin_getnum(bf);
+      unsigned int low = bin_getnum(bf);
+      unsigned int high = bin_getnum(bf);
+      BDD l, h;
+      int level;
+
+      if (n+2 == nodesize)
+      {
+	 unsigned int newsize = nodesize*2;
+	 int *tmp;
+
+	 if (newsize > nodenum+2)
+	    newsize = nodenum+2;
+	 if ((tmp=(int*)realloc(node, sizeof(int)*newsize)) == NULL)
+	 {
+	    res = bdd_error(BDD_MEMORY);
+	    break;
+	 }
+	 node = tmp;
+	 nodesize = newsize;
+      }
+
+      if (bf->err  ||  var >= (unsigned int)varnum  ||
+	  low < 1  ||  low > n+2  ||  high < 1  ||  high > n+2)
+      {
+	 res = bdd_error(BDD_FORMAT);
+	 break;
+      }
+      l = node[n+2-low];
+      h = node[n+2-high];
+      level = bddvar2level[var];
+      
+      if (direct)
+      {
+	 if (LEVEL(l) <= level  ||  LEVEL(h) <= level)
+	 {
+	    res = bdd_error(BDD_FORMAT);
+	    break;
+	 }
+	 node[n+2] = bdd_addref( bdd_makenode(level, l, h) );
+      }
+      else
+	 node[n+2] = bdd_addref( bdd_ite(bdd_ithvar(var), h, l) );
+      
+      if (bdderrorcond)
+      {
+	 res = -bdderrorcond;
+	 break;
+      }
+      loaded++;
+   }
+
+   if (direct)
+      bdd_enable_reorder();
+
+   if (res == 0)
+      res = bin_loadroots(bf, version, nodenum, &index, names, num);
+   
+   if (res == 0)
+   {
+      bin_checksum(bf);
+      
+      if (bf->err)
+      {
+	 bin_freenames(*names, *num);
+	 *names = NULL;
+	 *num = 0;
+	 res = bdd_error(BDD_FORMAT);
+      }
+      else
+      {
+	    /* The roots replace the node numbers in 'index' */
+	 for (n=0 ; n<(unsigned int)*num ; n++)
+	    index[n] = node[index[n]];
+	 *roots = index;
+	 index = NULL;
+      }
+   }
+
+   for (n=0 ; n<(unsigned int)loaded ; n++)
+      bdd_delref(node[n+2]);
+   
+   free(index);
+   free(node);
+   return res;
+}
+
+
+/* Read a file written by bin_save(). The arrays for the roots and names
+   are allocated here.
+*/
+static int bin_load(FILE *ifile, BDD **roots, char ***names, int *num)
+{
+   BinFile bf;
+   unsigned int varnum, version, n;
+   int *var2level;
+   int res, direct;
+
+   *roots = NULL;
+   *names = NULL;
+   *num = 0;
+   
+   if ((res=bin_open(&bf, ifile)) < 0)
+      return res;
+   
+   for (n=0 ; n<4 ; n++)
+      if (bin_getbyte(&bf) != BIN_MAGIC[n])
+	 bf.err = 1;
+   version = bin_getnum(&bf);
+   if (version < 1  ||  version > BIN_VERSION)
+      bf.err = 1;
+   
+   varnum = bin_getnum(&bf);
+   if (bf.err  ||  varnum > MAXVAR)
+   {
+      free(bf.buf);
+      return bdd_error(BDD_FORMAT);
+   }
+   
+   if ((var2level=NEW(int,varnum+1)) == NULL)
+   {
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+   for (n=0 ; n<varnum ; n++)
+   {
+      unsigned int level = bin_getnum(&bf);
+      
+      if (level >= varnum)
+	 bf.err = 1;
+      var2level[n] = level;
+   }
+   if (bf.err)
+   {
+      free(var2level);
+      free(bf.buf);
+      return bdd_error(BDD_FORMAT);
+   }
+
+   if ((int)varnum > bddvarnum)
+      bdd_setvarnum(varnum);
+
+   direct = bdd_sameorder(var2level, varnum);
+   free(var2level);
+   res = bin_loadnodes(&bf, version, varnum, direct, roots, names, num);
+
+      /* Leave the file just after the bdds in case more data follows */
+   if (bf.pos < bf.size)
+      fseek(ifile, (long)bf.pos - bf.size, SEEK_CUR);
+   
+   free(bf.buf);
+   return res;
+}
+
+
+int bdd_fnbinload(char *fname, BDD *r)
+{
+   FILE *ifile;
+   int ok;
+
+   if ((ifile=fopen(fname,"rb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_binload(ifile, r);
+   fclose(ifile);
+   return ok;
+}
+
+
+int bdd_binload(FILE *ifile, BDD *r)
+{
+   BDD *roots;
+   char **names;
+   int num, res;
+
+   *r = 0;
+   if ((res=bin_load(ifile, &roots, &names, &num)) < 0)
+      return res;
+
+   if (num != 1)
+      res = bdd_error(BDD_FORMAT);
+   else
+      *r = roots[0];
+   
+   free(roots);
+   bin_freenames(names, num);
+   return res;
+}
+
+
+int bdd_load_many(FILE *ifile, BDD **r, int *num)
+{
+   char **names;
+   int res;
+
+   if ((res=bin_load(ifile, r, &names, num)) < 0)
+      return res;
+   bin_freenames(names, *num);
+   return 0;
+}
+
+
+int bdd_load_named(FILE *ifile, BDD **r, char ***names, int *num)
+{
+   return bin_load(ifile, r, names, num);
+}
+
+
+int bdd_fnload_named(char *fname, BDD **r, char ***names, int *num)
+{
+   FILE *ifile;
+   int ok;
+
+   *r = NULL;
+   *names = NULL;
+   *num = 0;
+   
+   if ((ifile=fopen(fname,"rb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_load_named(ifile, r, names, num);
+   fclose(ifile);
+   return ok;
+}
+
+
+/*=== CHECKPOINTS ======================================================*/
+
+/* A checkpoint is the whole state of the package, written with the same
+   varints and checksum as the bdd files:
+
+     magic     "BDDC"
+     version
+     nodesize
+     varnum    level2var[0] ... level2var[varnum-1]
+     nodenum   nodenum * (step, level, low, high, refcou)
+     varset    varnum * (ithvar, nithvar)
+     pairnum   pairnum * (last+1, result[0] ... result[varnum-1])
+     fddnum    fddnum * (realsize, binsize, ivar[binsize], var)
+     blocknum  topnum, blocknum * (first, last, fixed, id, subnum)
+     checksum
+
+   Only the nodes reachable from referenced nodes are written, but they
+   keep their numbers and reference counts so the BDD numbers held by the
+   application are still valid after a restore. The nodes are written in
+   increasing order with 'step' being the distance from the previous one.
+   The pairs are written oldest first and the blocks as in the order
+   profiles of reorder.c.
+*/
+
+#define CHK_MAGIC    "BDDC"
+#define CHK_VERSION  1
+
+typedef struct s_Checkpoint
+{
+   int nodesize;
+   int varnum;
+   int *level2var;
+   int nodenum;
+   int *node;        /* nodenum * (index, level, low, high, refcou) */
+   BDD *varset;
+   int pairnum;
+   int *pair;        /* pairnum * (last, result[varnum]) */
+   int fddnum;
+   int *fdd;         /* fddnum * (realsize, binsize, var, ivar offset) */
+   int *ivar;
+   int blocknum;
+   int topnum;
+   int *block;
+} Checkpoint;
+
+
+static int chk_save(FILE *ofile)
+{
+   BinFile bf;
+   bddPair *p, **pairs;
+   int *block;
+   int n, i, pairnum, fddnum, blocknum, topnum, nodenum, prev, err;
+
+   if ((err=bin_open(&bf, ofile)) < 0)
+      return err;
+   
+   for (pairnum=0, p=bdd_pairs_list() ; p!=NULL ; p=p->next)
+      pairnum++;
+   if ((pairs=NEW(bddPair*,pairnum+1)) == NULL)
+   {
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+   for (n=pairnum, p=bdd_pairs_list() ; p!=NULL ; p=p->next)
+      pairs[--n] = p;
+   
+   if ((block=bdd_reorder_getblocks(&blocknum, &topnum)) == NULL)
+   {
+      free(pairs);
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+   
+   for (n=0 ; n<4 ; n++)
+      bin_putbyte(&bf, CHK_MAGIC[n]);
+   bin_putnum(&bf, CHK_VERSION);
+   bin_putnum(&bf, bddnodesize);
+   
+   bin_putnum(&bf, bddvarnum);
+   for (n=0 ; n<bddvarnum ; n++)
+      bin_putnum(&bf, bddlevel2var[n]);
+
+      /* The live nodes are the ones bdd_gbc() would keep */
+   for (n=0 ; n<bddnodesize ; n++)
+      if (bddnodes[n].refcou > 0)
+	 bdd_mark(n);
+   for (n=2, nodenum=0 ; n<bddnodesize ; n++)
+      if (MARKED(n))
+	 nodenum++;
+   
+   bin_putnum(&bf, nodenum);
+   for (n=2, prev=0 ; n<bddnodesize ; n++)
+      if (MARKED(n))
+      {
+	 UNMARK(n);
+	 bin_putnum(&bf, n-prev);
+	 bin_putnum(&bf, LEVEL(n));
+	 bin_putnum(&bf, LOW(n));
+	 bin_putnum(&bf, HIGH(n));
+	 bin_putnum(&bf, bddnodes[n].refcou);
+	 prev = n;
+      }
+
+   for (n=0 ; n<bddvarnum ; n++)
+   {
+      bin_putnum(&bf, bdd_ithvar(n));
+      bin_putnum(&bf, bdd_nithvar(n));
+   }
+
+   bin_putnum(&bf, pairnum);
+   for (n=0 ; n<pairnum ; n++)
+   {
+      bin_putnum(&bf, pairs[n]->last+1);
+      for (i=0 ; i<bddvarnum ; i++)
+	 bin_putnum(&bf, pairs[n]->result[i]);
+   }
+
+   fddnum = fdd_domainnum();
+   bin_putnum(&bf, fddnum);
+   for (n=0 ; n<fddnum ; n++)
+   {
+      int binsize = fdd_varnum(n);
+      int *ivar = fdd_vars(n);
+      
+      bin_putnum(&bf, fdd_domainsize(n));
+      bin_putnum(&bf, binsize);
+      for (i=0 ; i<binsize ; i++)
+	 bin_putnum(&bf, ivar[i]);
+      bin_putnum(&bf, fdd_ithset(n));
+   }
+
+   bin_putnum(&bf, blocknum);
+   bin_putnum(&bf, topnum);
+   for (n=0 ; n<blocknum*5 ; n++)
+      bin_putnum(&bf, block[n]);
+
+   bin_putsum(&bf);
+   bin_flush(&bf);
+
+   free(block);
+   free(pairs);
+   free(bf.buf);
+   
+   if (bf.err  ||  ferror(ofile))
+      return bdd_error(BDD_FILE);
+   return 0;
+}
+
+
+int bdd_checkpoint(char *fname)
+{
+   char *tmpname;
+   FILE *ofile;
+   int ok;
+
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   
+      /* Write a new file that then replaces the old one, so a crash never
+	 leaves a partial checkpoint */
+   if ((tmpname=NEW(char,strlen(fname)+5)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   sprintf(tmpname, "%s.tmp", fname);
+
+   if ((ofile=fopen(tmpname,"wb")) == NULL)
+   {
+      free(tmpname);
+      return bdd_error(BDD_FILE);
+   }
+
+   ok = chk_save(ofile);
+   if (fclose(ofile) != 0  &&  ok == 0)
+      ok = bdd_error(BDD_FILE);
+   if (ok == 0  &&  rename(tmpname, fname) != 0)
+      ok = bdd_error(BDD_FILE);
+   if (ok != 0)
+      remove(tmpname);
+   
+   free(tmpname);
+   return ok;
+}
+
+
+static void chk_free(Checkpoint *c)
+{
+   free(c->level2var);
+   free(c->node);
+   free(c->varset);
+   free(c->pair);
+   free(c->fdd);
+   free(c->ivar);
+   free(c->block);
+}
+
+
+/* Read the nodes of a checkpoint, setting the level of each node in
+   'level' so the references to them can be checked. The nodes must not
+   replace the constants and no two nodes may be equal, since they go
+   straight into the unique table.
+*/
+static int chk_loadnodes(BinFile *bf, Checkpoint *c, int *level)
+{
+   unsigned int nodenum, n, index = 0;
+   int *first, *next;
+
+   nodenum = bin_getnum(bf);
+   if (bf->err  ||  nodenum > (unsigned int)c->nodesize-2)
+      return bdd_error(BDD_FORMAT);
+   
+   c->nodenum = nodenum;
+   if ((c->node=NEW(int,nodenum*5+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+   for (n=0 ; n<nodenum  &&  !bf->err ; n++)
+   {
+      int *node = &c->node[n*5];
+      unsigned int step = bin_getnum(bf);
+      unsigned int lev = bin_getnum(bf);
+      unsigned int low = bin_getnum(bf);
+      unsigned int high = bin_getnum(bf);
+      unsigned int ref = bin_getnum(bf);
+
+      index += step;
+      if (step == 0  ||  index < 2  ||  index >= (unsigned int)c->nodesize  ||
+	  lev >= (unsigned int)c->varnum  ||  low == high  ||
+	  low >= (unsigned int)c->nodesize  ||
+	  high >= (unsigned int)c->nodesize  ||  ref > MAXREF)
+	 bf->err = 1;
+      else
+      {
+	 node[0] = index;
+	 node[1] = lev;
+	 node[2] = low;
+	 node[3] = high;
+	 node[4] = ref;
+	 level[index] = lev;
+      }
+   }
+
+   if (bf->err)
+      return bdd_error(BDD_FORMAT);
+
+   if ((first=NEW(int,nodenum+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   if ((next=NEW(int,nodenum+1)) == NULL)
+   {
+      free(first);
+      return bdd_error(BDD_MEMORY);
+   }
+   for (n=0 ; n<=nodenum ; n++)
+      first[n] = -1;
+   
+      /* All children must be restored nodes further down, and equal
+       * nodes are found through a hash on (level, low, high) */
+   for (n=0 ; n<nodenum  &&  !bf->err ; n++)
+   {
+      int *node = &c->node[n*5];
+      unsigned int hash = TRIPLE(node[1],node[2],node[3]) % (nodenum+1);
+      int k;
+      
+      if (level[node[2]] <= node[1]  ||  level[node[3]] <= node[1])
+	 bf->err = 1;
+      
+      for (k=first[hash] ; k>=0  &&  !bf->err ; k=next[k])
+      {
+	 int *other = &c->node[k*5];
+	 if (other[1] == node[1]  &&  other[2] == node[2]  &&
+	     other[3] == node[3])
+	    bf->err = 1;
+      }
+      next[n] = first[hash];
+      first[hash] = n;
+   }
+
+   free(next);
+   free(first);
+   return bf->err ? bdd_error(BDD_FORMAT) : 0;
+}
+
+
+/* Read a BDD number of a checkpoint that must be a restored node */
+static BDD chk_getroot(BinFile *bf, Checkpoint *c, int *level)
+{
+   unsigned int r = bin_getnum(bf);
+
+   if (r >= (unsigned int)c->nodesize  ||  level[r] < 0)
+   {
+      bf->err = 1;
+      return 0;
+   }
+   return r;
+}
+
+
+/* Read the pairs, domains and blocks of a checkpoint */
+static int chk_loadextra(BinFile *bf, Checkpoint *c, int *level)
+{
+   unsigned int num, n, i, ivarnum = 0;
+   int varnum = c->varnum;
+
+   num = bin_getnum(bf);
+   if (bf->err  ||  num > (unsigned int)INT_MAX/(varnum+1))
+      return bdd_error(BDD_FORMAT);
+   c->pairnum = num;
+   if ((c->pair=NEW(int,num*(varnum+1)+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+   for (n=0 ; n<num  &&  !bf->err ; n++)
+   {
+      int *pair = &c->pair[n*(varnum+1)];
+      unsigned int last = bin_getnum(bf);
+
+      if (last > (unsigned int)varnum)
+	 bf->err = 1;
+      pair[0] = (int)last - 1;
+      for (i=0 ; i<(unsigned int)varnum ; i++)
+	 pair[i+1] = chk_getroot(bf, c, level);
+   }
+
+   num = bin_getnum(bf);
+   if (bf->err  ||  num > (unsigned int)INT_MAX/4)
+      return bdd_error(BDD_FORMAT);
+   c->fddnum = num;
+   if ((c->fdd=NEW(int,num*4+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+   for (n=0 ; n<num  &&  !bf->err ; n++)
+   {
+      int *fdd = &c->fdd[n*4];
+      unsigned int binsize;
+      int *tmp_ptr;
+
+      fdd[0] = bin_getnum(bf);
+      fdd[1] = binsize = bin_getnum(bf);
+      fdd[3] = ivarnum;
+      if (fdd[0] < 1  ||  binsize < 1  ||  binsize > MAXVAR)
+      {
+	 bf->err = 1;
+	 break;
+      }
+      
+      if ((tmp_ptr=(int*)realloc(c->ivar, sizeof(int)*(ivarnum+binsize)))
+	  == NULL)
+	 return bdd_error(BDD_MEMORY);
+      c->ivar = tmp_ptr;
+      
+      for (i=0 ; i<binsize ; i++)
+      {
+	 unsigned int var = bin_getnum(bf);
+
+	 if (var >= (unsigned int)varnum)
+	    bf->err = 1;
+	 c->ivar[ivarnum++] = var;
+      }
+      fdd[2] = chk_getroot(bf, c, level);
+   }
+
+   c->blocknum = bin_getnum(bf);
+   c->topnum = bin_getnum(bf);
+   if (bf->err  ||  (unsigned int)c->blocknum > (unsigned int)INT_MAX/5)
+      return bdd_error(BDD_FORMAT);
+   if ((c->block=NEW(int,c->blocknum*5+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   for (n=0 ; n<(unsigned int)c->blocknum*5 ; n++)
+      c->block[n] = bin_getnum(bf);
+
+   return bf->err ? bdd_error(BDD_FORMAT) : 0;
+}
+
+
+/* Read and check a whole checkpoint before anything is changed */
+static int chk_load(FILE *ifile, Checkpoint *c)
+{
+   BinFile bf;
+   unsigned int nodesize, varnum, n;
+   int *level = NULL, *seen = NULL;
+   int res;
+
+   memset(c, 0, sizeof(Checkpoint));
+   if ((res=bin_open(&bf, ifile)) < 0)
+      return res;
+   
+   for (n=0 ; n<4 ; n++)
+      if (bin_getbyte(&bf) != CHK_MAGIC[n])
+	 bf.err = 1;
+   if (bin_getnum(&bf) != CHK_VERSION)
+      bf.err = 1;
+   
+   nodesize = bin_getnum(&bf);
+   varnum = bin_getnum(&bf);
+   if (bf.err  ||  varnum > MAXVAR  ||  nodesize < 2*varnum+2  ||
+       nodesize > (unsigned int)INT_MAX)
+   {
+      free(bf.buf);
+      return bdd_error(BDD_FORMAT);
+   }
+   c->nodesize = nodesize;
+   c->varnum = varnum;
+
+      /* Level of each restored node, -1 for all other nodes */
+   if ((level=NEW(int,nodesize)) == NULL  ||
+       (seen=NEW(int,varnum+1)) == NULL  ||
+       (c->level2var=NEW(int,varnum+1)) == NULL  ||
+       (c->varset=NEW(BDD,varnum*2+1)) == NULL)
+   {
+      free(level);
+      free(seen);
+      chk_free(c);
+      free(bf.buf);
+      return bdd_error(BDD_MEMORY);
+   }
+   for (n=0 ; n<nodesize ; n++)
+      level[n] = -1;
+   level[0] = level[1] = varnum;
+   memset(seen, 0, sizeof(int)*varnum);
+   
+   for (n=0 ; n<varnum ; n++)
+   {
+      unsigned int var = bin_getnum(&bf);
+      
+      if (var >= varnum  ||  seen[var]++)
+	 bf.err = 1;
+      else
+	 c->level2var[n] = var;
+   }
+   free(seen);
+
+   if (bf.err)
+      res = bdd_error(BDD_FORMAT);
+   else
+      res = chk_loadnodes(&bf, c, level);
+
+   if (res == 0)
+   {
+      for (n=0 ; n<varnum*2 ; n++)
+	 c->varset[n] = chk_getroot(&bf, c, level);
+      res = chk_loadextra(&bf, c, level);
+   }
+
+   if (res == 0)
+   {
+      bin_checksum(&bf);
+      if (bf.err)
+	 res = bdd_error(BDD_FORMAT);
+   }
+
+   if (res < 0)
+      chk_free(c);
+   free(level);
+   free(bf.buf);
+   return res;
+}
+
+
+/* Replace the state of a fresh package with a checkpoint */
+static int chk_apply(Checkpoint *c, bddPair ***pairs)
+{
+   int varnum = c->varnum;
+   int n, res;
+
+   if (varnum > 0  &&  (res=bdd_setvarnum(varnum)) < 0)
+      return res;
+   if ((res=bdd_nodetable_clear(c->nodesize)) < 0)
+      return res;
+
+   for (n=0 ; n<varnum ; n++)
+   {
+      bddlevel2var[n] = c->level2var[n];
+      bddvar2level[c->level2var[n]] = n;
+   }
+   
+   for (n=0 ; n<c->nodenum ; n++)
+   {
+      int *node = &c->node[n*5];
+      
+      bddnodes[node[0]].refcou = node[4];
+      LEVEL(node[0]) = node[1];
+      LOW(node[0]) = node[2];
+      HIGH(node[0]) = node[3];
+   }
+   bdd_nodetable_rehash(c->varset);
+
+   if (pairs != NULL  &&  (*pairs=NEW(bddPair*,c->pairnum+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   for (n=0 ; n<c->pairnum ; n++)
+   {
+      int *pair = &c->pair[n*(varnum+1)];
+      bddPair *p = bdd_pairs_restore(pair+1, pair[0]);
+
+      if (p == NULL)
+	 return bdd_error(BDD_MEMORY);
+      if (pairs != NULL)
+	 (*pairs)[n] = p;
+   }
+
+   for (n=0 ; n<c->fddnum ; n++)
+   {
+      int *fdd = &c->fdd[n*4];
+      
+      if ((res=bdd_fdd_restore(fdd[0], fdd[1], &c->ivar[fdd[3]], fdd[2])) < 0)
+	 return res;
+   }
+
+   return bdd_reorder_setblocks(c->block, c->blocknum, c->topnum);
+}
+
+
+int bdd_restore(char *fname, bddPair ***pairs, int *pairnum)
+{
+   Checkpoint c;
+   FILE *ifile;
+   int res;
+
+   if (pairs != NULL)
+      *pairs = NULL;
+   if (pairnum != NULL)
+      *pairnum = 0;
+   
+   if (!bddrunning  ||  bddvarnum > 0)
+      return bdd_error(BDD_RUNNING);
+   
+   if ((ifile=fopen(fname,"rb")) == NULL)
+      return bdd_error(BDD_FILE);
+   res = chk_load(ifile, &c);
+   fclose(ifile);
+   if (res < 0)
+      return res;
+
+   res = chk_apply(&c, pairs);
+   if (res < 0  &&  pairs != NULL)
+   {
+      free(*pairs);
+      *pairs = NULL;
+   }
+   else if (pairnum != NULL)
+      *pairnum = c.pairnum;
+   
+   chk_free(&c);
+   return res;
+}
+
+
+/* EOF */
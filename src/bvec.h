@@ -568,6 +568,8 @@ private:
    friend bdd  bvec_gte(const bvec &left, const bvec &right);
    friend bdd  bvec_equ(const bvec &left, const bvec &right);
    friend bdd  bvec_neq(const bvec &left, const bvec &right);
+   friend int  bdd_eval_batch(const bvec &v, const uint64_t *in, int words,
+			      uint64_t *out);
 
 public:
    bvec operator&(const bvec &a) const { return bvec_map2(*this, a, bdd_and); }
@@ -673,6 +675,10 @@ inline bdd  bvec_equ(const bvec &left, const bvec &right)
 inline bdd  bvec_neq(const bvec &left, const bvec &right)
 { return bvec_neq(left.roots, right.roots); }
 
+inline int bdd_eval_batch(const bvec &v, const uint64_t *in, int words,
+			  uint64_t *out)
+{ return bdd_eval_batch(v.roots.bitvec, v.roots.bitnum, in, words, out); }
+
 
    /* Hack to allow for overloading */
 #define bvec_var(a,b,c)  bvec_varpp(a,b,c)
@@ -0,0 +1,1279 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  circuit.c
+  DESCR: Construction of BDDs for AIGER and BLIF circuits
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "kernel.h"
+
+/* A circuit is read into a list of nodes where node 0 is the constant
+   false and the others are inputs or gates. Gates refer to their fanins
+   through literals, twice the node number plus one if the fanin is
+   negated, as in AIGER. An AND gate is the conjunction of its fanins
+   and a COVER gate is a BLIF cover: 'rownum' rows with one character
+   for each fanin ('0', '1' or '-') that give the onset of the gate, or
+   the offset if 'onset' is zero.
+
+   Latches are cut, so the current state of a latch becomes an input
+   after the primary inputs and the next state an output after the
+   primary outputs, named as the latch with a "'" added.
+
+   The gates that the outputs depend on are sorted topologically when
+   the circuit is read, which also finds cycles and undefined signals.
+   The BDDs are then made in that order and the BDD of a gate is
+   released as soon as its last fanout has been made.
+*/
+
+#define NODE_CONST   0
+#define NODE_INPUT   1
+#define NODE_AND     2
+#define NODE_COVER   3
+#define NODE_UNDEF   4    /* Used but not yet defined */
+
+typedef struct s_CircuitNode
+{
+   int kind;
+   int fanin;        /* First literal in 'fanins' */
+   int faninnum;
+   int row;          /* First character of the rows in 'rows' */
+   int rownum;
+   int onset;
+   int depth;        /* Longest path from an input */
+} CircuitNode;
+
+typedef struct s_CircuitSignal
+{
+   int node;         /* Node of an input or the current state of a latch */
+   int lit;          /* Literal of an output or the next state of a latch */
+   char *name;
+} CircuitSignal;
+
+struct s_bddCircuit
+{
+   CircuitNode *node;
+   int   nodenum, nodealloc;
+   int  *fanins;
+   int   faninnum, faninalloc;
+   char *rows;
+   int   rowsize, rowalloc;
+   CircuitSignal *input;
+   int   inputnum, inputalloc;
+   CircuitSignal *output;
+   int   outputnum, outputalloc;
+   CircuitSignal *latch;
+   int   latchnum, latchalloc;
+   int  *order;              /* Gates in topological order */
+   int   ordernum;
+   char **nodename;          /* BLIF signal names */
+   int   nodenamealloc;
+   int  *hash;               /* Open hash table of 'nodename' */
+   int   hashsize;
+};
+
+
+/*=== CIRCUIT STORAGE ==================================================*/
+
+   /* Makes room for 'need' elements of 'size' bytes in '*array' */
+static int circuit_grow(void **array, int *alloc, int need, size_t size)
+{
+   void *tmp_ptr;
+   int newalloc;
+   
+   if (need <= *alloc)
+      return 0;
+
+   newalloc = MAX(need, *alloc*2 + 16);
+   if ((tmp_ptr=realloc(*array, size*newalloc)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   *array = tmp_ptr;
+   *alloc = newalloc;
+   return 0;
+}
+
+
+static int circuit_addnode(bddCircuit *c, int kind)
+{
+   CircuitNode *node;
+   
+   if (circuit_grow((void**)&c->node, &c->nodealloc, c->nodenum+1,
+		    sizeof(CircuitNode)) < 0)
+      return BDD_MEMORY;
+
+   node = &c->node[c->nodenum];
+   memset(node, 0, sizeof(CircuitNode));
+   node->kind = kind;
+   return c->nodenum++;
+}
+
+
+   /* Adds a signal named 'name' followed by 'suffix' to one of the
+    * input, output or latch lists */
+static int circuit_addsignal(CircuitSignal **list, int *num, int *alloc,
+			     int node, int lit, const char *name,
+			     const char *suffix)
+{
+   CircuitSignal *s;
+   
+   if (circuit_grow((void**)list, alloc, *num+1, sizeof(CircuitSignal)) < 0)
+      return BDD_MEMORY;
+
+   s = &(*list)[*num];
+   if ((s->name=NEW(char,strlen(name)+strlen(suffix)+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   sprintf(s->name, "%s%s", name, suffix);
+   s->node = node;
+   s->lit = lit;
+   (*num)++;
+   return 0;
+}
+
+
+static int circuit_addinput(bddCircuit *c, int node, const char *name)
+{
+   c->node[node].kind = NODE_INPUT;
+   return circuit_addsignal(&c->input, &c->inputnum, &c->inputalloc,
+			    node, 0, name, "");
+}
+
+
+static int circuit_addoutput(bddCircuit *c, int lit, const char *name)
+{
+   return circuit_addsignal(&c->output, &c->outputnum, &c->outputalloc,
+			    0, lit, name, "");
+}
+
+
+static int circuit_addlatch(bddCircuit *c, int node, int next,
+			    const char *name)
+{
+   c->node[node].kind = NODE_INPUT;
+   return circuit_addsignal(&c->latch, &c->latchnum, &c->latchalloc,
+			    node, next, name, "");
+}
+
+
+   /* Makes the latches inputs and outputs once all primary inputs and
+    * outputs are known */
+static int circuit_cutlatches(bddCircuit *c)
+{
+   char *name;
+   int n, err;
+
+   for (n=0 ; n<c->latchnum ; n++)
+   {
+      name = c->latch[n].name;
+      
+      if ((err=circuit_addinput(c, c->latch[n].node, name)) < 0  ||
+	  (err=circuit_addsignal(&c->output, &c->outputnum, &c->outputalloc,
+				 0, c->latch[n].lit, name, "'")) < 0)
+	 return err;
+   }
+
+   return 0;
+}
+
+
+   /* Sorts the gates that the outputs depend on topologically and finds
+    * the depth of each node. Fails on cycles and undefined signals. */
+static int circuit_sort(bddCircuit *c)
+{
+   int *state, *stack;
+   int n, sp;
+   
+   state = (int*)calloc(c->nodenum, sizeof(int));
+   stack = NEW(int,2*c->nodenum);
+   c->order = NEW(int,c->nodenum);
+   if (state == NULL  ||  stack == NULL  ||  c->order == NULL)
+   {
+      free(state);
+      free(stack);
+      return bdd_error(BDD_MEMORY);
+   }
+   c->ordernum = 0;
+
+      /* 0 = not seen, 1 = on the stack, 2 = done. The stack holds pairs
+       * of a node and its next fanin */
+   for (n=0 ; n<c->outputnum ; n++)
+   {
+      int top = c->output[n].lit/2;
+
+      if (state[top] == 2)
+	 continue;
+
+      sp = 0;
+      stack[sp++] = top;
+      stack[sp++] = 0;
+      state[top] = 1;
+      
+      while (sp > 0)
+      {
+	 CircuitNode *g = &c->node[stack[sp-2]];
+	 
+	 if (g->kind == NODE_UNDEF)
+	    goto fail;
+	 
+	 if ((g->kind == NODE_AND  ||  g->kind == NODE_COVER)  &&
+	     stack[sp-1] < g->faninnum)
+	 {
+	    int f = c->fanins[g->fanin + stack[sp-1]++] / 2;
+	    
+	    if (state[f] == 1)
+	       goto fail;
+	    if (state[f] == 0)
+	    {
+	       state[f] = 1;
+	       stack[sp++] = f;
+	       stack[sp++] = 0;
+	    }
+	    continue;
+	 }
+
+	 if (g->kind == NODE_AND  ||  g->kind == NODE_COVER)
+	 {
+	    int i;
+	    
+	    g->depth = 0;
+	    for (i=0 ; i<g->faninnum ; i++)
+	       g->depth = MAX(g->depth, c->node[c->fanins[g->fanin+i]/2].depth+1);
+	    c->order[c->ordernum++] = stack[sp-2];
+	 }
+	 state[stack[sp-2]] = 2;
+	 sp -= 2;
+      }
+   }
+   
+   free(stack);
+   free(state);
+   return 0;
+
+ fail:
+   free(stack);
+   free(state);
+   return bdd_error(BDD_FORMAT);
+}
+
+
+static bddCircuit *circuit_new(void)
+{
+   bddCircuit *c;
+
+   if ((c=NEW(bddCircuit,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   memset(c, 0, sizeof(bddCircuit));
+   
+   if (circuit_addnode(c, NODE_CONST) < 0)
+   {
+      free(c);
+      return NULL;
+   }
+   return c;
+}
+
+
+void bdd_circuit_free(bddCircuit *c)
+{
+   int n;
+   
+   if (c == NULL)
+      return;
+
+   for (n=0 ; n<c->inputnum ; n++)
+      free(c->input[n].name);
+   for (n=0 ; n<c->outputnum ; n++)
+      free(c->output[n].name);
+   for (n=0 ; n<c->latchnum ; n++)
+      free(c->latch[n].name);
+   if (c->nodename != NULL)
+      for (n=0 ; n<c->nodenum ; n++)
+	 free(c->nodename[n]);
+   
+   free(c->node);
+   free(c->fanins);
+   free(c->rows);
+   free(c->input);
+   free(c->output);
+   free(c->latch);
+   free(c->order);
+   free(c->nodename);
+   free(c->hash);
+   free(c);
+}
+
+
+int bdd_circuit_inputnum(const bddCircuit *c)
+{
+   return c->inputnum;
+}
+
+
+int bdd_circuit_outputnum(const bddCircuit *c)
+{
+   return c->outputnum;
+}
+
+
+int bdd_circuit_gatenum(const bddCircuit *c)
+{
+   return c->ordernum;
+}
+
+
+const char *bdd_circuit_inputname(const bddCircuit *c, int n)
+{
+   if (n < 0  ||  n >= c->inputnum)
+   {
+      bdd_error(BDD_RANGE);
+      return NULL;
+   }
+   return c->input[n].name;
+}
+
+
+const char *bdd_circuit_outputname(const bddCircuit *c, int n)
+{
+   if (n < 0  ||  n >= c->outputnum)
+   {
+      bdd_error(BDD_RANGE);
+      return NULL;
+   }
+   return c->output[n].name;
+}
+
+
+/*=== BLIF =============================================================*/
+
+static unsigned int blif_hashname(const char *s)
+{
+   unsigned int h = 2166136261U;
+
+   while (*s)
+      h = (h ^ (unsigned char)*s++) * 16777619U;
+   return h;
+}
+
+
+   /* Returns the node of a signal, making an undefined node for new
+    * signals */
+static int blif_node(bddCircuit *c, const char *name)
+{
+   unsigned int h;
+   int node, n;
+   
+   if (2*c->nodenum >= c->hashsize)
+   {
+      int *tmp_ptr;
+      int newsize = MAX(1024, c->hashsize*2);
+
+      if ((tmp_ptr=NEW(int,newsize)) == NULL)
+	 return bdd_error(BDD_MEMORY);
+      free(c->hash);
+      c->hash = tmp_ptr;
+      c->hashsize = newsize;
+      
+      for (n=0 ; n<newsize ; n++)
+	 c->hash[n] = -1;
+      for (n=1 ; n<c->nodenum ; n++)
+      {
+	 h = blif_hashname(c->nodename[n]) & (newsize-1);
+	 while (c->hash[h] >= 0)
+	    h = (h+1) & (newsize-1);
+	 c->hash[h] = n;
+      }
+   }
+
+   h = blif_hashname(name) & (c->hashsize-1);
+   while (c->hash[h] >= 0)
+   {
+      if (strcmp(c->nodename[c->hash[h]], name) == 0)
+	 return c->hash[h];
+      h = (h+1) & (c->hashsize-1);
+   }
+
+   if (circuit_grow((void**)&c->nodename, &c->nodenamealloc, c->nodenum+1,
+		    sizeof(char*)) < 0)
+      return BDD_MEMORY;
+   if ((node=circuit_addnode(c, NODE_UNDEF)) < 0)
+      return node;
+   c->nodename[0] = NULL;
+   if ((c->nodename[node]=NEW(char,strlen(name)+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   strcpy(c->nodename[node], name);
+   
+   c->hash[h] = node;
+   return node;
+}
+
+
+   /* Splits the next logical line into tokens, joining lines that end in
+    * a backslash and removing comments. Returns the number of tokens or
+    * -1 at the end of the text. */
+static int blif_line(char **pos, char *end, char ***tok, int *tokalloc)
+{
+   char *p = *pos;
+   int num = 0;
+
+   if (p >= end)
+      return -1;
+
+   while (p < end  &&  *p != '\n')
+   {
+      if (*p == '#')
+      {
+	 while (p < end  &&  *p != '\n')
+	    *p++ = 0;
+      }
+      else if (*p == '\\'  &&
+	       (p+1 == end  ||  p[1] == '\n'  ||  p[1] == '\r'))
+      {
+	 while (p < end  &&  *p != '\n')
+	    *p++ = 0;
+	 if (p < end)
+	    *p++ = 0;
+      }
+      else if (isspace((unsigned char)*p))
+	 *p++ = 0;
+      else
+      {
+	 if (circuit_grow((void**)tok, tokalloc, num+1, sizeof(char*)) < 0)
+	    return BDD_MEMORY;
+	 (*tok)[num++] = p;
+	 while (p < end  &&  !isspace((unsigned char)*p)  &&  *p != '#')
+	    p++;
+      }
+   }
+
+   if (p < end)
+      *p++ = 0;
+   *pos = p;
+   return num;
+}
+
+
+   /* Adds a row to the cover of 'node' */
+static int blif_row(bddCircuit *c, int node, char **tok, int num)
+{
+   CircuitNode *g = &c->node[node];
+   const char *row = (num == 2 ? tok[0] : "");
+   const char *value = tok[num-1];
+   int n;
+
+   if (num > 2  ||  (int)strlen(row) != g->faninnum  ||
+       strlen(value) != 1  ||  (value[0] != '0'  &&  value[0] != '1')  ||
+       (g->rownum > 0  &&  g->onset != value[0]-'0'))
+      return bdd_error(BDD_FORMAT);
+   
+   for (n=0 ; n<g->faninnum ; n++)
+      if (row[n] != '0'  &&  row[n] != '1'  &&  row[n] != '-')
+	 return bdd_error(BDD_FORMAT);
+   
+   if (circuit_grow((void**)&c->rows, &c->rowalloc, c->rowsize+g->faninnum,
+		    1) < 0)
+      return BDD_MEMORY;
+   
+   memcpy(c->rows+c->rowsize, row, g->faninnum);
+   c->rowsize += g->faninnum;
+   g->onset = value[0]-'0';
+   g->rownum++;
+   return 0;
+}
+
+
+   /* Starts the cover of the last signal in 'tok' */
+static int blif_names(bddCircuit *c, char **tok, int num)
+{
+   int n, node, first = c->faninnum;
+   
+   if (num < 1)
+      return bdd_error(BDD_FORMAT);
+   if (circuit_grow((void**)&c->fanins, &c->faninalloc, c->faninnum+num-1,
+		    sizeof(int)) < 0)
+      return BDD_MEMORY;
+   
+   for (n=0 ; n<num ; n++)
+   {
+      if ((node=blif_node(c, tok[n])) < 0)
+	 return node;
+      if (n < num-1)
+	 c->fanins[c->faninnum++] = 2*node;
+   }
+   
+   if (c->node[node].kind != NODE_UNDEF)
+      return bdd_error(BDD_FORMAT);
+   
+   c->node[node].kind = NODE_COVER;
+   c->node[node].fanin = first;
+   c->node[node].faninnum = num-1;
+   c->node[node].row = c->rowsize;
+   c->node[node].rownum = 0;
+   c->node[node].onset = 1;
+   return node;
+}
+
+
+static int blif_parse(bddCircuit *c, char *text, char *end)
+{
+   char **tok = NULL;
+   int tokalloc = 0, num, n, node, next;
+   int cover = -1;         /* Node of the cover being read */
+   int err = 0;
+
+   while (err >= 0  &&  (num=blif_line(&text, end, &tok, &tokalloc)) != -1)
+   {
+      if (num <= 0)
+      {
+	 err = num;
+	 continue;
+      }
+      
+      if (tok[0][0] != '.')
+      {
+	 err = (cover < 0 ? bdd_error(BDD_FORMAT)
+		: blif_row(c, cover, tok, num));
+	 continue;
+      }
+
+      cover = -1;
+      
+      if (strcmp(tok[0], ".model") == 0)
+	 continue;
+      else if (strcmp(tok[0], ".end") == 0  ||  strcmp(tok[0], ".exdc") == 0)
+	 break;
+      else if (strcmp(tok[0], ".inputs") == 0)
+      {
+	 for (n=1 ; n<num  &&  err >= 0 ; n++)
+	 {
+	    if ((err=node=blif_node(c, tok[n])) < 0)
+	       break;
+	    if (c->node[node].kind != NODE_UNDEF)
+	       err = bdd_error(BDD_FORMAT);
+	    else
+	       err = circuit_addinput(c, node, tok[n]);
+	 }
+      }
+      else if (strcmp(tok[0], ".outputs") == 0)
+      {
+	 for (n=1 ; n<num  &&  err >= 0 ; n++)
+	    if ((err=node=blif_node(c, tok[n])) >= 0)
+	       err = circuit_addoutput(c, 2*node, tok[n]);
+      }
+      else if (strcmp(tok[0], ".names") == 0)
+	 err = cover = blif_names(c, tok+1, num-1);
+      else if (strcmp(tok[0], ".latch") == 0)
+      {
+	    /* .latch input output [type control] [init] */
+	 if (num < 3  ||  num > 6)
+	    err = bdd_error(BDD_FORMAT);
+	 else if ((err=next=blif_node(c, tok[1])) >= 0  &&
+		  (err=node=blif_node(c, tok[2])) >= 0)
+	 {
+	    if (c->node[node].kind != NODE_UNDEF)
+	       err = bdd_error(BDD_FORMAT);
+	    else
+	       err = circuit_addlatch(c, node, 2*next, tok[2]);
+	 }
+      }
+      else
+	 err = bdd_error(BDD_FORMAT);
+   }
+   
+   free(tok);
+   return err < 0 ? err : 0;
+}
+
+
+/*=== AIGER ============================================================*/
+
+   /* Reads an unsigned decimal number, skipping blanks but not newlines */
+static int aig_num(char **pos, char *end, int *res)
+{
+   char *p = *pos;
+   int n = 0;
+
+   while (p < end  &&  (*p == ' '  ||  *p == '\t'  ||  *p == '\r'))
+      p++;
+   if (p == end  ||  !isdigit((unsigned char)*p))
+      return -1;
+   
+   while (p < end  &&  isdigit((unsigned char)*p))
+   {
+      if (n > (INT_MAX - 9)/10)
+	 return -1;
+      n = 10*n + (*p++ - '0');
+   }
+   
+   *pos = p;
+   *res = n;
+   return 0;
+}
+
+
+   /* Moves past the end of the line */
+static int aig_eol(char **pos, char *end)
+{
+   char *p = *pos;
+
+   while (p < end  &&  (*p == ' '  ||  *p == '\t'  ||  *p == '\r'))
+      p++;
+   if (p < end  &&  *p != '\n')
+      return -1;
+   *pos = (p < end ? p+1 : p);
+   return 0;
+}
+
+
+   /* Reads a number on a line of its own */
+static int aig_line(char **pos, char *end, int *res)
+{
+   if (aig_num(pos, end, res) < 0  ||  aig_eol(pos, end) < 0)
+      return -1;
+   return 0;
+}
+
+
+   /* Reads a delta of the binary format */
+static int aig_delta(char **pos, char *end, int *res)
+{
+   unsigned int n = 0;
+   int shift;
+
+   for (shift=0 ; shift<35  &&  *pos<end ; shift+=7)
+   {
+      unsigned int c = (unsigned char)*(*pos)++;
+      
+      n |= (c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+      {
+	 if (n > (unsigned int)INT_MAX)
+	    return -1;
+	 *res = n;
+	 return 0;
+      }
+   }
+   return -1;
+}
+
+
+static int aig_and(bddCircuit *c, int lhs, int rhs0, int rhs1)
+{
+   CircuitNode *g;
+   
+   if ((lhs & 1)  ||  lhs < 2  ||  lhs/2 >= c->nodenum  ||
+       rhs0/2 >= c->nodenum  ||  rhs1/2 >= c->nodenum  ||
+       c->node[lhs/2].kind != NODE_UNDEF)
+      return bdd_error(BDD_FORMAT);
+   if (circuit_grow((void**)&c->fanins, &c->faninalloc, c->faninnum+2,
+		    sizeof(int)) < 0)
+      return BDD_MEMORY;
+
+   g = &c->node[lhs/2];
+   g->kind = NODE_AND;
+   g->fanin = c->faninnum;
+   g->faninnum = 2;
+   c->fanins[c->faninnum++] = rhs0;
+   c->fanins[c->faninnum++] = rhs1;
+   return 0;
+}
+
+
+   /* Checks that 'lit' names an unused node for an input or a latch */
+static int aig_newnode(bddCircuit *c, int lit)
+{
+   if ((lit & 1)  ||  lit < 2  ||  lit/2 >= c->nodenum  ||
+       c->node[lit/2].kind != NODE_UNDEF)
+      return bdd_error(BDD_FORMAT);
+   c->node[lit/2].kind = NODE_INPUT;
+   return lit/2;
+}
+
+
+static const char *aig_name(char *buf, const char *name, char type, int n)
+{
+   if (name != NULL)
+      return name;
+   sprintf(buf, "%c%d", type, n);
+   return buf;
+}
+
+
+static int aig_parse(bddCircuit *c, char *text, char *end)
+{
+   int binary = (text[1] == 'i');
+   int maxvar, inum, lnum, onum, anum, extra;
+   int *lit, n, init;
+   char **name, buf[32];
+   int err = 0;
+
+   text += 3;
+   if (aig_num(&text, end, &maxvar) < 0  ||  aig_num(&text, end, &inum) < 0  ||
+       aig_num(&text, end, &lnum) < 0  ||  aig_num(&text, end, &onum) < 0  ||
+       aig_num(&text, end, &anum) < 0)
+      return bdd_error(BDD_FORMAT);
+
+      /* The bad state, constraint, justice and fairness sections of
+       * AIGER 1.9 are only accepted when empty */
+   while (aig_num(&text, end, &extra) == 0)
+      if (extra != 0)
+	 return bdd_error(BDD_FORMAT);
+   
+   if (aig_eol(&text, end) < 0  ||  maxvar >= INT_MAX/2  ||
+       inum > maxvar  ||  lnum > maxvar  ||  anum > maxvar  ||
+       onum >= INT_MAX/2  ||  (binary  &&  maxvar != inum+lnum+anum))
+      return bdd_error(BDD_FORMAT);
+
+   for (n=0 ; n<maxvar ; n++)
+      if (circuit_addnode(c, NODE_UNDEF) < 0)
+	 return BDD_MEMORY;
+
+      /* Literals of inputs, latches and their next states, and outputs */
+   lit = NEW(int,inum+2*lnum+onum+1);
+   name = (char**)calloc(inum+lnum+onum+1, sizeof(char*));
+   if (lit == NULL  ||  name == NULL)
+   {
+      free(lit);
+      free(name);
+      return bdd_error(BDD_MEMORY);
+   }
+   
+   for (n=0 ; n<inum  &&  err == 0 ; n++)
+   {
+      lit[n] = 2*(n+1);
+      if (!binary  &&  aig_line(&text, end, &lit[n]) < 0)
+	 err = bdd_error(BDD_FORMAT);
+      else if (aig_newnode(c, lit[n]) < 0)
+	 err = BDD_FORMAT;
+   }
+
+   for (n=0 ; n<lnum  &&  err == 0 ; n++)
+   {
+      int *l = &lit[inum+2*n];
+      
+      l[0] = 2*(inum+n+1);
+      if ((!binary  &&  aig_num(&text, end, &l[0]) < 0)  ||
+	  aig_num(&text, end, &l[1]) < 0  ||  l[1]/2 > maxvar)
+	 err = bdd_error(BDD_FORMAT);
+	 /* Latches must start at zero or be uninitialized */
+      else if (aig_num(&text, end, &init) == 0  &&  init != 0  &&
+	       init != l[0])
+	 err = bdd_error(BDD_FORMAT);
+      else if (aig_eol(&text, end) < 0)
+	 err = bdd_error(BDD_FORMAT);
+      else if (aig_newnode(c, l[0]) < 0)
+	 err = BDD_FORMAT;
+   }
+
+   for (n=0 ; n<onum  &&  err == 0 ; n++)
+   {
+      int *l = &lit[inum+2*lnum+n];
+      
+      if (aig_line(&text, end, l) < 0  ||  *l/2 > maxvar)
+	 err = bdd_error(BDD_FORMAT);
+   }
+
+   for (n=0 ; n<anum  &&  err == 0 ; n++)
+   {
+      int lhs = 2*(inum+lnum+n+1), rhs0, rhs1;
+
+      if (binary)
+      {
+	 int d0 = 0, d1 = 0;
+	 
+	 if (aig_delta(&text, end, &d0) < 0  ||  aig_delta(&text, end, &d1) < 0
+	     ||  d0 > lhs  ||  d1 > lhs-d0)
+	    err = bdd_error(BDD_FORMAT);
+	 rhs0 = lhs - d0;
+	 rhs1 = rhs0 - d1;
+      }
+      else if (aig_num(&text, end, &lhs) < 0  ||
+	       aig_num(&text, end, &rhs0) < 0  ||
+	       aig_num(&text, end, &rhs1) < 0  ||  aig_eol(&text, end) < 0)
+	 err = bdd_error(BDD_FORMAT);
+
+      if (err == 0)
+	 err = aig_and(c, lhs, rhs0, rhs1);
+   }
+
+      /* Symbol table lines like "i0 name" until the end or a comment */
+   while (err == 0  &&  text < end  &&
+	  (*text == 'i'  ||  *text == 'l'  ||  *text == 'o'))
+   {
+      char type = *text++;
+      char *p;
+      
+      if (aig_num(&text, end, &n) < 0  ||  text == end  ||  *text != ' '  ||
+	  (type == 'i'  &&  n >= inum)  ||  (type == 'l'  &&  n >= lnum)  ||
+	  (type == 'o'  &&  n >= onum))
+      {
+	 err = bdd_error(BDD_FORMAT);
+	 break;
+      }
+      
+      p = ++text;
+      while (text < end  &&  *text != '\n')
+	 text++;
+      if (text < end)
+	 *text++ = 0;
+      
+      name[(type == 'i' ? 0 : type == 'l' ? inum : inum+lnum) + n] = p;
+   }
+
+      /* Signals without a symbol are named as in the symbol table */
+   for (n=0 ; n<inum  &&  err == 0 ; n++)
+      err = circuit_addinput(c, lit[n]/2, aig_name(buf, name[n], 'i', n));
+   for (n=0 ; n<lnum  &&  err == 0 ; n++)
+      err = circuit_addlatch(c, lit[inum+2*n]/2, lit[inum+2*n+1],
+			     aig_name(buf, name[inum+n], 'l', n));
+   for (n=0 ; n<onum  &&  err == 0 ; n++)
+      err = circuit_addoutput(c, lit[inum+2*lnum+n],
+			      aig_name(buf, name[inum+lnum+n], 'o', n));
+   
+   free(name);
+   free(lit);
+   return err;
+}
+
+
+/*=== LOADING ==========================================================*/
+
+   /* Reads the rest of 'ifile' into memory with a newline and a zero
+    * added at the end */
+static char *circuit_read(FILE *ifile, int *size)
+{
+   char *buf = NULL, *tmp_ptr;
+   size_t len = 0, alloc = 0, num;
+
+   do
+   {
+      if (len+2 >= alloc)
+      {
+	 alloc = (alloc == 0 ? 65536 : 2*alloc);
+	 if ((tmp_ptr=(char*)realloc(buf, alloc)) == NULL)
+	 {
+	    free(buf);
+	    return NULL;
+	 }
+	 buf = tmp_ptr;
+      }
+      num = fread(buf+len, 1, alloc-len-2, ifile);
+      len += num;
+   }
+   while (num > 0);
+
+   if (len > (size_t)INT_MAX-2)
+   {
+      free(buf);
+      return NULL;
+   }
+   
+   buf[len] = '\n';
+   buf[len+1] = 0;
+   *size = (int)len + 1;
+   return buf;
+}
+
+
+bddCircuit *bdd_circuit_load(FILE *ifile)
+{
+   bddCircuit *c;
+   char *text;
+   int size, err;
+
+   if ((text=circuit_read(ifile, &size)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   if ((c=circuit_new()) == NULL)
+   {
+      free(text);
+      return NULL;
+   }
+
+   if (size >= 4  &&  text[0] == 'a'  &&  
+       (strncmp(text, "aag ", 4) == 0  ||  strncmp(text, "aig ", 4) == 0))
+      err = aig_parse(c, text, text+size);
+   else
+      err = blif_parse(c, text, text+size);
+
+   if (err == 0)
+      err = circuit_cutlatches(c);
+   if (err == 0)
+      err = circuit_sort(c);
+   
+   free(text);
+   if (err < 0)
+   {
+      bdd_circuit_free(c);
+      return NULL;
+   }
+   
+   return c;
+}
+
+
+bddCircuit *bdd_circuit_fnload(char *fname)
+{
+   bddCircuit *c;
+   FILE *ifile;
+
+   if ((ifile=fopen(fname, "rb")) == NULL)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   c = bdd_circuit_load(ifile);
+   fclose(ifile);
+   return c;
+}
+
+
+/*=== STATIC ORDER =====================================================*/
+
+   /* Orders the inputs by a depth first search from the outputs that
+    * visits the deepest fanin first, so inputs that meet in the same
+    * small gates end up close together. Returns the position of each
+    * input in 'rank'. */
+static int circuit_order(bddCircuit *c, int *rank)
+{
+   int *inputpos, *stack;
+   char *seen;
+   int n, sp, next = 0;
+
+   inputpos = NEW(int,c->nodenum);
+   stack = NEW(int,c->nodenum);
+   seen = (char*)calloc(c->nodenum, 1);
+   if (inputpos == NULL  ||  stack == NULL  ||  seen == NULL)
+   {
+      free(inputpos);
+      free(stack);
+      free(seen);
+      return bdd_error(BDD_MEMORY);
+   }
+
+   for (n=0 ; n<c->inputnum ; n++)
+   {
+      inputpos[c->input[n].node] = n;
+      rank[n] = -1;
+   }
+   
+   for (n=0 ; n<c->outputnum ; n++)
+   {
+      sp = 0;
+      if (!seen[c->output[n].lit/2])
+      {
+	 stack[sp++] = c->output[n].lit/2;
+	 seen[c->output[n].lit/2] = 1;
+      }
+      
+      while (sp > 0)
+      {
+	 CircuitNode *g = &c->node[stack[sp-1]];
+	 int i, best = -1;
+	 
+	 if (g->kind == NODE_INPUT)
+	    rank[inputpos[stack[sp-1]]] = next++;
+
+	    /* The deepest fanin not yet seen */
+	 if (g->kind == NODE_AND  ||  g->kind == NODE_COVER)
+	    for (i=0 ; i<g->faninnum ; i++)
+	    {
+	       int f = c->fanins[g->fanin+i]/2;
+	       if (!seen[f]  &&
+		   (best < 0  ||  c->node[f].depth > c->node[best].depth))
+		  best = f;
+	    }
+	 
+	 if (best < 0)
+	    sp--;
+	 else
+	 {
+	    seen[best] = 1;
+	    stack[sp++] = best;
+	 }
+      }
+   }
+
+      /* Inputs that no output depends on go last */
+   for (n=0 ; n<c->inputnum ; n++)
+      if (rank[n] < 0)
+	 rank[n] = next++;
+   
+   free(seen);
+   free(stack);
+   free(inputpos);
+   return 0;
+}
+
+
+   /* Places the variables of the inputs as given by 'rank' on the levels
+    * they already use */
+static int circuit_setorder(bddCircuit *c, int firstvar, int *rank)
+{
+   int *level, *neworder;
+   int n, i;
+
+   level = NEW(int,c->inputnum+1);
+   neworder = NEW(int,bddvarnum);
+   if (level == NULL  ||  neworder == NULL)
+   {
+      free(level);
+      free(neworder);
+      return bdd_error(BDD_MEMORY);
+   }
+
+      /* Sort the levels used by the inputs */
+   for (n=0 ; n<c->inputnum ; n++)
+   {
+      int l = bddvar2level[firstvar+n];
+      
+      for (i=n ; i>0  &&  level[i-1] > l ; i--)
+	 level[i] = level[i-1];
+      level[i] = l;
+   }
+
+   for (n=0 ; n<bddvarnum ; n++)
+      neworder[n] = bddlevel2var[n];
+   for (n=0 ; n<c->inputnum ; n++)
+      neworder[level[rank[n]]] = firstvar+n;
+
+   bdd_setvarorder(neworder);
+   
+   free(neworder);
+   free(level);
+   return 0;
+}
+
+
+/*=== CONSTRUCTION =====================================================*/
+
+   /* The conjunction of two possibly negated BDDs */
+static BDD circuit_and(BDD a, int nega, BDD b, int negb)
+{
+   static const int op[4] = { bddop_and, bddop_diff, bddop_less, bddop_nor };
+   return bdd_apply(a, b, op[2*nega + negb]);
+}
+
+
+static BDD circuit_cover(bddCircuit *c, CircuitNode *g, BDD *val)
+{
+   BDD sum = bdd_addref(bddfalse);
+   BDD cube = bddfalse, tmp;
+   int r, i;
+
+   for (r=0 ; r<g->rownum ; r++)
+   {
+      char *row = c->rows + g->row + r*g->faninnum;
+
+      cube = bdd_addref(bddtrue);
+      for (i=0 ; i<g->faninnum ; i++)
+      {
+	 int lit = c->fanins[g->fanin+i];
+
+	 if (row[i] == '-')
+	    continue;
+	 
+	 tmp = circuit_and(cube, 0, val[lit/2], (lit & 1) ^ (row[i] == '0'));
+	 if (tmp < 0)
+	    goto fail;
+	 bdd_addref(tmp);
+	 bdd_delref(cube);
+	 cube = tmp;
+      }
+
+      tmp = bdd_apply(sum, cube, bddop_or);
+      if (tmp < 0)
+	 goto fail;
+      bdd_addref(tmp);
+      bdd_delref(sum);
+      bdd_delref(cube);
+      sum = tmp;
+   }
+
+   tmp = g->onset ? sum : bdd_not(sum);
+   bdd_delref(sum);
+   return tmp;
+
+ fail:
+   bdd_delref(cube);
+   bdd_delref(sum);
+   return tmp;
+}
+
+
+   /* Counts the nodes of all live gates */
+static int circuit_livenodes(bddCircuit *c, int made, BDD *val, int *fanout,
+			     BDD *live)
+{
+   int n, num = 0;
+
+   for (n=0 ; n<=made ; n++)
+      if (fanout[c->order[n]] > 0)
+	 live[num++] = val[c->order[n]];
+   return bdd_anodecount(live, num);
+}
+
+
+int bdd_circuit_build(bddCircuit *c, int firstvar, int flags, BDD *out,
+		      bddCircuitStat *stat)
+{
+   BDD *val, *live = NULL;
+   int *fanout, *rank;
+   int n, i, made, outnum = 0, livenum = 0;
+   int err = 0;
+
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   if (firstvar < 0  ||  c->inputnum > MAXVAR-firstvar)
+      return bdd_error(BDD_VAR);
+   if (firstvar+c->inputnum > bddvarnum)
+      if ((err=bdd_setvarnum(firstvar+c->inputnum)) < 0)
+	 return err;
+
+   if (stat != NULL)
+      memset(stat, 0, sizeof(bddCircuitStat));
+   
+   if (flags & BDD_CIRCUIT_ORDER)
+   {
+      if ((rank=NEW(int,c->inputnum+1)) == NULL)
+	 return bdd_error(BDD_MEMORY);
+      if ((err=circuit_order(c, rank)) == 0)
+	 err = circuit_setorder(c, firstvar, rank);
+      free(rank);
+      if (err < 0)
+	 return err;
+   }
+
+   val = NEW(BDD,c->nodenum);
+   fanout = (int*)calloc(c->nodenum, sizeof(int));
+   if (flags & BDD_CIRCUIT_PEAK)
+      live = NEW(BDD,c->ordernum+1);
+   if (val == NULL  ||  fanout == NULL  ||
+       ((flags & BDD_CIRCUIT_PEAK)  &&  live == NULL))
+   {
+      free(val);
+      free(fanout);
+      free(live);
+      return bdd_error(BDD_MEMORY);
+   }
+
+      /* Inputs use the permanently referenced variable BDDs. The fanout
+       * of a gate counts the gates and outputs that still need it. */
+   val[0] = bddfalse;
+   for (n=0 ; n<c->inputnum ; n++)
+      val[c->input[n].node] = bdd_ithvar(firstvar+n);
+   for (n=0 ; n<c->ordernum ; n++)
+   {
+      CircuitNode *g = &c->node[c->order[n]];
+      for (i=0 ; i<g->faninnum ; i++)
+	 fanout[c->fanins[g->fanin+i]/2]++;
+   }
+   for (n=0 ; n<c->outputnum ; n++)
+      fanout[c->output[n].lit/2]++;
+
+   for (made=0 ; made<c->ordernum ; made++)
+   {
+      int node = c->order[made];
+      CircuitNode *g = &c->node[node];
+      BDD res;
+
+      if (g->kind == NODE_AND)
+      {
+	 int a = c->fanins[g->fanin], b = c->fanins[g->fanin+1];
+	 res = circuit_and(val[a/2], a & 1, val[b/2], b & 1);
+      }
+      else
+	 res = circuit_cover(c, g, val);
+
+      if (res < 0)
+      {
+	 err = res;
+	 break;
+      }
+      val[node] = bdd_addref(res);
+
+	 /* Release the fanins that this was the last fanout of */
+      for (i=0 ; i<g->faninnum ; i++)
+      {
+	 int f = c->fanins[g->fanin+i]/2;
+	 if (--fanout[f] == 0  &&
+	     (c->node[f].kind == NODE_AND  ||  c->node[f].kind == NODE_COVER))
+	 {
+	    bdd_delref(val[f]);
+	    livenum--;
+	 }
+      }
+      livenum++;
+
+      if (stat != NULL)
+      {
+	 stat->maxlive = MAX(stat->maxlive, livenum);
+	 stat->peaknodes = MAX(stat->peaknodes, bdd_getnodenum());
+	 if (flags & BDD_CIRCUIT_PEAK)
+	    stat->peaklive = MAX(stat->peaklive,
+				 circuit_livenodes(c, made, val, fanout, live));
+      }
+   }
+
+   if (stat != NULL)
+      stat->gates = made;
+   
+   while (err == 0  &&  outnum < c->outputnum)
+   {
+      int lit = c->output[outnum].lit;
+      
+      out[outnum] = (lit & 1) ? bdd_not(val[lit/2]) : val[lit/2];
+      if (out[outnum] < 0)
+	 err = out[outnum];
+      else
+	 bdd_addref(out[outnum++]);
+   }
+
+      /* The outputs are returned without references, as for bdd_load */
+   for (n=0 ; n<outnum ; n++)
+      bdd_delref(out[n]);
+   for (n=0 ; n<made ; n++)
+      if (fanout[c->order[n]] > 0)
+	 bdd_delref(val[c->order[n]]);
+   
+   free(live);
+   free(fanout);
+   free(val);
+   return err;
+}
+
+
+/* EOF */
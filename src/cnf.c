@@ -0,0 +1,829 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  cnf.c
+  DESCR: Construction of BDDs for CNF formulas in the DIMACS format
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "kernel.h"
+
+/* The clauses are kept with the DIMACS literals, so variable v is BDD
+   variable firstvar+v-1 when the BDD is made. Projection lines like
+   "c ind 1 2 0" or "c p show 1 2 0" mark the variables that a projected
+   count is over.
+
+   The BDD is made by bucket elimination. The variables get an
+   elimination order and each clause BDD is put in the bucket of its
+   first variable in that order. The buckets are then emptied in order:
+   the BDDs of a bucket are conjoined and the result is put in the
+   bucket of its next variable. If the variable of the bucket is not
+   projected it is quantified away with bdd_appex() in the last
+   conjunction, since no later bucket can hold it. Without projection
+   all variables are counted and nothing can be quantified, but the
+   buckets still keep the conjunctions local.
+*/
+
+struct s_bddCnf
+{
+   int   varnum;
+   int   clausenum;
+   int  *lit;            /* Literals of all clauses */
+   int   litnum, litalloc;
+   int  *start;          /* Start of each clause in 'lit', and the end */
+   int   startalloc;
+   char *projected;      /* Projected variables, NULL without projection */
+   int   projectedalloc;
+   int   projectedmax;
+};
+
+typedef struct s_CnfItem
+{
+   BDD r;
+   int next;
+} CnfItem;
+
+
+/*=== LOADING ==========================================================*/
+
+static int cnf_grow(void **array, int *alloc, int need, size_t size)
+{
+   void *tmp_ptr;
+   int newalloc;
+   
+   if (need <= *alloc)
+      return 0;
+
+   newalloc = MAX(need, *alloc*2 + 16);
+   if ((tmp_ptr=realloc(*array, size*newalloc)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   *array = tmp_ptr;
+   *alloc = newalloc;
+   return 0;
+}
+
+
+   /* Reads a signed decimal number. Returns 0 on success, -1 at the end
+    * of the file and -2 for anything else */
+static int cnf_num(FILE *ifile, int *res)
+{
+   int c, neg = 0;
+   long n = 0;
+
+   while ((c=getc(ifile)) != EOF  &&  isspace(c))
+      ;
+   if (c == EOF)
+      return -1;
+   
+   if (c == '-')
+   {
+      neg = 1;
+      c = getc(ifile);
+   }
+   if (!isdigit(c))
+   {
+      ungetc(c, ifile);
+      return -2;
+   }
+   
+   for ( ; isdigit(c) ; c=getc(ifile))
+      if ((n = 10*n + (c-'0')) > INT_MAX)
+	 return -2;
+   ungetc(c, ifile);
+
+   *res = neg ? -(int)n : (int)n;
+   return 0;
+}
+
+
+static void cnf_skipline(FILE *ifile)
+{
+   int c;
+
+   while ((c=getc(ifile)) != EOF  &&  c != '\n')
+      ;
+}
+
+
+   /* Reads the variables of a projection line up to the ending zero.
+    * These lines may come before the header, so the range is checked
+    * when all of the file has been read. */
+static int cnf_projection(bddCnf *cnf, FILE *ifile)
+{
+   int v, oldalloc;
+
+   while (cnf_num(ifile, &v) == 0  &&  v != 0)
+   {
+      if (v < 0)
+	 return bdd_error(BDD_FORMAT);
+      
+      oldalloc = cnf->projectedalloc;
+      if (cnf_grow((void**)&cnf->projected, &cnf->projectedalloc, v+1, 1) < 0)
+	 return BDD_MEMORY;
+      memset(cnf->projected+oldalloc, 0, cnf->projectedalloc-oldalloc);
+      
+      cnf->projected[v] = 1;
+      cnf->projectedmax = MAX(cnf->projectedmax, v);
+   }
+   return 0;
+}
+
+
+   /* Handles a comment line after the 'c' */
+static int cnf_comment(bddCnf *cnf, FILE *ifile)
+{
+   char word[8];
+   int c, n = 0;
+
+   while ((c=getc(ifile)) == ' '  ||  c == '\t')
+      ;
+   while (c != EOF  &&  !isspace(c)  &&  n < 7)
+   {
+      word[n++] = c;
+      c = getc(ifile);
+   }
+   word[n] = 0;
+   ungetc(c, ifile);
+
+      /* "c p show" is used by newer model counting benchmarks */
+   if (strcmp(word, "p") == 0)
+   {
+      while ((c=getc(ifile)) == ' '  ||  c == '\t')
+	 ;
+      for (n=0 ; c != EOF  &&  !isspace(c)  &&  n < 7 ; c=getc(ifile))
+	 word[n++] = c;
+      word[n] = 0;
+      ungetc(c, ifile);
+      if (strcmp(word, "show") != 0)
+	 n = 0;
+   }
+
+   if (n > 0  &&  (strcmp(word, "ind") == 0  ||  strcmp(word, "show") == 0))
+      return cnf_projection(cnf, ifile);
+
+   cnf_skipline(ifile);
+   return 0;
+}
+
+
+static int cnf_parse(bddCnf *cnf, FILE *ifile)
+{
+   int c, v, declared, header = 0, open = 0, err;
+
+   while ((c=getc(ifile)) != EOF)
+   {
+      if (isspace(c))
+	 continue;
+
+      if (c == 'c')
+      {
+	 if ((err=cnf_comment(cnf, ifile)) < 0)
+	    return err;
+	 continue;
+      }
+
+      if (c == 'p')
+      {
+	 if (header  ||  fscanf(ifile, " cnf %d %d", &cnf->varnum,
+				&declared) != 2  ||
+	     cnf->varnum < 0  ||  cnf->varnum > MAXVAR  ||  declared < 0)
+	    return bdd_error(BDD_FORMAT);
+	 if (cnf_grow((void**)&cnf->start, &cnf->startalloc,
+		      MIN(declared,1000000)+1, sizeof(int)) < 0)
+	    return BDD_MEMORY;
+	 cnf->start[0] = 0;
+	 header = 1;
+	 continue;
+      }
+
+	 /* SATLIB files end with "%" */
+      if (c == '%')
+	 break;
+
+      ungetc(c, ifile);
+      if (!header  ||  cnf_num(ifile, &v) < 0  ||
+	  v < -cnf->varnum  ||  v > cnf->varnum)
+	 return bdd_error(BDD_FORMAT);
+
+      open = (v != 0);
+      if (v != 0)
+      {
+	 if (cnf_grow((void**)&cnf->lit, &cnf->litalloc, cnf->litnum+1,
+		      sizeof(int)) < 0)
+	    return BDD_MEMORY;
+	 cnf->lit[cnf->litnum++] = v;
+      }
+      else
+      {
+	 if (cnf_grow((void**)&cnf->start, &cnf->startalloc,
+		      cnf->clausenum+2, sizeof(int)) < 0)
+	    return BDD_MEMORY;
+	 cnf->start[++cnf->clausenum] = cnf->litnum;
+      }
+   }
+
+   if (!header  ||  cnf->projectedmax > cnf->varnum)
+      return bdd_error(BDD_FORMAT);
+   if (cnf->projected != NULL)
+   {
+      int oldalloc = cnf->projectedalloc;
+      
+      if (cnf_grow((void**)&cnf->projected, &cnf->projectedalloc,
+		   cnf->varnum+1, 1) < 0)
+	 return BDD_MEMORY;
+      memset(cnf->projected+oldalloc, 0, cnf->projectedalloc-oldalloc);
+   }
+   
+      /* The last clause may miss its zero */
+   if (open)
+   {
+      if (cnf_grow((void**)&cnf->start, &cnf->startalloc,
+		   cnf->clausenum+2, sizeof(int)) < 0)
+	 return BDD_MEMORY;
+      cnf->start[++cnf->clausenum] = cnf->litnum;
+   }
+   
+   return 0;
+}
+
+
+bddCnf *bdd_cnf_load(FILE *ifile)
+{
+   bddCnf *cnf;
+
+   if ((cnf=NEW(bddCnf,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   memset(cnf, 0, sizeof(bddCnf));
+
+   if (cnf_parse(cnf, ifile) < 0)
+   {
+      bdd_cnf_free(cnf);
+      return NULL;
+   }
+
+   return cnf;
+}
+
+
+bddCnf *bdd_cnf_fnload(char *fname)
+{
+   bddCnf *cnf;
+   FILE *ifile;
+
+   if ((ifile=fopen(fname, "r")) == NULL)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   cnf = bdd_cnf_load(ifile);
+   fclose(ifile);
+   return cnf;
+}
+
+
+void bdd_cnf_free(bddCnf *cnf)
+{
+   if (cnf == NULL)
+      return;
+   
+   free(cnf->lit);
+   free(cnf->start);
+   free(cnf->projected);
+   free(cnf);
+}
+
+
+int bdd_cnf_varnum(const bddCnf *cnf)
+{
+   return cnf->varnum;
+}
+
+
+int bdd_cnf_clausenum(const bddCnf *cnf)
+{
+   return cnf->clausenum;
+}
+
+
+/*=== ELIMINATION ORDER ================================================*/
+
+   /* Orders the variables from the deepest level up */
+static void cnf_levelorder(bddCnf *cnf, int firstvar, int *elim)
+{
+   int level, n = 0;
+
+   for (level=bddvarnum-1 ; level>=0 ; level--)
+   {
+      int v = bddlevel2var[level] - firstvar;
+      
+      if (v >= 0  &&  v < cnf->varnum)
+	 elim[n++] = v+1;
+   }
+}
+
+
+   /* Orders the variables by a greedy minimum width arrangement. A
+    * clause is open when some but not all of its variables are placed,
+    * and the number of open clauses bounds the width of the BDD at that
+    * point. Each step places the variable that opens the fewest new
+    * clauses minus the clauses it closes, with ties going to the one
+    * in most open clauses and then to the deepest level. 'score' holds
+    * that difference and 'front' the number of open clauses for each
+    * unplaced variable. */
+static int cnf_minwidth(bddCnf *cnf, int firstvar, int *elim)
+{
+   int *occ, *occstart, *left, *score, *front;
+   char *opened, *placed;
+   int n, i, k, err = 0;
+   int varnum = cnf->varnum;
+
+   occ = NEW(int,cnf->litnum+1);
+   occstart = (int*)calloc(varnum+2, sizeof(int));
+   left = NEW(int,cnf->clausenum+1);
+   score = (int*)calloc(varnum+1, sizeof(int));
+   front = (int*)calloc(varnum+1, sizeof(int));
+   opened = (char*)calloc(cnf->clausenum+1, 1);
+   placed = (char*)calloc(varnum+1, 1);
+   
+   if (occ == NULL  ||  occstart == NULL  ||  left == NULL  ||
+       score == NULL  ||  front == NULL  ||  opened == NULL  ||
+       placed == NULL)
+   {
+      err = bdd_error(BDD_MEMORY);
+      goto done;
+   }
+
+      /* Clauses of each variable and the number of distinct variables
+       * of each clause. 'placed' marks the variables already counted for
+       * the current clause and is cleared again after each clause. */
+   for (n=0 ; n<cnf->clausenum ; n++)
+   {
+      for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+	 if (!placed[abs(cnf->lit[i])])
+	 {
+	    placed[abs(cnf->lit[i])] = 1;
+	    occstart[abs(cnf->lit[i])+1]++;
+	 }
+      for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+	 placed[abs(cnf->lit[i])] = 0;
+   }
+   for (n=1 ; n<=varnum ; n++)
+      occstart[n+1] += occstart[n];
+   for (n=0 ; n<cnf->clausenum ; n++)
+   {
+      left[n] = 0;
+      for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+      {
+	 int v = abs(cnf->lit[i]);
+	 if (!placed[v])
+	 {
+	    placed[v] = 1;
+	    occ[occstart[v] + score[v]++] = n;
+	    left[n]++;
+	 }
+      }
+      for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+	 placed[abs(cnf->lit[i])] = 0;
+   }
+
+      /* A unit clause is opened and closed by its only variable */
+   for (n=0 ; n<cnf->clausenum ; n++)
+      if (left[n] == 1)
+	 score[abs(cnf->lit[cnf->start[n]])]--;
+
+   for (n=0 ; n<varnum ; n++)
+   {
+      int best = 0, infront = 0;
+
+	 /* Variables of open clauses come first so the arrangement grows
+	  * along the formula instead of jumping between its parts */
+      for (i=1 ; i<=varnum ; i++)
+	 if (!placed[i]  &&  front[i] > 0)
+	    infront = 1;
+      
+      for (i=1 ; i<=varnum ; i++)
+      {
+	 if (placed[i]  ||  (infront  &&  front[i] == 0))
+	    continue;
+	 if (best == 0  ||  score[i] < score[best]  ||
+	     (score[i] == score[best]  &&
+	      (front[i] > front[best]  ||
+	       (front[i] == front[best]  &&
+		bddvar2level[firstvar+i-1] > bddvar2level[firstvar+best-1]))))
+	    best = i;
+      }
+
+      elim[n] = best;
+      placed[best] = 1;
+
+      for (k=occstart[best] ; k<occstart[best+1] ; k++)
+      {
+	 int c = occ[k];
+
+	    /* The other variables can no longer open this clause. The
+	     * score is lowered once for a repeated variable. */
+	 if (!opened[c])
+	 {
+	    opened[c] = 1;
+	    for (i=cnf->start[c] ; i<cnf->start[c+1] ; i++)
+	       if (!placed[abs(cnf->lit[i])])
+	       {
+		  int v = abs(cnf->lit[i]), m;
+		  for (m=cnf->start[c] ; m<i && abs(cnf->lit[m])!=v ; m++)
+		     ;
+		  if (m == i)
+		  {
+		     score[v]--;
+		     front[v]++;
+		  }
+	       }
+	 }
+
+	    /* The last variable of the clause closes it */
+	 if (--left[c] == 1)
+	 {
+	    for (i=cnf->start[c] ; i<cnf->start[c+1] ; i++)
+	       if (!placed[abs(cnf->lit[i])])
+	       {
+		  score[abs(cnf->lit[i])]--;
+		  break;
+	       }
+	 }
+      }
+   }
+
+ done:
+   free(occ);
+   free(occstart);
+   free(left);
+   free(score);
+   free(front);
+   free(opened);
+   free(placed);
+   return err;
+}
+
+
+   /* Gives the variables of the formula the levels they already use
+    * between them with the first eliminated variable deepest */
+static int cnf_setorder(bddCnf *cnf, int firstvar, int *elim)
+{
+   int *neworder;
+   int level, n = 0;
+
+   if ((neworder=NEW(int,bddvarnum)) == NULL)
+      return bdd_error(BDD_MEMORY);
+
+   for (level=bddvarnum-1 ; level>=0 ; level--)
+   {
+      int v = bddlevel2var[level] - firstvar;
+
+      if (v >= 0  &&  v < cnf->varnum)
+	 neworder[level] = firstvar + elim[n++] - 1;
+      else
+	 neworder[level] = bddlevel2var[level];
+   }
+
+   bdd_setvarorder(neworder);
+   free(neworder);
+   return 0;
+}
+
+
+/*=== CONSTRUCTION =====================================================*/
+
+   /* Makes the BDD of clause 'n' bottom up with bdd_makenode(). Returns
+    * the BDD with a reference added. */
+static BDD cnf_clause(bddCnf *cnf, int n, int firstvar, int *level)
+{
+   int num = 0, i, j;
+   BDD r, tmp;
+
+      /* Sort the literals by level with the deepest first. A literal is
+       * stored as level*2 + negated. */
+   for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+   {
+      int v = cnf->lit[i];
+      int l = 2*bddvar2level[firstvar+abs(v)-1] + (v < 0);
+      
+      for (j=num ; j>0  &&  level[j-1] < l ; j--)
+	 level[j] = level[j-1];
+      level[j] = l;
+      num++;
+   }
+
+   r = bdd_addref(bddfalse);
+   for (i=0 ; i<num ; i++)
+   {
+      if (i > 0  &&  level[i]/2 == level[i-1]/2)
+      {
+	    /* x | !x is true, x | x is x */
+	 if (level[i] != level[i-1])
+	 {
+	    bdd_delref(r);
+	    return bdd_addref(bddtrue);
+	 }
+	 continue;
+      }
+
+      if (level[i] & 1)
+	 tmp = bdd_makenode(level[i]/2, bddtrue, r);
+      else
+	 tmp = bdd_makenode(level[i]/2, r, bddtrue);
+      if (bdderrorcond)
+      {
+	 bdd_delref(r);
+	 return -bdderrorcond;
+      }
+      
+      bdd_addref(tmp);
+      bdd_delref(r);
+      r = tmp;
+   }
+
+   return r;
+}
+
+
+   /* Finds the bucket that 'r' goes to after the bucket at 'pos' */
+static int cnf_nextbucket(BDD r, int pos, int firstvar, int varnum,
+			  int *elimpos)
+{
+   BDD s = bdd_support(r);
+   int next = -1;
+
+   for ( ; !ISCONST(s) ; s=HIGH(s))
+   {
+      int v = bddlevel2var[LEVEL(s)] - firstvar;
+      
+      if (v >= 0  &&  v < varnum  &&  elimpos[v+1] > pos  &&
+	  (next < 0  ||  elimpos[v+1] < next))
+	 next = elimpos[v+1];
+   }
+
+   return next;
+}
+
+
+static int cnf_build(bddCnf *cnf, int firstvar, int flags, BDD *res)
+{
+   CnfItem *item;
+   int *elim, *elimpos, *bucket, *level;
+   int itemnum = 0, final = -1, unsat = 0;
+   int n, i, err = 0;
+   int varnum = cnf->varnum;
+   int quantify = ((flags & BDD_CNF_PROJECT)  &&  cnf->projected != NULL);
+   BDD acc;
+
+   elim = NEW(int,varnum+1);
+   elimpos = NEW(int,varnum+1);
+   bucket = NEW(int,varnum+1);
+   level = NEW(int,cnf->litnum+1);
+   item = NEW(CnfItem,cnf->clausenum+varnum+1);
+   
+   if (elim == NULL  ||  elimpos == NULL  ||  bucket == NULL  ||
+       level == NULL  ||  item == NULL)
+   {
+      err = bdd_error(BDD_MEMORY);
+      goto done;
+   }
+
+   if (flags & BDD_CNF_MINWIDTH)
+   {
+      if ((err=cnf_minwidth(cnf, firstvar, elim)) == 0)
+	 err = cnf_setorder(cnf, firstvar, elim);
+   }
+   else
+      cnf_levelorder(cnf, firstvar, elim);
+   if (err < 0)
+      goto done;
+   
+   for (n=0 ; n<varnum ; n++)
+   {
+      elimpos[elim[n]] = n;
+      bucket[n] = -1;
+   }
+
+      /* Clauses go to the bucket of their first variable, and the empty
+       * clause directly to the end */
+   bdd_disable_reorder();
+   for (n=0 ; n<cnf->clausenum ; n++)
+   {
+      BDD r = cnf_clause(cnf, n, firstvar, level);
+      int pos = -1;
+
+      if (r < 0)
+      {
+	 err = r;
+	 break;
+      }
+      
+      for (i=cnf->start[n] ; i<cnf->start[n+1] ; i++)
+	 if (pos < 0  ||  elimpos[abs(cnf->lit[i])] < pos)
+	    pos = elimpos[abs(cnf->lit[i])];
+
+      if (r == bddtrue)
+	 continue;
+      
+      item[itemnum].r = r;
+      if (pos < 0)
+      {
+	 item[itemnum].next = final;
+	 final = itemnum++;
+      }
+      else
+      {
+	 item[itemnum].next = bucket[pos];
+	 bucket[pos] = itemnum++;
+      }
+   }
+   bdd_enable_reorder();
+   
+   for (n=0 ; n<varnum  &&  err == 0 ; n++)
+   {
+      int v = elim[n], next;
+      BDD var = bdd_ithvar(firstvar+v-1);
+      
+      if (bucket[n] < 0)
+	 continue;
+
+	 /* Conjoin the bucket and quantify the variable in the last
+	  * step if it is not projected */
+      acc = item[bucket[n]].r;
+      for (i=item[bucket[n]].next ; i>=0  &&  err == 0 ; i=item[i].next)
+      {
+	 BDD tmp;
+	 
+	 if (quantify  &&  !cnf->projected[v]  &&  item[i].next < 0)
+	    tmp = bdd_appex(acc, item[i].r, bddop_and, var);
+	 else
+	    tmp = bdd_apply(acc, item[i].r, bddop_and);
+	 if (tmp < 0)
+	    err = tmp;
+	 else
+	 {
+	    bdd_addref(tmp);
+	    bdd_delref(acc);
+	    bdd_delref(item[i].r);
+	    item[i].r = bddtrue;
+	    acc = tmp;
+	 }
+      }
+      item[bucket[n]].r = bddtrue;
+      
+      if (err == 0  &&  quantify  &&  !cnf->projected[v]  &&
+	  item[bucket[n]].next < 0)
+      {
+	 BDD tmp = bdd_exist(acc, var);
+	 if (tmp < 0)
+	    err = tmp;
+	 else
+	 {
+	    bdd_addref(tmp);
+	    bdd_delref(acc);
+	    acc = tmp;
+	 }
+      }
+
+      if (err < 0)
+      {
+	 bdd_delref(acc);
+	 break;
+      }
+      
+	 /* An unsatisfiable bucket makes everything false */
+      if (acc == bddfalse)
+      {
+	 unsat = 1;
+	 break;
+      }
+      if (acc == bddtrue)
+	 continue;
+
+      item[bucket[n]].r = acc;
+      if ((next=cnf_nextbucket(acc, n, firstvar, varnum, elimpos)) < 0)
+      {
+	 item[bucket[n]].next = final;
+	 final = bucket[n];
+      }
+      else
+      {
+	 item[bucket[n]].next = bucket[next];
+	 bucket[next] = bucket[n];
+      }
+   }
+
+      /* What is left has no variables to eliminate */
+   if (err == 0)
+   {
+      acc = (unsat ? bddfalse : bddtrue);
+      for (i=final ; i>=0  &&  !unsat  &&  err == 0 ; i=item[i].next)
+      {
+	 BDD tmp = bdd_apply(acc, item[i].r, bddop_and);
+	 if (tmp < 0)
+	    err = tmp;
+	 else
+	 {
+	    bdd_addref(tmp);
+	    bdd_delref(acc);
+	    acc = tmp;
+	 }
+      }
+      if (err == 0)
+	 *res = acc;
+      bdd_delref(acc);
+   }
+
+      /* Every item still holds its own reference */
+   for (i=0 ; i<itemnum ; i++)
+      bdd_delref(item[i].r);
+   
+ done:
+   free(item);
+   free(level);
+   free(bucket);
+   free(elimpos);
+   free(elim);
+   return err;
+}
+
+
+int bdd_cnf_build(bddCnf *cnf, int firstvar, int flags, BDD *res)
+{
+   int err;
+   
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   if (firstvar < 0  ||  cnf->varnum > MAXVAR-firstvar)
+      return bdd_error(BDD_VAR);
+   if (firstvar+cnf->varnum > bddvarnum)
+      if ((err=bdd_setvarnum(firstvar+cnf->varnum)) < 0)
+	 return err;
+
+   return cnf_build(cnf, firstvar, flags, res);
+}
+
+
+char *bdd_cnf_count(bddCnf *cnf, int firstvar, int flags)
+{
+   BDD r, varset, tmp;
+   char *count;
+   int n;
+
+   if (bdd_cnf_build(cnf, firstvar, flags, &r) < 0)
+      return NULL;
+   bdd_addref(r);
+
+      /* Count over the projected variables or all variables */
+   varset = bdd_addref(bddtrue);
+   for (n=cnf->varnum ; n>0 ; n--)
+      if (!(flags & BDD_CNF_PROJECT)  ||  cnf->projected == NULL  ||
+	  cnf->projected[n])
+      {
+	 tmp = bdd_addref( bdd_apply(varset, bdd_ithvar(firstvar+n-1),
+				     bddop_and) );
+	 bdd_delref(varset);
+	 varset = tmp;
+      }
+
+   count = bdd_satcountset_exact(r, varset);
+   
+   bdd_delref(varset);
+   bdd_delref(r);
+   return count;
+}
+
+
+/* EOF */
@@ -0,0 +1,980 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  compile.c
+  DESCR: Compilation of BDDs into flat read-only evaluation programs
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "config.h"
+#include "kernel.h"
+
+#if defined(HAVE_MMAP) && defined(HAVE_SYS_MMAN_H) && defined(HAVE_UNISTD_H)
+#define PROGRAM_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#ifdef HAVE_SHM_OPEN
+#define PROGRAM_SHM
+#endif
+#endif
+
+/* A compiled program is one contiguous image that is never changed after
+   it has been built, so any number of threads may evaluate it at the same
+   time. For the same reason the queries report illegal roots and lack of
+   memory only through their return values and never call the global error
+   handler. The image is also the file format:
+
+     header    bddProgramHeader
+     roots     uint32_t[rootnum]
+     levels    uint32_t[varnum]
+     var       uint32_t[nodenum]
+     low       uint16_t[nodenum] or uint32_t[nodenum]
+     high      uint16_t[nodenum] or uint32_t[nodenum]
+
+   The nodes are numbered 0..nodenum-1 such that all children have higher
+   numbers than their parents, and the constants false and true are
+   numbered nodenum and nodenum+1. The children are stored as the positive
+   offset from the parent, using 16 bits whenever all offsets fit. The
+   levels are the variable order at compile time, needed for counting.
+
+   All offsets in the image are fixed, so a file can be mapped into memory
+   and used as it is by any number of processes. The same holds for a POSIX
+   shared memory object, which lets a process freeze its bdds once for a
+   number of workers that attach it. A worker that needs a frozen bdd in
+   its own node table imports it, and the handle remembers the imported
+   node of each program node so shared parts are only made once. */
+
+#define PROGRAM_MAGIC   "BDDP"
+#define PROGRAM_ENDIAN  0x01020304
+#define PROGRAM_VERSION 2
+
+typedef struct s_bddProgramHeader
+{
+   char     magic[4];
+   uint32_t endian;     /* PROGRAM_ENDIAN in the writers byte order */
+   uint32_t version;
+   uint32_t width;      /* Size of a child offset in bytes (2 or 4) */
+   uint32_t order;      /* BDD_COMPILE_DFS or BDD_COMPILE_BFS */
+   uint32_t varnum;     /* Number of variables that may be referenced */
+   uint32_t nodenum;
+   uint32_t rootnum;
+} bddProgramHeader;
+
+struct s_bddProgram
+{
+   char *image;
+   size_t size;
+   const bddProgramHeader *header;
+   int mapped;          /* Set if 'image' is mapped from a file */
+   const uint32_t *roots;
+   const uint32_t *level;
+   const uint32_t *var;
+   const void *low;
+   const void *high;
+   BDD *import;         /* Referenced private bdds of imported nodes */
+};
+
+static size_t program_imagesize(uint32_t, uint32_t, uint32_t, uint32_t);
+static bddProgram *program_new(char *, size_t);
+static int  program_header(const bddProgramHeader *);
+static int  program_check(bddProgram *);
+static uint32_t program_child(const bddProgram *, uint32_t, int);
+static uint32_t program_level(const bddProgram *, uint32_t);
+#ifdef PROGRAM_MMAP
+static bddProgram *program_mapfd(int, int);
+#endif
+
+
+/*************************************************************************
+  Compilation
+*************************************************************************/
+
+static size_t program_imagesize(uint32_t width, uint32_t varnum,
+				uint32_t nodenum, uint32_t rootnum)
+{
+   return sizeof(bddProgramHeader) + sizeof(uint32_t)*(size_t)rootnum +
+      sizeof(uint32_t)*(size_t)varnum +
+      sizeof(uint32_t)*(size_t)nodenum + 2*(size_t)width*nodenum;
+}
+
+
+   /* Creates the program handle for an image and sets up the array
+    * pointers. The header must have been validated before this. */
+static bddProgram *program_new(char *image, size_t size)
+{
+   bddProgram *p;
+   const bddProgramHeader *h = (const bddProgramHeader*)image;
+   
+   if ((p=NEW(bddProgram,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   p->image = image;
+   p->size = size;
+   p->mapped = 0;
+   p->header = h;
+   p->roots = (const uint32_t*)(image + sizeof(bddProgramHeader));
+   p->level = p->roots + h->rootnum;
+   p->var = p->level + h->varnum;
+   p->low = p->var + h->nodenum;
+   p->high = (const char*)p->low + (size_t)h->width*h->nodenum;
+   p->import = NULL;
+
+   return p;
+}
+
+
+bddProgram *bdd_acompile(BDD *r, int num, int order)
+{
+   int *cone, *index, *levelcount = NULL;
+   bddProgramHeader *h;
+   bddProgram *p;
+   uint32_t *roots, *var;
+   uint32_t width = 2;
+   char *image;
+   size_t size;
+   int n, i, conenum;
+
+   if (r == NULL  ||  num < 1)
+   {
+      bdd_error(BDD_SIZE);
+      return NULL;
+   }
+   if (order != BDD_COMPILE_DFS  &&  order != BDD_COMPILE_BFS)
+   {
+      bdd_error(BDD_ILLBDD);
+      return NULL;
+   }
+   for (n=0 ; n<num ; n++)
+      CHECKa(r[n], NULL);
+
+   if ((cone=bdd_postorder(r, num, &conenum)) == NULL)
+      return NULL;
+
+   if ((index=NEW(int,bddnodesize)) == NULL)
+   {
+      free(cone);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   
+   if (order == BDD_COMPILE_DFS)
+   {
+	 /* Reverse post order puts parents before children and keeps each
+	  * node close to the first child visited from it */
+      for (n=0 ; n<conenum ; n++)
+	 index[cone[n]] = conenum-1-n;
+   }
+   else
+   {
+	 /* Breadth first by level, found by a counting sort on the levels */
+      if ((levelcount=NEW(int,bddvarnum+1)) == NULL)
+      {
+	 free(cone);
+	 free(index);
+	 bdd_error(BDD_MEMORY);
+	 return NULL;
+      }
+      
+      memset(levelcount, 0, sizeof(int)*(bddvarnum+1));
+      for (n=0 ; n<conenum ; n++)
+	 levelcount[LEVEL(cone[n])+1]++;
+      for (n=0 ; n<bddvarnum ; n++)
+	 levelcount[n+1] += levelcount[n];
+      for (n=conenum-1 ; n>=0 ; n--)
+	 index[cone[n]] = levelcount[LEVEL(cone[n])]++;
+      free(levelcount);
+   }
+
+      /* Find the width of the child offsets */
+   for (n=0 ; n<conenum ; n++)
+   {
+      int node = cone[n];
+      int lo = (LOW(node) < 2 ? conenum+LOW(node) : index[LOW(node)]);
+      int hi = (HIGH(node) < 2 ? conenum+HIGH(node) : index[HIGH(node)]);
+
+      if (lo - index[node] > 0xFFFF  ||  hi - index[node] > 0xFFFF)
+      {
+	 width = 4;
+	 break;
+      }
+   }
+   
+   size = program_imagesize(width, bddvarnum, conenum, num);
+   if ((image=(char*)malloc(size)) == NULL)
+   {
+      free(cone);
+      free(index);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   h = (bddProgramHeader*)image;
+   memcpy(h->magic, PROGRAM_MAGIC, 4);
+   h->endian = PROGRAM_ENDIAN;
+   h->version = PROGRAM_VERSION;
+   h->width = width;
+   h->order = order;
+   h->varnum = bddvarnum;
+   h->nodenum = conenum;
+   h->rootnum = num;
+   
+   if ((p=program_new(image, size)) == NULL)
+   {
+      free(cone);
+      free(index);
+      free(image);
+      return NULL;
+   }
+
+   roots = (uint32_t*)p->roots;
+   var = (uint32_t*)p->var;
+   
+   for (n=0 ; n<num ; n++)
+      roots[n] = (r[n] < 2 ? conenum+r[n] : index[r[n]]);
+   for (n=0 ; n<bddvarnum ; n++)
+      ((uint32_t*)p->level)[n] = bddvar2level[n];
+
+   for (n=0 ; n<conenum ; n++)
+   {
+      int node = cone[n];
+      int lo = (LOW(node) < 2 ? conenum+LOW(node) : index[LOW(node)]);
+      int hi = (HIGH(node) < 2 ? conenum+HIGH(node) : index[HIGH(node)]);
+
+      i = index[node];
+      var[i] = bddlevel2var[LEVEL(node)];
+      
+      if (width == 2)
+      {
+	 ((uint16_t*)p->low)[i] = (uint16_t)(lo - i);
+	 ((uint16_t*)p->high)[i] = (uint16_t)(hi - i);
+      }
+      else
+      {
+	 ((uint32_t*)p->low)[i] = (uint32_t)(lo - i);
+	 ((uint32_t*)p->high)[i] = (uint32_t)(hi - i);
+      }
+   }
+
+   free(cone);
+   free(index);
+   
+   return p;
+}
+
+
+bddProgram *bdd_compile(BDD r, int order)
+{
+   return bdd_acompile(&r, 1, order);
+}
+
+
+void bdd_program_free(bddProgram *p)
+{
+   if (p == NULL)
+      return;
+
+   bdd_program_forget(p);
+#ifdef PROGRAM_MMAP
+   if (p->mapped)
+      munmap(p->image, p->size);
+   else
+#endif
+      free(p->image);
+   free(p);
+}
+
+
+/*************************************************************************
+  Evaluation
+*************************************************************************/
+
+int bdd_program_eval(const bddProgram *p, int root, const char *assign)
+{
+   const uint32_t *var = p->var;
+   uint32_t n = p->header->nodenum;
+   uint32_t i;
+
+   if (root < 0  ||  (uint32_t)root >= p->header->rootnum)
+      return BDD_SIZE;
+
+   i = p->roots[root];
+   
+   if (p->header->width == 2)
+   {
+      const uint16_t *low = (const uint16_t*)p->low;
+      const uint16_t *high = (const uint16_t*)p->high;
+
+      while (i < n)
+	 i += (assign[var[i]] ? high[i] : low[i]);
+   }
+   else
+   {
+      const uint32_t *low = (const uint32_t*)p->low;
+      const uint32_t *high = (const uint32_t*)p->high;
+
+      while (i < n)
+	 i += (assign[var[i]] ? high[i] : low[i]);
+   }
+
+   return (int)(i - n);
+}
+
+
+int bdd_program_nodenum(const bddProgram *p)
+{
+   return (int)p->header->nodenum;
+}
+
+
+int bdd_program_rootnum(const bddProgram *p)
+{
+   return (int)p->header->rootnum;
+}
+
+
+int bdd_program_varnum(const bddProgram *p)
+{
+   return (int)p->header->varnum;
+}
+
+
+/*************************************************************************
+  Queries
+*************************************************************************/
+
+   /* Returns the absolute index of the low (hi=0) or high (hi=1) child */
+static uint32_t program_child(const bddProgram *p, uint32_t i, int hi)
+{
+   const void *child = (hi ? p->high : p->low);
+   
+   if (p->header->width == 2)
+      return i + ((const uint16_t*)child)[i];
+   return i + ((const uint32_t*)child)[i];
+}
+
+
+   /* Returns the level of a node, counting the constants as being below
+    * all variables */
+static uint32_t program_level(const bddProgram *p, uint32_t i)
+{
+   if (i >= p->header->nodenum)
+      return p->header->varnum;
+   return p->level[p->var[i]];
+}
+
+
+double bdd_program_satcount(const bddProgram *p, int root)
+{
+   uint32_t n = p->header->nodenum;
+   uint32_t r, i;
+   double *count, res;
+   char *mark;
+
+   if (root < 0  ||  (uint32_t)root >= p->header->rootnum)
+      return 0.0;
+
+   r = p->roots[root];
+   if (r >= n)
+      return (r == n ? 0.0 : pow(2.0, (double)p->header->varnum));
+
+      /* Only the nodes reachable from the root are counted. All of them
+       * have indices from r and up, so this can be done in two passes
+       * over that part of the node array - first down to mark the nodes
+       * and then up to count them. */
+   count = NEW(double, n+2-r);
+   mark = (char*)calloc(n-r, 1);
+   if (count == NULL  ||  mark == NULL)
+   {
+      free(count);
+      free(mark);
+      return 0.0;
+   }
+
+   mark[0] = 1;
+   for (i=r ; i<n ; i++)
+   {
+      uint32_t lo, hi;
+      
+      if (!mark[i-r])
+	 continue;
+      if ((lo=program_child(p,i,0)) < n)
+	 mark[lo-r] = 1;
+      if ((hi=program_child(p,i,1)) < n)
+	 mark[hi-r] = 1;
+   }
+
+   count[n-r] = 0.0;
+   count[n+1-r] = 1.0;
+   for (i=n ; i>r ; )
+   {
+      uint32_t lo, hi, level;
+
+      if (!mark[--i - r])
+	 continue;
+      
+      lo = program_child(p,i,0);
+      hi = program_child(p,i,1);
+      level = program_level(p,i);
+      count[i-r] =
+	 pow(2.0, (double)(program_level(p,lo)-level-1)) * count[lo-r] +
+	 pow(2.0, (double)(program_level(p,hi)-level-1)) * count[hi-r];
+   }
+
+   res = pow(2.0, (double)program_level(p,r)) * count[0];
+   free(count);
+   free(mark);
+   return res;
+}
+
+
+int bdd_program_satone(const bddProgram *p, int root, char *assign)
+{
+   uint32_t n = p->header->nodenum;
+   uint32_t i;
+
+   if (root < 0  ||  (uint32_t)root >= p->header->rootnum)
+      return BDD_SIZE;
+
+   memset(assign, 0, p->header->varnum);
+   i = p->roots[root];
+
+      /* Every node except false has a path to true, so it is enough to
+       * avoid stepping onto false */
+   while (i < n)
+   {
+      uint32_t lo = program_child(p,i,0);
+
+      if (lo == n)
+      {
+	 assign[p->var[i]] = 1;
+	 i = program_child(p,i,1);
+      }
+      else
+	 i = lo;
+   }
+
+   return (int)(i - n);
+}
+
+
+int bdd_program_restrict(const bddProgram *p, int root,
+			 const signed char *assign)
+{
+   uint32_t n = p->header->nodenum;
+   uint32_t r, i;
+   char *res;
+   int result;
+
+   if (root < 0  ||  (uint32_t)root >= p->header->rootnum)
+      return BDD_SIZE;
+
+   r = p->roots[root];
+   if (r >= n)
+      return (int)(r - n);
+
+      /* The result of each node is 0 or 1 when it is constant under the
+       * assignment and 2 when it still depends on a free variable. It is
+       * computed bottom up over all nodes below the root and follows only
+       * the selected child of an assigned variable. */
+   if ((res=(char*)malloc(n+2-r)) == NULL)
+      return BDD_MEMORY;
+   res[n-r] = 0;
+   res[n+1-r] = 1;
+
+   for (i=n ; i>r ; )
+   {
+      int value = assign[p->var[--i]];
+
+      if (value >= 0)
+	 res[i-r] = res[program_child(p,i,value ? 1 : 0)-r];
+      else
+      {
+	 char lo = res[program_child(p,i,0)-r];
+	 char hi = res[program_child(p,i,1)-r];
+	 res[i-r] = (lo == hi ? lo : 2);
+      }
+   }
+
+   result = res[0];
+   free(res);
+   return result;
+}
+
+
+/*************************************************************************
+  Import into the node table
+*************************************************************************/
+
+int bdd_program_import(bddProgram *p, int root, BDD *res)
+{
+   uint32_t n = p->header->nodenum;
+   uint32_t varnum = p->header->varnum;
+   uint32_t *stack;
+   uint32_t i;
+   int sp = 0, direct = 1, err = 0;
+
+   *res = 0;
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   if (root < 0  ||  (uint32_t)root >= p->header->rootnum)
+      return bdd_error(BDD_SIZE);
+
+   if (varnum > (uint32_t)bddvarnum)
+   {
+      if (varnum > MAXVAR)
+	 return bdd_error(BDD_FORMAT);
+      if ((err=bdd_setvarnum(varnum)) < 0)
+	 return err;
+   }
+
+   if (p->import == NULL)
+   {
+      if ((p->import=NEW(BDD,n+2)) == NULL)
+	 return bdd_error(BDD_MEMORY);
+      for (i=0 ; i<n ; i++)
+	 p->import[i] = -1;
+      p->import[n] = 0;
+      p->import[n+1] = 1;
+   }
+
+   i = p->roots[root];
+   if (p->import[i] >= 0)
+   {
+      *res = p->import[i];
+      return 0;
+   }
+
+      /* Each pushed node is a child of the one below it, so the stack never
+       * holds more nodes than there are levels in a checked program. An
+       * unchecked program that breaks this is rejected. */
+   if ((stack=NEW(uint32_t,varnum+1)) == NULL)
+      return bdd_error(BDD_MEMORY);
+
+      /* The nodes can be made directly if the variable order is still the
+       * one the program was compiled with */
+   for (i=0 ; i<varnum  &&  direct ; i++)
+      if ((uint32_t)bddvar2level[i] != p->level[i])
+	 direct = 0;
+   if (direct)
+      bdd_disable_reorder();
+
+   stack[sp++] = p->roots[root];
+   
+   while (sp > 0  &&  err == 0)
+   {
+      uint32_t lo, hi;
+      BDD l, h;
+      
+      i = stack[sp-1];
+      lo = program_child(p,i,0);
+      hi = program_child(p,i,1);
+      
+      if (lo > n+1  ||  hi > n+1  ||  p->var[i] >= varnum)
+      {
+	 err = bdd_error(BDD_FORMAT);
+	 break;
+      }
+      
+      if (p->import[lo] < 0  ||  p->import[hi] < 0)
+      {
+	 if (sp > (int)varnum)
+	    err = bdd_error(BDD_FORMAT);
+	 else
+	    stack[sp++] = (p->import[lo] < 0 ? lo : hi);
+	 continue;
+      }
+
+      l = p->import[lo];
+      h = p->import[hi];
+      if (direct)
+      {
+	 int level = bddvar2level[p->var[i]];
+	 
+	 if (LEVEL(l) <= level  ||  LEVEL(h) <= level)
+	 {
+	    err = bdd_error(BDD_FORMAT);
+	    break;
+	 }
+	 p->import[i] = bdd_addref( bdd_makenode(level, l, h) );
+      }
+      else
+	 p->import[i] = bdd_addref( bdd_ite(bdd_ithvar(p->var[i]), h, l) );
+
+      if (bdderrorcond)
+      {
+	 p->import[i] = -1;
+	 err = -bdderrorcond;
+      }
+      sp--;
+   }
+
+   if (direct)
+      bdd_enable_reorder();
+   free(stack);
+
+   if (err == 0)
+      *res = p->import[p->roots[root]];
+   return err;
+}
+
+
+void bdd_program_forget(bddProgram *p)
+{
+   uint32_t i;
+   
+   if (p->import == NULL)
+      return;
+
+   if (bddrunning)
+      for (i=0 ; i<p->header->nodenum ; i++)
+	 if (p->import[i] >= 0)
+	    bdd_delref(p->import[i]);
+   
+   free(p->import);
+   p->import = NULL;
+}
+
+
+/*************************************************************************
+  Saving and loading
+*************************************************************************/
+
+   /* Validates the fixed size header of an image */
+static int program_header(const bddProgramHeader *h)
+{
+   if (memcmp(h->magic, PROGRAM_MAGIC, 4) != 0  ||
+       h->endian != PROGRAM_ENDIAN  ||  h->version != PROGRAM_VERSION  ||
+       (h->width != 2  &&  h->width != 4)  ||  h->rootnum < 1)
+      return BDD_FORMAT;
+   return 0;
+}
+
+
+   /* Validates a complete image so that evaluation of it can never go out
+    * of bounds or loop */
+static int program_check(bddProgram *p)
+{
+   const bddProgramHeader *h = p->header;
+   uint32_t n;
+
+   for (n=0 ; n<h->rootnum ; n++)
+      if (p->roots[n] > h->nodenum+1)
+	 return BDD_FORMAT;
+
+   for (n=0 ; n<h->varnum ; n++)
+      if (p->level[n] >= h->varnum)
+	 return BDD_FORMAT;
+
+   for (n=0 ; n<h->nodenum ; n++)
+   {
+      uint32_t lo, hi;
+      
+      if (h->width == 2)
+      {
+	 lo = ((const uint16_t*)p->low)[n];
+	 hi = ((const uint16_t*)p->high)[n];
+      }
+      else
+      {
+	 lo = ((const uint32_t*)p->low)[n];
+	 hi = ((const uint32_t*)p->high)[n];
+      }
+
+      if (p->var[n] >= h->varnum  ||  lo == 0  ||  hi == 0  ||
+	  lo > h->nodenum+1-n  ||  hi > h->nodenum+1-n)
+	 return BDD_FORMAT;
+
+	 /* The counting queries rely on the levels growing downwards */
+      if (program_level(p,n) >= program_level(p,n+lo)  ||
+	  program_level(p,n) >= program_level(p,n+hi))
+	 return BDD_FORMAT;
+   }
+
+   return 0;
+}
+
+
+int bdd_program_fnsave(char *fname, const bddProgram *p)
+{
+   FILE *ofile;
+   int ok;
+
+   if ((ofile=fopen(fname,"wb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_program_save(ofile, p);
+   if (fclose(ofile) != 0  &&  ok == 0)
+      return bdd_error(BDD_FILE);
+   return ok;
+}
+
+
+int bdd_program_save(FILE *ofile, const bddProgram *p)
+{
+   if (fwrite(p->image, 1, p->size, ofile) != p->size)
+      return bdd_error(BDD_FILE);
+   return 0;
+}
+
+
+bddProgram *bdd_program_fnload(char *fname)
+{
+   FILE *ifile;
+   bddProgram *p;
+
+   if ((ifile=fopen(fname,"rb")) == NULL)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   p = bdd_program_load(ifile);
+   fclose(ifile);
+   return p;
+}
+
+
+bddProgram *bdd_program_load(FILE *ifile)
+{
+   bddProgramHeader h;
+   bddProgram *p;
+   char *image;
+   size_t size;
+   int err;
+
+   if (fread(&h, sizeof(h), 1, ifile) != 1)
+   {
+      bdd_error(BDD_FORMAT);
+      return NULL;
+   }
+
+   if ((err=program_header(&h)) < 0)
+   {
+      bdd_error(err);
+      return NULL;
+   }
+
+   size = program_imagesize(h.width, h.varnum, h.nodenum, h.rootnum);
+   if ((image=(char*)malloc(size)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   memcpy(image, &h, sizeof(h));
+   if (fread(image+sizeof(h), 1, size-sizeof(h), ifile) != size-sizeof(h))
+   {
+      free(image);
+      bdd_error(BDD_FORMAT);
+      return NULL;
+   }
+
+   if ((p=program_new(image, size)) == NULL)
+   {
+      free(image);
+      return NULL;
+   }
+
+   if ((err=program_check(p)) < 0)
+   {
+      bdd_program_free(p);
+      bdd_error(err);
+      return NULL;
+   }
+
+   return p;
+}
+
+
+#ifdef PROGRAM_MMAP
+   /* Maps the program in the file or shared memory object 'fd' and closes
+    * the descriptor */
+static bddProgram *program_mapfd(int fd, int check)
+{
+   const bddProgramHeader *h;
+   struct stat st;
+   bddProgram *p;
+   char *image;
+   size_t size;
+   int err;
+
+   if (fstat(fd, &st) != 0)
+   {
+      close(fd);
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   size = (size_t)st.st_size;
+   if (size < sizeof(bddProgramHeader))
+   {
+      close(fd);
+      bdd_error(BDD_FORMAT);
+      return NULL;
+   }
+
+      /* The mapping stays valid after the descriptor is closed. It is
+       * shared so all processes mapping the file use the same pages. */
+   image = (char*)mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+   if (image == (char*)MAP_FAILED)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   h = (const bddProgramHeader*)image;
+   if ((err=program_header(h)) < 0  ||
+       size != program_imagesize(h->width,h->varnum,h->nodenum,h->rootnum))
+   {
+      munmap(image, size);
+      bdd_error(err < 0 ? err : BDD_FORMAT);
+      return NULL;
+   }
+
+   if ((p=program_new(image, size)) == NULL)
+   {
+      munmap(image, size);
+      return NULL;
+   }
+   p->mapped = 1;
+
+   if (check  &&  (err=program_check(p)) < 0)
+   {
+      bdd_program_free(p);
+      bdd_error(err);
+      return NULL;
+   }
+
+   return p;
+}
+#endif
+
+
+bddProgram *bdd_program_map(char *fname, int check)
+{
+#ifdef PROGRAM_MMAP
+   int fd;
+
+   if ((fd=open(fname, O_RDONLY)) < 0)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   return program_mapfd(fd, check);
+#else
+      /* Without mmap the file is read and validated as usual */
+   (void)check;
+   return bdd_program_fnload(fname);
+#endif
+}
+
+
+/*************************************************************************
+  Shared memory
+*************************************************************************/
+
+int bdd_program_share(const bddProgram *p, char *name)
+{
+#ifdef PROGRAM_SHM
+   char *image;
+   int fd;
+
+      /* An existing object is never replaced, since shrinking it under
+       * processes that have it mapped would make them fault */
+   if ((fd=shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0644)) < 0)
+      return bdd_error(BDD_FILE);
+
+   if (ftruncate(fd, (off_t)p->size) != 0)
+      image = (char*)MAP_FAILED;
+   else
+      image = (char*)mmap(NULL, p->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+			  fd, 0);
+   close(fd);
+   
+   if (image == (char*)MAP_FAILED)
+   {
+      shm_unlink(name);
+      return bdd_error(BDD_FILE);
+   }
+
+   memcpy(image, p->image, p->size);
+   munmap(image, p->size);
+   return 0;
+#else
+   (void)p;
+   (void)name;
+   return bdd_error(BDD_FILE);
+#endif
+}
+
+
+bddProgram *bdd_program_attach(char *name, int check)
+{
+#ifdef PROGRAM_SHM
+   int fd;
+
+   if ((fd=shm_open(name, O_RDONLY, 0)) < 0)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   return program_mapfd(fd, check);
+#else
+   (void)name;
+   (void)check;
+   bdd_error(BDD_FILE);
+   return NULL;
+#endif
+}
+
+
+int bdd_program_unshare(char *name)
+{
+#ifdef PROGRAM_SHM
+   if (shm_unlink(name) != 0)
+      return bdd_error(BDD_FILE);
+   return 0;
+#else
+   (void)name;
+   return bdd_error(BDD_FILE);
+#endif
+}
+
+
+/* EOF */
@@ -36,9 +36,9 @@
 *************************************************************************/
 #include <string.h>
 #include <stdlib.h>
-#include <iomanip>
 #include "kernel.h"
 #include "bvec.h"
+#include "printer.h"
 
 using namespace std;
 
@@ -61,9 +61,7 @@ const bdd bddtruepp = bdd_true();
 const bdd bddfalsepp = bdd_false();
 
    /* Internal prototypes */
-static void bdd_printset_rec(ostream&, int, int*);
-static void bdd_printdot_rec(ostream&, int);
-static void fdd_printset_rec(ostream &, int, int *);
+static void printer_strminit(BddPrinter *, ostream &);
 
 
 static bddstrmhandler strmhandler_bdd;
@@ -141,6 +139,162 @@ int bdd_anodecountpp(const bdd *r, int num)
    return cou;
 }
 
+int bdd_eval_batch(const bdd *r, int num, const uint64_t *in, int words,
+		   uint64_t *out)
+{
+   BDD *cpr = NEW(BDD,num+1);
+   int res;
+   int n;
+
+   if (cpr == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+      // No need for ref.cou. since r[n] holds the reference
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   res = bdd_eval_batch(cpr, num, in, words, out);
+   
+   free(cpr);
+
+   return res;
+}
+
+bddProgram *bdd_acompile(const bdd *r, int num, int order)
+{
+   BDD *cpr = NEW(BDD,num+1);
+   bddProgram *res;
+   int n;
+
+   if (cpr == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   res = bdd_acompile(cpr, num, order);
+   
+   free(cpr);
+
+   return res;
+}
+
+int bdd_save_many(FILE *ofile, const bdd *r, int num)
+{
+   return bdd_save_named(ofile, r, NULL, num);
+}
+
+
+int bdd_save_named(FILE *ofile, const bdd *r, char **names, int num)
+{
+   BDD *cpr = NEW(BDD,num+1);
+   int res, n;
+
+   if (cpr == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+      // No need for ref.cou. since r[n] holds the reference
+   for (n=0 ; n<num ; n++)
+      cpr[n] = r[n].root;
+
+   res = bdd_save_named(ofile, cpr, names, num);
+   
+   free(cpr);
+
+   return res;
+}
+
+
+int bdd_fnsave_named(char *fname, const bdd *r, char **names, int num)
+{
+   FILE *ofile;
+   int ok;
+
+   if ((ofile=fopen(fname,"wb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_save_named(ofile, r, names, num);
+   if (fclose(ofile) != 0  &&  ok == 0)
+      return bdd_error(BDD_FILE);
+   return ok;
+}
+
+
+   // The array of roots is allocated with new[] and must be deleted with
+   // delete[]
+int bdd_load_many(FILE *ifile, bdd **r, int *num)
+{
+   char **names;
+   int res, n;
+
+   if ((res=bdd_load_named(ifile, r, &names, num)) < 0)
+      return res;
+
+   for (n=0 ; n<*num ; n++)
+      free(names[n]);
+   free(names);
+   return 0;
+}
+
+
+int bdd_load_named(FILE *ifile, bdd **r, char ***names, int *num)
+{
+   BDD *cpr;
+   int res, n;
+
+   *r = NULL;
+   if ((res=bdd_load_named(ifile, &cpr, names, num)) < 0)
+      return res;
+
+   *r = new bdd[*num];
+   for (n=0 ; n<*num ; n++)
+      (*r)[n] = bdd(cpr[n]);
+   
+   free(cpr);
+   return 0;
+}
+
+
+int bdd_fnload_named(char *fname, bdd **r, char ***names, int *num)
+{
+   FILE *ifile;
+   int ok;
+
+   *r = NULL;
+   *names = NULL;
+   *num = 0;
+   
+   if ((ifile=fopen(fname,"rb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_load_named(ifile, r, names, num);
+   fclose(ifile);
+   return ok;
+}
+
+
+int bdd_circuit_build(bddCircuit *c, int firstvar, int flags, bdd *out,
+		      bddCircuitStat *stat)
+{
+   BDD *cpr = NEW(BDD,bdd_circuit_outputnum(c)+1);
+   int res, n;
+
+   if (cpr == NULL)
+      return bdd_error(BDD_MEMORY);
+
+   res = bdd_circuit_build(c, firstvar, flags, cpr, stat);
+   if (res == 0)
+      for (n=0 ; n<bdd_circuit_outputnum(c) ; n++)
+	 out[n] = bdd(cpr[n]);
+   
+   free(cpr);
+   return res;
+}
+
+
 /*************************************************************************
   BDD class functions
 *************************************************************************/
@@ -169,6 +323,52 @@ bdd bdd::operator=(int r)
 }
 
 
+/*************************************************************************
+  Cube iteration
+*************************************************************************/
+
+bdd_cubes::bdd_cubes(const bdd &r, int batch) : root(r)
+{
+   batchsize = batch;
+   iter = NULL;
+   cubes = NULL;
+   cubenum = pos = 0;
+}
+
+
+bdd_cubes::~bdd_cubes(void)
+{
+   bdd_cube_iter_free(iter);
+}
+
+
+bdd_cubes::iterator bdd_cubes::begin(void)
+{
+      // Restart the enumeration each time a new loop is started
+   bdd_cube_iter_free(iter);
+   iter = bdd_cube_iter_new(root.root, batchsize);
+   cubenum = pos = 0;
+
+   return iterator(this, fetch());
+}
+
+
+const char *bdd_cubes::fetch(void)
+{
+   if (pos >= cubenum)
+   {
+      if ((cubenum=bdd_cube_iter_next(iter, &cubes)) <= 0)
+      {
+	 cubenum = pos = 0;
+	 return NULL;
+      }
+      pos = 0;
+   }
+
+   return cubes + bdd_varnum()*pos++;
+}
+
+
 /*************************************************************************
   C++ iostream operators
 *************************************************************************/
@@ -207,89 +407,54 @@ bddstrmhandler bdd_strm_hook(bddstrmhandler handler)
 }
 
 
+static void printer_strmsink(void *data, const char *buf, int len)
+{
+   ((ostream*)data)->write(buf, len);
+}
+
+
+static void printer_strmname(BddPrinter *p, int var)
+{
+   strmhandler_bdd(*(ostream*)p->data, var);
+}
+
+
+static void printer_strmfddname(BddPrinter *p, int var)
+{
+   strmhandler_fdd(*(ostream*)p->data, var);
+}
+
+
+   // Sets up a printer for 'o' that names variables and finite domains
+   // with the stream handlers
+static void printer_strminit(BddPrinter *p, ostream &o)
+{
+   BddPrinter_init(p, printer_strmsink, &o);
+   p->style = PRINTER_CPPSTYLE;
+   if (strmhandler_bdd)
+      p->varname = printer_strmname;
+   if (strmhandler_fdd)
+      p->fddname = printer_strmfddname;
+}
+
+
 ostream &operator<<(ostream &o, const bdd &r)
 {
+   BddPrinter p;
+
+   printer_strminit(&p, o);
+   
    if (bdd_ioformat::curformat == IOFORMAT_SET)
-   {
-      if (r.root < 2)
-      {
-	 o << (r.root == 0 ? "F" : "T");
-	 return o;
-      }
-      
-      int *set = new int[bddvarnum];
-      if (set == NULL)
-      {
-	 bdd_error(BDD_MEMORY);
-	 return o;
-      }
-      
-      memset(set, 0, sizeof(int) * bddvarnum);
-      bdd_printset_rec(o, r.root, set);
-      delete[] set;
-   }
+      BddPrinter_set(&p, r.root);
    else
    if (bdd_ioformat::curformat == IOFORMAT_TABLE)
-   {
-      o << "ROOT: " << r.root << "\n";
-      if (r.root < 2)
-	 return o;
-      
-      bdd_mark(r.root);
-
-      for (int n=0 ; n<bddnodesize ; n++)
-      {
-	 if (LEVEL(n) & MARKON)
-	 {
-	    BddNode *node = &bddnodes[n];
-	 
-	    LEVELp(node) &= MARKOFF;
-
-	    o << "[" << setw(5) << n << "] ";
-	    if (strmhandler_bdd)
-	       strmhandler_bdd(o,bddlevel2var[LEVELp(node)]);
-	    else
-	       o << setw(3) << bddlevel2var[LEVELp(node)];
-	    o << " :";
-	    o << " " << setw(3) << LOWp(node);
-	    o << " " << setw(3) << HIGHp(node);
-	    o << "\n";
-	 }
-      }
-   }
+      BddPrinter_table(&p, r.root);
    else
    if (bdd_ioformat::curformat == IOFORMAT_DOT)
-   {
-      o << "digraph G {\n";
-      o << "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n";
-      o << "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n";
-      
-      bdd_printdot_rec(o, r.root);
-      
-      o << "}\n";
-
-      bdd_unmark(r.root);
-   }
+      BddPrinter_dot(&p, r.root);
    else
    if (bdd_ioformat::curformat == IOFORMAT_FDDSET)
-   {
-      if (ISCONST(r.root))
-      {
-	 o << (r == 0 ? "F" : "T");
-	 return o;
-      }
-      
-      int *set = new int[bddvarnum];
-      if (set == NULL)
-      {
-	 bdd_error(BDD_MEMORY);
-	 return o;
-      }
-      
-      memset(set, 0, sizeof(int) * bddvarnum);
-      fdd_printset_rec(o, r.root, set);
-      delete[] set;
-   }
+      BddPrinter_fddset(&p, r.root);
    
    return o;
 }
@@ -330,168 +495,13 @@ ostream &operator<<(ostream &o, const bdd_ioformat &f)
    else
    if (f.format == IOFORMAT_ALL)
    {
-      for (int n=0 ; n<bddnodesize ; n++)
-      {
-	 const BddNode *node = &bddnodes[n];
-	 
-	 if (LOWp(node) != -1)
-	 {
-	    o << "[" << setw(5) << n << "] ";
-	    if (strmhandler_bdd)
-	       strmhandler_bdd(o,bddlevel2var[LEVELp(node)]);
-	    else
-	       o << setw(3) << bddlevel2var[LEVELp(node)] << " :";
-	    o << " " << setw(3) << LOWp(node);
-	    o << " " << setw(3) << HIGHp(node);
-	    o << "\n";
-	 }
-      }
-   }
-   
-   return o;
-}
-
-
-static void bdd_printset_rec(ostream& o, int r, int* set)
-{
-   int n;
-   int first;
-   
-   if (r == 0)
-      return;
-   else
-   if (r == 1)
-   {
-      o << "<";
-      first = 1;
-      
-      for (n=0 ; n<bddvarnum ; n++)
-      {
-	 if (set[n] > 0)
-	 {
-	    if (!first)
-	       o << ", ";
-	    first = 0;
-	    if (strmhandler_bdd)
-	       strmhandler_bdd(o,bddlevel2var[n]);
-	    else
-	       o << bddlevel2var[n];
-	    o << ":" << (set[n]==2 ? 1 : 0);
-	 }
-      }
+      BddPrinter p;
 
-      o << ">";
-   }
-   else
-   {
-      set[LEVEL(r)] = 1;
-      bdd_printset_rec(o, LOW(r), set);
-      
-      set[LEVEL(r)] = 2;
-      bdd_printset_rec(o, HIGH(r), set);
-      
-      set[LEVEL(r)] = 0;
+      printer_strminit(&p, o);
+      BddPrinter_all(&p);
    }
-}
-
-
-static void bdd_printdot_rec(ostream& o, int r)
-{
-   if (ISCONST(r) || MARKED(r))
-      return;
-
-   o << r << "[label=\"";
-   if (strmhandler_bdd)
-      strmhandler_bdd(o,bddlevel2var[LEVEL(r)]);
-   else
-      o << bddlevel2var[LEVEL(r)];
-   o << "\"];\n";
-   o << r << " -> " << LOW(r) << "[style=dotted];\n";
-   o << r << " -> " << HIGH(r) << "[style=filled];\n";
-
-   SETMARK(r);
-   
-   bdd_printdot_rec(o, LOW(r));
-   bdd_printdot_rec(o, HIGH(r));
-}
-
-
-static void fdd_printset_rec(ostream &o, int r, int *set)
-{
-   int n,m,i;
-   int used = 0;
-   int *binval;
-   int ok, first;
    
-   if (r == 0)
-      return;
-   else
-   if (r == 1)
-   {
-      o << "<";
-      first=1;
-      int fdvarnum = fdd_domainnum();
-	 
-      for (n=0 ; n<fdvarnum ; n++)
-      {
-	 int firstval=1;
-	 used = 0;
-	 int binsize = fdd_varnum(n);
-	 int *vars = fdd_vars(n);
-	 
-	 for (m=0 ; m<binsize ; m++)
-	    if (set[vars[m]] != 0)
-	       used = 1;
-	 
-	 if (used)
-	 {
-	    if (!first)
-	       o << ", ";
-	    first = 0;
-	    if (strmhandler_fdd)
-	       strmhandler_fdd(o, n);
-	    else
-	       o << n;
-	    o << ":";
-
-	    for (m=0 ; m<(1<<binsize) ; m++)
-	    {
-	       binval = fdddec2bin(n, m);
-	       ok=1;
-	       
-	       for (i=0 ; i<binsize && ok ; i++)
-		  if (set[vars[i]] == 1  &&  binval[i] != 0)
-		     ok = 0;
-		  else
-		  if (set[vars[i]] == 2  &&  binval[i] != 1)
-		     ok = 0;
-
-	       if (ok)
-	       {
-		  if (firstval)
-		     o << m;
-		  else
-		     o << "/" << m;
-		  firstval = 0;
-	       }
-
-	       free(binval);
-	    }
-	 }
-      }
-
-      o << ">";
-   }
-   else
-   {
-      set[bddlevel2var[LEVEL(r)]] = 1;
-      fdd_printset_rec(o, LOW(r), set);
-      
-      set[bddlevel2var[LEVEL(r)]] = 2;
-      fdd_printset_rec(o, HIGH(r), set);
-      
-      set[bddlevel2var[LEVEL(r)]] = 0;
-   }
+   return o;
 }
 
 
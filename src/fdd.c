@@ -41,10 +41,9 @@
 #include <string.h>
 #include "kernel.h"
 #include "fdd.h"
+#include "printer.h"
 
 
-static void fdd_printset_rec(FILE *, int, int *);
-
 /*======================================================================*/
 /* NOTE: ALL FDD operations works with LSB in top of the variable order */
 /*       and in index zero of the domain tables                         */
@@ -202,6 +201,42 @@ int fdd_overlapdomain(int v1, int v2)
 }
 
 
+/* Adds a domain from a checkpoint. The reference to 'var' is already
+   counted in the restored node table.
+*/
+int bdd_fdd_restore(int realsize, int binsize, int *ivar, BDD var)
+{
+   Domain *d;
+   int n;
+   
+   if (fdvarnum + 1 > fdvaralloc)
+   {
+      int newalloc = (fdvaralloc > 0 ? fdvaralloc*2 : 1);
+      Domain *tmp_ptr = (Domain*)realloc(domain, sizeof(Domain)*newalloc);
+      if (tmp_ptr == NULL)
+	 return bdd_error(BDD_MEMORY);
+      domain = tmp_ptr;
+      fdvaralloc = newalloc;
+   }
+
+   d = &domain[fdvarnum];
+   if ((d->ivar=(int *)malloc(sizeof(int)*binsize)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   
+   d->realsize = realsize;
+   d->binsize = binsize;
+   d->var = var;
+   for (n=0 ; n<binsize ; n++)
+   {
+      d->ivar[n] = ivar[n];
+      if (ivar[n] >= firstbddvar)
+	 firstbddvar = ivar[n]+1;
+   }
+
+   return fdvarnum++;
+}
+
+
 void fdd_clearall(void)
 {
    bdd_fdd_done();
@@ -498,112 +533,26 @@ void fdd_printset(BDD r)
 }
 
 
+static void printer_filename(BddPrinter *p, int var)
+{
+   filehandler((FILE*)p->data, var);
+}
+
+
 void fdd_fprintset(FILE *ofile, BDD r)
 {
-   int *set;
+   BddPrinter p;
    
    if (!bddrunning)
    {
       bdd_error(BDD_RUNNING);
       return;
    }
-   
-   if (r < 2)
-   {
-      fprintf(ofile, "%s", r == 0 ? "F" : "T");
-      return;
-   }
-
-   set = (int *)malloc(sizeof(int)*bddvarnum);
-   if (set == NULL)
-   {
-      bdd_error(BDD_MEMORY);
-      return;
-   }
-   
-   memset(set, 0, sizeof(int) * bddvarnum);
-   fdd_printset_rec(ofile, r, set);
-   free(set);
-}
-
-
-static void fdd_printset_rec(FILE *ofile, int r, int *set)
-{
-   int n,m,i;
-   int used = 0;
-   int *var;
-   int *binval;
-   int ok, first;
-   
-   if (r == 0)
-      return;
-   else
-   if (r == 1)
-   {
-      fprintf(ofile, "<");
-      first=1;
-
-      for (n=0 ; n<fdvarnum ; n++)
-      {
-	 int firstval=1;
-	 used = 0;
-
-	 for (m=0 ; m<domain[n].binsize ; m++)
-	    if (set[domain[n].ivar[m]] != 0)
-	       used = 1;
-	 
-	 if (used)
-	 {
-	    if (!first)
-	       fprintf(ofile, ", ");
-	    first = 0;
-	    if (filehandler)
-	       filehandler(ofile, n);
-	    else
-	       fprintf(ofile, "%d", n);
-	       
-	    fprintf(ofile,":");
-
-	    var = domain[n].ivar;
-	    
-	    for (m=0 ; m<(1<<domain[n].binsize) ; m++)
-	    {
-	       binval = fdddec2bin(n, m);
-	       ok=1;
-	       
-	       for (i=0 ; i<domain[n].binsize && ok ; i++)
-		  if (set[var[i]] == 1  &&  binval[i] != 0)
-		     ok = 0;
-		  else
-		  if (set[var[i]] == 2  &&  binval[i] != 1)
-		     ok = 0;
-
-	       if (ok)
-	       {
-		  if (firstval)
-		     fprintf(ofile, "%d", m);
-		  else
-		     fprintf(ofile, "/%d", m);
-		  firstval = 0;
-	       }
-
-	       free(binval);
-	    }
-	 }
-      }
 
-      fprintf(ofile, ">");
-   }
-   else
-   {
-      set[bddlevel2var[LEVEL(r)]] = 1;
-      fdd_printset_rec(ofile, LOW(r), set);
-      
-      set[bddlevel2var[LEVEL(r)]] = 2;
-      fdd_printset_rec(ofile, HIGH(r), set);
-      
-      set[bddlevel2var[LEVEL(r)]] = 0;
-   }
+   BddPrinter_init(&p, BddPrinter_filesink, ofile);
+   if (filehandler)
+      p.fddname = printer_filename;
+   BddPrinter_fddset(&p, r);
 }
 
 
@@ -84,6 +84,10 @@ int*         bddvar2level;      /* Variable -> level table */
 int*         bddlevel2var;      /* Level -> variable table */
 jmp_buf      bddexception;      /* Long-jump point for interrupting calc. */
 int          bddresized;        /* Flag indicating a resize of the nodetable */
+int          bddreordered;      /* Number of variable reorderings done */
+int          bddresumable;      /* Current operation can be reordered */
+int          bddreorderpending; /* Reorder at the next safe point */
+int          bddrestartable;    /* Resumable operation may start over */
 
 bddCacheStat bddcachestats;
 
@@ -94,7 +98,6 @@ static BDD*     bddvarset;             /* Set of defined BDD variables */
 static int      gbcollectnum;          /* Number of garbage collections */
 static int      cachesize;             /* Size of the operator caches */
 static long int gbcclock;              /* Clock ticks used in GBC */
-static int      usednodes_nextreorder; /* When to do reorder next time */
 static bddinthandler  err_handler;     /* Error handler */
 static bddgbchandler  gbc_handler;     /* Garbage collection handler */
 static bdd2inthandler resize_handler;  /* Node-table-resize handler */
@@ -145,6 +148,10 @@ int bdd_init(int initnodesize, int cs)
       return bdd_error(BDD_MEMORY);
 
    bddresized = 0;
+   bddreordered = 0;
+   bddresumable = 0;
+   bddreorderpending = 0;
+   bddrestartable = 0;
    
    for (n=0 ; n<bddnodesize ; n++)
    {
@@ -173,7 +180,7 @@ int bdd_init(int initnodesize, int cs)
    gbcollectnum = 0;
    gbcclock = 0;
    cachesize = cs;
-   usednodes_nextreorder = bddnodesize;
+   bdd_trigger_init(bddnodesize);
    bddmaxnodeincrease = DEFAULTMAXNODEINC;
 
    bdderrorcond = 0;
@@ -287,7 +294,7 @@ int bdd_setvarnum(int num)
 
    if (bddrefstack != NULL)
       free(bddrefstack);
-   bddrefstack = bddrefstacktop = (int*)malloc(sizeof(int)*(num*2+4));
+   bddrefstack = bddrefstacktop = (int*)malloc(sizeof(int)*(num*8+4));
 
    for(bdv=bddvarnum ; bddvarnum < num; bddvarnum++)
    {
@@ -314,6 +321,7 @@ int bdd_setvarnum(int num)
    
    bdd_pairs_resize(oldbddvarnum, bddvarnum);
    bdd_operator_varresize();
+   bdd_reorder_varresize();
    
    bdd_enable_reorder();
    
@@ -686,7 +694,7 @@ void bdd_gbc(void)
       }
    }
 
-   bdd_operator_reset();
+   bdd_operator_clean();
 
    c2 = clock();
    gbcclock += c2-c1;
@@ -833,6 +841,89 @@ void bdd_unmark_upto(int i, int level)
 }
 
 
+/* Collects the nodes in the cone of the 'num' roots in 'r' in post order,
+   children before parents, using an explicit stack instead of recursion.
+   Terminals are not included. The result is a malloc'ed array and the
+   number of nodes in it is stored in 'cnt'. All nodes are left unmarked. */
+int *bdd_postorder(BDD *r, int num, int *cnt)
+{
+   int *res, *stack;
+   char *state;
+   int size = 1024, n = 0, sp, i;
+
+   res = NEW(int,size);
+   stack = NEW(int,bddvarnum+1);
+   state = (char*)malloc(bddvarnum+1);
+
+   if (res == NULL  ||  stack == NULL  ||  state == NULL)
+   {
+      free(res);
+      free(stack);
+      free(state);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   for (i=0 ; i<num ; i++)
+   {
+      if (r[i] < 2  ||  MARKED(r[i]))
+	 continue;
+
+      SETMARK(r[i]);
+      stack[0] = r[i];
+      state[0] = 0;
+      sp = 1;
+
+      while (sp > 0)
+      {
+	 int t = stack[sp-1];
+	 int c;
+
+	 if (state[sp-1] < 2)
+	 {
+	    c = (state[sp-1]++ == 0 ? LOW(t) : HIGH(t));
+	    if (c >= 2  &&  !MARKED(c))
+	    {
+	       SETMARK(c);
+	       stack[sp] = c;
+	       state[sp] = 0;
+	       sp++;
+	    }
+	    continue;
+	 }
+
+	 if (n == size)
+	 {
+	    int *tmp = (int*)realloc(res, sizeof(int)*size*2);
+	    if (tmp == NULL)
+	    {
+	       for (i=0 ; i<num ; i++)
+		  bdd_unmark(r[i]);
+	       free(res);
+	       free(stack);
+	       free(state);
+	       bdd_error(BDD_MEMORY);
+	       return NULL;
+	    }
+	    res = tmp;
+	    size *= 2;
+	 }
+
+	 res[n++] = t;
+	 sp--;
+      }
+   }
+
+   for (i=0 ; i<n ; i++)
+      UNMARK(res[i]);
+
+   free(stack);
+   free(state);
+   *cnt = n;
+   return res;
+}
+
+
 /*************************************************************************
   Unique node table functions
 *************************************************************************/
@@ -885,13 +976,24 @@ int bdd_makenode(unsigned int level, int low, int high)
          /* Try to allocate more nodes */
       bdd_gbc();
 
-      if ((bddnodesize-bddfreenum) >= usednodes_nextreorder  &&
-	   bdd_reorder_ready())
+      if (bdd_reorder_ready()  &&
+	  bdd_trigger_check(bddnodesize-bddfreenum))
       {
-	 longjmp(bddexception,1);
+	    /* Operations that can be resumed are reordered at their next
+	       safe point, the others are started over. A resumable one is
+	       also started over, once, if no node was freed */
+	 if (!bddresumable  ||  (bddfreepos == 0  &&  bddrestartable))
+	 {
+	    bddrestartable = 0;
+	    longjmp(bddexception,1);
+	 }
+	 bddreorderpending = 1;
       }
 
-      if ((bddfreenum*100) / bddnodesize <= minfreenodes)
+         /* A pending reordering will free nodes, so only grow the table
+	    now if there is nothing left */
+      if ((bddfreenum*100) / bddnodesize <= minfreenodes  &&
+	  (!bddreorderpending  ||  bddfreepos == 0))
       {
 	 bdd_noderesize(1);
 	 hash = NODEHASH(level, low, high);
@@ -977,18 +1079,66 @@ int bdd_noderesize(int doRehash)
 }
 
 
-void bdd_checkreorder(void)
+/* Replaces all nodes except the constants with 'size' free nodes. Used
+   when restoring a checkpoint, which then fills in the nodes and calls
+   bdd_nodetable_rehash(). The variables are kept.
+*/
+int bdd_nodetable_clear(int size)
 {
-   bdd_reorder_auto();
+   BddNode *newnodes;
+   int oldsize = bddnodesize;
+   int n;
 
-      /* Do not reorder before twice as many nodes have been used */
-   usednodes_nextreorder = 2 * (bddnodesize - bddfreenum);
+   newnodes = (BddNode*)realloc(bddnodes, sizeof(BddNode)*size);
+   if (newnodes == NULL)
+      return bdd_error(BDD_MEMORY);
+   bddnodes = newnodes;
+   bddnodesize = size;
    
-      /* And if very little was gained this time (< 20%) then wait until
-       * even more nodes (upto twice as many again) have been used */
-   if (bdd_reorder_gain() < 20)
-      usednodes_nextreorder +=
-	 (usednodes_nextreorder * (20-bdd_reorder_gain())) / 20;
+   if (resize_handler != NULL  &&  size != oldsize)
+      resize_handler(oldsize, size);
+
+   for (n=0 ; n<bddnodesize ; n++)
+   {
+      bddnodes[n].hash = 0;
+      if (n < 2)
+	 continue;
+      bddnodes[n].refcou = 0;
+      LEVEL(n) = 0;
+      LOW(n) = -1;
+      HIGH(n) = 0;
+      bddnodes[n].next = 0;
+   }
+
+   bddfreepos = 0;
+   bddfreenum = 0;
+   bddresized = 1;
+   
+   return 0;
+}
+
+
+/* Rebuilds the unique table and free list in one pass over the nodes
+   set up after bdd_nodetable_clear(). 'varset' holds the nodes of the
+   variables and their negations as in 'bddvarset'.
+*/
+void bdd_nodetable_rehash(BDD *varset)
+{
+   bdd_gbc_rehash();
+   memcpy(bddvarset, varset, sizeof(BDD)*bddvarnum*2);
+   bdd_operator_reset();
+}
+
+
+void bdd_checkreorder(void)
+{
+   if (!bdd_reorder_ready())
+      return;
+   
+      /* The trigger policy decides when to do the next one, see trigger.c */
+   bdd_trigger_start();
+   bdd_reorder_auto();
+   bdd_trigger_done(bddnodesize - bddfreenum);
 }
 
 
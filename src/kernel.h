@@ -107,6 +107,10 @@ extern int*      bddlevel2var;
 extern jmp_buf   bddexception;
 extern int       bddreorderdisabled;
 extern int       bddresized;
+extern int       bddreordered;
+extern int       bddresumable;
+extern int       bddreorderpending;
+extern int       bddrestartable;
 extern bddCacheStat bddcachestats;
 
 #ifdef CPLUSPLUS
@@ -191,27 +195,41 @@ extern "C" {
 extern int    bdd_error(int);
 extern int    bdd_makenode(unsigned int, int, int);
 extern int    bdd_noderesize(int);
+extern int    bdd_nodetable_clear(int);
+extern void   bdd_nodetable_rehash(BDD*);
 extern void   bdd_checkreorder(void);
 extern void   bdd_mark(int);
 extern void   bdd_mark_upto(int, int);
 extern void   bdd_markcount(int, int*);
 extern void   bdd_unmark(int);
 extern void   bdd_unmark_upto(int, int);
+extern int   *bdd_postorder(BDD*, int, int*);
 extern void   bdd_register_pair(bddPair*);
 extern int   *fdddec2bin(int, int);
+extern int    bdd_sameorder(int*, int);
 
 extern int    bdd_operator_init(int);
 extern void   bdd_operator_done(void);
 extern void   bdd_operator_varresize(void);
 extern void   bdd_operator_reset(void);
+extern void   bdd_operator_clean(void);
+extern void   bdd_operator_reorder(char*, int);
+
+extern void   bdd_trigger_init(int);
+extern int    bdd_trigger_check(int);
+extern void   bdd_trigger_start(void);
+extern void   bdd_trigger_done(int);
 
 extern void   bdd_pairs_init(void);
 extern void   bdd_pairs_done(void);
 extern int    bdd_pairs_resize(int,int);
 extern void   bdd_pairs_vardown(int);
+extern bddPair *bdd_pairs_list(void);
+extern bddPair *bdd_pairs_restore(BDD*, int);
 
 extern void   bdd_fdd_init(void);
 extern void   bdd_fdd_done(void);
+extern int    bdd_fdd_restore(int, int, int*, BDD);
 
 extern void   bdd_reorder_init(void);
 extern void   bdd_reorder_done(void);
@@ -219,6 +237,9 @@ extern int    bdd_reorder_ready(void);
 extern void   bdd_reorder_auto(void);
 extern int    bdd_reorder_vardown(int);
 extern int    bdd_reorder_varup(int);
+extern void   bdd_reorder_varresize(void);
+extern int   *bdd_reorder_getblocks(int*, int*);
+extern int    bdd_reorder_setblocks(int*, int, int);
 
 extern void   bdd_cpp_init(void);
 
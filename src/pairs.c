@@ -96,6 +96,41 @@ void bdd_register_pair(bddPair *p)
 }
 
 
+   /* Returns the list of all pairs, newest first */
+bddPair *bdd_pairs_list(void)
+{
+   return pairs;
+}
+
+
+   /* Makes a pair from a checkpoint with the results 'result' (by level).
+    * The references to the results are already counted in the restored
+    * node table. Returns NULL without an error when out of memory. */
+bddPair *bdd_pairs_restore(BDD *result, int last)
+{
+   bddPair *p;
+   int n;
+   
+   if ((p=(bddPair*)malloc(sizeof(bddPair))) == NULL)
+      return NULL;
+
+   if ((p->result=(BDD*)malloc(sizeof(BDD)*bddvarnum)) == NULL)
+   {
+      free(p);
+      return NULL;
+   }
+
+   for (n=0 ; n<bddvarnum ; n++)
+      p->result[n] = result[n];
+
+   p->id = update_pairsid();
+   p->last = last;
+   
+   bdd_register_pair(p);
+   return p;
+}
+
+
 void bdd_pairs_vardown(int level)
 {
    bddPair *p;
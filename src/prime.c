@@ -194,6 +194,21 @@ static int isMillerRabinPrime(unsigned int src)
 }
 
 
+/* The witnesses 2, 7 and 61 decide all numbers below 4759123141, so this
+   check needs no random numbers and can run in several threads at once */
+static int isFixedMillerRabinPrime(unsigned int src)
+{
+  static const unsigned int witness[] = { 2, 7, 61 };
+  int n;
+
+  for (n=0 ; n<3 ; ++n)
+    if (witness[n] % src != 0  &&  isWitness(witness[n] % src,src))
+      return 0;
+
+  return 1;
+}
+
+
 /*************************************************************************
   Basic prime searching stuff
 *************************************************************************/
@@ -245,6 +260,18 @@ unsigned int bdd_prime_lte(unsigned int src)
 }
 
 
+unsigned int bdd_prime_lte_fixed(unsigned int src)
+{
+  if (isEven(src))
+     --src;
+
+  while (hasEasyFactors(src)  ||  !isFixedMillerRabinPrime(src))
+     src -= 2;
+
+  return src;
+}
+
+
 
 /*************************************************************************
    Testing
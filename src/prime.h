@@ -40,6 +40,7 @@
 
 unsigned int bdd_prime_gte(unsigned int src);
 unsigned int bdd_prime_lte(unsigned int src);
+unsigned int bdd_prime_lte_fixed(unsigned int src);
 
 
 #endif /* _PRIME_H */
@@ -0,0 +1,525 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  printer.c
+  DESCR: Buffered text output shared by the C and C++ printing functions
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "printer.h"
+#include "fdd.h"
+
+/* The printers write their text to a fixed buffer that is handed to the
+   sink whenever it is full, so a FILE or an ostream sees a few large
+   writes instead of one small formatted write for each node or cube.
+   Numbers are formatted by hand instead of through printf.
+
+   The traversals keep their own stacks instead of recursing, so the depth
+   of a BDD is only bounded by the memory for an array of its levels. */
+
+static void printer_var(BddPrinter *, int, int);
+static int  printer_mark(BDD);
+static void printer_unmark(BDD);
+static void printer_cube(BddPrinter *, int *, int *, int);
+static void printer_fddcube(BddPrinter *, int *);
+
+
+/*=== BUFFER ===========================================================*/
+
+void BddPrinter_init(BddPrinter *p, BddPrintSink sink, void *data)
+{
+   p->sink = sink;
+   p->data = data;
+   p->varname = NULL;
+   p->fddname = NULL;
+   p->style = PRINTER_CSTYLE;
+   p->pos = 0;
+}
+
+
+void BddPrinter_flush(BddPrinter *p)
+{
+   if (p->pos > 0)
+      p->sink(p->data, p->buf, p->pos);
+   p->pos = 0;
+}
+
+
+void BddPrinter_write(BddPrinter *p, const char *s, int len)
+{
+   if (p->pos + len > PRINTER_BUFSIZE)
+   {
+      BddPrinter_flush(p);
+      
+	 /* Text larger than the buffer goes directly to the sink */
+      if (len >= PRINTER_BUFSIZE)
+      {
+	 p->sink(p->data, s, len);
+	 return;
+      }
+   }
+
+   memcpy(p->buf + p->pos, s, len);
+   p->pos += len;
+}
+
+
+void BddPrinter_str(BddPrinter *p, const char *s)
+{
+   BddPrinter_write(p, s, strlen(s));
+}
+
+
+   /* Appends 'val' right aligned in 'width' characters as "%*d" would */
+void BddPrinter_int(BddPrinter *p, int val, int width)
+{
+   char digits[12];
+   unsigned int u = (val < 0 ? 0u-(unsigned int)val : (unsigned int)val);
+   int len = 0;
+   char *out;
+
+   do
+   {
+      digits[len++] = '0' + u%10;
+      u /= 10;
+   }
+   while (u > 0);
+   if (val < 0)
+      digits[len++] = '-';
+
+   if (width > PRINTER_BUFSIZE/2)
+      width = PRINTER_BUFSIZE/2;
+   if (p->pos + len + width > PRINTER_BUFSIZE)
+      BddPrinter_flush(p);
+   
+   out = p->buf + p->pos;
+   for ( ; width > len ; width--)
+      *out++ = ' ';
+   while (len > 0)
+      *out++ = digits[--len];
+   p->pos = out - p->buf;
+}
+
+
+void BddPrinter_filesink(void *data, const char *buf, int len)
+{
+   fwrite(buf, 1, len, (FILE*)data);
+}
+
+
+   /* Prints the name of 'var' with the name function if there is one and
+    * otherwise its number in 'width' characters */
+static void printer_var(BddPrinter *p, int var, int width)
+{
+   if (p->varname)
+   {
+      BddPrinter_flush(p);
+      p->varname(p, var);
+   }
+   else
+      BddPrinter_int(p, var, width);
+}
+
+
+/*=== NODE TABLES ======================================================*/
+
+void BddPrinter_all(BddPrinter *p)
+{
+   int n;
+   
+   for (n=0 ; n<bddnodesize ; n++)
+   {
+      if (LOW(n) != -1)
+      {
+	 BddPrinter_char(p, '[');
+	 BddPrinter_int(p, n, 5);
+	 if (p->style == PRINTER_CSTYLE)
+	 {
+	    BddPrinter_str(p, " - ");
+	    BddPrinter_int(p, bddnodes[n].refcou, 2);
+	    BddPrinter_str(p, "] ");
+	    printer_var(p, bddlevel2var[LEVEL(n)], 3);
+	    BddPrinter_char(p, ':');
+	 }
+	 else
+	 {
+	    BddPrinter_str(p, "] ");
+	    printer_var(p, bddlevel2var[LEVEL(n)], 3);
+	    if (!p->varname)
+	       BddPrinter_str(p, " :");
+	 }
+	 
+	 BddPrinter_char(p, ' ');
+	 BddPrinter_int(p, LOW(n), 3);
+	 BddPrinter_char(p, ' ');
+	 BddPrinter_int(p, HIGH(n), 3);
+	 BddPrinter_char(p, '\n');
+      }
+   }
+
+   BddPrinter_flush(p);
+}
+
+
+void BddPrinter_table(BddPrinter *p, BDD r)
+{
+   int n;
+   
+   BddPrinter_str(p, "ROOT: ");
+   BddPrinter_int(p, r, 0);
+   BddPrinter_char(p, '\n');
+   
+   if (r >= 2  &&  printer_mark(r) == 0)
+   {
+      for (n=0 ; n<bddnodesize ; n++)
+      {
+	 if (LEVEL(n) & MARKON)
+	 {
+	    UNMARK(n);
+	    
+	    BddPrinter_char(p, '[');
+	    BddPrinter_int(p, n, 5);
+	    BddPrinter_str(p, "] ");
+	    printer_var(p, bddlevel2var[LEVEL(n)], 3);
+	    if (p->style == PRINTER_CSTYLE)
+	       BddPrinter_char(p, ':');
+	    else
+	       BddPrinter_str(p, " :");
+	    BddPrinter_char(p, ' ');
+	    BddPrinter_int(p, LOW(n), 3);
+	    BddPrinter_char(p, ' ');
+	    BddPrinter_int(p, HIGH(n), 3);
+	    BddPrinter_char(p, '\n');
+	 }
+      }
+   }
+
+   BddPrinter_flush(p);
+}
+
+
+   /* Marks the nodes of 'r' like bdd_mark() but without recursion. The
+    * nodes on the current path each leave at most their high child on
+    * the stack, so it holds at most one node for each level plus one. */
+static int printer_mark(BDD r)
+{
+   int *stack;
+   int sp = 0;
+
+   if (ISCONST(r)  ||  MARKED(r))
+      return 0;
+   if ((stack=NEW(int,bddvarnum+2)) == NULL)
+      return bdd_error(BDD_MEMORY);
+
+   stack[sp++] = r;
+   SETMARK(r);
+   
+   while (sp > 0)
+   {
+      BDD n = stack[--sp];
+      
+      if (ISNONCONST(HIGH(n))  &&  !MARKED(HIGH(n)))
+      {
+	 SETMARK(HIGH(n));
+	 stack[sp++] = HIGH(n);
+      }
+      if (ISNONCONST(LOW(n))  &&  !MARKED(LOW(n)))
+      {
+	 SETMARK(LOW(n));
+	 stack[sp++] = LOW(n);
+      }
+   }
+
+   free(stack);
+   return 0;
+}
+
+
+   /* Removes the marks set by printer_mark() or BddPrinter_dot(). A node
+    * is unmarked when it is pushed, so the same bound holds. */
+static void printer_unmark(BDD r)
+{
+   int *stack;
+   int sp = 0;
+
+   if (ISCONST(r)  ||  !MARKED(r))
+      return;
+   if ((stack=NEW(int,bddvarnum+2)) == NULL)
+   {
+      bdd_unmark(r);
+      return;
+   }
+
+   stack[sp++] = r;
+   UNMARK(r);
+   
+   while (sp > 0)
+   {
+      BDD n = stack[--sp];
+      
+      if (ISNONCONST(HIGH(n))  &&  MARKED(HIGH(n)))
+      {
+	 UNMARK(HIGH(n));
+	 stack[sp++] = HIGH(n);
+      }
+      if (ISNONCONST(LOW(n))  &&  MARKED(LOW(n)))
+      {
+	 UNMARK(LOW(n));
+	 stack[sp++] = LOW(n);
+      }
+   }
+
+   free(stack);
+}
+
+
+/*=== SETS =============================================================*/
+
+   /* Walks all paths to the true terminal with an explicit stack and
+    * prints a cube for each. 'node' holds the nodes of the current path
+    * and 'state' holds 1 for a low branch and 2 for a high branch. 'set'
+    * holds the same branches indexed by level, with 0 for a skipped
+    * level, for the finite domain cubes. */
+static void printer_paths(BddPrinter *p, BDD r, int fdd)
+{
+   int *set, *node, *state;
+   int sp = 0;
+
+   if (r < 2)
+   {
+      BddPrinter_str(p, r == 0 ? "F" : "T");
+      BddPrinter_flush(p);
+      return;
+   }
+   
+   set = (int*)calloc(bddvarnum, sizeof(int));
+   node = NEW(int,bddvarnum+1);
+   state = NEW(int,bddvarnum+1);
+   if (set == NULL  ||  node == NULL  ||  state == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      free(set);
+      free(node);
+      free(state);
+      return;
+   }
+
+   node[0] = r;
+   state[0] = 0;
+
+   while (sp >= 0)
+   {
+      BDD n = node[sp];
+
+      if (n < 2)
+      {
+	 if (n == 1)
+	 {
+	    if (fdd)
+	       printer_fddcube(p, set);
+	    else
+	       printer_cube(p, node, state, sp);
+	 }
+	 sp--;
+      }
+      else
+      if (state[sp] < 2)
+      {
+	 set[LEVEL(n)] = ++state[sp];
+	 node[sp+1] = (state[sp] == 1 ? LOW(n) : HIGH(n));
+	 state[sp+1] = 0;
+	 sp++;
+      }
+      else
+      {
+	 set[LEVEL(n)] = 0;
+	 sp--;
+      }
+   }
+
+   BddPrinter_flush(p);
+   free(set);
+   free(node);
+   free(state);
+}
+
+
+void BddPrinter_set(BddPrinter *p, BDD r)
+{
+   printer_paths(p, r, 0);
+}
+
+
+   /* Prints the cube of the path in 'node' and 'state'. The levels of the
+    * path are increasing, so this gives the same order as a scan of all
+    * levels but only costs the length of the path. */
+static void printer_cube(BddPrinter *p, int *node, int *state, int num)
+{
+   int n;
+
+   BddPrinter_char(p, '<');
+   
+   for (n=0 ; n<num ; n++)
+   {
+      if (n > 0)
+	 BddPrinter_str(p, ", ");
+      printer_var(p, bddlevel2var[LEVEL(node[n])], 0);
+      BddPrinter_char(p, ':');
+      BddPrinter_char(p, state[n] == 2 ? '1' : '0');
+   }
+
+   BddPrinter_char(p, '>');
+}
+
+
+void BddPrinter_fddset(BddPrinter *p, BDD r)
+{
+   printer_paths(p, r, 1);
+}
+
+
+   /* Prints the values of each finite domain allowed by the cube. A value
+    * is allowed when its bits agree with the branches taken, which is
+    * tested on masks instead of expanding each value to bits. */
+static void printer_fddcube(BddPrinter *p, int *set)
+{
+   int n, m, i, first = 1;
+   int domainnum = fdd_domainnum();
+
+   BddPrinter_char(p, '<');
+   
+   for (n=0 ; n<domainnum ; n++)
+   {
+      int binsize = fdd_varnum(n);
+      int *var = fdd_vars(n);
+      int mask = 0, value = 0, firstval = 1;
+      
+      for (i=0 ; i<binsize ; i++)
+      {
+	 int s = set[bddvar2level[var[i]]];
+	 if (s != 0)
+	    mask |= 1 << i;
+	 if (s == 2)
+	    value |= 1 << i;
+      }
+      
+      if (mask == 0)
+	 continue;
+      
+      if (!first)
+	 BddPrinter_str(p, ", ");
+      first = 0;
+      if (p->fddname)
+      {
+	 BddPrinter_flush(p);
+	 p->fddname(p, n);
+      }
+      else
+	 BddPrinter_int(p, n, 0);
+      BddPrinter_char(p, ':');
+
+      for (m=0 ; m<(1<<binsize) ; m++)
+      {
+	 if ((m & mask) == value)
+	 {
+	    if (!firstval)
+	       BddPrinter_char(p, '/');
+	    BddPrinter_int(p, m, 0);
+	    firstval = 0;
+	 }
+      }
+   }
+
+   BddPrinter_char(p, '>');
+}
+
+
+/*=== DOT ==============================================================*/
+
+   /* Prints the nodes in the same order as a recursive walk that prints
+    * a node and then its low and high children. A node is checked when it
+    * is popped, so each node on the current path leaves at most its high
+    * child on the stack. */
+void BddPrinter_dot(BddPrinter *p, BDD r)
+{
+   int *stack;
+   int sp = 0;
+   
+   BddPrinter_str(p, "digraph G {\n");
+   BddPrinter_str(p, "0 [shape=box, label=\"0\", style=filled, shape=box, height=0.3, width=0.3];\n");
+   BddPrinter_str(p, "1 [shape=box, label=\"1\", style=filled, shape=box, height=0.3, width=0.3];\n");
+
+   if ((stack=NEW(int,bddvarnum+2)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      BddPrinter_flush(p);
+      return;
+   }
+   
+   stack[sp++] = r;
+   
+   while (sp > 0)
+   {
+      BDD n = stack[--sp];
+
+      if (ISCONST(n)  ||  MARKED(n))
+	 continue;
+
+      BddPrinter_int(p, n, 0);
+      BddPrinter_str(p, p->style == PRINTER_CSTYLE ? " [label=\"" : "[label=\"");
+      printer_var(p, bddlevel2var[LEVEL(n)], 0);
+      BddPrinter_str(p, "\"];\n");
+      
+      BddPrinter_int(p, n, 0);
+      BddPrinter_str(p, " -> ");
+      BddPrinter_int(p, LOW(n), 0);
+      BddPrinter_str(p, p->style == PRINTER_CSTYLE ?
+		     " [style=dotted];\n" : "[style=dotted];\n");
+      BddPrinter_int(p, n, 0);
+      BddPrinter_str(p, " -> ");
+      BddPrinter_int(p, HIGH(n), 0);
+      BddPrinter_str(p, p->style == PRINTER_CSTYLE ?
+		     " [style=filled];\n" : "[style=filled];\n");
+
+      SETMARK(n);
+      stack[sp++] = HIGH(n);
+      stack[sp++] = LOW(n);
+   }
+
+   BddPrinter_str(p, "}\n");
+   BddPrinter_flush(p);
+   
+   free(stack);
+   printer_unmark(r);
+}
+
+
+/* EOF */
@@ -0,0 +1,100 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  printer.h
+  DESCR: Buffered text output shared by the C and C++ printing functions
+*************************************************************************/
+
+#ifndef _PRINTER_H
+#define _PRINTER_H
+
+#include "kernel.h"
+
+#define PRINTER_BUFSIZE 8192
+
+   /* Layouts of the table, node table and dot output. The C++ operators
+      have always used a slightly different spacing than the C functions. */
+#define PRINTER_CSTYLE   0
+#define PRINTER_CPPSTYLE 1
+
+struct s_BddPrinter;
+
+   /* A sink receives the buffered text in large blocks */
+typedef void (*BddPrintSink)(void *data, const char *buf, int len);
+
+   /* A name function prints a variable or finite domain name. The buffer
+      is flushed before it is called, so it may write to the sink target
+      directly. */
+typedef void (*BddPrintName)(struct s_BddPrinter *p, int var);
+
+typedef struct s_BddPrinter
+{
+   BddPrintSink sink;
+   void *data;
+   BddPrintName varname;
+   BddPrintName fddname;
+   int style;
+   int pos;
+   char buf[PRINTER_BUFSIZE];
+} BddPrinter;
+
+
+#ifdef CPLUSPLUS
+extern "C" {
+#endif
+
+extern void BddPrinter_init(BddPrinter *, BddPrintSink, void *);
+extern void BddPrinter_flush(BddPrinter *);
+extern void BddPrinter_write(BddPrinter *, const char *, int);
+extern void BddPrinter_str(BddPrinter *, const char *);
+extern void BddPrinter_int(BddPrinter *, int, int);
+
+extern void BddPrinter_all(BddPrinter *);
+extern void BddPrinter_table(BddPrinter *, BDD);
+extern void BddPrinter_set(BddPrinter *, BDD);
+extern void BddPrinter_fddset(BddPrinter *, BDD);
+extern void BddPrinter_dot(BddPrinter *, BDD);
+
+extern void BddPrinter_filesink(void *, const char *, int);
+
+#ifdef CPLUSPLUS
+}
+#endif
+
+   /* Append a single character */
+#define BddPrinter_char(p, c) \
+   do { if ((p)->pos == PRINTER_BUFSIZE) BddPrinter_flush(p); \
+        (p)->buf[(p)->pos++] = (c); } while (0)
+
+
+#endif /* _PRINTER_H */
+
+
+/* EOF */
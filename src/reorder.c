@@ -37,13 +37,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 #include <math.h>
 #include <assert.h>
+#include <limits.h>
 #include "config.h"
 #include "kernel.h"
 #include "bddtree.h"
 #include "imatrix.h"
 #include "prime.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 /* IMPORTANT:
  * The semantics of the "level" field in the BddNode struct changes during
@@ -89,9 +94,39 @@ typedef struct _levelData
 
 static levelData *levels; /* Indexed by variable! */
 
+   /* Nodes that still have the function they had before the reordering.
+      Nodes made by reorder_makenode() are cleared, the rest are moved in
+      place by the swaps. Used to keep the operator caches. */
+static char *keptnodes;
+static int keptnum;
+
    /* Interaction matrix */
 static imatrix *iactmtx;
 
+   /* Window size for BDD_REORDER_WINK and max. blocks for exact reordering */
+static int reorderwindow;
+static int reorderexactlimit;
+
+   /* Budgets for one reordering session. Zero means no limit on the number
+      of swaps or the time. Sifting stops moving a block when the size
+      grows more than 'reordergrowth' percent above the best size seen. */
+static int reordermaxswaps;
+static int reordermaxtime;
+static int reordergrowth;
+static long reorder_swaptotal;
+static long reorder_swaps;
+static long reorder_starttime;
+static bddsifthandler sift_handler;
+
+   /* Schedules and random state for annealing and genetic reordering */
+static double annealstart;
+static double annealcooling;
+static int annealrounds;
+static int annealsteps;
+static int geneticpopulation;
+static int geneticgenerations;
+static unsigned short reorderseed[3];
+
    /* Reordering information for the user */
 static int verbose;
 static bddinthandler reorder_handler;
@@ -101,6 +136,18 @@ static bddsizehandler reorder_nodenum;
    /* Number of live nodes before and after a reordering session */
 static int usednum_before;
 static int usednum_after;
+
+   /* Order profile waiting for bdd_setvarnum(), see bdd_loadorder(), and
+      the file to keep the best order in */
+static struct
+{
+   int varnum;
+   int *order;
+   int topnum;
+   int blocknum;
+   int *block;
+} profile;
+static char *bestorderfile;
 	    
    /* Kernel variables needed for reordering */
 extern int bddfreepos;
@@ -110,6 +157,76 @@ extern int bddproduced;
    /* Flag telling us when a node table resize is done */
 static int resizedInMakenode;
 
+   /* Block parallel reordering. Each worker reorders one subtree of the
+      variable tree using a private free list, its own random state and
+      measures the size through its own levels only. The random states are
+      seeded from 'reorderseed', so the result does not depend on the
+      number of threads. Without the library's pthread support the
+      workers are run one at a time, which gives the same result. */
+typedef struct s_reorderWorker
+{
+   BddTree *block;          /* The subtree handled by this worker */
+   int offset;              /* Global size minus local size at start */
+   int freepos;             /* Private free list */
+   int freenum;
+   long produced;
+   long swaps;              /* Number of swaps done by this worker */
+   unsigned short seed[3];  /* Random state */
+} reorderWorker;
+
+static int reorderthreads;
+static reorderWorker *reorder_tasks;
+static int reorder_tasknum;
+static int reorder_tasknext;
+static int reorder_taskmethod;
+static int reorder_resized;
+static int reorder_failed;
+
+#ifdef HAVE_PTHREAD
+static __thread reorderWorker *worker;
+static pthread_mutex_t reorder_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_rwlock_t reorder_worldlock = PTHREAD_RWLOCK_INITIALIZER;
+#define REORDER_LOCK()       pthread_mutex_lock(&reorder_mutex)
+#define REORDER_UNLOCK()     pthread_mutex_unlock(&reorder_mutex)
+#define REORDER_SHARE()      pthread_rwlock_rdlock(&reorder_worldlock)
+#define REORDER_EXCLUSIVE()  pthread_rwlock_wrlock(&reorder_worldlock)
+#define REORDER_RELEASE()    pthread_rwlock_unlock(&reorder_worldlock)
+#define REORDER_COUNT(a)     __atomic_fetch_add(&(a), 1, __ATOMIC_RELAXED)
+
+   /* The reference count and the variable share one word in the node */
+typedef union
+{
+   unsigned int word;
+   struct
+   {
+      unsigned int refcou : 10;
+      unsigned int level  : 22;
+   } f;
+} nodeWord;
+
+   /* Reads of node words that another worker may be changing at the same
+      time, such as the children of a node that lie in a sibling block or
+      the reference counts of nodes with parents in a sibling block */
+static inline nodeWord reorder_word(int n)
+{
+   nodeWord w;
+   w.word = __atomic_load_n((unsigned int*)&bddnodes[n], __ATOMIC_RELAXED);
+   return w;
+}
+#define SHAREDVAR(n)    (reorder_word(n).f.level)
+#define SHAREDREFCOU(n) (reorder_word(n).f.refcou)
+#else
+static reorderWorker *worker;
+#define REORDER_LOCK()
+#define REORDER_UNLOCK()
+#define REORDER_SHARE()
+#define REORDER_EXCLUSIVE()
+#define REORDER_RELEASE()
+#define REORDER_COUNT(a)     ((a)++)
+#define SHAREDVAR(n)         VAR(n)
+#define SHAREDREFCOU(n)      (bddnodes[n].refcou)
+#endif
+
    /* New node hashing function for use with reordering */
 #define NODEHASH(var,l,h) ((PAIR((l),(h))%levels[var].size)+levels[var].start)
 
@@ -121,10 +238,14 @@ static void reorder_setLevellookup(void);
 static int  reorder_makenode(int, int, int);
 static int  reorder_varup(int);
 static int  reorder_vardown(int);
+static int  reorder_localnodenum(void);
 static int  reorder_init(void);
 static void reorder_done(void);
+static BddTree *reorder_block(BddTree *, int);
+static void profile_clear(void);
+static void profile_savebest(void);
 
-#define random(a) (lrand48() % (a))
+#define random(a) ((worker ? nrand48(worker->seed) : lrand48()) % (a))
 
    /* For sorting the blocks according to some specific size value */
 typedef struct s_sizePair
@@ -133,6 +254,13 @@ typedef struct s_sizePair
    BddTree *block;
 } sizePair;
 
+   /* Running lower bound used to stop sifting a block early */
+typedef struct s_siftBound
+{
+   char *dep;    /* Variables interacting with the moving blocks */
+   int ahead;    /* Removable nodes on such levels still to be passed */
+} siftBound;
+
 
 /*************************************************************************
   Initialize and shutdown
@@ -150,6 +278,18 @@ void bdd_reorder_init(void)
    reorder_nodenum = bdd_getnodenum;
    usednum_before = usednum_after = 0;
    blockid = 0;
+   reorderthreads = 0;
+   reorderwindow = 4;
+   reorderexactlimit = 12;
+   reordermaxswaps = 0;
+   reordermaxtime = 0;
+   reordergrowth = 20;
+   sift_handler = NULL;
+   bdd_reorder_anneal(0.05, 0.9, 50, 0);
+   bdd_reorder_genetic(20, 30);
+   bdd_reorder_seed(0);
+   profile_clear();
+   bdd_reorder_bestfile(NULL);
 }
 
 
@@ -158,6 +298,8 @@ void bdd_reorder_done(void)
    bddtree_del(vartree);
    bdd_operator_reset();
    vartree = NULL;
+   profile_clear();
+   bdd_reorder_bestfile(NULL);
 }
 
 
@@ -463,97 +605,259 @@ static BddTree *reorder_win3ite(BddTree *t)
 
 /*=== Reorder by sifting =============================================*/
 
+/* Wall clock time in milliseconds
+ */
+static long reorder_msec(void)
+{
+   struct timeval tv;
+   
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec*1000L + tv.tv_usec/1000;
+}
+
+
+/* Number of swaps done by the current thread
+ */
+static long reorder_localswaps(void)
+{
+   return worker ? worker->swaps : reorder_swaps;
+}
+
+
+/* Check whether the swap or time budget for this session is used up
+ */
+static int reorder_budgetdone(void)
+{
+   if (reordermaxswaps > 0  &&  reorder_swaptotal >= reordermaxswaps)
+      return 1;
+   if (reordermaxtime > 0  &&
+       reorder_msec() - reorder_starttime >= reordermaxtime)
+      return 1;
+   return 0;
+}
+
+
+/* Largest size allowed while moving a block when the best size seen
+   is 'best'
+*/
+static int reorder_maxallowed(int best)
+{
+   int max = best + (int)((double)best * reordergrowth / 100.0);
+   
+   if (bddmaxnodesize > 0)
+      max = MIN(max, bddmaxnodesize-bddmaxnodeincrease-2);
+   return max;
+}
+
+
+/* Prepare a lower bound on the size that can be reached by moving the
+   'num' blocks starting with 'blk'. Only the levels of the moving blocks
+   and of the interacting variables still to be passed can change, and
+   each of these keeps at least one node. The interacting variables are
+   marked once here, and the nodes on the levels still to be passed are
+   kept as a running sum, since a swap only changes the two levels
+   involved. No bound is used when the size is measured by a user
+   supplied probe.
+*/
+static void siftbound_init(siftBound *sb, BddTree *blk, int num)
+{
+   BddTree *this;
+   int n, v, w;
+
+   sb->dep = NULL;
+   sb->ahead = 0;
+   
+   if (reorder_nodenum != bdd_getnodenum  &&
+       reorder_nodenum != reorder_localnodenum)
+      return;
+   if ((sb->dep=NEW(char,bddvarnum)) == NULL)
+      return;
+   
+   memset(sb->dep, 0, bddvarnum);
+   for (this=blk,n=0 ; n<num ; this=this->next,n++)
+      for (w=this->first ; w<=this->last ; w++)
+	 for (v=0 ; v<bddvarnum ; v++)
+	    if (imatrixDepends(iactmtx, w, v))
+	       sb->dep[v] = 1;
+}
+
+
+static void siftbound_done(siftBound *sb)
+{
+   free(sb->dep);
+   sb->dep = NULL;
+}
+
+
+   /* Nodes that may vanish from the interacting levels of 'num' blocks */
+static int siftbound_sum(siftBound *sb, BddTree *blk, int num)
+{
+   int sum = 0;
+   int n, v;
+
+   for (n=0 ; n<num  &&  blk!=NULL ; n++,blk=blk->next)
+      for (v=blk->first ; v<=blk->last ; v++)
+	 if (sb->dep[v]  &&  levels[v].nodenum > 1)
+	    sum += levels[v].nodenum - 1;
+   return sum;
+}
+
+
+   /* Collect the levels still to be passed when moving in one direction */
+static void siftbound_start(siftBound *sb, BddTree *blk, int num,
+			    int dirIsUp)
+{
+   BddTree *this;
+   int n;
+
+   if (sb->dep == NULL)
+      return;
+
+   for (this=blk,n=1 ; n<num ; n++)
+      this = this->next;
+   
+   sb->ahead = 0;
+   for (this=dirIsUp ? blk->prev : this->next ; this!=NULL ;
+	this=dirIsUp ? this->prev : this->next)
+      sb->ahead += siftbound_sum(sb, this, 1);
+}
+
+
+   /* Account for moving past the 'num' blocks starting with 'blk' */
+static void siftbound_pass(siftBound *sb, BddTree *blk, int num)
+{
+   if (sb->dep != NULL)
+      sb->ahead -= siftbound_sum(sb, blk, num);
+}
+
+
+   /* The bound itself, or zero when none is used */
+static int siftbound_get(siftBound *sb, BddTree *blk, int num)
+{
+   int size = reorder_nodenum();
+   int n, v;
+
+   if (sb->dep == NULL)
+      return 0;
+   
+   for (n=0 ; n<num ; n++,blk=blk->next)
+      for (v=blk->first ; v<=blk->last ; v++)
+	 if (levels[v].nodenum > 1)
+	    size -= levels[v].nodenum - 1;
+
+   return size - sb->ahead;
+}
+
+
+/* Report the statistics for one sifted block to the user
+ */
+static void reorder_siftreport(bddSiftStat *stat, long swaps, long time)
+{
+   stat->after = reorder_nodenum();
+   stat->swaps = (int)(reorder_localswaps() - swaps);
+   stat->time = reorder_msec() - time;
+
+   if (verbose > 1)
+      printf("\n> %d nodes, %d swaps (%.1f sec)\n",
+	     stat->after, stat->swaps, stat->time/1000.0);
+
+   if (sift_handler != NULL)
+   {
+      REORDER_LOCK();
+      sift_handler(stat);
+      REORDER_UNLOCK();
+   }
+}
+
+
 /* Move a specific block up and down in the order and place at last in
    the best position
 */
-static void reorder_sift_bestpos(BddTree *blk, int middlePos)
+static void reorder_sift_bestpos(BddTree *blk, int middlePos,
+				 bddSiftStat *stat)
 {
    int best = reorder_nodenum();
-   int maxAllowed;
+   int maxAllowed = reorder_maxallowed(best);
    int bestpos = 0;
    int dirIsUp = 1;
+   siftBound bound;
    int n;
    
-   if (bddmaxnodesize > 0)
-      maxAllowed = MIN(best/5+best, bddmaxnodesize-bddmaxnodeincrease-2);
-   else
-      maxAllowed = best/5+best;
-
       /* Determine initial direction */
    if (blk->pos > middlePos)
       dirIsUp = 0;
 
+   siftbound_init(&bound, blk, 1);
+   
       /* Move block back and forth */
    for (n=0 ; n<2 ; n++)
    {
       int first = 1;
+
+      siftbound_start(&bound, blk, 1, dirIsUp);
       
-      if (dirIsUp)
+      while ((dirIsUp ? blk->prev : blk->next) != NULL  &&
+	     (reorder_nodenum() <= maxAllowed || first))
       {
-	 while (blk->prev != NULL  &&
-		(reorder_nodenum() <= maxAllowed || first))
+	 if (reorder_budgetdone())
 	 {
-	    first = 0;
-	    blockdown(blk->prev);
-	    bestpos--;
-	    
+	    stat->limited = 1;
+	    break;
+	 }
+	 if (siftbound_get(&bound, blk, 1) >= best)
+	 {
+	    stat->pruned++;
 	    if (verbose > 1)
 	    {
-	       printf("-");
+	       printf("|");
 	       fflush(stdout);
 	    }
-	    
-	    if (reorder_nodenum() < best)
-	    {
-	       best = reorder_nodenum();
-	       bestpos = 0;
-
-	       if (bddmaxnodesize > 0)
-		  maxAllowed = MIN(best/5+best,
-				   bddmaxnodesize-bddmaxnodeincrease-2);
-	       else
-		  maxAllowed = best/5+best;
-	    }
+	    break;
 	 }
-      }
-      else
-      {
-	 while (blk->next != NULL  &&
-		(reorder_nodenum() <= maxAllowed  ||  first))
+	 
+	 first = 0;
+	 if (dirIsUp)
+	 {
+	    siftbound_pass(&bound, blk->prev, 1);
+	    blockdown(blk->prev);
+	    bestpos--;
+	 }
+	 else
 	 {
-	    first = 0;
+	    siftbound_pass(&bound, blk->next, 1);
 	    blockdown(blk);
 	    bestpos++;
+	 }
 	    
-	    if (verbose > 1)
-	    {
-	       printf("+");
-	       fflush(stdout);
-	    }
+	 if (verbose > 1)
+	 {
+	    printf(dirIsUp ? "-" : "+");
+	    fflush(stdout);
+	 }
 	    
-	    if (reorder_nodenum() < best)
-	    {
-	       best = reorder_nodenum();
-	       bestpos = 0;
-	       
-	       if (bddmaxnodesize > 0)
-		  maxAllowed = MIN(best/5+best,
-				   bddmaxnodesize-bddmaxnodeincrease-2);
-	       else
-		  maxAllowed = best/5+best;
-	    }
+	 if (reorder_nodenum() < best)
+	 {
+	    best = reorder_nodenum();
+	    bestpos = 0;
+	    maxAllowed = reorder_maxallowed(best);
 	 }
       }
 	 
-      if (reorder_nodenum() > maxAllowed  &&  verbose > 1)
+      if (reorder_nodenum() > maxAllowed)
       {
-	 printf("!");
-	 fflush(stdout);
+	 stat->grown++;
+	 if (verbose > 1)
+	 {
+	    printf("!");
+	    fflush(stdout);
+	 }
       }
 
       dirIsUp = !dirIsUp;
    }
 
+   siftbound_done(&bound);
+
       /* Move to best pos */
    while (bestpos < 0)
    {
@@ -579,9 +883,11 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
    if (t == NULL)
       return t;
 
-   for (n=0 ; n<num ; n++)
+   for (n=0 ; n<num  &&  !reorder_budgetdone() ; n++)
    {
-      long c2, c1 = clock();
+      long swaps = reorder_localswaps();
+      long time = reorder_msec();
+      bddSiftStat stat;
    
       if (verbose > 1)
       {
@@ -593,14 +899,12 @@ static BddTree *reorder_sift_seq(BddTree *t, BddTree **seq, int num)
 	 printf(": ");
       }
 
-      reorder_sift_bestpos(seq[n], num/2);
-
-      if (verbose > 1)
-	 printf("\n> %d nodes", reorder_nodenum());
-
-      c2 = clock();
-      if (verbose > 1)
-	 printf(" (%.1f sec)\n", (float)(c2-c1)/CLOCKS_PER_SEC);
+      memset(&stat, 0, sizeof(stat));
+      stat.id = seq[n]->id;
+      stat.before = reorder_nodenum();
+      
+      reorder_sift_bestpos(seq[n], num/2, &stat);
+      reorder_siftreport(&stat, swaps, time);
    }
 
       /* Find first block */
@@ -693,132 +997,1163 @@ static BddTree *reorder_siftite(BddTree *t)
       lastsize = reorder_nodenum();
       first = reorder_sift(first);
    }
-   while (reorder_nodenum() != lastsize);
+   while (reorder_nodenum() != lastsize  &&  !reorder_budgetdone());
 
    return first;
 }
 
 
-/*=== Random reordering (mostly for debugging and test ) =============*/
+/*=== Symmetric sifting ==============================================*/
 
-static BddTree *reorder_random(BddTree *t)
+/* Check whether the two adjacent variables x (above) and y (below) are
+   symmetric in all the nodes of the current forest. Either all x nodes
+   must satisfy f01 == f10 or all of them must satisfy f00 == f11, and
+   all references to y nodes must come from x nodes. Nodes with a
+   saturated reference count are left out of the reference check.
+*/
+static int reorder_symcheck_nodes(int x, int y)
 {
-   BddTree *this;
-   BddTree **seq;
-   int n, num=0;
+   int possym = 1, negsym = 1;
+   int arcs = 0, refs = 0;
+   int n;
 
-   if (t == NULL)
-      return t;
-   
-   for (this=t ; this!=NULL ; this=this->next)
-      num++;
-   seq = NEW(BddTree*,num);
-   for (this=t,num=0 ; this!=NULL ; this=this->next)
-      seq[num++] = this;
+   if (!imatrixDepends(iactmtx, x, y))
+      return 0;
    
-   for (n=0 ; n<4*num ; n++)
+   for (n=0 ; n<levels[x].size ; n++)
    {
-      int blk = random(num);
-      if (seq[blk]->next != NULL)
-	 blockdown(seq[blk]);
-   }
-
-      /* Find first block */
-   for (this=t ; this->prev != NULL ; this=this->prev)
-      /* nil */;
-
-   free(seq);
-
-   if (verbose)
-      printf("Random order: %d nodes\n", reorder_nodenum());
-   return this;
-}
-
+      int r;
 
-/*************************************************************************
-  Swapping adjacent blocks
-*************************************************************************/
+      for (r=bddnodes[n+levels[x].start].hash ; r!=0 ; r=bddnodes[r].next)
+      {
+	 int f0 = LOW(r), f1 = HIGH(r);
+	 int f00, f01, f10, f11;
 
-static void blockdown(BddTree *left)
-{
-   BddTree *right = left->next;
-   int n;
-   int leftsize = left->last - left->first;
-   int rightsize = right->last - right->first;
-   int leftstart = bddvar2level[left->seq[0]];
-   int *lseq = left->seq;
-   int *rseq = right->seq;
+	 if (SHAREDVAR(f0) != y  &&  SHAREDVAR(f1) != y)
+	 {
+	       /* Only the projection function of x may bypass y */
+	    if (ISCONST(f0)  &&  ISCONST(f1))
+	       continue;
+	    return 0;
+	 }
+	 
+	 if (SHAREDVAR(f0) == y)
+	 {
+	    f00 = LOW(f0);
+	    f01 = HIGH(f0);
+	    if (SHAREDREFCOU(f0) != MAXREF)
+	       arcs++;
+	 }
+	 else
+	    f00 = f01 = f0;
 
-      /* Move left past right */
-   while (bddvar2level[lseq[0]] < bddvar2level[rseq[rightsize]])
-   {
-      for (n=0 ; n<leftsize ; n++)
-      {
-	 if (bddvar2level[lseq[n]]+1  !=  bddvar2level[lseq[n+1]]
-	     && bddvar2level[lseq[n]]  <  bddvar2level[rseq[rightsize]])
+	 if (SHAREDVAR(f1) == y)
 	 {
-	    reorder_vardown(lseq[n]);
+	    f10 = LOW(f1);
+	    f11 = HIGH(f1);
+	    if (SHAREDREFCOU(f1) != MAXREF)
+	       arcs++;
 	 }
-      }
+	 else
+	    f10 = f11 = f1;
 
-      if (bddvar2level[lseq[leftsize]] <  bddvar2level[rseq[rightsize]])
-      {
-	 reorder_vardown(lseq[leftsize]);
+	 possym &= (f01 == f10);
+	 negsym &= (f00 == f11);
+	 if (!possym  &&  !negsym)
+	    return 0;
       }
    }
 
-      /* Move right to where left started */
-   while (bddvar2level[rseq[0]] > leftstart)
+   for (n=0 ; n<levels[y].size ; n++)
    {
-      for (n=rightsize ; n>0 ; n--)
-      {
-	 if (bddvar2level[rseq[n]]-1 != bddvar2level[rseq[n-1]]
-	     && bddvar2level[rseq[n]] > leftstart)
-	 {
-	    reorder_varup(rseq[n]);
-	 }
-      }
+      int r;
 
-      if (bddvar2level[rseq[0]] > leftstart)
-	 reorder_varup(rseq[0]);
+      for (r=bddnodes[n+levels[y].start].hash ; r!=0 ; r=bddnodes[r].next)
+	 if (SHAREDREFCOU(r) != MAXREF)
+	    refs += SHAREDREFCOU(r);
    }
 
-      /* Swap left and right data in the order */
-   left->next = right->next;
-   right->prev = left->prev;
-   left->prev = right;
-   right->next = left;
-
-   if (right->prev != NULL)
-      right->prev->next = right;
-   if (left->next != NULL)
-      left->next->prev = left;
-
-   n = left->pos;
-   left->pos = right->pos;
-   right->pos = n;
+   return arcs == refs;
 }
 
 
-/*************************************************************************
-  Kernel reordering routines
-*************************************************************************/
+static int reorder_symcheck(int x, int y)
+{
+   int res;
+   
+   if (worker != NULL)
+      REORDER_SHARE();
+   res = reorder_symcheck_nodes(x, y);
+   if (worker != NULL)
+      REORDER_RELEASE();
 
-/*=== Garbage collection for reordering ================================*/
+   return res;
+}
 
-/* Note: Node may be marked
+
+/* Last block in the symmetry group starting with blk
  */
-static void addref_rec(int r, char *dep)
+static BddTree *symgroup_last(BddTree *blk)
 {
-   if (r < 2)
-      return;
+   BddTree *this = blk;
+   int n;
    
-   if (bddnodes[r].refcou == 0 || MARKED(r))
-   {
-      bddfreenum--;
+   for (n=1 ; n<blk->symsize ; n++)
+      this = this->next;
+   return this;
+}
 
-         /* Detect variable dependencies for the interaction matrix */
-      dep[VAR(r) & MARKHIDE] = 1;
+
+/* Join the symmetry group starting with 'top' with the group following
+   it if the variables at the boundary are symmetric. Only groups of
+   single variable blocks are joined. Returns non-zero on success.
+*/
+static int symgroup_join(BddTree *top)
+{
+   BddTree *last = symgroup_last(top);
+   BddTree *bot = last->next;
+   BddTree *this;
+   int n;
+
+   if (bot == NULL)
+      return 0;
+   if (last->first != last->last  ||  bot->first != bot->last)
+      return 0;
+   if (!reorder_symcheck(last->first, bot->first))
+      return 0;
+
+   for (this=bot,n=0 ; n<bot->symsize ; this=this->next,n++)
+      this->symhead = top;
+   top->symsize += n;
+
+   return 1;
+}
+
+
+/* Move the symmetry group starting with blk past the group just after it
+ */
+static void symgroup_down(BddTree *blk)
+{
+   BddTree *last = symgroup_last(blk);
+   int num = last->next->symsize;
+   int n, m;
+
+   for (n=0 ; n<num ; n++)
+   {
+      BddTree *this = last;
+      
+      for (m=0 ; m<blk->symsize ; m++)
+      {
+	 BddTree *prev = this->prev;
+	 blockdown(this);
+	 this = prev;
+      }
+   }
+}
+
+
+/* Move the symmetry group starting with blk past the group just before it
+ */
+static void symgroup_up(BddTree *blk)
+{
+   int num = blk->prev->symhead->symsize;
+   int n, m;
+
+   for (n=0 ; n<num ; n++)
+   {
+      BddTree *this = blk->prev;
+      
+      for (m=0 ; m<blk->symsize ; m++)
+	 blockdown(this);
+   }
+}
+
+
+/* Move a symmetry group up and down in the order, join it with the
+   neighbours it is found to be symmetric with, and place it at last in
+   the best position found. Groups are only joined at a best position
+   so the size never increases.
+*/
+static void reorder_siftsym_bestpos(BddTree *blk, int middlePos,
+				    bddSiftStat *stat)
+{
+   int best = reorder_nodenum();
+   int maxAllowed = reorder_maxallowed(best);
+   int bestlevel = bddvar2level[blk->seq[0]];
+   int dirIsUp = 1;
+   siftBound bound;
+   int n;
+   
+      /* Determine initial direction */
+   if (blk->pos > middlePos)
+      dirIsUp = 0;
+
+   siftbound_init(&bound, blk, blk->symsize);
+   
+      /* Move group back and forth */
+   for (n=0 ; n<2 ; n++)
+   {
+      int first = 1;
+
+      siftbound_start(&bound, blk, blk->symsize, dirIsUp);
+      
+      while ((dirIsUp ? blk->prev : symgroup_last(blk)->next) != NULL  &&
+	     (reorder_nodenum() <= maxAllowed || first))
+      {
+	 if (reorder_budgetdone())
+	 {
+	    stat->limited = 1;
+	    break;
+	 }
+	    /* Joins happen at the best size so only stop when it can't
+	       be reached again */
+	 if (siftbound_get(&bound, blk, blk->symsize) > best)
+	 {
+	    stat->pruned++;
+	    if (verbose > 1)
+	    {
+	       printf("|");
+	       fflush(stdout);
+	    }
+	    break;
+	 }
+	 
+	 first = 0;
+	 
+	 if (dirIsUp)
+	 {
+	    BddTree *above = blk->prev->symhead;
+	    
+	    if (reorder_nodenum() <= best  &&  symgroup_join(above))
+	    {
+	       blk = above;
+	       best = reorder_nodenum();
+	       bestlevel = bddvar2level[blk->seq[0]];
+	       siftbound_done(&bound);
+	       siftbound_init(&bound, blk, blk->symsize);
+	       siftbound_start(&bound, blk, blk->symsize, dirIsUp);
+	       continue;
+	    }
+	    siftbound_pass(&bound, above, above->symsize);
+	    symgroup_up(blk);
+	 }
+	 else
+	 {
+	    BddTree *below = symgroup_last(blk)->next;
+	    
+	    if (reorder_nodenum() <= best  &&  symgroup_join(blk))
+	    {
+	       best = reorder_nodenum();
+	       bestlevel = bddvar2level[blk->seq[0]];
+	       siftbound_done(&bound);
+	       siftbound_init(&bound, blk, blk->symsize);
+	       siftbound_start(&bound, blk, blk->symsize, dirIsUp);
+	       continue;
+	    }
+	    siftbound_pass(&bound, below, below->symsize);
+	    symgroup_down(blk);
+	 }
+	 
+	 if (verbose > 1)
+	 {
+	    printf(dirIsUp ? "-" : "+");
+	    fflush(stdout);
+	 }
+	 
+	 if (reorder_nodenum() < best)
+	 {
+	    best = reorder_nodenum();
+	    bestlevel = bddvar2level[blk->seq[0]];
+	    maxAllowed = reorder_maxallowed(best);
+	 }
+      }
+	 
+      if (reorder_nodenum() > maxAllowed)
+      {
+	 stat->grown++;
+	 if (verbose > 1)
+	 {
+	    printf("!");
+	    fflush(stdout);
+	 }
+      }
+
+      dirIsUp = !dirIsUp;
+   }
+
+   siftbound_done(&bound);
+
+      /* Move to best pos */
+   while (bddvar2level[blk->seq[0]] < bestlevel)
+      symgroup_down(blk);
+   while (bddvar2level[blk->seq[0]] > bestlevel)
+      symgroup_up(blk);
+}
+
+
+/* Sifting where symmetric variables are detected and sifted as a group.
+   Groups are only formed from blocks with one variable.
+*/
+static BddTree *reorder_siftsym(BddTree *t)
+{
+   BddTree *this, **seq;
+   sizePair *p;
+   char *done;
+   int n, num;
+
+   if (t == NULL)
+      return t;
+   
+   for (this=t,num=0 ; this!=NULL ; this=this->next)
+   {
+      this->pos = num++;
+      this->symhead = this;
+      this->symsize = 1;
+   }
+   
+   if ((p=NEW(sizePair,num)) == NULL)
+      return t;
+   if ((seq=NEW(BddTree*,num)) == NULL)
+   {
+      free(p);
+      return t;
+   }
+   if ((done=NEW(char,num)) == NULL)
+   {
+      free(seq);
+      free(p);
+      return t;
+   }
+   memset(done, 0, num);
+
+      /* Find the initial groups */
+   for (this=t ; this!=NULL ; this=symgroup_last(this)->next)
+      while (symgroup_join(this))
+	 /* nil */ ;
+   
+   for (this=t,n=0 ; this!=NULL ; this=this->next,n++)
+   {
+      int v;
+
+         /* Accumulate number of nodes for each block */
+      p[n].val = 0;
+      for (v=this->first ; v<=this->last ; v++)
+	 p[n].val -= levels[v].nodenum;
+
+      p[n].block = this;
+   }
+
+      /* Sort according to the number of nodes at each level */
+   qsort(p, num, sizeof(sizePair), siftTestCmp);
+   
+   for (n=0 ; n<num ; n++)
+      seq[n] = p[n].block;
+
+      /* Sift each group once, starting from any block in it */
+   for (n=0 ; n<num  &&  !reorder_budgetdone() ; n++)
+   {
+      BddTree *blk = seq[n]->symhead;
+      long swaps = reorder_localswaps();
+      long time = reorder_msec();
+      bddSiftStat stat;
+      int k, m;
+
+      if (done[n])
+	 continue;
+      
+      if (verbose > 1)
+      {
+	 printf("Sift ");
+	 if (reorder_filehandler)
+	    reorder_filehandler(stdout, blk->id);
+	 else
+	    printf("%d", blk->id);
+	 printf(": ");
+      }
+
+      memset(&stat, 0, sizeof(stat));
+      stat.id = blk->id;
+      stat.before = reorder_nodenum();
+      
+      reorder_siftsym_bestpos(blk, num/2, &stat);
+      reorder_siftreport(&stat, swaps, time);
+
+         /* The group may have grown while sifting */
+      blk = blk->symhead;
+      for (this=blk,k=0 ; k<blk->symsize ; this=this->next,k++)
+	 for (m=n ; m<num ; m++)
+	    if (seq[m] == this)
+	       done[m] = 1;
+   }
+
+      /* Find first block */
+   for (this=t ; this->prev != NULL ; this=this->prev)
+      /* nil */;
+
+   free(done);
+   free(seq);
+   free(p);
+   
+   return this;
+}
+
+
+/* Do symmetric sifting iteratively until no more improvement can be found
+ */
+static BddTree *reorder_siftsymite(BddTree *t)
+{
+   BddTree *first=t;
+   int lastsize;
+   int c=1;
+   
+   if (t == NULL)
+      return t;
+   
+   do
+   {
+      if (verbose > 1)
+	 printf("Reorder %d\n", c++);
+      
+      lastsize = reorder_nodenum();
+      first = reorder_siftsym(first);
+   }
+   while (reorder_nodenum() != lastsize  &&  !reorder_budgetdone());
+
+   return first;
+}
+
+/*=== Reorder using a sliding window of size k =========================*/
+
+/* Collect the blocks of a list in an array with the current sequence
+ */
+static BddTree **reorder_blockarray(BddTree *t, int *num)
+{
+   BddTree *this, **cur;
+   int n;
+
+   for (this=t,n=0 ; this!=NULL ; this=this->next)
+      n++;
+   if ((cur=NEW(BddTree*,n)) == NULL)
+      return NULL;
+   for (this=t,n=0 ; this!=NULL ; this=this->next)
+      cur[n++] = this;
+
+   *num = n;
+   return cur;
+}
+
+
+/* Swap the blocks at position pos and pos+1 in the sequence
+ */
+static void reorder_swappos(BddTree **cur, int pos)
+{
+   BddTree *tmp = cur[pos];
+   
+   blockdown(cur[pos]);
+   cur[pos] = cur[pos+1];
+   cur[pos+1] = tmp;
+}
+
+
+/* Place the blocks in 'seq' at the positions from 'first' and on
+ */
+static void reorder_arrange(BddTree **cur, BddTree **seq, int first, int num)
+{
+   int n, pos;
+
+   for (n=0 ; n<num ; n++)
+   {
+      for (pos=first+n ; cur[pos] != seq[n] ; pos++)
+	 /* nil */ ;
+      while (pos > first+n)
+	 reorder_swappos(cur, --pos);
+   }
+}
+
+
+/* Try all permutations of the 'size' blocks from position 'first' with
+   a sequence of adjacent transpositions (Steinhaus-Johnson-Trotter) and
+   keep the best of them
+*/
+static void reorder_winperm(BddTree **cur, int first, int size)
+{
+   BddTree **bestseq;
+   int *perm, *dir;
+   int best = reorder_nodenum();
+   int n;
+
+   bestseq = NEW(BddTree*,size);
+   perm = NEW(int,size);
+   dir = NEW(int,size);
+   if (bestseq == NULL  ||  perm == NULL  ||  dir == NULL)
+   {
+      free(bestseq);
+      free(perm);
+      free(dir);
+      return;
+   }
+   
+   for (n=0 ; n<size ; n++)
+   {
+      bestseq[n] = cur[first+n];
+      perm[n] = n;
+      dir[n] = -1;
+   }
+
+   while (1)
+   {
+      int pos = -1, e = -1;
+
+         /* Find the largest mobile element */
+      for (n=0 ; n<size ; n++)
+      {
+	 int m = n + dir[perm[n]];
+	 if (m >= 0  &&  m < size  &&  perm[m] < perm[n]  &&  perm[n] > e)
+	 {
+	    e = perm[n];
+	    pos = n;
+	 }
+      }
+      if (e < 0)
+	 break;
+
+      n = MIN(pos, pos+dir[e]);
+      reorder_swappos(cur, first+n);
+      perm[pos] = perm[pos+dir[e]];
+      perm[pos+dir[e]] = e;
+
+      for (n=0 ; n<size ; n++)
+	 if (perm[n] > e)
+	    dir[perm[n]] = -dir[perm[n]];
+
+      if (reorder_nodenum() < best)
+      {
+	 best = reorder_nodenum();
+	 for (n=0 ; n<size ; n++)
+	    bestseq[n] = cur[first+n];
+      }
+   }
+
+   reorder_arrange(cur, bestseq, first, size);
+
+   free(bestseq);
+   free(perm);
+   free(dir);
+}
+
+
+static BddTree *reorder_wink(BddTree *t, int size)
+{
+   BddTree **cur;
+   int n, num;
+
+   if (t == NULL)
+      return t;
+   if ((cur=reorder_blockarray(t, &num)) == NULL)
+      return t;
+   
+   if (verbose > 1)
+      printf("Win%d start: %d nodes\n", size, reorder_nodenum());
+   fflush(stdout);
+
+   size = MIN(size, num);
+   for (n=0 ; size > 1  &&  n+size <= num ; n++)
+   {
+      reorder_winperm(cur, n, size);
+      
+      if (verbose > 1)
+      {
+	 printf(".");
+	 fflush(stdout);
+      }
+   }
+
+   if (verbose > 1)
+      printf("\nWin%d end: %d nodes\n", size, reorder_nodenum());
+   fflush(stdout);
+
+   t = cur[0];
+   free(cur);
+   
+   return t;
+}
+
+
+/*=== Exact reordering =================================================*/
+
+/* Number of nodes on the levels of a block
+ */
+static int reorder_blocksize(BddTree *blk)
+{
+   int v, size = 0;
+
+   for (v=blk->first ; v<=blk->last ; v++)
+      size += levels[v].nodenum;
+   return size;
+}
+
+
+/* Sequence of the blocks in 'set' as found by reorder_exact()
+ */
+static void reorder_exactseq(BddTree **blk, int *last, int set, BddTree **seq)
+{
+   int n, num = 0;
+
+   for (n=set ; n ; n &= ~(1 << last[n]))
+      num++;
+   for (n=set ; n ; n &= ~(1 << last[n]))
+      seq[--num] = blk[last[n]];
+}
+
+
+/* Find an optimal order of the blocks by dynamic programming over the sets
+   of blocks placed at the top (Friedman and Supowit). The size of a block
+   only depends on the set of blocks above it, so cost[s] is the smallest
+   number of nodes on the levels of the blocks in 's' when they are on top.
+   Sets that cannot beat the current order even with one node per level
+   in use below them are skipped. Lists with more blocks than the limit
+   are sifted instead.
+*/
+static BddTree *reorder_exact(BddTree *t)
+{
+   BddTree **cur, **blk, **seq;
+   int *cost, *last, *lb;
+   int size = reorder_nodenum();
+   int n, num, set, full, ub;
+
+   if (t == NULL)
+      return t;
+   if ((cur=reorder_blockarray(t, &num)) == NULL)
+      return t;
+   if (num > reorderexactlimit)
+   {
+      free(cur);
+      return reorder_sift(t);
+   }
+
+   blk = NEW(BddTree*,num);
+   seq = NEW(BddTree*,num);
+   lb = NEW(int,num);
+   cost = NEW(int,1<<num);
+   last = NEW(int,1<<num);
+   if (blk == NULL  ||  seq == NULL  ||  lb == NULL  ||
+       cost == NULL  ||  last == NULL)
+   {
+      t = cur[0];
+      free(cur); free(blk); free(seq); free(lb); free(cost); free(last);
+      return t;
+   }
+
+   if (verbose > 1)
+      printf("Exact start: %d nodes\n", size);
+   fflush(stdout);
+
+   full = (1 << num) - 1;
+   ub = 0;
+   for (n=0 ; n<num ; n++)
+   {
+      int v;
+      
+      blk[n] = cur[n];
+      ub += reorder_blocksize(blk[n]);
+
+         /* Levels with nodes stay in use in any order */
+      for (v=blk[n]->first, lb[n]=0 ; v<=blk[n]->last ; v++)
+	 if (levels[v].nodenum > 0)
+	    lb[n]++;
+   }
+   
+   for (set=0 ; set<=full ; set++)
+      cost[set] = -1;
+   cost[0] = 0;
+
+      /* Visit the sets by number of elements */
+   for (n=0 ; n<num ; n++)
+   {
+      for (set=0 ; set<full ; set++)
+      {
+	 int k, b, bound = cost[set];
+	 
+	 if (cost[set] < 0)
+	    continue;
+	 
+	 for (b=0,k=0 ; b<num ; b++)
+	    if (set & (1 << b))
+	       k++;
+	    else
+	       bound += lb[b];
+	 if (k != n  ||  bound >= ub)
+	    continue;
+
+	    /* Place the best sequence of 'set' at the top */
+	 reorder_exactseq(blk, last, set, seq);
+	 reorder_arrange(cur, seq, 0, k);
+
+	    /* ... and try each of the remaining blocks below it */
+	 for (b=0 ; b<num ; b++)
+	 {
+	    int pos, c, next = set | (1 << b);
+	    
+	    if (set & (1 << b))
+	       continue;
+
+	    for (pos=k ; cur[pos] != blk[b] ; pos++)
+	       /* nil */ ;
+	    while (pos > k)
+	       reorder_swappos(cur, --pos);
+
+	    c = cost[set] + reorder_blocksize(blk[b]);
+	    if (cost[next] < 0  ||  c < cost[next])
+	    {
+	       cost[next] = c;
+	       last[next] = b;
+	    }
+	 }
+      }
+      
+      if (verbose > 1)
+      {
+	 printf(".");
+	 fflush(stdout);
+      }
+   }
+
+      /* Use the optimal order unless the probe prefers the old one */
+   if (cost[full] >= 0  &&  cost[full] < ub)
+   {
+      reorder_exactseq(blk, last, full, seq);
+      reorder_arrange(cur, seq, 0, num);
+      if (reorder_nodenum() > size)
+	 reorder_arrange(cur, blk, 0, num);
+   }
+   else
+      reorder_arrange(cur, blk, 0, num);
+
+   if (verbose > 1)
+      printf("\nExact end: %d nodes\n", reorder_nodenum());
+   fflush(stdout);
+
+   t = cur[0];
+   free(cur); free(blk); free(seq); free(lb); free(cost); free(last);
+   
+   return t;
+}
+
+/*=== Simulated annealing and genetic reordering =====================*/
+
+/* Random numbers for the stochastic methods. They come from the seed
+   set by bdd_reorder_seed, or from the worker's own state when the
+   blocks are reordered in parallel.
+*/
+static long reorder_stochrand(long a)
+{
+   return nrand48(worker ? worker->seed : reorderseed) % a;
+}
+
+
+static double reorder_stochreal(void)
+{
+   return erand48(worker ? worker->seed : reorderseed);
+}
+
+
+/* Reorder by simulated annealing. Adjacent blocks are swapped at random
+   and a swap that adds 'd' nodes is kept with probability exp(-d/T).
+   The temperature T starts as a fraction of the size and is lowered
+   after each round. The best order seen is restored at the end.
+*/
+static BddTree *reorder_anneal(BddTree *t)
+{
+   BddTree **cur, **bestseq, *first;
+   int num, size, best, steps;
+   int round, n;
+   double temp;
+
+   if (t == NULL  ||  t->next == NULL)
+      return t;
+   if ((cur=reorder_blockarray(t, &num)) == NULL)
+      return t;
+   if ((bestseq=NEW(BddTree*,num)) == NULL)
+   {
+      free(cur);
+      return t;
+   }
+   memcpy(bestseq, cur, sizeof(BddTree*)*num);
+
+   size = best = reorder_nodenum();
+   temp = annealstart * size;
+   steps = (annealsteps > 0 ? annealsteps : 4*num);
+
+   if (verbose > 1)
+      printf("Annealing %d blocks from %d nodes\n", num, size);
+
+   for (round=0 ; round<annealrounds  &&  !reorder_budgetdone() ; round++)
+   {
+      int accepted = 0;
+
+      for (n=0 ; n<steps ; n++)
+      {
+	 int pos = (int)reorder_stochrand(num-1);
+	 int newsize;
+
+	 reorder_swappos(cur, pos);
+	 newsize = reorder_nodenum();
+
+	 if (newsize <= size  ||
+	     (temp > 0.0  &&  reorder_stochreal() < exp((size-newsize)/temp)))
+	 {
+	    size = newsize;
+	    accepted++;
+
+	    if (size < best)
+	    {
+	       best = size;
+	       memcpy(bestseq, cur, sizeof(BddTree*)*num);
+	    }
+	 }
+	 else
+	    reorder_swappos(cur, pos);
+      }
+
+      if (verbose > 1)
+	 printf("Round %d: T=%.1f, %d accepted, %d nodes (best %d)\n",
+		round, temp, accepted, size, best);
+
+      temp *= annealcooling;
+   }
+
+   reorder_arrange(cur, bestseq, 0, num);
+   first = cur[0];
+
+   free(bestseq);
+   free(cur);
+
+   if (verbose)
+      printf("Annealing: %d nodes\n", reorder_nodenum());
+   return first;
+}
+
+
+/* Place the blocks in the order given by 'genes', which holds indices
+   into 'blk'
+*/
+static void reorder_arrangegenes(BddTree **cur, BddTree **blk, int *genes,
+				 int num)
+{
+   BddTree **seq = NEW(BddTree*,num);
+   int n;
+
+   if (seq == NULL)
+      return;
+
+   for (n=0 ; n<num ; n++)
+      seq[n] = blk[genes[n]];
+   reorder_arrange(cur, seq, 0, num);
+   free(seq);
+}
+
+
+/* Measure the size of 'count' orders in 'genes'
+ */
+static void reorder_evaluate(BddTree **cur, BddTree **blk, int *genes,
+			     int *fit, int num, int count)
+{
+   int n;
+
+   for (n=0 ; n<count ; n++)
+   {
+      reorder_arrangegenes(cur, blk, genes+n*num, num);
+      fit[n] = reorder_nodenum();
+   }
+}
+
+
+/* Pick the better of two random members of the population
+ */
+static int reorder_tournament(int *fit, int pop)
+{
+   int a = (int)reorder_stochrand(pop);
+   int b = (int)reorder_stochrand(pop);
+
+   if (fit[b] < fit[a]  ||  (fit[b] == fit[a]  &&  b < a))
+      return b;
+   return a;
+}
+
+
+/* Order crossover: the child gets a random slice from the first parent
+   and the remaining blocks in the sequence they have in the second
+*/
+static void reorder_crossover(int *a, int *b, int *child, char *used,
+			      int num)
+{
+   int from = (int)reorder_stochrand(num);
+   int to = (int)reorder_stochrand(num);
+   int n, k;
+
+   if (from > to)
+   {
+      n = from;
+      from = to;
+      to = n;
+   }
+
+   memset(used, 0, num);
+   for (n=from ; n<=to ; n++)
+   {
+      child[n] = a[n];
+      used[a[n]] = 1;
+   }
+
+   for (n=0,k=0 ; n<num ; n++)
+   {
+      if (used[b[n]])
+	 continue;
+      if (k == from)
+	 k = to+1;
+      child[k++] = b[n];
+   }
+}
+
+
+/* Reorder by a genetic search over block orders. Each generation makes
+   as many children as there are members, by crossover and mutation of
+   parents picked by tournament, and the best of the parents and the
+   children form the next generation. The first member is the current
+   order so the result is never worse.
+*/
+static BddTree *reorder_genetic(BddTree *t)
+{
+   BddTree **cur, **blk, *first;
+   int *genes, *fit, *rank, *tmp;
+   char *used;
+   int num, pop = geneticpopulation;
+   int gen, n, k;
+
+   if (t == NULL  ||  t->next == NULL)
+      return t;
+   if ((cur=reorder_blockarray(t, &num)) == NULL)
+      return t;
+
+   blk = NEW(BddTree*,num);
+   genes = NEW(int,2*pop*num);
+   tmp = NEW(int,pop*num);
+   fit = NEW(int,2*pop);
+   rank = NEW(int,2*pop);
+   used = NEW(char,num);
+   if (blk == NULL  ||  genes == NULL  ||  tmp == NULL  ||  fit == NULL  ||
+       rank == NULL  ||  used == NULL)
+   {
+      free(blk);
+      free(genes);
+      free(tmp);
+      free(fit);
+      free(rank);
+      free(used);
+      free(cur);
+      return t;
+   }
+   memcpy(blk, cur, sizeof(BddTree*)*num);
+
+      /* Start with the current order and random ones */
+   for (n=0 ; n<pop ; n++)
+   {
+      int *g = genes+n*num;
+
+      for (k=0 ; k<num ; k++)
+	 g[k] = k;
+      for (k=num-1 ; n>0  &&  k>0 ; k--)
+      {
+	 int j = (int)reorder_stochrand(k+1);
+	 int x = g[k];
+	 g[k] = g[j];
+	 g[j] = x;
+      }
+   }
+   fit[0] = reorder_nodenum();
+   reorder_evaluate(cur, blk, genes+num, fit+1, num, pop-1);
+
+   for (gen=0 ; gen<geneticgenerations  &&  !reorder_budgetdone() ; gen++)
+   {
+      for (n=0 ; n<pop ; n++)
+      {
+	 int *child = genes+(pop+n)*num;
+	 int a = reorder_tournament(fit, pop);
+	 int b = reorder_tournament(fit, pop);
+
+	 reorder_crossover(genes+a*num, genes+b*num, child, used, num);
+
+	    /* Mutate by swapping two blocks */
+	 if (reorder_stochrand(2))
+	 {
+	    int i = (int)reorder_stochrand(num);
+	    int j = (int)reorder_stochrand(num);
+	    int x = child[i];
+	    child[i] = child[j];
+	    child[j] = x;
+	 }
+      }
+
+      reorder_evaluate(cur, blk, genes+pop*num, fit+pop, num, pop);
+
+	 /* Keep the best, ties going to the parents */
+      for (n=0 ; n<2*pop ; n++)
+      {
+	 for (k=n ; k>0  &&  fit[rank[k-1]] > fit[n] ; k--)
+	    rank[k] = rank[k-1];
+	 rank[k] = n;
+      }
+
+      for (n=0 ; n<pop ; n++)
+      {
+	 memcpy(tmp+n*num, genes+rank[n]*num, sizeof(int)*num);
+	 rank[pop+n] = fit[rank[n]];
+      }
+      memcpy(genes, tmp, sizeof(int)*pop*num);
+      memcpy(fit, rank+pop, sizeof(int)*pop);
+
+      if (verbose > 1)
+	 printf("Generation %d: best %d, worst %d nodes\n",
+		gen, fit[0], fit[pop-1]);
+   }
+
+   reorder_arrangegenes(cur, blk, genes, num);
+   first = cur[0];
+
+   free(blk);
+   free(genes);
+   free(tmp);
+   free(fit);
+   free(rank);
+   free(used);
+   free(cur);
+
+   if (verbose)
+      printf("Genetic: %d nodes\n", reorder_nodenum());
+   return first;
+}
+
+
+/*=== Random reordering (mostly for debugging and test ) =============*/
+
+static BddTree *reorder_random(BddTree *t)
+{
+   BddTree *this;
+   BddTree **seq;
+   int n, num=0;
+
+   if (t == NULL)
+      return t;
+   
+   for (this=t ; this!=NULL ; this=this->next)
+      num++;
+   seq = NEW(BddTree*,num);
+   for (this=t,num=0 ; this!=NULL ; this=this->next)
+      seq[num++] = this;
+   
+   for (n=0 ; n<4*num ; n++)
+   {
+      int blk = random(num);
+      if (seq[blk]->next != NULL)
+	 blockdown(seq[blk]);
+   }
+
+      /* Find first block */
+   for (this=t ; this->prev != NULL ; this=this->prev)
+      /* nil */;
+
+   free(seq);
+
+   if (verbose)
+      printf("Random order: %d nodes\n", reorder_nodenum());
+   return this;
+}
+
+
+/*************************************************************************
+  Swapping adjacent blocks
+*************************************************************************/
+
+static void blockdown(BddTree *left)
+{
+   BddTree *right = left->next;
+   int n;
+   int leftsize = left->last - left->first;
+   int rightsize = right->last - right->first;
+   int leftstart = bddvar2level[left->seq[0]];
+   int *lseq = left->seq;
+   int *rseq = right->seq;
+
+      /* Move left past right */
+   while (bddvar2level[lseq[0]] < bddvar2level[rseq[rightsize]])
+   {
+      for (n=0 ; n<leftsize ; n++)
+      {
+	 if (bddvar2level[lseq[n]]+1  !=  bddvar2level[lseq[n+1]]
+	     && bddvar2level[lseq[n]]  <  bddvar2level[rseq[rightsize]])
+	 {
+	    reorder_vardown(lseq[n]);
+	 }
+      }
+
+      if (bddvar2level[lseq[leftsize]] <  bddvar2level[rseq[rightsize]])
+      {
+	 reorder_vardown(lseq[leftsize]);
+      }
+   }
+
+      /* Move right to where left started */
+   while (bddvar2level[rseq[0]] > leftstart)
+   {
+      for (n=rightsize ; n>0 ; n--)
+      {
+	 if (bddvar2level[rseq[n]]-1 != bddvar2level[rseq[n-1]]
+	     && bddvar2level[rseq[n]] > leftstart)
+	 {
+	    reorder_varup(rseq[n]);
+	 }
+      }
+
+      if (bddvar2level[rseq[0]] > leftstart)
+	 reorder_varup(rseq[0]);
+   }
+
+      /* Swap left and right data in the order */
+   left->next = right->next;
+   right->prev = left->prev;
+   left->prev = right;
+   right->next = left;
+
+   if (right->prev != NULL)
+      right->prev->next = right;
+   if (left->next != NULL)
+      left->next->prev = left;
+
+   n = left->pos;
+   left->pos = right->pos;
+   right->pos = n;
+}
+
+
+/*************************************************************************
+  Kernel reordering routines
+*************************************************************************/
+
+/*=== Garbage collection for reordering ================================*/
+
+/* Note: Node may be marked
+ */
+static void addref_rec(int r, char *dep)
+{
+   if (r < 2)
+      return;
+   
+   if (bddnodes[r].refcou == 0 || MARKED(r))
+   {
+      bddfreenum--;
+
+         /* Detect variable dependencies for the interaction matrix */
+      dep[VAR(r) & MARKHIDE] = 1;
 
          /* Make sure the nodenum field is updated. Used in the initial GBC */
       levels[VAR(r) & MARKHIDE].nodenum++;
@@ -840,21 +2175,20 @@ static void addref_rec(int r, char *dep)
 }
 
 
-static void addDependencies(char *dep)
+static void addDependencies(char *dep, int *support)
 {
-   int n,m;
+   int num, n, m;
 
-   for (n=0 ; n<bddvarnum ; n++)
-   {
-      for (m=n ; m<bddvarnum ; m++)
+   for (n=0,num=0 ; n<bddvarnum ; n++)
+      if (dep[n])
+	 support[num++] = n;
+   
+   for (n=0 ; n<num ; n++)
+      for (m=n ; m<num ; m++)
       {
-	 if (dep[n]  &&  dep[m])
-	 {
-	    imatrixSet(iactmtx, n,m);
-	    imatrixSet(iactmtx, m,n);
-	 }
+	 imatrixSet(iactmtx, support[n],support[m]);
+	 imatrixSet(iactmtx, support[m],support[n]);
       }
-   }
 }
 
 
@@ -865,6 +2199,7 @@ static void addDependencies(char *dep)
 static int mark_roots(void)
 {
    char *dep = NEW(char,bddvarnum);
+   int *support = NEW(int,bddvarnum);
    int n;
 
    for (n=2,extrootsize=0 ; n<bddnodesize ; n++)
@@ -882,6 +2217,7 @@ static int mark_roots(void)
    
    if ((extroots=(int*)(malloc(sizeof(int)*extrootsize))) == NULL)
    {
+      free(support);
       free(dep);
       return bdd_error(BDD_MEMORY);
    }
@@ -904,7 +2240,7 @@ static int mark_roots(void)
 	 addref_rec(LOWp(node), dep);
 	 addref_rec(HIGHp(node), dep);
 
-	 addDependencies(dep);
+	 addDependencies(dep, support);
       }
 
       /* Make sure the hash field is empty. This saves a loop in the
@@ -915,6 +2251,7 @@ static int mark_roots(void)
    bddnodes[0].hash = 0;
    bddnodes[1].hash = 0;
 
+   free(support);
    free(dep);
    return 0;
 }
@@ -1015,6 +2352,151 @@ static void reorder_rehashAll(void)
 }
 
 
+/*=== Node access for parallel reordering =============================*/
+
+/* Workers may share nodes below their own levels, so reference counts
+   and variables are updated atomically by them.
+*/
+static void reorder_incref(int n)
+{
+#ifdef HAVE_PTHREAD
+   if (worker != NULL)
+   {
+      unsigned int *p = (unsigned int*)&bddnodes[n];
+      nodeWord old, upd;
+
+      old.word = __atomic_load_n(p, __ATOMIC_RELAXED);
+      do
+      {
+	 if (old.f.refcou == MAXREF)
+	    return;
+	 upd = old;
+	 upd.f.refcou++;
+      }
+      while (!__atomic_compare_exchange_n(p, &old.word, upd.word, 1,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+      return;
+   }
+#endif
+   INCREF(n);
+}
+
+
+static void reorder_decref(int n)
+{
+#ifdef HAVE_PTHREAD
+   if (worker != NULL)
+   {
+      unsigned int *p = (unsigned int*)&bddnodes[n];
+      nodeWord old, upd;
+
+      old.word = __atomic_load_n(p, __ATOMIC_RELAXED);
+      do
+      {
+	 if (old.f.refcou == MAXREF  ||  old.f.refcou == 0)
+	    return;
+	 upd = old;
+	 upd.f.refcou--;
+      }
+      while (!__atomic_compare_exchange_n(p, &old.word, upd.word, 1,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+      return;
+   }
+#endif
+   DECREF(n);
+}
+
+
+static void reorder_setvar(BddNode *node, int var)
+{
+#ifdef HAVE_PTHREAD
+   if (worker != NULL)
+   {
+      unsigned int *p = (unsigned int*)node;
+      nodeWord old, upd;
+
+      old.word = __atomic_load_n(p, __ATOMIC_RELAXED);
+      do
+      {
+	 upd = old;
+	 upd.f.level = var;
+      }
+      while (!__atomic_compare_exchange_n(p, &old.word, upd.word, 1,
+					  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+      return;
+   }
+#endif
+   VARp(node) = var;
+}
+
+
+/* Make sure the current worker has at least 'num' free nodes of its own
+   and keep the node table in place until reorder_leave() is called. The
+   table is only resized when no other worker is inside a swap.
+*/
+static void reorder_enter(int num)
+{
+   if (worker == NULL)
+      return;
+
+   REORDER_LOCK();
+   while (worker->freenum < num  &&  !reorder_failed)
+   {
+      int r;
+      
+      if (bddfreepos == 0)
+      {
+	 REORDER_UNLOCK();
+	 REORDER_EXCLUSIVE();
+	 REORDER_LOCK();
+	 
+	 if (bddfreepos == 0)
+	 {
+	    if (bdd_noderesize(0) < 0  ||  bddfreepos == 0)
+	       reorder_failed = 1;
+	    else
+	       reorder_resized = 1;
+	 }
+	 
+	 REORDER_UNLOCK();
+	 REORDER_RELEASE();
+	 REORDER_LOCK();
+	 continue;
+      }
+
+      r = bddfreepos;
+      bddfreepos = bddnodes[r].next;
+      bddnodes[r].next = worker->freepos;
+      worker->freepos = r;
+      worker->freenum++;
+      bddfreenum--;
+   }
+   REORDER_UNLOCK();
+   
+   REORDER_SHARE();
+}
+
+
+static void reorder_leave(void)
+{
+   if (worker != NULL)
+      REORDER_RELEASE();
+}
+
+
+/* Size seen by a worker: its own levels plus what the rest of the node
+   table held when the worker was started. */
+static int reorder_localnodenum(void)
+{
+   int n, size = worker->offset;
+
+   for (n=worker->block->first ; n<=worker->block->last ; n++)
+      size += levels[n].nodenum;
+
+   return size;
+}
+
+
 /*=== Unique table handling for reordering =============================*/
 
 /* Note: rehashing must not take place during a makenode call. It is okay
@@ -1036,7 +2518,7 @@ static int reorder_makenode(int var, int low, int high)
       /* check whether childs are equal */
    if (low == high)
    {
-      INCREF(low);
+      reorder_incref(low);
       return low;
    }
 
@@ -1051,7 +2533,7 @@ static int reorder_makenode(int var, int low, int high)
 #ifdef CACHESTATS
 	 bddcachestats.uniqueHit++;
 #endif
-	 INCREF(res);
+	 reorder_incref(res);
 	 return res;
       }
       res = bddnodes[res].next;
@@ -1066,34 +2548,55 @@ static int reorder_makenode(int var, int low, int high)
    bddcachestats.uniqueMiss++;
 #endif
 
-      /* Any free nodes to use ? */
-   if (bddfreepos == 0)
+      /* Workers use the nodes reserved by reorder_enter() */
+   if (worker != NULL)
    {
-      if (bdderrorcond)
+      if (worker->freepos == 0)
+      {
+	 reorder_failed = 1;
 	 return 0;
+      }
       
-         /* Try to allocate more nodes - call noderesize without
-	  * enabling rehashing.
-          * Note: if ever rehashing is allowed here, then remember to
-	  * update local variable "hash" */
-      bdd_noderesize(0);
-      resizedInMakenode = 1;
-
-         /* Panic if that is not possible */
+      res = worker->freepos;
+      worker->freepos = bddnodes[res].next;
+      worker->freenum--;
+      worker->produced++;
+      levels[var].nodenum++;
+   }
+   else
+   {
+	 /* Any free nodes to use ? */
       if (bddfreepos == 0)
       {
-	 bdd_error(BDD_NODENUM);
-	 bdderrorcond = abs(BDD_NODENUM);
-	 return 0;
+	 if (bdderrorcond)
+	    return 0;
+	 
+	    /* Try to allocate more nodes - call noderesize without
+	     * enabling rehashing.
+	     * Note: if ever rehashing is allowed here, then remember to
+	     * update local variable "hash" */
+	 bdd_noderesize(0);
+	 resizedInMakenode = 1;
+	 
+	    /* Panic if that is not possible */
+	 if (bddfreepos == 0)
+	 {
+	    bdd_error(BDD_NODENUM);
+	    bdderrorcond = abs(BDD_NODENUM);
+	    return 0;
+	 }
       }
-   }
 
-      /* Build new node */
-   res = bddfreepos;
-   bddfreepos = bddnodes[bddfreepos].next;
-   levels[var].nodenum++;
-   bddproduced++;
-   bddfreenum--;
+         /* Build new node */
+      res = bddfreepos;
+      bddfreepos = bddnodes[bddfreepos].next;
+      levels[var].nodenum++;
+      bddproduced++;
+      bddfreenum--;
+   }
+   
+   if (res < keptnum)
+      keptnodes[res] = 0;
    
    node = &bddnodes[res];
    VARp(node) = var;
@@ -1106,8 +2609,8 @@ static int reorder_makenode(int var, int low, int high)
 
       /* Make sure it is reference counted */
    node->refcou = 1;
-   INCREF(LOWp(node));
-   INCREF(HIGHp(node));
+   reorder_incref(LOWp(node));
+   reorder_incref(HIGHp(node));
    
    return res;
 }
@@ -1140,7 +2643,8 @@ static int reorder_downSimple(int var0)
 	 BddNode *node = &bddnodes[r];
 	 int next = node->next;
 
-	 if (VAR(LOWp(node)) != var1  &&  VAR(HIGHp(node)) != var1)
+	 if (SHAREDVAR(LOWp(node)) != var1  &&
+	     SHAREDVAR(HIGHp(node)) != var1)
 	 {
  	       /* Node does not depend on next var, let it stay in the chain */
 	    node->next = bddnodes[n+vl0].hash;
@@ -1184,7 +2688,7 @@ static void reorder_swap(int toBeProcessed, int var0)
       int f00, f01, f10, f11, hash;
       
          /* Find the cofactors for the new nodes */
-      if (VAR(f0) == var1)
+      if (SHAREDVAR(f0) == var1)
       {
 	 f00 = LOW(f0);
 	 f01 = HIGH(f0);
@@ -1192,7 +2696,7 @@ static void reorder_swap(int toBeProcessed, int var0)
       else
 	 f00 = f01 = f0;
       
-      if (VAR(f1) == var1)
+      if (SHAREDVAR(f1) == var1)
       {
 	 f10 = LOW(f1);
 	 f11 = HIGH(f1);
@@ -1211,11 +2715,11 @@ static void reorder_swap(int toBeProcessed, int var0)
 	  * possible for the LOWp(node)/high nodes to come alive again,
 	  * so deref. of the childs is delayed until the local GBC. */
 
-      DECREF(LOWp(node));
-      DECREF(HIGHp(node));
+      reorder_decref(LOWp(node));
+      reorder_decref(HIGHp(node));
       
          /* Update in-place */
-      VARp(node) = var1;
+      reorder_setvar(node, var1);
       LOWp(node) = f0;
       HIGHp(node) = f1;
 	    
@@ -1253,21 +2757,30 @@ static void reorder_localGbc(int var0)
 	 BddNode *node = &bddnodes[r];
 	 int next = node->next;
 
-	 if (node->refcou > 0)
+	 if (SHAREDREFCOU(r) > 0)
 	 {
 	    node->next = bddnodes[hash].hash;
 	    bddnodes[hash].hash = r;
 	 }
 	 else
 	 {
-	    DECREF(LOWp(node));
-	    DECREF(HIGHp(node));
+	    reorder_decref(LOWp(node));
+	    reorder_decref(HIGHp(node));
 	    
 	    LOWp(node) = -1;
-	    node->next = bddfreepos; 
-	    bddfreepos = r;
+	    if (worker != NULL)
+	    {
+	       node->next = worker->freepos;
+	       worker->freepos = r;
+	       worker->freenum++;
+	    }
+	    else
+	    {
+	       node->next = bddfreepos; 
+	       bddfreepos = r;
+	       bddfreenum++;
+	    }
 	    levels[var1].nodenum--;
-	    bddfreenum++;
 	 }
 
 	 r = next;
@@ -1382,8 +2895,10 @@ static void reorder_localGbcResize(int toBeProcessed, int var0)
    else
       levels[var1].size = MIN(levels[var1].maxsize, levels[var1].size*2);
 
+      /* Workers must not touch the lrand48 state used by bdd_prime_lte */
    if (levels[var1].size >= 4)
-      levels[var1].size = bdd_prime_lte(levels[var1].size);
+      levels[var1].size = (worker ? bdd_prime_lte_fixed(levels[var1].size)
+			   : bdd_prime_lte(levels[var1].size));
 
       /* Rehash the remaining live nodes */
    while (toBeProcessed)
@@ -1462,10 +2977,18 @@ static int reorder_vardown(int var)
       return 0;
 
    resizedInMakenode = 0;
+   REORDER_COUNT(reorder_swaptotal);
+   if (worker)
+      worker->swaps++;
+   else
+      reorder_swaps++;
    
    if (imatrixDepends(iactmtx, var, bddlevel2var[level+1]))
    {
-      int toBeProcessed = reorder_downSimple(var);
+      int toBeProcessed;
+
+      reorder_enter(2*levels[var].nodenum);
+      toBeProcessed = reorder_downSimple(var);
 #ifdef USERESIZE
       levelData *l = &levels[var];
       
@@ -1481,6 +3004,7 @@ static int reorder_vardown(int var)
 	 reorder_swap(toBeProcessed, var);
 	 reorder_localGbc(var);
       }
+      reorder_leave();
    }
    
       /* Swap the var<->level tables */
@@ -1493,7 +3017,9 @@ static int reorder_vardown(int var)
    bddvar2level[ bddlevel2var[level] ] = n;
    
       /* Update all rename pairs */
+   REORDER_LOCK();
    bdd_pairs_vardown(level);
+   REORDER_UNLOCK();
 
    if (resizedInMakenode)
       reorder_rehashAll();
@@ -1634,6 +3160,13 @@ static int reorder_init(void)
       /* Garbage collect and rehash to new scheme */
    reorder_gbc();
 
+   keptnum = 0;
+   if ((keptnodes=NEW(char,bddnodesize)) != NULL)
+   {
+      memset(keptnodes, 1, bddnodesize);
+      keptnum = bddnodesize;
+   }
+   
    return 0;
 }
 
@@ -1662,15 +3195,166 @@ static void reorder_done(void)
    printf("\n");
 #endif
    
-#if 0
-   for (n=0 ; n<bddvarnum ; n++)
-      printf("%3d: %4d nodes , %4d entries\n", n, levels[n].nodenum,
-	     levels[n].size);
-#endif
-   free(extroots);
-   free(levels);
-   imatrixDelete(iactmtx);
-   bdd_gbc();
+#if 0
+   for (n=0 ; n<bddvarnum ; n++)
+      printf("%3d: %4d nodes , %4d entries\n", n, levels[n].nodenum,
+	     levels[n].size);
+#endif
+   free(extroots);
+   free(levels);
+   imatrixDelete(iactmtx);
+   bddreordered++;
+
+   bdd_operator_reorder(keptnodes, keptnum);
+   free(keptnodes);
+   keptnodes = NULL;
+   keptnum = 0;
+   
+   bdd_gbc();
+}
+
+
+/* Reorder all the subtrees of 't' as separate tasks. Each task takes a
+   free list of its own and the tasks are spread over the requested
+   number of threads.
+*/
+static void *reorder_thread(void *arg)
+{
+   while (1)
+   {
+      int n;
+      
+      REORDER_LOCK();
+      n = reorder_tasknext++;
+      REORDER_UNLOCK();
+
+      if (n >= reorder_tasknum)
+	 break;
+
+      worker = &reorder_tasks[n];
+      reorder_block(worker->block, reorder_taskmethod);
+      worker = NULL;
+   }
+
+   return arg;
+}
+
+
+static void reorder_children(BddTree *t, int method)
+{
+   BddTree *this;
+   int size = bdd_getnodenum();
+   int stochastic = (method == BDD_REORDER_RANDOM  ||
+		     method == BDD_REORDER_ANNEAL  ||
+		     method == BDD_REORDER_GENETIC);
+   int n, num;
+
+   for (this=t->nextlevel,num=0 ; this!=NULL ; this=this->next)
+      num++;
+   
+   if ((reorder_tasks=NEW(reorderWorker,num)) == NULL)
+   {
+      for (this=t->nextlevel ; this ; this=this->next)
+	 reorder_block(this, method);
+      return;
+   }
+
+   for (this=t->nextlevel,n=0 ; this!=NULL ; this=this->next,n++)
+   {
+      reorderWorker *w = &reorder_tasks[n];
+      int v;
+
+      w->block = this;
+      w->offset = size;
+      for (v=this->first ; v<=this->last ; v++)
+	 w->offset -= levels[v].nodenum;
+      w->freepos = 0;
+      w->freenum = 0;
+      w->produced = 0;
+      w->swaps = 0;
+      for (v=0 ; v<3 ; v++)
+	 w->seed[v] = (stochastic ? (unsigned short)nrand48(reorderseed) : 0);
+   }
+
+   reorder_tasknum = num;
+   reorder_tasknext = 0;
+   reorder_taskmethod = method;
+   reorder_nodenum = reorder_localnodenum;
+   
+#ifdef HAVE_PTHREAD
+   {
+      int threadnum = MIN(reorderthreads, num) - 1;
+      pthread_t *threads = NULL;
+      int started = 0;
+
+      if (threadnum > 0  &&  (threads=NEW(pthread_t,threadnum)) != NULL)
+	 for (started=0 ; started<threadnum ; started++)
+	    if (pthread_create(&threads[started], NULL, reorder_thread, NULL))
+	       break;
+      
+      reorder_thread(NULL);
+      
+      for (n=0 ; n<started ; n++)
+	 pthread_join(threads[n], NULL);
+      free(threads);
+   }
+#else
+   reorder_thread(NULL);
+#endif
+
+   reorder_nodenum = bdd_getnodenum;
+
+      /* Return the private free lists */
+   for (n=0 ; n<num ; n++)
+   {
+      reorderWorker *w = &reorder_tasks[n];
+
+      while (w->freepos != 0)
+      {
+	 int r = w->freepos;
+	 w->freepos = bddnodes[r].next;
+	 bddnodes[r].next = bddfreepos;
+	 bddfreepos = r;
+      }
+      
+      bddfreenum += w->freenum;
+      bddproduced += w->produced;
+   }
+   
+   free(reorder_tasks);
+   reorder_tasks = NULL;
+
+   if (reorder_resized)
+   {
+      reorder_rehashAll();
+      reorder_resized = 0;
+   }
+   
+   if (reorder_failed)
+   {
+      reorder_failed = 0;
+      bdd_error(BDD_NODENUM);
+      bdderrorcond = abs(BDD_NODENUM);
+   }
+}
+
+
+/* The subtrees of 't' are reordered as tasks when there are at least two
+   of them and one has blocks of its own to reorder. Tasks are only used
+   when two or more threads are asked for, so a default reordering works
+   as it always did.
+*/
+static int reorder_hastasks(BddTree *t)
+{
+   BddTree *this;
+
+   if (t->nextlevel == NULL  ||  t->nextlevel->next == NULL)
+      return 0;
+   
+   for (this=t->nextlevel ; this!=NULL ; this=this->next)
+      if (this->nextlevel != NULL)
+	 return 1;
+   return 0;
 }
 
 
@@ -1719,11 +3403,36 @@ static BddTree *reorder_block(BddTree *t, int method)
       case BDD_REORDER_RANDOM:
 	 t->nextlevel = reorder_random(t->nextlevel);
 	 break;
+      case BDD_REORDER_SIFT_SYM:
+	 t->nextlevel = reorder_siftsym(t->nextlevel);
+	 break;
+      case BDD_REORDER_SIFT_SYMITE:
+	 t->nextlevel = reorder_siftsymite(t->nextlevel);
+	 break;
+      case BDD_REORDER_EXACT:
+	 t->nextlevel = reorder_exact(t->nextlevel);
+	 break;
+      case BDD_REORDER_WIN4:
+	 t->nextlevel = reorder_wink(t->nextlevel, 4);
+	 break;
+      case BDD_REORDER_WINK:
+	 t->nextlevel = reorder_wink(t->nextlevel, reorderwindow);
+	 break;
+      case BDD_REORDER_ANNEAL:
+	 t->nextlevel = reorder_anneal(t->nextlevel);
+	 break;
+      case BDD_REORDER_GENETIC:
+	 t->nextlevel = reorder_genetic(t->nextlevel);
+	 break;
       }
    }
 
-   for (this=t->nextlevel ; this ; this=this->next)
-      reorder_block(this, method);
+   if (worker == NULL  &&  reorderthreads > 1  &&
+       reorder_nodenum == bdd_getnodenum  &&  reorder_hastasks(t))
+      reorder_children(t, method);
+   else
+      for (this=t->nextlevel ; this ; this=this->next)
+	 reorder_block(this, method);
 
    if (t->seq != NULL)
       qsort(t->seq, t->last-t->first+1, sizeof(int), varseqCmp);
@@ -1747,6 +3456,8 @@ void bdd_reorder(int method)
       return;
 
    usednum_before = bddnodesize - bddfreenum;
+   reorder_swaptotal = 0;
+   reorder_starttime = reorder_msec();
    
    top->first = 0;
    top->last = bdd_varnum()-1;
@@ -1763,6 +3474,8 @@ void bdd_reorder(int method)
    reorder_done();
    bddreordermethod = savemethod;
    bddreordertimes = savetimes;
+
+   profile_savebest();
 }
 
 
@@ -1846,6 +3559,119 @@ int bdd_reorder_verbose(int v)
 }
 
 
+int bdd_reorder_window(int size)
+{
+   int tmp = reorderwindow;
+
+   if (size < 2)
+      return bdd_error(BDD_RANGE);
+   
+   reorderwindow = size;
+   return tmp;
+}
+
+
+int bdd_reorder_exactlimit(int num)
+{
+   int tmp = reorderexactlimit;
+
+   if (num < 1  ||  num > 20)
+      return bdd_error(BDD_RANGE);
+   
+   reorderexactlimit = num;
+   return tmp;
+}
+
+
+int bdd_reorder_threads(int num)
+{
+   int tmp = reorderthreads;
+
+   if (num < 0)
+      return bdd_error(BDD_RANGE);
+   
+   reorderthreads = num;
+   return tmp;
+}
+
+
+int bdd_reorder_maxswaps(int num)
+{
+   int tmp = reordermaxswaps;
+
+   if (num < 0)
+      return bdd_error(BDD_RANGE);
+   
+   reordermaxswaps = num;
+   return tmp;
+}
+
+
+int bdd_reorder_maxtime(int msec)
+{
+   int tmp = reordermaxtime;
+
+   if (msec < 0)
+      return bdd_error(BDD_RANGE);
+   
+   reordermaxtime = msec;
+   return tmp;
+}
+
+
+int bdd_reorder_maxgrowth(int percent)
+{
+   int tmp = reordergrowth;
+
+   if (percent < 0)
+      return bdd_error(BDD_RANGE);
+   
+   reordergrowth = percent;
+   return tmp;
+}
+
+
+int bdd_reorder_anneal(double start, double cooling, int rounds, int steps)
+{
+   if (start < 0.0  ||  cooling <= 0.0  ||  cooling > 1.0  ||
+       rounds < 0  ||  steps < 0)
+      return bdd_error(BDD_RANGE);
+
+   annealstart = start;
+   annealcooling = cooling;
+   annealrounds = rounds;
+   annealsteps = steps;
+   return 0;
+}
+
+
+int bdd_reorder_genetic(int population, int generations)
+{
+   if (population < 2  ||  generations < 0)
+      return bdd_error(BDD_RANGE);
+
+   geneticpopulation = population;
+   geneticgenerations = generations;
+   return 0;
+}
+
+
+void bdd_reorder_seed(long seed)
+{
+   reorderseed[0] = 0x330E;
+   reorderseed[1] = (unsigned short)seed;
+   reorderseed[2] = (unsigned short)(seed >> 16);
+}
+
+
+bddsifthandler bdd_sift_hook(bddsifthandler handler)
+{
+   bddsifthandler tmp = sift_handler;
+   sift_handler = handler;
+   return tmp;
+}
+
+
 bddsizehandler bdd_reorder_probe(bddsizehandler handler)
 {
    bddsizehandler old = reorder_nodenum;
@@ -1994,5 +3820,391 @@ void bdd_fprintorder(FILE *ofile)
 }
 
 
+/*=== Order profiles ===================================================*/
+
+/* An order profile is the variable order and the block tree written as
+   integers:
+
+     varnum blocknum
+     level2var[0] ... level2var[varnum-1]
+     topnum
+     first last fixed id subnum      (blocknum times)
+
+   The blocks are written in pre-order, each followed by the 'subnum'
+   blocks on its next level. A profile loaded before all its variables
+   exist is kept in 'profile' until bdd_setvarnum() makes them.
+*/
+
+static int blocks_count(BddTree *t, int all)
+{
+   int num = 0;
+
+   for ( ; t != NULL ; t=t->next)
+      num += 1 + (all ? blocks_count(t->nextlevel, 1) : 0);
+   return num;
+}
+
+
+static void save_blocks_rec(FILE *ofile, BddTree *t)
+{
+   for ( ; t != NULL ; t=t->next)
+   {
+      fprintf(ofile, "%d %d %d %d %d\n", t->first, t->last, t->fixed,
+	      t->id, blocks_count(t->nextlevel, 0));
+      save_blocks_rec(ofile, t->nextlevel);
+   }
+}
+
+
+int bdd_fnsaveorder(char *fname)
+{
+   FILE *ofile;
+   int ok;
+
+   if ((ofile=fopen(fname,"w")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_saveorder(ofile);
+   if (fclose(ofile) != 0  &&  ok == 0)
+      return bdd_error(BDD_FILE);
+   return ok;
+}
+
+
+static int save_order(FILE *ofile)
+{
+   int n;
+   
+   fprintf(ofile, "%d %d\n", bddvarnum, blocks_count(vartree, 1));
+   for (n=0 ; n<bddvarnum ; n++)
+      fprintf(ofile, "%d ", bddlevel2var[n]);
+   fprintf(ofile, "\n%d\n", blocks_count(vartree, 0));
+   save_blocks_rec(ofile, vartree);
+
+   return ferror(ofile) ? -1 : 0;
+}
+
+
+int bdd_saveorder(FILE *ofile)
+{
+   if (save_order(ofile) < 0)
+      return bdd_error(BDD_FILE);
+   return 0;
+}
+
+
+/* Rebuild 'num' blocks on one level of the tree from block[*pos] of the
+   'blocknum' blocks, checking that each covers a range of levels inside
+   'first...last'. Returns -1 on an inconsistent profile.
+*/
+static int load_blocks_rec(BddTree **list, int *block, int blocknum,
+			   int num, int *pos, int first, int last)
+{
+   BddTree *prev = NULL;
+   int n, v;
+
+   *list = NULL;
+   
+   for (n=0 ; n<num ; n++)
+   {
+      int *b = &block[*pos * 5];
+      int top = INT_MAX, bottom = -1;
+      BddTree *t;
+
+      if (*pos >= blocknum  ||  b[0] < first  ||  b[1] > last  ||
+	  b[1] < b[0]  ||  b[3] < 0  ||  b[4] < 0)
+	 return -1;
+
+         /* Siblings must not share variables */
+      for (t=*list ; t!=NULL ; t=t->next)
+	 if (b[0] <= t->last  &&  t->first <= b[1])
+	    return -1;
+      
+      for (v=b[0] ; v<=b[1] ; v++)
+      {
+	 top = MIN(top, bddvar2level[v]);
+	 bottom = MAX(bottom, bddvar2level[v]);
+      }
+      if (bottom-top != b[1]-b[0])
+	 return -1;
+      
+      if ((t=bddtree_newrange(b[0], b[1], b[2] != 0, b[3])) == NULL)
+	 return -1;
+      t->prev = prev;
+      if (prev == NULL)
+	 *list = t;
+      else
+	 prev->next = t;
+      prev = t;
+      
+      blockid = MAX(blockid, b[3]+1);
+      (*pos)++;
+      
+      if (load_blocks_rec(&t->nextlevel, block, blocknum, b[4], pos,
+			  b[0], b[1]) < 0)
+	 return -1;
+   }
+
+   return 0;
+}
+
+
+/* Set the order and blocks from the profile. Variables that were not in
+   the profile keep their relative order below the others.
+*/
+static int profile_apply(void)
+{
+   int *neworder, *oldorder, *placed;
+   int n, level = 0, pos = 0, err = 0;
+   int oldblockid = blockid;
+   BddTree *tree, *oldtree = vartree;
+
+   if ((neworder=NEW(int,bddvarnum)) == NULL)
+      return bdd_error(BDD_MEMORY);
+   if ((oldorder=NEW(int,bddvarnum)) == NULL)
+   {
+      free(neworder);
+      return bdd_error(BDD_MEMORY);
+   }
+   if ((placed=NEW(int,bddvarnum)) == NULL)
+   {
+      free(oldorder);
+      free(neworder);
+      return bdd_error(BDD_MEMORY);
+   }
+   memset(placed, 0, sizeof(int)*bddvarnum);
+   memcpy(oldorder, bddlevel2var, sizeof(int)*bddvarnum);
+   
+   for (n=0 ; n<profile.varnum ; n++)
+   {
+      neworder[level++] = profile.order[n];
+      placed[profile.order[n]] = 1;
+   }
+   for (n=0 ; n<bddvarnum ; n++)
+      if (!placed[bddlevel2var[n]])
+	 neworder[level++] = bddlevel2var[n];
+
+      /* The old order and blocks come back if the blocks do not fit */
+   vartree = NULL;
+   blockid = 0;
+   bdd_setvarorder(neworder);
+
+   if (load_blocks_rec(&tree, profile.block, profile.blocknum,
+		       profile.topnum, &pos, 0, profile.varnum-1) < 0  ||
+       pos != profile.blocknum)
+   {
+      bddtree_del(tree);
+      bdd_setvarorder(oldorder);
+      vartree = oldtree;
+      blockid = oldblockid;
+      err = bdd_error(BDD_FORMAT);
+   }
+   else
+   {
+      bddtree_del(oldtree);
+      vartree = tree;
+   }
+   
+   free(placed);
+   free(oldorder);
+   free(neworder);
+   profile_clear();
+   return err;
+}
+
+
+static void profile_clear(void)
+{
+   free(profile.order);
+   free(profile.block);
+   profile.order = profile.block = NULL;
+   profile.varnum = 0;
+}
+
+
+/* Called by bdd_setvarnum() when new variables have been made
+ */
+void bdd_reorder_varresize(void)
+{
+   if (profile.order != NULL  &&  bddvarnum >= profile.varnum)
+      profile_apply();
+}
+
+
+int bdd_fnloadorder(char *fname)
+{
+   FILE *ifile;
+   int ok;
+
+   if ((ifile=fopen(fname,"r")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_loadorder(ifile);
+   fclose(ifile);
+   return ok;
+}
+
+
+int bdd_loadorder(FILE *ifile)
+{
+   int *seen;
+   int n;
+   
+   profile_clear();
+   
+   if (fscanf(ifile, "%d %d", &profile.varnum, &profile.blocknum) != 2  ||
+       profile.varnum < 1  ||  profile.varnum > MAXVAR  ||
+       profile.blocknum < 0)
+   {
+      profile.varnum = 0;
+      return bdd_error(BDD_FORMAT);
+   }
+   
+   if ((profile.order=NEW(int,profile.varnum)) == NULL  ||
+       (profile.block=NEW(int,profile.blocknum*5+1)) == NULL  ||
+       (seen=NEW(int,profile.varnum)) == NULL)
+   {
+      profile_clear();
+      return bdd_error(BDD_MEMORY);
+   }
+   memset(seen, 0, sizeof(int)*profile.varnum);
+
+   for (n=0 ; n<profile.varnum ; n++)
+   {
+      int *v = &profile.order[n];
+      
+      if (fscanf(ifile, "%d", v) != 1  ||
+	  *v < 0  ||  *v >= profile.varnum  ||  seen[*v]++)
+      {
+	 free(seen);
+	 profile_clear();
+	 return bdd_error(BDD_FORMAT);
+      }
+   }
+   free(seen);
+
+   if (fscanf(ifile, "%d", &profile.topnum) != 1)
+   {
+      profile_clear();
+      return bdd_error(BDD_FORMAT);
+   }
+   for (n=0 ; n<profile.blocknum*5 ; n++)
+      if (fscanf(ifile, "%d", &profile.block[n]) != 1)
+      {
+	 profile_clear();
+	 return bdd_error(BDD_FORMAT);
+      }
+
+   if (bddvarnum >= profile.varnum)
+      return profile_apply();
+   return 0;
+}
+
+
+static void get_blocks_rec(BddTree *t, int *block, int *pos)
+{
+   for ( ; t != NULL ; t=t->next)
+   {
+      int *b = &block[(*pos)++ * 5];
+      
+      b[0] = t->first;
+      b[1] = t->last;
+      b[2] = t->fixed;
+      b[3] = t->id;
+      b[4] = blocks_count(t->nextlevel, 0);
+      get_blocks_rec(t->nextlevel, block, pos);
+   }
+}
+
+
+/* Returns a new array with the block tree in the same layout as in the
+   profiles, setting 'num' to the number of blocks and 'topnum' to the
+   number of top level blocks. Used for checkpoints, which report a NULL
+   result as running out of memory.
+*/
+int *bdd_reorder_getblocks(int *num, int *topnum)
+{
+   int *block;
+   int pos = 0;
+
+   *num = blocks_count(vartree, 1);
+   *topnum = blocks_count(vartree, 0);
+   if ((block=NEW(int,*num*5+1)) == NULL)
+      return NULL;
+
+   get_blocks_rec(vartree, block, &pos);
+   return block;
+}
+
+
+/* Replaces the block tree with the 'num' blocks in 'block' as returned
+   by bdd_reorder_getblocks() for the current order.
+*/
+int bdd_reorder_setblocks(int *block, int num, int topnum)
+{
+   BddTree *tree;
+   int pos = 0;
+
+   bdd_clrvarblocks();
+   if (load_blocks_rec(&tree, block, num, topnum, &pos, 0, bddvarnum-1) < 0
+       ||  pos != num)
+   {
+      bddtree_del(tree);
+      blockid = 0;
+      return bdd_error(BDD_FORMAT);
+   }
+
+   vartree = tree;
+   return 0;
+}
+
+
+/* Save the order after a reordering that reduced the number of nodes.
+   The profile is written to a new file that then replaces the old one,
+   so a crash never leaves a partial profile. Errors are ignored since
+   the old profile is still usable.
+*/
+static void profile_savebest(void)
+{
+   char *tmpname;
+   FILE *ofile;
+
+   if (bestorderfile == NULL  ||  usednum_after >= usednum_before)
+      return;
+   if ((tmpname=NEW(char,strlen(bestorderfile)+5)) == NULL)
+      return;
+   sprintf(tmpname, "%s.tmp", bestorderfile);
+
+   if ((ofile=fopen(tmpname,"w")) != NULL)
+   {
+      int ok = save_order(ofile);
+      
+      if (fclose(ofile) == 0  &&  ok == 0)
+	 rename(tmpname, bestorderfile);
+      else
+	 remove(tmpname);
+   }
+   
+   free(tmpname);
+}
+
+
+int bdd_reorder_bestfile(char *fname)
+{
+   char *name = NULL;
+   
+   if (fname != NULL)
+   {
+      if ((name=NEW(char,strlen(fname)+1)) == NULL)
+	 return bdd_error(BDD_MEMORY);
+      strcpy(name, fname);
+   }
+
+   free(bestorderfile);
+   bestorderfile = name;
+   return 0;
+}
+
+
 
 /* EOF */
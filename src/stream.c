@@ -0,0 +1,753 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  stream.c
+  DESCR: Streams of BDDs written incrementally
+*************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "kernel.h"
+
+/* A stream is a sequence of roots where each root only adds the nodes
+   that were not written for an earlier root. The file is
+
+     magic     "BDDS"
+     version
+     blocks    rawsize, codesize, checksum, data[codesize or rawsize]
+     end       rawsize zero (may be missing if the writer never finished)
+
+   The blocks hold the records as a plain byte stream, compressed when
+   'codesize' is non-zero. The checksum is FNV-1a of the uncompressed
+   bytes, written as four bytes with the low byte first. Each record adds
+   one root:
+
+     nodenum   nodenum * (var, id-low, id-high)
+     root      nextid-root
+
+   The constants have ids 0 and 1 and the nodes get the ids 2, 3, ... in
+   the order they are written, over all records. Children are written as
+   the distance back from the node and the root as the distance back from
+   the next free id, all as varints like in binio.c. Records may continue
+   from one block into the next.
+
+   The compression is a small LZ77 coder. A block is a list of sequences
+
+     litnum, literals[litnum], matchlen, offset
+
+   copying 'matchlen' bytes from 'offset' bytes back after the literals.
+   A zero 'matchlen' ends the block and has no offset.
+*/
+
+#define STREAM_MAGIC     "BDDS"
+#define STREAM_VERSION   1
+#define STREAM_BLOCKSIZE 65536
+
+#define FNV_OFFSET   2166136261U
+#define FNV_PRIME    16777619U
+
+#define LZ_MINMATCH  4
+#define LZ_HASHBITS  12
+
+struct s_bddStream
+{
+   FILE *file;
+   int   ownfile;        /* Close 'file' when the stream is closed */
+   int   flags;
+   unsigned char *raw;   /* Records not yet written */
+   int   rawpos;
+   unsigned char *code;  /* Room for one compressed block */
+   int  *map;            /* Per node index: id, var, low id, high id */
+   int   mapsize;        /* Number of node indices in 'map' */
+   int   nextid;         /* Id of the next node written */
+   int   rootnum;
+   int   err;            /* Set by any write failure */
+};
+
+typedef struct s_StreamReader
+{
+   FILE *file;
+   unsigned char *raw;
+   unsigned char *code;
+   int   pos;            /* Next byte in 'raw' */
+   int   size;           /* Bytes in 'raw' */
+   int   end;            /* Set at the end of the stream */
+   int   err;            /* Set on any damaged block */
+} StreamReader;
+
+
+/*=== LZ CODEC =========================================================*/
+
+static int lz_putnum(unsigned char *out, int pos, int cap, unsigned int n)
+{
+   while (n >= 0x80)
+   {
+      if (pos >= cap)
+	 return -1;
+      out[pos++] = (n & 0x7F) | 0x80;
+      n >>= 7;
+   }
+   if (pos >= cap)
+      return -1;
+   out[pos++] = n;
+   return pos;
+}
+
+
+static int lz_getnum(const unsigned char *in, int *pos, int size)
+{
+   unsigned int n = 0;
+   int shift;
+
+   for (shift=0 ; shift<35  &&  *pos<size ; shift+=7)
+   {
+      int c = in[(*pos)++];
+      n |= (unsigned int)(c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+	 return n > (unsigned int)INT_MAX ? -1 : (int)n;
+   }
+   return -1;
+}
+
+
+static int lz_literals(unsigned char *out, int pos, int cap,
+		       const unsigned char *lit, int num)
+{
+   if ((pos=lz_putnum(out, pos, cap, num)) < 0  ||  pos+num > cap)
+      return -1;
+   memcpy(out+pos, lit, num);
+   return pos+num;
+}
+
+
+/* Compress 'size' bytes from 'in' into at most 'cap' bytes of 'out'.
+   Returns the compressed size, or zero if it does not fit.
+*/
+static int lz_compress(const unsigned char *in, int size,
+		       unsigned char *out, int cap)
+{
+   int hash[1 << LZ_HASHBITS];
+   int pos = 0, lit = 0, o = 0;
+
+   memset(hash, 0, sizeof(hash));
+
+   while (pos+LZ_MINMATCH <= size)
+   {
+      unsigned int h = (in[pos] | in[pos+1] << 8 | in[pos+2] << 16 |
+			(unsigned int)in[pos+3] << 24) * 2654435761U;
+      int cand;
+
+      h >>= 32 - LZ_HASHBITS;
+      cand = hash[h] - 1;
+      hash[h] = pos + 1;
+      
+      if (cand >= 0  &&  memcmp(in+cand, in+pos, LZ_MINMATCH) == 0)
+      {
+	 int len = LZ_MINMATCH;
+
+	 while (pos+len < size  &&  in[cand+len] == in[pos+len])
+	    len++;
+
+	 if ((o=lz_literals(out, o, cap, in+lit, pos-lit)) < 0  ||
+	     (o=lz_putnum(out, o, cap, len)) < 0  ||
+	     (o=lz_putnum(out, o, cap, pos-cand)) < 0)
+	    return 0;
+	 
+	 pos += len;
+	 lit = pos;
+      }
+      else
+	 pos++;
+   }
+
+   if ((o=lz_literals(out, o, cap, in+lit, size-lit)) < 0  ||
+       (o=lz_putnum(out, o, cap, 0)) < 0)
+      return 0;
+   return o;
+}
+
+
+/* Expand 'codesize' bytes from 'in' to exactly 'size' bytes in 'out'.
+   Returns -1 on damaged data.
+*/
+static int lz_expand(const unsigned char *in, int codesize,
+		     unsigned char *out, int size)
+{
+   int pos = 0, o = 0;
+
+   while (1)
+   {
+      int lit, len, offset;
+
+      if ((lit=lz_getnum(in, &pos, codesize)) < 0  ||
+	  lit > codesize-pos  ||  lit > size-o)
+	 return -1;
+      memcpy(out+o, in+pos, lit);
+      pos += lit;
+      o += lit;
+
+      if ((len=lz_getnum(in, &pos, codesize)) < 0)
+	 return -1;
+      if (len == 0)
+	 break;
+      
+      if ((offset=lz_getnum(in, &pos, codesize)) < 1  ||  offset > o  ||
+	  len > size-o)
+	 return -1;
+	 /* The match may overlap the bytes it makes */
+      for ( ; len > 0 ; len--, o++)
+	 out[o] = out[o-offset];
+   }
+
+   return (pos == codesize  &&  o == size) ? 0 : -1;
+}
+
+
+/*=== WRITING ==========================================================*/
+
+static void stream_putnum(FILE *ofile, unsigned int n)
+{
+   while (n >= 0x80)
+   {
+      putc((n & 0x7F) | 0x80, ofile);
+      n >>= 7;
+   }
+   putc(n, ofile);
+}
+
+
+static unsigned int stream_checksum(const unsigned char *data, int size)
+{
+   unsigned int sum = FNV_OFFSET;
+   int n;
+
+   for (n=0 ; n<size ; n++)
+      sum = (sum ^ data[n]) * FNV_PRIME;
+   return sum;
+}
+
+
+/* Write the records collected so far as one block */
+static void stream_block(bddStream *s)
+{
+   unsigned int sum;
+   int codesize = 0, n;
+
+   if (s->rawpos == 0)
+      return;
+   
+   if (s->flags & BDD_STREAM_LZ)
+      codesize = lz_compress(s->raw, s->rawpos, s->code, s->rawpos-1);
+   sum = stream_checksum(s->raw, s->rawpos);
+
+   stream_putnum(s->file, s->rawpos);
+   stream_putnum(s->file, codesize);
+   for (n=0 ; n<4 ; n++)
+      putc((sum >> (8*n)) & 0xFF, s->file);
+   
+   if (codesize > 0)
+      n = fwrite(s->code, 1, codesize, s->file) != (size_t)codesize;
+   else
+      n = fwrite(s->raw, 1, s->rawpos, s->file) != (size_t)s->rawpos;
+   if (n  ||  ferror(s->file))
+      s->err = 1;
+   
+   s->rawpos = 0;
+}
+
+
+static void stream_putbyte(bddStream *s, unsigned int c)
+{
+   if (s->rawpos == STREAM_BLOCKSIZE)
+      stream_block(s);
+   s->raw[s->rawpos++] = c;
+}
+
+
+static void stream_putrec(bddStream *s, unsigned int n)
+{
+   while (n >= 0x80)
+   {
+      stream_putbyte(s, (n & 0x7F) | 0x80);
+      n >>= 7;
+   }
+   stream_putbyte(s, n);
+}
+
+
+bddStream *bdd_stream_open(FILE *ofile, int flags)
+{
+   bddStream *s;
+   int n;
+
+   if ((s=NEW(bddStream,1)) == NULL)
+   {
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+   memset(s, 0, sizeof(bddStream));
+   
+   s->raw = NEW(unsigned char,STREAM_BLOCKSIZE);
+   s->code = NEW(unsigned char,STREAM_BLOCKSIZE);
+   if (s->raw == NULL  ||  s->code == NULL)
+   {
+      free(s->raw);
+      free(s->code);
+      free(s);
+      bdd_error(BDD_MEMORY);
+      return NULL;
+   }
+
+   s->file = ofile;
+   s->flags = flags;
+   s->nextid = 2;
+
+   for (n=0 ; n<4 ; n++)
+      putc(STREAM_MAGIC[n], ofile);
+   stream_putnum(ofile, STREAM_VERSION);
+   
+   return s;
+}
+
+
+bddStream *bdd_stream_fnopen(char *fname, int flags)
+{
+   FILE *ofile;
+   bddStream *s;
+
+   if ((ofile=fopen(fname,"wb")) == NULL)
+   {
+      bdd_error(BDD_FILE);
+      return NULL;
+   }
+
+   if ((s=bdd_stream_open(ofile, flags)) == NULL)
+   {
+      fclose(ofile);
+      return NULL;
+   }
+   s->ownfile = 1;
+   
+   return s;
+}
+
+
+/* The id of node 'n' as known by the stream, which is only valid for the
+   nodes already handled by bdd_stream_add() */
+static int stream_id(bddStream *s, int n)
+{
+   return n < 2 ? n : s->map[n*4];
+}
+
+
+int bdd_stream_add(bddStream *s, BDD r)
+{
+   int *cone, *added;
+   int n, num, addnum = 0;
+
+   CHECK(r);
+   if (s->err)
+      return bdd_error(BDD_FILE);
+
+   if (s->mapsize < bddnodesize)
+   {
+      int *tmp_ptr = (int*)realloc(s->map, sizeof(int)*4*bddnodesize);
+      if (tmp_ptr == NULL)
+	 return bdd_error(BDD_MEMORY);
+      s->map = tmp_ptr;
+      for (n=s->mapsize ; n<bddnodesize ; n++)
+	 s->map[n*4] = -1;
+      s->mapsize = bddnodesize;
+   }
+
+   if ((cone=bdd_postorder(&r, 1, &num)) == NULL)
+      return BDD_MEMORY;
+
+      /* Node numbers are reused after garbage collections and reordering
+       * changes the nodes, so a node is only known if it still has the
+       * variable and children it had when written. As the children come
+       * first that also holds for them, so the node is the same function.
+       * The new nodes are collected at the front of 'cone'. */
+   added = cone;
+   for (n=0 ; n<num ; n++)
+   {
+      int node = cone[n];
+      int *m = &s->map[node*4];
+      int var = bddlevel2var[LEVEL(node)];
+      int low = stream_id(s, LOW(node));
+      int high = stream_id(s, HIGH(node));
+
+      if (m[0] < 0  ||  m[1] != var  ||  m[2] != low  ||  m[3] != high)
+      {
+	 m[0] = s->nextid + addnum;
+	 m[1] = var;
+	 m[2] = low;
+	 m[3] = high;
+	 added[addnum++] = node;
+      }
+   }
+
+   stream_putrec(s, addnum);
+   for (n=0 ; n<addnum ; n++)
+   {
+      int *m = &s->map[added[n]*4];
+      
+      stream_putrec(s, m[1]);
+      stream_putrec(s, m[0] - m[2]);
+      stream_putrec(s, m[0] - m[3]);
+   }
+   s->nextid += addnum;
+   stream_putrec(s, s->nextid - stream_id(s, r));
+
+   free(cone);
+   
+   if (s->err)
+      return bdd_error(BDD_FILE);
+   return s->rootnum++;
+}
+
+
+int bdd_stream_flush(bddStream *s)
+{
+   stream_block(s);
+   if (fflush(s->file) != 0)
+      s->err = 1;
+   
+   if (s->err)
+      return bdd_error(BDD_FILE);
+   return 0;
+}
+
+
+int bdd_stream_close(bddStream *s)
+{
+   int err = 0;
+   
+   if (s == NULL)
+      return 0;
+   
+   stream_block(s);
+   stream_putnum(s->file, 0);
+   if (fflush(s->file) != 0  ||  ferror(s->file))
+      s->err = 1;
+   if (s->ownfile  &&  fclose(s->file) != 0)
+      s->err = 1;
+   if (s->err)
+      err = bdd_error(BDD_FILE);
+   
+   free(s->raw);
+   free(s->code);
+   free(s->map);
+   free(s);
+   return err;
+}
+
+
+/*=== READING ==========================================================*/
+
+static int reader_filenum(StreamReader *rd, unsigned int *res)
+{
+   unsigned int n = 0;
+   int shift, c;
+
+   for (shift=0 ; shift<35 ; shift+=7)
+   {
+      if ((c=getc(rd->file)) == EOF)
+	 return -1;
+      n |= (unsigned int)(c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+      {
+	 *res = n;
+	 return 0;
+      }
+   }
+   return -1;
+}
+
+
+/* Read the next block into 'raw'. A stream that ends before a block
+   header has simply ended, any other damage is an error.
+*/
+static void reader_block(StreamReader *rd)
+{
+   unsigned int rawsize, codesize, sum = 0;
+   int n, c;
+
+   if (reader_filenum(rd, &rawsize) < 0  ||  rawsize == 0)
+   {
+      rd->end = 1;
+      return;
+   }
+
+   if (reader_filenum(rd, &codesize) < 0  ||  rawsize > STREAM_BLOCKSIZE  ||
+       codesize >= rawsize)
+   {
+      rd->err = rd->end = 1;
+      return;
+   }
+
+   for (n=0 ; n<4 ; n++)
+   {
+      if ((c=getc(rd->file)) == EOF)
+	 rd->err = 1;
+      sum |= (unsigned int)(c & 0xFF) << (8*n);
+   }
+
+   if (codesize > 0)
+   {
+      if (fread(rd->code, 1, codesize, rd->file) != codesize  ||
+	  lz_expand(rd->code, codesize, rd->raw, rawsize) < 0)
+	 rd->err = 1;
+   }
+   else if (fread(rd->raw, 1, rawsize, rd->file) != rawsize)
+      rd->err = 1;
+
+   if (rd->err  ||  stream_checksum(rd->raw, rawsize) != sum)
+   {
+      rd->err = rd->end = 1;
+      return;
+   }
+
+   rd->pos = 0;
+   rd->size = rawsize;
+}
+
+
+static unsigned int reader_getnum(StreamReader *rd)
+{
+   unsigned int n = 0;
+   int shift, c;
+
+   for (shift=0 ; shift<35 ; shift+=7)
+   {
+      if (rd->pos == rd->size)
+	 reader_block(rd);
+      if (rd->end)
+	 return 0;
+      
+      c = rd->raw[rd->pos++];
+      n |= (unsigned int)(c & 0x7F) << shift;
+      if ((c & 0x80) == 0)
+	 return n;
+   }
+
+   rd->err = rd->end = 1;
+   return 0;
+}
+
+
+/* Make the nodes of the stream below 'root' with the nodes given as
+   (var, low id, high id) in 'node'. A node is made directly when its
+   variable is above its children in the current order and otherwise
+   with bdd_ite(), so any order works.
+*/
+static int stream_build(int *node, int root, int maxvar, BDD *r)
+{
+   char *mark;
+   BDD *res;
+   int n, err = 0;
+
+   if (maxvar >= bddvarnum  &&  (err=bdd_setvarnum(maxvar+1)) < 0)
+      return err;
+   
+   if ((mark=(char*)calloc(root+2, 1)) == NULL  ||
+       (res=NEW(BDD,root+2)) == NULL)
+   {
+      free(mark);
+      return bdd_error(BDD_MEMORY);
+   }
+   
+   mark[root] = 1;
+   for (n=root ; n>=2 ; n--)
+      if (mark[n])
+	 mark[node[n*3+1]] = mark[node[n*3+2]] = 1;
+
+   res[0] = 0;
+   res[1] = 1;
+   bdd_disable_reorder();
+   
+   for (n=2 ; n<=root ; n++)
+   {
+      int level, l, h;
+      
+      if (!mark[n])
+	 continue;
+      
+      level = bddvar2level[node[n*3]];
+      l = res[node[n*3+1]];
+      h = res[node[n*3+2]];
+      if (LEVEL(l) > level  &&  LEVEL(h) > level)
+	 res[n] = bdd_addref( bdd_makenode(level, l, h) );
+      else
+	 res[n] = bdd_addref( bdd_ite(bdd_ithvar(node[n*3]), h, l) );
+      
+      if (bdderrorcond)
+      {
+	 err = -bdderrorcond;
+	 mark[n] = 0;
+	 break;
+      }
+   }
+
+   bdd_enable_reorder();
+   
+   *r = (err == 0 ? res[root] : 0);
+   for (n=2 ; n<=root ; n++)
+      if (mark[n])
+	 bdd_delref(res[n]);
+   
+   free(res);
+   free(mark);
+   return err;
+}
+
+
+int bdd_stream_load(FILE *ifile, int root, BDD *r)
+{
+   StreamReader rd;
+   int *node = NULL;
+   int nodenum = 2, nodealloc = 0, rootnum = 0, last = -1, maxvar = -1;
+   unsigned int version;
+   int n, err = 0;
+
+   *r = 0;
+   if (!bddrunning)
+      return bdd_error(BDD_RUNNING);
+   
+   for (n=0 ; n<4 ; n++)
+      if (getc(ifile) != STREAM_MAGIC[n])
+	 return bdd_error(BDD_FORMAT);
+   rd.file = ifile;
+   if (reader_filenum(&rd, &version) < 0  ||  version != STREAM_VERSION)
+      return bdd_error(BDD_FORMAT);
+
+   rd.raw = NEW(unsigned char,STREAM_BLOCKSIZE);
+   rd.code = NEW(unsigned char,STREAM_BLOCKSIZE);
+   if (rd.raw == NULL  ||  rd.code == NULL)
+   {
+      free(rd.raw);
+      free(rd.code);
+      return bdd_error(BDD_MEMORY);
+   }
+   rd.pos = rd.size = 0;
+   rd.end = rd.err = 0;
+
+      /* Read records until the wanted root. A record cut off at the end of
+       * the stream is from a writer that never finished and is ignored. */
+   while (root < 0  ||  rootnum <= root)
+   {
+      unsigned int addnum = reader_getnum(&rd);
+      unsigned int dist;
+      
+      if (rd.end)
+	 break;
+
+      if (addnum > (unsigned int)(INT_MAX/3 - nodenum))
+      {
+	 rd.err = 1;
+	 break;
+      }
+      if (nodenum + (int)addnum > nodealloc)
+      {
+	 int newalloc = MAX(nodealloc*2, nodenum + (int)addnum + 1024);
+	 int *tmp_ptr = (int*)realloc(node, sizeof(int)*3*newalloc);
+	 if (tmp_ptr == NULL)
+	 {
+	    err = bdd_error(BDD_MEMORY);
+	    break;
+	 }
+	 node = tmp_ptr;
+	 nodealloc = newalloc;
+      }
+      
+      for (n=0 ; n<(int)addnum  &&  !rd.end ; n++)
+      {
+	 int id = nodenum + n;
+	 unsigned int var = reader_getnum(&rd);
+	 unsigned int low = reader_getnum(&rd);
+	 unsigned int high = reader_getnum(&rd);
+
+	 if (rd.end)
+	    break;
+	 if (var >= MAXVAR  ||  low < 1  ||  low > (unsigned int)id  ||
+	     high < 1  ||  high > (unsigned int)id)
+	    rd.err = rd.end = 1;
+	 
+	 node[id*3] = var;
+	 node[id*3+1] = id - low;
+	 node[id*3+2] = id - high;
+	 maxvar = MAX(maxvar, (int)var);
+      }
+
+      dist = reader_getnum(&rd);
+      if (rd.end)
+	 break;
+      
+      nodenum += addnum;
+      if (dist < 1  ||  dist > (unsigned int)nodenum)
+      {
+	 rd.err = 1;
+	 break;
+      }
+      last = nodenum - dist;
+      rootnum++;
+   }
+
+   if (err == 0)
+   {
+      if (rd.err)
+	 err = bdd_error(BDD_FORMAT);
+      else if (last < 0  ||  (root >= 0  &&  rootnum <= root))
+	 err = bdd_error(BDD_RANGE);
+      else
+	 err = stream_build(node, last, maxvar, r);
+   }
+
+   free(node);
+   free(rd.raw);
+   free(rd.code);
+   return err;
+}
+
+
+int bdd_stream_fnload(char *fname, int root, BDD *r)
+{
+   FILE *ifile;
+   int ok;
+
+   if ((ifile=fopen(fname,"rb")) == NULL)
+      return bdd_error(BDD_FILE);
+
+   ok = bdd_stream_load(ifile, root, r);
+   fclose(ifile);
+   return ok;
+}
+
+
+/* EOF */
@@ -72,6 +72,8 @@ BddTree *bddtree_new(int id)
    t->next = t->prev = t->nextlevel = NULL;
    t->seq = NULL;
    t->id = id;
+   t->symsize = 1;
+   t->symhead = t;
    return t;
 }
 
@@ -192,6 +194,32 @@ BddTree *bddtree_addrange(BddTree *t, int first, int last, int fixed,int id)
 }
 
 
+/* Make a single block for the variables first...last. Unlike addrange
+   the caller links it into the tree, so a tree can be rebuilt exactly
+   as it was saved.
+*/
+BddTree *bddtree_newrange(int first, int last, int fixed, int id)
+{
+   BddTree *t;
+
+   if (first < 0  ||  last < first)
+      return NULL;
+   if ((t=bddtree_new(id)) == NULL)
+      return NULL;
+   
+   t->first = first;
+   t->last = last;
+   t->fixed = fixed;
+   if ((t->seq=NEW(int,last-first+1)) == NULL)
+   {
+      free(t);
+      return NULL;
+   }
+   update_seq(t);
+   return t;
+}
+
+
 #if 0
 int main(void)
 {
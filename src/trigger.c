@@ -0,0 +1,220 @@
+/*========================================================================
+               Copyright (C) 1996-2002 by Jorn Lind-Nielsen
+                            All rights reserved
+
+    Permission is hereby granted, without written agreement and without
+    license or royalty fees, to use, reproduce, prepare derivative
+    works, distribute, and display this software and its documentation
+    for any purpose, provided that (1) the above copyright notice and
+    the following two paragraphs appear in all copies of the source code
+    and (2) redistributions, including without limitation binaries,
+    reproduce these notices in the supporting documentation. Substantial
+    modifications to this software may be copyrighted by their authors
+    and need not follow the licensing terms described here, provided
+    that the new terms are clearly indicated in all files where they apply.
+
+    IN NO EVENT SHALL JORN LIND-NIELSEN, OR DISTRIBUTORS OF THIS
+    SOFTWARE BE LIABLE TO ANY PARTY FOR DIRECT, INDIRECT, SPECIAL,
+    INCIDENTAL, OR CONSEQUENTIAL DAMAGES ARISING OUT OF THE USE OF THIS
+    SOFTWARE AND ITS DOCUMENTATION, EVEN IF THE AUTHORS OR ANY OF THE
+    ABOVE PARTIES HAVE BEEN ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+    JORN LIND-NIELSEN SPECIFICALLY DISCLAIM ANY WARRANTIES, INCLUDING,
+    BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+    FITNESS FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS
+    ON AN "AS IS" BASIS, AND THE AUTHORS AND DISTRIBUTORS HAVE NO
+    OBLIGATION TO PROVIDE MAINTENANCE, SUPPORT, UPDATES, ENHANCEMENTS, OR
+    MODIFICATIONS.
+========================================================================*/
+
+/*************************************************************************
+  FILE:  trigger.c
+  DESCR: Policies for when to start automatic reordering
+*************************************************************************/
+#include <stdlib.h>
+#include <sys/time.h>
+#include "kernel.h"
+
+/* The kernel asks bdd_trigger_check() after each garbage collection that
+   was forced by a full node table whether it is time to reorder. The
+   policies are
+
+     DOUBLE   Wait until twice as many nodes are live as right after the
+              last reordering, and up to twice that again if the gain was
+	      small. This is the old rule.
+     GROWTH   Wait until the live nodes have grown 'triggergrowth' percent
+              since the last reordering.
+     COST     As GROWTH, but also wait until the time since the last
+              reordering is large enough to pay for it. A reordering that
+	      took T ms and removed G percent of the nodes is repeated
+	      after no less than 100*T/G ms. The wait ends anyway when the
+	      live nodes have grown four times as much.
+     BACKOFF  As GROWTH, but the growth needed is doubled after each
+              reordering that gained less than 20 percent, up to 256
+	      times, and set back after one that gained more.
+*/
+
+   /* The growth needed is never scaled up more than this */
+#define MAXBACKOFF 256
+
+   /* A reordering is a poor one if it gains less than this (percent) */
+#define POORGAIN 20
+
+static int  triggerpolicy;    /* Current policy */
+static int  triggergrowth;    /* Growth needed for a reordering (percent) */
+static int  triggerbase;      /* Live nodes after the last reordering */
+static int  triggergain;      /* Gain of the last reordering (percent) */
+static int  triggernext;      /* Live nodes needed for the next reordering */
+static int  triggerbackoff;   /* Growth multiplier for BACKOFF */
+static long triggerstart;     /* Start time of the current reordering */
+static long triggerlast;      /* End time of the last reordering */
+static long triggerwait;      /* Time needed since the last reordering */
+
+
+/* Wall clock time in milliseconds
+ */
+static long trigger_msec(void)
+{
+   struct timeval tv;
+   
+   gettimeofday(&tv, NULL);
+   return tv.tv_sec*1000L + tv.tv_usec/1000;
+}
+
+
+/* Number of live nodes needed when 'growth' percent growth is needed.
+   Done in double to avoid overflow on large tables.
+*/
+static int trigger_grown(int growth)
+{
+   double next = (double)triggerbase * (100.0+growth) / 100.0;
+   
+   if (next > (double)INT_MAX)
+      return INT_MAX;
+   return (int)next;
+}
+
+
+/* Calculate the number of live nodes needed for the next reordering
+ */
+static void trigger_setnext(void)
+{
+   switch (triggerpolicy)
+   {
+   case BDD_TRIGGER_DOUBLE:
+         /* Twice the nodes, and for a gain below 20% upto twice that */
+      if (triggergain < POORGAIN)
+	 triggernext = trigger_grown(100 + 10*(POORGAIN-triggergain));
+      else
+	 triggernext = trigger_grown(100);
+      break;
+      
+   case BDD_TRIGGER_GROWTH:
+   case BDD_TRIGGER_COST:
+      triggernext = trigger_grown(triggergrowth);
+      break;
+
+   case BDD_TRIGGER_BACKOFF:
+      triggernext = trigger_grown(triggergrowth * triggerbackoff);
+      break;
+   }
+}
+
+
+/*=== Kernel interface =================================================*/
+
+void bdd_trigger_init(int nodesize)
+{
+   triggerpolicy = BDD_TRIGGER_DOUBLE;
+   triggergrowth = 100;
+   triggerbase = nodesize/2;
+   triggergain = POORGAIN;
+   triggernext = nodesize;
+   triggerbackoff = 1;
+   triggerlast = trigger_msec();
+   triggerwait = 0;
+}
+
+
+/* Called with the number of live nodes after a garbage collection.
+   Returns non-zero if a reordering should be done now.
+*/
+int bdd_trigger_check(int used)
+{
+   if (used < triggernext)
+      return 0;
+   
+   if (triggerpolicy == BDD_TRIGGER_COST  &&
+       trigger_msec() - triggerlast < triggerwait  &&
+       used < trigger_grown(4*triggergrowth))
+      return 0;
+
+   return 1;
+}
+
+
+void bdd_trigger_start(void)
+{
+   triggerstart = trigger_msec();
+}
+
+
+/* Called with the number of live nodes after an automatic reordering
+ */
+void bdd_trigger_done(int used)
+{
+   triggerlast = trigger_msec();
+   triggerbase = used;
+   triggergain = bdd_reorder_gain();
+   
+   if (triggergain > 0)
+      triggerwait = (100 * (triggerlast - triggerstart)) / triggergain;
+   else
+      triggerwait = 100 * (triggerlast - triggerstart);
+
+   if (triggergain < POORGAIN)
+   {
+      if (triggerbackoff < MAXBACKOFF)
+	 triggerbackoff *= 2;
+   }
+   else
+      triggerbackoff = 1;
+   
+   trigger_setnext();
+}
+
+
+/*=== User interface ===================================================*/
+
+int bdd_reorder_trigger(int policy)
+{
+   int tmp = triggerpolicy;
+
+   if (policy < BDD_TRIGGER_DOUBLE  ||  policy > BDD_TRIGGER_BACKOFF)
+      return bdd_error(BDD_RANGE);
+
+   triggerpolicy = policy;
+   triggerbase = bdd_getnodenum();
+   triggergain = POORGAIN;
+   triggerbackoff = 1;
+   triggerlast = trigger_msec();
+   triggerwait = 0;
+   trigger_setnext();
+   return tmp;
+}
+
+
+int bdd_reorder_triggergrowth(int percent)
+{
+   int tmp = triggergrowth;
+
+   if (percent <= 0)
+      return bdd_error(BDD_RANGE);
+
+   triggergrowth = percent;
+   trigger_setnext();
+   return tmp;
+}
+
+
+/* EOF */